@@ -0,0 +1,169 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+#include "cconfig.h"
+#include "cprofile.h"
+
+#define LIBRARY_FILES       400                 /** Files with long names at the top of the library. */
+#define LIBRARY_DIRS        3                   /** Directories at the top of the library. */
+#define LIBRARY_DIR_FILES   40                  /** Files in each directory. */
+#define LIBRARY_ZIPS        3                   /** Archives at the top of the library. */
+#define LIBRARY_ZIP_FILES   30                  /** Files in each archive. */
+#define LIBRARY_ROMS        "roms/"             /** Directory the profile lists, so the config and profile stay out of it. */
+#define LIBRARY_CONFIG      "config.txt"        /** Config the launcher reads by default. */
+#define LIBRARY_PROFILE     "profile.txt"       /** Profile the launcher reads by default. */
+
+/* Names are longer than the list so the selection scrolls, the extension cycles over the profile */
+static string LibraryName( uint32_t index )
+{
+    char name[96];
+
+    snprintf( name, sizeof(name), "Synthetic Adventure %04u - The Long Subtitle Of The Training Library (Rev %u).e%u",
+              index, index%3, index%2 );
+    return name;
+}
+
+static int8_t WriteEmpty( const string& location )
+{
+    int fd;
+
+    fd = open( location.c_str(), O_WRONLY|O_CREAT, 0644 );
+    if (fd < 0)
+    {
+        return 1;
+    }
+    close( fd );
+    return 0;
+}
+
+static int8_t WriteLibraryConfig( const string& location, const string& font )
+{
+    ofstream fout;
+
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        return 1;
+    }
+
+    fout << OPT_USEZIPSUPPORT << "=1" << endl;
+    fout << OPT_TEXT_SCROLL_OPTION << "=1" << endl;
+    fout << OPT_SHOWPOINTER << "=0" << endl;
+    fout << OPT_PATH_FONT << "=" << font << endl;
+    fout.close();
+    return fout.fail() ? 1 : 0;
+}
+
+static int8_t WriteLibraryProfile( const string& location )
+{
+    ofstream fout;
+
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        return 1;
+    }
+
+    fout << PROFILE_TARGETAPP << "Training" << endl;
+    fout << PROFILE_FILEPATH << LIBRARY_ROMS << endl << endl;
+    fout << "[e0;e1;bin]" << endl;
+    fout << PROFILE_EXEPATH << "/opt/emu/emu" << endl;
+    fout << PROFILE_EXTARG << "Rom;;0;File;%filename%" << endl;
+    fout << PROFILE_EXTARG << "Scale;-scale;0;1x;1;2x;2;3x;3" << endl;
+    fout << PROFILE_EXTARG << "Sound;-sound;1;Off;0;On;1" << endl << endl;
+
+    // Every tenth file has an entry so the titles and custom values are drawn as well
+    for (uint32_t i=0; i<LIBRARY_FILES; i+=10)
+    {
+        fout << "{./" << LibraryName( i ) << ";Title " << i << "}" << endl;
+        fout << PROFILE_ENTRY_CMDS << VALUE_NOVALUE << endl;
+        fout << PROFILE_ENTRY_ARGS << VALUE_NOVALUE << endl;
+    }
+    fout.close();
+    return fout.fail() ? 1 : 0;
+}
+
+int8_t WriteLibrary( CBench& bench, const string& location, const string& font )
+{
+    string roms;
+    string name;
+    string last;
+
+    roms = location + "/" + LIBRARY_ROMS;
+    if (   (mkdir( location.c_str(), 0755 ) != 0 && errno != EEXIST)
+        || (mkdir( roms.c_str(), 0755 ) != 0 && errno != EEXIST)
+       )
+    {
+        bench.Log( __FILENAME__, __LINE__, "Failed to create library %s: %s", location.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    // Directories are listed first, then the archives, then the files
+    for (uint32_t dir=0; dir<LIBRARY_DIRS; dir++)
+    {
+        name = roms + "Folder " + bench.i_to_a( dir ) + "/";
+        if (mkdir( name.c_str(), 0755 ) != 0 && errno != EEXIST)
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to create library %s: %s", name.c_str(), strerror(errno) );
+            return 1;
+        }
+        for (uint32_t i=0; i<LIBRARY_DIR_FILES; i++)
+        {
+            if (WriteEmpty( name + LibraryName( i ) ))
+            {
+                bench.Log( __FILENAME__, __LINE__, "Failed to write library file: %s", strerror(errno) );
+                return 1;
+            }
+        }
+    }
+
+    for (uint32_t zip=0; zip<LIBRARY_ZIPS; zip++)
+    {
+        name = roms + "0 Archive " + bench.i_to_a( zip ) + ZIP_EXT;
+        if (WriteTestZip( name, LIBRARY_ZIP_FILES, last ))
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to write library archive %s", name.c_str() );
+            return 1;
+        }
+    }
+
+    for (uint32_t i=0; i<LIBRARY_FILES; i++)
+    {
+        if (WriteEmpty( roms + LibraryName( i ) ))
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to write library file: %s", strerror(errno) );
+            return 1;
+        }
+    }
+
+    if (   WriteLibraryConfig( location + "/" + LIBRARY_CONFIG, font )
+        || WriteLibraryProfile( location + "/" + LIBRARY_PROFILE )
+       )
+    {
+        bench.Log( __FILENAME__, __LINE__, "Failed to write the config and profile of library %s", location.c_str() );
+        return 1;
+    }
+
+    bench.Log( __FILENAME__, __LINE__, "Wrote training library %s", location.c_str() );
+    return 0;
+}
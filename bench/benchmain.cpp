@@ -0,0 +1,98 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+
+int32_t main( int32_t argc, char** argv )
+{
+    CBench          bench;
+    benchsettings_t settings;
+    string          output = BENCH_OUTPUT;
+    string          baseline;
+    string          library;
+    string          font = BENCH_FONT;
+
+    for (int32_t i=1; i<argc; i++)
+    {
+        string arg = argv[i];
+
+        if (arg.compare( "--json" ) == 0 && i+1 < argc)
+        {
+            output = argv[++i];
+        }
+        else if (arg.compare( "--filter" ) == 0 && i+1 < argc)
+        {
+            bench.SetFilter( argv[++i] );
+        }
+        else if (arg.compare( "--scan-max" ) == 0 && i+1 < argc)
+        {
+            settings.ScanMax = bench.a_to_i( argv[++i] );
+        }
+        else if (arg.compare( "--scan-exts" ) == 0 && i+1 < argc)
+        {
+            settings.ScanExts = MAX( bench.a_to_i( argv[++i] ), 1 );
+        }
+        else if (arg.compare( "--scan-entries" ) == 0 && i+1 < argc)
+        {
+            settings.ScanEntries = bench.a_to_i( argv[++i] );
+        }
+        else if (arg.compare( "--compare" ) == 0 && i+1 < argc)
+        {
+            baseline = argv[++i];
+        }
+        else if (arg.compare( "--library" ) == 0 && i+1 < argc)
+        {
+            library = argv[++i];
+        }
+        else if (arg.compare( "--font" ) == 0 && i+1 < argc)
+        {
+            font = argv[++i];
+        }
+        else
+        {
+            bench.Log( __FILENAME__, __LINE__, "Usage: %s [--json file] [--filter text] [--scan-max files] [--scan-exts count] [--scan-entries count] [--compare file]", argv[0] );
+            bench.Log( __FILENAME__, __LINE__, "       %s --library dir [--font file]", argv[0] );
+            return 1;
+        }
+    }
+
+    // Only writes the library the launcher is trained on, nothing is timed
+    if (library.length() > 0)
+    {
+        return WriteLibrary( bench, library, font );
+    }
+
+    if (BenchScale( bench ))
+    {
+        return 1;
+    }
+    BenchProfile( bench );
+    BenchScan( bench, settings );
+    BenchZip( bench );
+    BenchString( bench );
+
+    if (bench.WriteJson( output ))
+    {
+        return 1;
+    }
+    return (baseline.length() > 0) ? bench.Compare( baseline ) : 0;
+}
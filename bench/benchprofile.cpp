@@ -0,0 +1,224 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+#include "cconfig.h"
+#include "cprofile.h"
+#include "cprofilecache.h"
+
+#define BENCH_PROFILE           "bench_profile.txt"     /** Synthetic profile written for the benchmarks and removed after. */
+#define BENCH_PROFILE_ENTRIES   50000                   /** Number of entry blocks in the synthetic profile. */
+
+/** @brief Data structure for one profile benchmark
+ */
+struct profilecase_t {
+    profilecase_t() : Base(NULL), Location(""), Delimiter(DELIMITER), Fields(0) {};
+    CBase*          Base;           /** @brief Access to the CBase string helpers */
+    string          Location;       /** @brief Profile to read */
+    string          Delimiter;      /** @brief Delimiter used between options */
+    uint32_t        Fields;         /** @brief Fields seen by the last pass, so the work cannot be skipped */
+};
+
+static int8_t WriteTestProfile( const string& location, uint32_t entries )
+{
+    ofstream fout;
+
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        return 1;
+    }
+
+    fout << "# Global Settings" << endl;
+    fout << PROFILE_TARGETAPP << "Bench" << endl;
+    fout << PROFILE_FILEPATH << "/media/roms/" << endl << endl;
+    fout << "<Clock>" << endl;
+    fout << PROFILE_CMDPATH << "/usr/bin/clock" << endl;
+    fout << PROFILE_CMDARG << "Speed;-c;0;Default;%na%;Fast;500;Slow;200" << endl << endl;
+    fout << "[zip;gb;gbc]" << endl;
+    fout << PROFILE_EXEPATH << "/opt/emu/gbemu" << endl;
+    fout << PROFILE_BLACKLIST << "bios.gb;boot.zip" << endl;
+    fout << PROFILE_EXTARG << "Rom;;0;File;%filename%" << endl;
+    fout << PROFILE_EXTARG << "Scale;-s;0;None;%na%;Two;2;Three;3" << endl << endl;
+
+    // Mostly aliases like a scraped collection, some with custom values
+    for (uint32_t i=0; i<entries; i++)
+    {
+        fout << "{/media/roms/game" << setw(5) << setfill('0') << i << ".zip;Game Title Number " << i << "}" << endl;
+        if (i%4 == 0)
+        {
+            fout << PROFILE_ENTRY_CMDS << (i%2) << endl;
+            fout << PROFILE_ENTRY_ARGS << "-1;" << (i%3) << endl;
+        }
+        else
+        {
+            fout << PROFILE_ENTRY_CMDS << VALUE_NOVALUE << endl;
+            fout << PROFILE_ENTRY_ARGS << VALUE_NOVALUE << endl;
+        }
+    }
+    fout.close();
+    return 0;
+}
+
+/* The getline and UnprefixString line handling that CProfile::Load used before the tokenizer, kept as the reference */
+static void BenchTokenizeLegacy( void* data )
+{
+    profilecase_t*  test = static_cast<profilecase_t*>(data);
+    const char*     prefixes[] = { PROFILE_TARGETAPP, PROFILE_FILEPATH, PROFILE_CMDPATH, PROFILE_CMDARG, PROFILE_EXEPATH,
+                                   PROFILE_BLACKLIST, PROFILE_EXTARG, PROFILE_ENTRY_CMDS, PROFILE_ENTRY_ARGS };
+    ifstream        fin;
+    string          line;
+    string          value;
+    string          path, name, alias;
+    string::size_type pos1, pos2;
+    vector<string>  parts;
+
+    test->Fields = 0;
+    fin.open( test->Location.c_str(), ios_base::in );
+    while (!fin.eof())
+    {
+        getline( fin, line );
+        if (line.length() == 0)
+        {
+            continue;
+        }
+
+        if (line.at(0) == '{' && line.at(line.length()-1) == '}')
+        {
+            pos1  = line.find_last_of('/');
+            pos2  = line.find_last_of(test->Delimiter);
+            path  = line.substr( 1, pos1 );
+            name  = line.substr( pos1+1, pos2-pos1-1 );
+            alias = line.substr( pos2+1, line.length()-pos2-2 );
+            test->Fields += 2;
+            continue;
+        }
+
+        for (uint8_t i=0; i<sizeof(prefixes)/sizeof(prefixes[0]); i++)
+        {
+            if (test->Base->UnprefixString( value, line, prefixes[i] ) == true)
+            {
+                test->Base->SplitString( test->Delimiter, value, parts );
+                for (uint16_t j=0; j<parts.size(); j++)
+                {
+                    test->Fields += test->Base->a_to_i( parts.at(j) ) != 0;
+                }
+                test->Fields += parts.size();
+                break;
+            }
+        }
+    }
+    fin.close();
+}
+
+static void BenchTokenize( void* data )
+{
+    profilecase_t*      test = static_cast<profilecase_t*>(data);
+    const char*         prefixes[] = { PROFILE_TARGETAPP, PROFILE_FILEPATH, PROFILE_CMDPATH, PROFILE_CMDARG, PROFILE_EXEPATH,
+                                       PROFILE_BLACKLIST, PROFILE_EXTARG, PROFILE_ENTRY_CMDS, PROFILE_ENTRY_ARGS };
+    CTokenizer          tokens;
+    textview_t          line;
+    textview_t          value;
+    vector<textview_t>  parts;
+
+    test->Fields = 0;
+    tokens.Open( test->Location );
+    while (tokens.Next( line ) == true)
+    {
+        if (line.Length == 0)
+        {
+            continue;
+        }
+
+        if (line.Data[0] == '{' && line.Data[line.Length-1] == '}')
+        {
+            test->Fields += 2;
+            continue;
+        }
+
+        for (uint8_t i=0; i<sizeof(prefixes)/sizeof(prefixes[0]); i++)
+        {
+            if (tokens.Unprefix( line, prefixes[i], value ) == true)
+            {
+                tokens.Split( value, test->Delimiter, parts );
+                for (uint16_t j=0; j<parts.size(); j++)
+                {
+                    test->Fields += tokens.Integer( parts.at(j) ) != 0;
+                }
+                test->Fields += parts.size();
+                break;
+            }
+        }
+    }
+    tokens.Close();
+}
+
+/* The text is parsed and compiled every pass, the compiled form it leaves behind is removed first */
+static void BenchLoad( void* data )
+{
+    profilecase_t*  test = static_cast<profilecase_t*>(data);
+    CProfile        profile;
+
+    unlink( (test->Location + PROFILECACHE_EXT).c_str() );
+    profile.Load( test->Location, test->Delimiter );
+    test->Fields = profile.Entries.size();
+}
+
+/* The compiled form left by profile_load_50k is mapped every pass */
+static void BenchLoadCompiled( void* data )
+{
+    profilecase_t*  test = static_cast<profilecase_t*>(data);
+    CProfile        profile;
+
+    profile.Load( test->Location, test->Delimiter );
+    test->Fields = profile.Entries.size();
+}
+
+void BenchProfile( CBench& bench )
+{
+    profilecase_t test;
+
+    if (   (bench.Enabled( "profile_load_50k" ) == false)
+        && (bench.Enabled( "profile_load_compiled_50k" ) == false)
+        && (bench.Enabled( "profile_tokenize_50k" ) == false)
+        && (bench.Enabled( "profile_tokenize_legacy_50k" ) == false)
+       )
+    {
+        return;
+    }
+
+    test.Base     = &bench;
+    test.Location = BENCH_PROFILE;
+    if (WriteTestProfile( test.Location, BENCH_PROFILE_ENTRIES ))
+    {
+        bench.Log( __FILENAME__, __LINE__, "Failed to write test profile %s", test.Location.c_str() );
+        return;
+    }
+
+    bench.Run( "profile_tokenize_legacy_50k", 10, BenchTokenizeLegacy, &test );
+    bench.Run( "profile_tokenize_50k", 10, BenchTokenize, &test );
+    bench.Run( "profile_load_50k", 10, BenchLoad, &test );
+    bench.Run( "profile_load_compiled_50k", 10, BenchLoadCompiled, &test );
+
+    unlink( (test.Location + PROFILECACHE_EXT).c_str() );
+    unlink( test.Location.c_str() );
+}
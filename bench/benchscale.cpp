@@ -0,0 +1,359 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+
+/** @brief Data structure for one scaling benchmark
+ */
+struct scalecase_t {
+    scalecase_t() : Base(NULL), Source(NULL), Width(0), Height(0), Mode(0) {};
+    CBase*          Base;           /** @brief Access to CBase::ScaleSurface */
+    SDL_Surface*    Source;         /** @brief Image to scale */
+    uint16_t        Width;          /** @brief Scaled width */
+    uint16_t        Height;         /** @brief Scaled height */
+    uint8_t         Mode;           /** @brief Filter, index is defined in SCALE_MODE_T */
+};
+
+/* The per pixel scaler that ScaleSurface used before the fixed point filters, kept as the reference */
+static uint32_t LegacyGetPixel( SDL_Surface *surface, int16_t x, int16_t y )
+{
+    int16_t bpp = surface->format->BytesPerPixel;
+    uint8_t *p = static_cast<uint8_t*>(surface->pixels) + (y * surface->pitch) + (x * bpp);
+
+    switch (bpp) {
+        case 1:
+            return *p;
+        case 2:
+            return *(uint16_t *)p;
+        case 3:
+            if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
+                return p[0] << 16 | p[1] << 8 | p[2];
+            else
+                return p[0] | p[1] << 8 | p[2] << 16;
+        case 4:
+            return *(uint32_t *)p;
+        default:
+            return 0;
+    }
+}
+
+static void LegacyPutPixel( SDL_Surface *surface, int16_t x, int16_t y, uint32_t pixel )
+{
+    int16_t bpp = surface->format->BytesPerPixel;
+    uint8_t *p = static_cast<uint8_t*>(surface->pixels) + (y * surface->pitch) + (x * bpp);
+
+    switch (bpp) {
+        case 1:
+            *p = pixel;
+            break;
+        case 2:
+            *(uint16_t *)p = pixel;
+            break;
+        case 3:
+            if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
+                p[0] = (pixel >> 16) & 0xff;
+                p[1] = (pixel >> 8) & 0xff;
+                p[2] = pixel & 0xff;
+            } else {
+                p[0] = pixel & 0xff;
+                p[1] = (pixel >> 8) & 0xff;
+                p[2] = (pixel >> 16) & 0xff;
+            }
+            break;
+        case 4:
+        default:
+            *(uint32_t *)p = pixel;
+            break;
+    }
+}
+
+static SDL_Surface* LegacyScaleSurface( SDL_Surface *surface, uint16_t width, uint16_t height )
+{
+    SDL_Surface *_ret = SDL_CreateRGBSurface(surface->flags, width, height, surface->format->BitsPerPixel,
+        surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, surface->format->Amask);
+
+    double _stretch_factor_x = ( static_cast<double>(width) / static_cast<double>(surface->w) );
+    double _stretch_factor_y = ( static_cast<double>(height) / static_cast<double>(surface->h) );
+
+    for (int32_t y = 0; y < surface->h; y++)
+        for (int32_t x = 0; x < surface->w; x++)
+            for (int32_t o_y = 0; o_y < _stretch_factor_y; ++o_y)
+                for (int32_t o_x = 0; o_x < _stretch_factor_x; ++o_x)
+                    LegacyPutPixel( _ret, static_cast<int32_t>(_stretch_factor_x * x) + o_x,
+                        static_cast<int32_t>(_stretch_factor_y * y) + o_y, LegacyGetPixel(surface, x, y) );
+
+    return _ret;
+}
+
+static SDL_Surface* CreateTestImage( uint16_t width, uint16_t height, uint8_t depth )
+{
+    SDL_Surface* image;
+
+    if (depth == 16)
+        image = SDL_CreateRGBSurface( SDL_SWSURFACE, width, height, 16, 0xF800, 0x07E0, 0x001F, 0 );
+    else
+        image = SDL_CreateRGBSurface( SDL_SWSURFACE, width, height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 );
+
+    if (image == NULL)
+        return NULL;
+
+    // Gradients with some noise so the filters cannot take shortcuts
+    for (int32_t y=0; y<height; y++)
+    {
+        uint8_t* row = static_cast<uint8_t*>(image->pixels) + y*image->pitch;
+        for (int32_t x=0; x<width; x++)
+        {
+            uint8_t r = (x*255)/width;
+            uint8_t g = (y*255)/height;
+            uint8_t b = ((x*7) ^ (y*13)) & 0xFF;
+
+            if (depth == 16)
+                reinterpret_cast<uint16_t*>(row)[x] = ((r>>3)<<11) | ((g>>2)<<5) | (b>>3);
+            else
+                reinterpret_cast<uint32_t*>(row)[x] = 0xFF000000 | (r<<16) | (g<<8) | b;
+        }
+    }
+    return image;
+}
+
+/* Blocks of the color key, or of clear red pixels when the image is translucent */
+static void MaskTestImage( SDL_Surface* image, bool translucent )
+{
+    uint32_t key = SDL_MapRGB( image->format, 0xFF, 0, 0xFF );
+
+    for (int32_t y=0; y<image->h; y++)
+    {
+        uint8_t* row = static_cast<uint8_t*>(image->pixels) + y*image->pitch;
+        for (int32_t x=0; x<image->w; x++)
+        {
+            if ((x/8 + y/8) % 3 != 0)
+            {
+                if (translucent == true)
+                    reinterpret_cast<uint32_t*>(row)[x] &= ~0x00FF0000;
+                continue;
+            }
+
+            if (image->format->BytesPerPixel == 2)
+                reinterpret_cast<uint16_t*>(row)[x] = key;
+            else if (translucent == true)
+                reinterpret_cast<uint32_t*>(row)[x] = 0x00FF0000;
+            else
+                reinterpret_cast<uint32_t*>(row)[x] = key;
+        }
+    }
+
+    if (translucent == false)
+    {
+#if SDL_VERSION_ATLEAST(2,0,0)
+        SDL_SetColorKey( image, SDL_TRUE, key );
+#else /* SDL 1.2 */
+        SDL_SetColorKey( image, SDL_SRCCOLORKEY, key );
+#endif
+    }
+}
+
+static uint32_t GetPixel( SDL_Surface* image, int32_t x, int32_t y )
+{
+    const uint8_t* p = static_cast<const uint8_t*>(image->pixels) + y*image->pitch + x*image->format->BytesPerPixel;
+
+    return (image->format->BytesPerPixel == 2) ? *reinterpret_cast<const uint16_t*>(p) : *reinterpret_cast<const uint32_t*>(p);
+}
+
+/* The filters may not change where the key is or let a color bleed out of clear pixels */
+static int8_t CheckMasked( CBench& bench, SDL_Surface* source, SDL_Surface* nearest, SDL_Surface* scaled, bool translucent,
+                           const char* name )
+{
+    uint32_t key   = SDL_MapRGB( source->format, 0xFF, 0, 0xFF ) & ~source->format->Amask;
+    uint32_t wrong = 0;
+
+    for (int32_t y=0; y<scaled->h; y++)
+    {
+        for (int32_t x=0; x<scaled->w; x++)
+        {
+            uint32_t pixel = GetPixel( scaled, x, y );
+
+            if (translucent == true)
+            {
+                // Opaque source pixels have no red, any red that shows came from a clear pixel
+                if ((pixel & 0xFF000000) != 0 && (pixel & 0x00FF0000) != 0)
+                    wrong++;
+            }
+            else if (((pixel & ~source->format->Amask) == key) != ((GetPixel( nearest, x, y ) & ~source->format->Amask) == key))
+            {
+                wrong++;
+            }
+        }
+    }
+
+    if (wrong > 0)
+    {
+        bench.Log( __FILENAME__, __LINE__, "Scale check %s: %d pixels differ", name, wrong );
+        return 1;
+    }
+    return 0;
+}
+
+/* Nearest sampling has to give the pixels of the per pixel scaler, the filters have to respect the mask */
+static int8_t CheckScale( CBench& bench )
+{
+    const char* mode_names[SCALE_TOTAL] = { "nearest", "bilinear", "box" };
+    struct {
+        uint16_t    src_w, src_h, dst_w, dst_h;
+    } sizes[] = {
+        { 640, 480, 160, 120 },
+        { 320, 240, 800, 480 },
+        { 37,  23,  101, 59  },
+        { 101, 59,  37,  23  },
+        { 64,  48,  64,  48  },
+    };
+    uint8_t     depths[] = { 16, 32 };
+    int8_t      result = 0;
+
+    for (uint8_t d=0; d<sizeof(depths); d++)
+    {
+        for (uint8_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+        {
+            for (uint8_t masking=0; masking<3; masking++)
+            {
+                bool            translucent = (masking == 2);
+                SDL_Surface*    source;
+                SDL_Surface*    legacy;
+                SDL_Surface*    nearest;
+                SDL_Surface*    scaled;
+                stringstream    name;
+                uint32_t        differ;
+
+                // Only the 32 bpp image has an alpha channel
+                if (translucent == true && depths[d] != 32)
+                    continue;
+
+                source = CreateTestImage( sizes[i].src_w, sizes[i].src_h, depths[d] );
+                if (source == NULL)
+                {
+                    bench.Log( __FILENAME__, __LINE__, "Failed to create test image: %s", SDL_GetError() );
+                    return 1;
+                }
+                if (masking > 0)
+                {
+                    MaskTestImage( source, translucent );
+                }
+
+                name.str( "" );
+                name << sizes[i].src_w << "x" << sizes[i].src_h << "_to_" << sizes[i].dst_w << "x" << sizes[i].dst_h
+                     << "_" << (int32_t)depths[d] << (masking == 1 ? "_keyed" : (translucent ? "_alpha" : ""));
+
+                legacy  = LegacyScaleSurface( source, sizes[i].dst_w, sizes[i].dst_h );
+                nearest = bench.ScaleSurface( source, sizes[i].dst_w, sizes[i].dst_h, SCALE_NEAREST );
+                differ  = 0;
+                for (int32_t y=0; y<sizes[i].dst_h; y++)
+                {
+                    for (int32_t x=0; x<sizes[i].dst_w; x++)
+                    {
+                        differ += (GetPixel( legacy, x, y ) != GetPixel( nearest, x, y )) ? 1 : 0;
+                    }
+                }
+                if (differ > 0)
+                {
+                    bench.Log( __FILENAME__, __LINE__, "Scale check nearest %s: %d pixels differ from the legacy scaler", name.str().c_str(), differ );
+                    result = 1;
+                }
+
+                for (uint8_t mode=SCALE_BILINEAR; mode<SCALE_TOTAL && masking>0; mode++)
+                {
+                    scaled = bench.ScaleSurface( source, sizes[i].dst_w, sizes[i].dst_h, mode );
+                    if (CheckMasked( bench, source, nearest, scaled, translucent, (string(mode_names[mode]) + " " + name.str()).c_str() ))
+                    {
+                        result = 1;
+                    }
+                    SDL_FreeSurface( scaled );
+                }
+
+                SDL_FreeSurface( nearest );
+                SDL_FreeSurface( legacy );
+                SDL_FreeSurface( source );
+            }
+        }
+    }
+
+    if (result == 0)
+    {
+        bench.Log( __FILENAME__, __LINE__, "Scale check passed" );
+    }
+    return result;
+}
+
+static void BenchLegacy( void* data )
+{
+    scalecase_t* test = static_cast<scalecase_t*>(data);
+    SDL_FreeSurface( LegacyScaleSurface( test->Source, test->Width, test->Height ) );
+}
+
+static void BenchScaler( void* data )
+{
+    scalecase_t* test = static_cast<scalecase_t*>(data);
+    SDL_FreeSurface( test->Base->ScaleSurface( test->Source, test->Width, test->Height, test->Mode ) );
+}
+
+int8_t BenchScale( CBench& bench )
+{
+    const char* mode_names[SCALE_TOTAL] = { "nearest", "bilinear", "box" };
+    struct {
+        const char* name;
+        uint16_t    src_w, src_h, dst_w, dst_h;
+        uint8_t     depth;
+        uint32_t    iterations;
+    } sizes[] = {
+        { "preview_640x480_to_160x120_32",     640, 480, 160, 120, 32, 50 },
+        { "preview_640x480_to_160x120_16",     640, 480, 160, 120, 16, 50 },
+        { "background_320x240_to_800x480_32",  320, 240, 800, 480, 32, 20 },
+        { "background_320x240_to_800x480_16",  320, 240, 800, 480, 16, 20 },
+    };
+    scalecase_t test;
+
+    if (CheckScale( bench ))
+    {
+        return 1;
+    }
+
+    test.Base = &bench;
+    for (uint8_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        test.Source = CreateTestImage( sizes[i].src_w, sizes[i].src_h, sizes[i].depth );
+        test.Width  = sizes[i].dst_w;
+        test.Height = sizes[i].dst_h;
+        if (test.Source == NULL)
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to create test image: %s", SDL_GetError() );
+            continue;
+        }
+
+        bench.Run( string("scale_legacy_") + sizes[i].name, sizes[i].iterations, BenchLegacy, &test );
+        for (test.Mode=0; test.Mode<SCALE_TOTAL; test.Mode++)
+        {
+            bench.Run( string("scale_") + mode_names[test.Mode] + "_" + sizes[i].name, sizes[i].iterations, BenchScaler, &test );
+        }
+
+        SDL_FreeSurface( test.Source );
+    }
+
+    return 0;
+}
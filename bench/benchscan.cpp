@@ -0,0 +1,217 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+#include "cconfig.h"
+#include "cprofile.h"
+#include "cprofilecache.h"
+
+#define BENCH_SCAN_DIR          "bench_scan"            /** Prefix of the synthetic directories, removed after. */
+#define BENCH_SCAN_PROFILE      "bench_scan.txt"        /** Profile naming the synthetic extensions and entries, removed after. */
+
+/** @brief Data structure for the benchmarks of one synthetic directory
+ */
+struct scancase_t {
+    scancase_t() : Profile(NULL), Location(""), Items(), Unsorted(), Names(), Found(0) {};
+    CProfile*           Profile;        /** @brief Profile with the extensions and entries of the directory */
+    string              Location;       /** @brief Path of the directory with a trailing slash */
+    vector<listitem_t>  Items;          /** @brief Listing produced by the last pass */
+    vector<listitem_t>  Unsorted;       /** @brief Listing in a shuffled order for the sort benchmark */
+    vector<string>      Names;          /** @brief Names of the files in the directory */
+    uint32_t            Found;          /** @brief Extensions found by the last pass, so the work cannot be skipped */
+};
+
+static string ScanName( uint32_t index, uint32_t exts )
+{
+    char name[32];
+
+    snprintf( name, sizeof(name), "file%06u.e%u", index, index%exts );
+    return name;
+}
+
+static int8_t WriteScanProfile( const string& location, const benchsettings_t& settings )
+{
+    ofstream fout;
+
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        return 1;
+    }
+
+    fout << PROFILE_TARGETAPP << "Bench" << endl;
+    fout << PROFILE_FILEPATH << "./" << endl << endl;
+    fout << "[";
+    for (uint32_t ext=0; ext<settings.ScanExts; ext++)
+    {
+        fout << (ext > 0 ? ";" : "") << "e" << ext;
+    }
+    fout << "]" << endl;
+    fout << PROFILE_EXEPATH << "/opt/emu/emu" << endl;
+    fout << PROFILE_BLACKLIST << ScanName( 1, settings.ScanExts ) << endl;
+    fout << PROFILE_EXTARG << "Rom;;0;File;%filename%" << endl << endl;
+
+    // Entries are spread over the largest directory, an entry for the relative path matches any directory
+    for (uint32_t i=0; i<settings.ScanEntries; i++)
+    {
+        fout << "{./" << ScanName( (uint64_t)i*settings.ScanMax/MAX(settings.ScanEntries, 1), settings.ScanExts )
+             << ";Title " << i << "}" << endl;
+        fout << PROFILE_ENTRY_CMDS << VALUE_NOVALUE << endl;
+        fout << PROFILE_ENTRY_ARGS << VALUE_NOVALUE << endl;
+    }
+    fout.close();
+    return 0;
+}
+
+static int8_t WriteScanDir( scancase_t& test, uint32_t files, uint32_t exts )
+{
+    int     fd;
+    string  name;
+
+    if (mkdir( test.Location.c_str(), 0755 ) != 0 && errno != EEXIST)
+    {
+        return 1;
+    }
+
+    test.Names.clear();
+    for (uint32_t i=0; i<files; i++)
+    {
+        // A directory every hundred files, they are listed above the files
+        if (i%100 == 99)
+        {
+            name = test.Location + "dir" + ScanName( i, exts );
+            if (mkdir( name.c_str(), 0755 ) != 0 && errno != EEXIST)
+            {
+                return 1;
+            }
+        }
+
+        test.Names.push_back( ScanName( i, exts ) );
+        fd = open( (test.Location + test.Names.back()).c_str(), O_WRONLY|O_CREAT, 0644 );
+        if (fd < 0)
+        {
+            return 1;
+        }
+        close( fd );
+    }
+    return 0;
+}
+
+static void RemoveScanDir( scancase_t& test, uint32_t files, uint32_t exts )
+{
+    for (uint32_t i=0; i<files; i++)
+    {
+        if (i%100 == 99)
+        {
+            rmdir( (test.Location + "dir" + ScanName( i, exts )).c_str() );
+        }
+        unlink( (test.Location + ScanName( i, exts )).c_str() );
+    }
+    rmdir( test.Location.c_str() );
+}
+
+static void BenchScanDir( void* data )
+{
+    scancase_t* test = static_cast<scancase_t*>(data);
+
+    test->Profile->ScanDir( test->Location, false, false, test->Items );
+    test->Found = test->Items.size();
+}
+
+/* The copy of the shuffled listing is part of every pass */
+static void BenchSortItems( void* data )
+{
+    scancase_t* test = static_cast<scancase_t*>(data);
+
+    test->Items = test->Unsorted;
+    sort( test->Items.begin(), test->Items.end(), CompareItems );
+}
+
+static void BenchFindExtension( void* data )
+{
+    scancase_t* test = static_cast<scancase_t*>(data);
+
+    test->Found = 0;
+    for (uint32_t i=0; i<test->Names.size(); i++)
+    {
+        test->Found += test->Profile->FindExtension( test->Names.at(i) ) >= 0;
+    }
+}
+
+void BenchScan( CBench& bench, const benchsettings_t& settings )
+{
+    uint32_t    sizes[] = { 1000, 20000, settings.ScanMax };
+    uint32_t    iterations[] = { 50, 10, 3 };
+    string      suffix;
+    CProfile    profile;
+    scancase_t  test;
+
+    if (WriteScanProfile( BENCH_SCAN_PROFILE, settings ) || profile.Load( BENCH_SCAN_PROFILE, DELIMITER ))
+    {
+        bench.Log( __FILENAME__, __LINE__, "Failed to write test profile %s", BENCH_SCAN_PROFILE );
+        unlink( BENCH_SCAN_PROFILE );
+        return;
+    }
+    unlink( (string(BENCH_SCAN_PROFILE) + PROFILECACHE_EXT).c_str() );
+    unlink( BENCH_SCAN_PROFILE );
+
+    test.Profile = &profile;
+    for (uint8_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        // The largest size is configurable, it is only run when bigger than the fixed ones
+        if (sizes[i] == 0 || (i > 0 && sizes[i] <= sizes[i-1]))
+        {
+            continue;
+        }
+
+        suffix = bench.i_to_a( sizes[i]/1000 ) + "k";
+        if (   (bench.Enabled( "scan_dir_" + suffix ) == false)
+            && (bench.Enabled( "scan_sort_" + suffix ) == false)
+            && (bench.Enabled( "find_extension_" + suffix ) == false)
+           )
+        {
+            continue;
+        }
+
+        test.Location = string(BENCH_SCAN_DIR) + "_" + suffix + "/";
+        if (WriteScanDir( test, sizes[i], settings.ScanExts ))
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to write test directory %s: %s", test.Location.c_str(), strerror(errno) );
+            RemoveScanDir( test, sizes[i], settings.ScanExts );
+            continue;
+        }
+
+        // Interleave the two halves of a sorted listing so the sort has work to do
+        profile.ScanDir( test.Location, false, false, test.Items );
+        test.Unsorted.clear();
+        for (uint32_t j=0; j<test.Items.size(); j++)
+        {
+            test.Unsorted.push_back( test.Items.at( (j%2 == 0) ? j/2 : test.Items.size()-1-j/2 ) );
+        }
+
+        bench.Run( "scan_dir_" + suffix, iterations[i], BenchScanDir, &test );
+        bench.Run( "scan_sort_" + suffix, iterations[i], BenchSortItems, &test );
+        bench.Run( "find_extension_" + suffix, iterations[i], BenchFindExtension, &test );
+
+        RemoveScanDir( test, sizes[i], settings.ScanExts );
+    }
+}
@@ -0,0 +1,90 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+#include "cconfig.h"
+#include "cprofile.h"
+
+#define BENCH_STRING_LINES      10000           /** Lines handled in each pass of the string benchmarks. */
+
+/** @brief Data structure for the string benchmarks
+ */
+struct stringcase_t {
+    stringcase_t() : Base(NULL), Lines(), Parts(), Found(0) {};
+    CBase*          Base;           /** @brief Access to the CBase string helpers */
+    vector<string>  Lines;          /** @brief Profile lines to handle */
+    vector<string>  Parts;          /** @brief Result of the last split */
+    uint32_t        Found;          /** @brief Results of the last pass, so the work cannot be skipped */
+};
+
+static void BenchSplitString( void* data )
+{
+    stringcase_t*   test = static_cast<stringcase_t*>(data);
+
+    test->Found = 0;
+    for (uint32_t i=0; i<test->Lines.size(); i++)
+    {
+        test->Base->SplitString( DELIMITER, test->Lines.at(i), test->Parts );
+        test->Found += test->Parts.size();
+    }
+}
+
+/* Every line is tried against the prefixes in the order CProfile::Load used to */
+static void BenchUnprefixString( void* data )
+{
+    stringcase_t*   test = static_cast<stringcase_t*>(data);
+    const char*     prefixes[] = { PROFILE_TARGETAPP, PROFILE_FILEPATH, PROFILE_CMDPATH, PROFILE_CMDARG, PROFILE_EXEPATH,
+                                   PROFILE_BLACKLIST, PROFILE_EXTARG, PROFILE_ENTRY_CMDS, PROFILE_ENTRY_ARGS };
+    string          value;
+
+    test->Found = 0;
+    for (uint32_t i=0; i<test->Lines.size(); i++)
+    {
+        for (uint8_t j=0; j<sizeof(prefixes)/sizeof(prefixes[0]); j++)
+        {
+            if (test->Base->UnprefixString( value, test->Lines.at(i), prefixes[j] ) == true)
+            {
+                test->Found += value.length();
+                break;
+            }
+        }
+    }
+}
+
+void BenchString( CBench& bench )
+{
+    const char*     samples[] = { PROFILE_CMDARG "Speed;-c;0;Default;%na%;Fast;500;Slow;200",
+                                  PROFILE_EXTARG "Scale;-s;0;None;%na%;Two;2;Three;3",
+                                  PROFILE_BLACKLIST "bios.gb;boot.zip;neogeo.zip;pgm.zip",
+                                  PROFILE_ENTRY_ARGS "-1;2;0;1",
+                                  PROFILE_ENTRY_CMDS "1" };
+    stringcase_t    test;
+
+    test.Base = &bench;
+    for (uint32_t i=0; i<BENCH_STRING_LINES; i++)
+    {
+        test.Lines.push_back( samples[i%(sizeof(samples)/sizeof(samples[0]))] );
+    }
+
+    bench.Run( "string_split_10k", 20, BenchSplitString, &test );
+    bench.Run( "string_unprefix_10k", 20, BenchUnprefixString, &test );
+}
@@ -0,0 +1,223 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+#include "czip.h"
+
+#include <zlib.h>
+
+#define BENCH_ZIP           "bench_zip"             /** Prefix of the generated archives, removed after. */
+#define BENCH_ZIP_DIR       "bench_zip_out"         /** Files are extracted here, removed after. */
+#define BENCH_ZIP_SIZE      16384                   /** Bytes in each file of the archives. */
+
+/** @brief Data structure for the benchmarks of one generated archive
+ */
+struct zipcase_t {
+    zipcase_t() : Zip(), Location(""), Last(""), Files() {};
+    CZip            Zip;            /** @brief Reader under test */
+    string          Location;       /** @brief Path of the archive */
+    string          Last;           /** @brief Name of the last file, the slowest to find */
+    vector<string>  Files;          /** @brief Listing produced by the last pass */
+};
+
+static void Write16( string& out, uint16_t value )
+{
+    out += (char)(value & 0xFF);
+    out += (char)(value >> 8);
+}
+
+static void Write32( string& out, uint32_t value )
+{
+    Write16( out, value & 0xFFFF );
+    Write16( out, value >> 16 );
+}
+
+static bool Deflate( const string& data, string& out )
+{
+    z_stream    stream;
+    int32_t     err;
+
+    memset( &stream, 0, sizeof(stream) );
+    if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
+    {
+        return false;
+    }
+
+    out.resize( deflateBound( &stream, data.length() ) );
+    stream.next_in   = (Bytef*)data.data();
+    stream.avail_in  = data.length();
+    stream.next_out  = (Bytef*)&out[0];
+    stream.avail_out = out.length();
+    err = deflate( &stream, Z_FINISH );
+    out.resize( stream.total_out );
+    deflateEnd( &stream );
+
+    return (err == Z_STREAM_END);
+}
+
+/* Writes a zip with every other file deflated, like a rom set of mixed compressibility */
+int8_t WriteTestZip( const string& location, uint32_t files, string& last )
+{
+    ofstream    fout;
+    string      central;
+    string      header;
+    string      data;
+    string      packed;
+    string      name;
+    uint32_t    offset;
+    uint32_t    crc;
+    uint16_t    method;
+
+    fout.open( location.c_str(), ios_base::trunc|ios_base::binary );
+    if (!fout)
+    {
+        return 1;
+    }
+
+    offset = 0;
+    for (uint32_t i=0; i<files; i++)
+    {
+        char text[32];
+
+        snprintf( text, sizeof(text), "rom%05u.bin", i );
+        name = text;
+
+        data.resize( BENCH_ZIP_SIZE );
+        for (uint32_t j=0; j<data.length(); j++)
+        {
+            data[j] = (char)((j*31 + i) ^ (j >> 5));
+        }
+        crc = crc32( 0, (const Bytef*)data.data(), data.length() );
+
+        method = Z_DEFLATED;
+        if (i%2 == 1 || Deflate( data, packed ) == false)
+        {
+            method = 0;
+            packed = data;
+        }
+
+        header.clear();
+        Write32( header, 0x04034b50 );
+        Write16( header, 20 );
+        Write16( header, 0 );
+        Write16( header, method );
+        Write16( header, 0 );
+        Write16( header, 0x21 );
+        Write32( header, crc );
+        Write32( header, packed.length() );
+        Write32( header, data.length() );
+        Write16( header, name.length() );
+        Write16( header, 0 );
+        fout << header << name << packed;
+
+        Write32( central, 0x02014b50 );
+        Write16( central, 20 );
+        Write16( central, 20 );
+        Write16( central, 0 );
+        Write16( central, method );
+        Write16( central, 0 );
+        Write16( central, 0x21 );
+        Write32( central, crc );
+        Write32( central, packed.length() );
+        Write32( central, data.length() );
+        Write16( central, name.length() );
+        Write16( central, 0 );
+        Write16( central, 0 );
+        Write16( central, 0 );
+        Write16( central, 0 );
+        Write32( central, 0 );
+        Write32( central, offset );
+        central += name;
+
+        offset += header.length() + name.length() + packed.length();
+        last = name;
+    }
+
+    header.clear();
+    Write32( header, 0x06054b50 );
+    Write16( header, 0 );
+    Write16( header, 0 );
+    Write16( header, files );
+    Write16( header, files );
+    Write32( header, central.length() );
+    Write32( header, offset );
+    Write16( header, 0 );
+    fout << central << header;
+    fout.close();
+
+    return fout.fail() ? 1 : 0;
+}
+
+static void BenchListFiles( void* data )
+{
+    zipcase_t* test = static_cast<zipcase_t*>(data);
+
+    test->Files.clear();
+    test->Zip.ListFiles( test->Location, test->Files );
+}
+
+/* Every entry before the last one is walked, the extracted file is synced like at launch */
+static void BenchExtractFile( void* data )
+{
+    zipcase_t* test = static_cast<zipcase_t*>(data);
+
+    test->Zip.ExtractFile( test->Location, BENCH_ZIP_DIR, test->Last );
+}
+
+void BenchZip( CBench& bench )
+{
+    uint32_t    sizes[] = { 100, 1000, 10000 };
+    uint32_t    iterations[] = { 100, 20, 5 };
+    string      suffix;
+    zipcase_t   test;
+
+    for (uint8_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+    {
+        suffix = bench.i_to_a( sizes[i] );
+        if (   (bench.Enabled( "zip_list_" + suffix ) == false)
+            && (bench.Enabled( "zip_extract_last_" + suffix ) == false)
+           )
+        {
+            continue;
+        }
+
+        test.Location = string(BENCH_ZIP) + "_" + suffix + ".zip";
+        if (WriteTestZip( test.Location, sizes[i], test.Last ) || mkdir( BENCH_ZIP_DIR, 0755 ) != 0)
+        {
+            bench.Log( __FILENAME__, __LINE__, "Failed to write test zip %s", test.Location.c_str() );
+            unlink( test.Location.c_str() );
+            continue;
+        }
+
+        bench.Run( "zip_list_" + suffix, iterations[i], BenchListFiles, &test );
+        bench.Run( "zip_extract_last_" + suffix, iterations[i], BenchExtractFile, &test );
+
+        if (bench.Enabled( "zip_list_" + suffix ) && test.Files.size() != sizes[i])
+        {
+            bench.Log( __FILENAME__, __LINE__, "Warning listed %d of %d files in %s", (int32_t)test.Files.size(), sizes[i], test.Location.c_str() );
+        }
+
+        unlink( (string(BENCH_ZIP_DIR) + "/" + test.Last).c_str() );
+        rmdir( BENCH_ZIP_DIR );
+        unlink( test.Location.c_str() );
+    }
+}
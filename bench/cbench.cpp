@@ -0,0 +1,168 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbench.h"
+
+#define BENCH_JSON_NAME     "\"name\": \""           /** Text before the name of a benchmark in the json. */
+#define BENCH_JSON_MIN      "\"min_ns\": "           /** Text before the fastest iteration of a benchmark in the json. */
+
+CBench::CBench() : CBase(),
+        Filter      (""),
+        Results     ()
+{
+}
+
+CBench::~CBench()
+{
+}
+
+void CBench::SetFilter( const string& filter )
+{
+    Filter = filter;
+}
+
+bool CBench::Enabled( const string& name )
+{
+    return (Filter.length() == 0 || name.find(Filter) != string::npos);
+}
+
+uint64_t CBench::Now( void )
+{
+    struct timespec now;
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast<uint64_t>(now.tv_sec)*1000000000ULL + now.tv_nsec;
+}
+
+void CBench::Run( const string& name, uint32_t iterations, benchfunc_t func, void* data )
+{
+    benchresult_t   result;
+    uint64_t        start;
+    uint64_t        elapsed;
+
+    if (Enabled( name ) == false || iterations == 0)
+        return;
+
+    func( data );
+
+    result.Name         = name;
+    result.Iterations   = iterations;
+    result.MinNs        = ~0ULL;
+    for (uint32_t i=0; i<iterations; i++)
+    {
+        start = Now();
+        func( data );
+        elapsed = Now() - start;
+
+        result.TotalNs += elapsed;
+        result.MinNs    = MIN(result.MinNs, elapsed);
+        result.MaxNs    = MAX(result.MaxNs, elapsed);
+    }
+
+    Log( __FILENAME__, __LINE__, "%-40s %8d iters %12.3f us/iter (min %.3f max %.3f)", name.c_str(), iterations,
+         result.TotalNs/1000.0/iterations, result.MinNs/1000.0, result.MaxNs/1000.0 );
+
+    Results.push_back( result );
+}
+
+int8_t CBench::WriteJson( const string& location )
+{
+    ofstream fout;
+
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open benchmark output %s", location.c_str() );
+        return 1;
+    }
+
+    fout << "{" << endl << "  \"benchmarks\": [" << endl;
+    for (uint16_t i=0; i<Results.size(); i++)
+    {
+        const benchresult_t& result = Results.at(i);
+
+        fout << "    { \"name\": \"" << result.Name << "\""
+             << ", \"iterations\": " << result.Iterations
+             << ", \"mean_ns\": " << result.TotalNs/result.Iterations
+             << ", \"min_ns\": " << result.MinNs
+             << ", \"max_ns\": " << result.MaxNs
+             << " }" << (i < Results.size()-1 ? "," : "") << endl;
+    }
+    fout << "  ]" << endl << "}" << endl;
+    fout.close();
+
+    Log( __FILENAME__, __LINE__, "Wrote %d results to %s", static_cast<int32_t>(Results.size()), location.c_str() );
+    return 0;
+}
+
+int8_t CBench::Compare( const string& location )
+{
+    ifstream            fin;
+    string              line;
+    string              name;
+    string::size_type   pos;
+    uint64_t            before;
+    double              product;
+    uint16_t            count;
+
+    fin.open( location.c_str(), ios_base::in );
+    if (!fin)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open benchmark baseline %s", location.c_str() );
+        return 1;
+    }
+
+    // Only reads the lines WriteJson writes, the fastest iteration is the least noisy to compare
+    product = 1.0;
+    count   = 0;
+    while (getline( fin, line ))
+    {
+        pos = line.find( BENCH_JSON_NAME );
+        if (pos == string::npos || line.find( BENCH_JSON_MIN ) == string::npos)
+        {
+            continue;
+        }
+        pos   += strlen( BENCH_JSON_NAME );
+        name   = line.substr( pos, line.find( '"', pos ) - pos );
+        before = strtoull( line.c_str() + line.find( BENCH_JSON_MIN ) + strlen( BENCH_JSON_MIN ), NULL, 10 );
+
+        for (uint16_t i=0; i<Results.size(); i++)
+        {
+            if (Results.at(i).Name.compare( name ) == 0 && before > 0 && Results.at(i).MinNs > 0)
+            {
+                Log( __FILENAME__, __LINE__, "%-40s %12.3f us before %12.3f us now %6.2fx", name.c_str(),
+                     before/1000.0, Results.at(i).MinNs/1000.0, (double)before/Results.at(i).MinNs );
+                product *= (double)before/Results.at(i).MinNs;
+                count++;
+                break;
+            }
+        }
+    }
+    fin.close();
+
+    if (count > 0)
+    {
+        Log( __FILENAME__, __LINE__, "Speedup over %s: %.2fx geometric mean of %d benchmarks", location.c_str(),
+             pow( product, 1.0/count ), count );
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CBENCH_H
+#define CBENCH_H
+
+#include <math.h>
+#include <time.h>
+
+#include "cbase.h"
+
+using namespace std;
+
+#define BENCH_OUTPUT    "bench.json"        /** Default location for the benchmark results. */
+
+#define BENCH_SCAN_MAX      200000              /** Default number of files in the largest synthetic directory. */
+#define BENCH_SCAN_EXTS     4                   /** Default number of extensions the synthetic files are spread over. */
+#define BENCH_SCAN_ENTRIES  1000                /** Default number of profile entries matching synthetic files. */
+#define BENCH_FONT          "DejaVuSansMono-Bold.ttf"   /** Default font named by the config of a training library. */
+
+typedef void (*benchfunc_t)( void* data );  /** A single iteration of a benchmark. */
+
+/** @brief Data structure for the sizes of the generated test data
+ */
+struct benchsettings_t {
+    benchsettings_t() : ScanMax(BENCH_SCAN_MAX), ScanExts(BENCH_SCAN_EXTS), ScanEntries(BENCH_SCAN_ENTRIES) {};
+    uint32_t    ScanMax;            /** @brief Files in the largest synthetic directory, smaller ones are 1k and 20k */
+    uint32_t    ScanExts;           /** @brief Extensions known to the profile the files are spread over */
+    uint32_t    ScanEntries;        /** @brief Profile entries naming files of the directory */
+};
+
+/** @brief Data structure for the timing of one benchmark
+ */
+struct benchresult_t {
+    benchresult_t() : Name(""), Iterations(0), TotalNs(0), MinNs(0), MaxNs(0) {};
+    string      Name;               /** @brief Name of the benchmark */
+    uint32_t    Iterations;         /** @brief Number of timed iterations */
+    uint64_t    TotalNs;            /** @brief Sum of all iterations in nanoseconds */
+    uint64_t    MinNs;              /** @brief Fastest iteration in nanoseconds */
+    uint64_t    MaxNs;              /** @brief Slowest iteration in nanoseconds */
+};
+
+/** @brief This class times benchmark functions and writes the results
+ */
+class CBench : public CBase
+{
+    public:
+        /** Constructor. */
+        CBench();
+        /** Destructor. */
+        virtual ~CBench();
+
+        /** @brief Only run benchmarks whose name contains the filter text
+         * @param filter : text to match, empty runs everything
+         */
+        void        SetFilter   ( const string& filter );
+
+        /** @brief Check if a benchmark will be run, so setup can be skipped
+         * @param name : name of the benchmark
+         * @return true if the benchmark passes the filter
+         */
+        bool        Enabled     ( const string& name );
+
+        /** @brief Time a function, one untimed warmup call is made first
+         * @param name : name of the benchmark
+         * @param iterations : number of timed calls
+         * @param func : function to time
+         * @param data : passed to each call of the function
+         */
+        void        Run         ( const string& name, uint32_t iterations, benchfunc_t func, void* data );
+
+        /** @brief Write all results as a json document
+         * @param location : path to the output file
+         * @return 0 if passed 1 if failed
+         */
+        int8_t      WriteJson   ( const string& location );
+
+        /** @brief Log the speedup of each benchmark over the same one in an earlier json document
+         * @param location : path to the earlier results
+         * @return 0 if passed 1 if failed
+         */
+        int8_t      Compare     ( const string& location );
+
+        /** @brief Read the monotonic clock
+         * @return time in nanoseconds
+         */
+        uint64_t    Now         ( void );
+
+    private:
+        string                  Filter;     /**< Benchmarks must contain this text to be run. */
+        vector<benchresult_t>   Results;    /**< Timings of every benchmark that was run. */
+};
+
+/** @brief Benchmarks for the image scaler compared to the per pixel implementation it replaced, after checking
+ *         that nearest sampling gives the same pixels and that the filters respect the color key and alpha
+ * @param bench : harness to run with
+ * @return 0 if passed 1 if the check failed
+ */
+int8_t BenchScale( CBench& bench );
+
+/** @brief Benchmarks for loading a profile with 50k entries and for the line handling it replaced
+ * @param bench : harness to run with
+ */
+void BenchProfile( CBench& bench );
+
+/** @brief Benchmarks for scanning synthetic directories, sorting the listing and matching extensions
+ * @param bench : harness to run with
+ * @param settings : sizes of the directories and their profile
+ */
+void BenchScan( CBench& bench, const benchsettings_t& settings );
+
+/** @brief Benchmarks for listing and extracting generated zip archives
+ * @param bench : harness to run with
+ */
+void BenchZip( CBench& bench );
+
+/** @brief Benchmarks for the string helpers used when reading profiles and config
+ * @param bench : harness to run with
+ */
+void BenchString( CBench& bench );
+
+/** @brief Write an archive of generated files, half of them deflated and half stored
+ * @param location : path of the archive
+ * @param files : number of files in the archive
+ * @param last : set to the name of the last file
+ * @return 0 if passed 1 if failed
+ */
+int8_t WriteTestZip( const string& location, uint32_t files, string& last );
+
+/** @brief Write a library with a config and profile for the launcher to be trained on, see bench/train.replay
+ * @param bench : harness to log with
+ * @param location : directory of the library
+ * @param font : font the config names
+ * @return 0 if passed 1 if failed
+ */
+int8_t WriteLibrary( CBench& bench, const string& location, const string& font );
+
+#endif // CBENCH_H
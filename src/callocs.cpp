@@ -0,0 +1,205 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "callocs.h"
+
+#if defined(ALLOCS)
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <new>
+
+#include "cbase.h"
+
+/** Steady frames must not allocate in these subsystems */
+#define ALLOC_STEADY(X)     ((X) != ALLOC_OTHER && (X) != ALLOC_TOOLS)
+
+/** glibc lets the program replace malloc so allocations made inside SDL are counted too, elsewhere only
+ *  operator new is counted */
+#if defined(__GLIBC__) && !defined(__UCLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define ALLOCS_MALLOC
+#endif
+
+/* Counts are added atomically where the compiler can, otherwise the other threads may lose a few */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define ALLOC_ADD(X,Y)      __sync_fetch_and_add( &(X), (Y) )
+#else
+#define ALLOC_ADD(X,Y)      ((X) += (Y))
+#endif
+
+static const char* AllocNames[ALLOC_TOTAL] = { "other", "input", "draw", "names", "present", "tools" };
+
+static volatile uint32_t    AllocCounts[ALLOC_TOTAL];       // Allocations since the start
+static volatile uint32_t    AllocBytes[ALLOC_TOTAL];        // Bytes asked for since the start
+static volatile uint32_t    AllocPending[ALLOC_TOTAL];      // Allocations in the frame being drawn
+static uint32_t             AllocDirty[ALLOC_TOTAL];        // Frames that allocated in the subsystem
+static uint32_t             AllocPeak[ALLOC_TOTAL];         // Most allocations in one frame
+static uint32_t             AllocFrames     = 0;
+static uint32_t             AllocLast       = 0;
+static __thread uint8_t     AllocCurrent    = ALLOC_OTHER;  // Subsystem of the calling thread
+
+static void AllocCount( size_t size )
+{
+    uint8_t scope = AllocCurrent;
+
+    ALLOC_ADD( AllocCounts[scope], 1 );
+    ALLOC_ADD( AllocBytes[scope], size );
+    ALLOC_ADD( AllocPending[scope], 1 );
+}
+
+static void AllocLog( const char* message, ... )
+{
+    va_list args;
+
+    va_start( args, message );
+    LogWrite( LOG_INFO, __FILENAME__, __LINE__, message, args );
+    va_end( args );
+}
+
+uint8_t AllocEnter( uint8_t scope )
+{
+    uint8_t previous = AllocCurrent;
+
+    AllocCurrent = (scope < ALLOC_TOTAL) ? scope : (uint8_t)ALLOC_OTHER;
+    return previous;
+}
+
+void AllocFrame( void )
+{
+    uint32_t count;
+
+    AllocFrames++;
+    AllocLast = 0;
+    for (uint8_t scope=0; scope<ALLOC_TOTAL; scope++)
+    {
+        count = AllocPending[scope];
+        ALLOC_ADD( AllocPending[scope], -count );
+
+        if (count > 0)
+        {
+            AllocDirty[scope]++;
+        }
+        if (count > AllocPeak[scope])
+        {
+            AllocPeak[scope] = count;
+        }
+        if (ALLOC_STEADY(scope))
+        {
+            AllocLast += count;
+        }
+    }
+}
+
+uint32_t AllocLastFrame( void )
+{
+    return AllocLast;
+}
+
+void AllocReport( void )
+{
+    AllocLog( "Allocations over %u frames", AllocFrames );
+    for (uint8_t scope=0; scope<ALLOC_TOTAL; scope++)
+    {
+        AllocLog( "Allocations %-8s %8u calls %10u bytes %8u frames allocating %6u most in a frame",
+                  AllocNames[scope], AllocCounts[scope], AllocBytes[scope], AllocDirty[scope], AllocPeak[scope] );
+    }
+}
+
+#if defined(ALLOCS_MALLOC)
+
+extern "C" void* __libc_malloc( size_t size );
+extern "C" void* __libc_calloc( size_t count, size_t size );
+extern "C" void* __libc_realloc( void* pointer, size_t size );
+
+extern "C" void* malloc( size_t size )
+{
+    AllocCount( size );
+    return __libc_malloc( size );
+}
+
+extern "C" void* calloc( size_t count, size_t size )
+{
+    AllocCount( count*size );
+    return __libc_calloc( count, size );
+}
+
+extern "C" void* realloc( void* pointer, size_t size )
+{
+    AllocCount( size );
+    return __libc_realloc( pointer, size );
+}
+
+#else
+
+// Dynamic exception specifications are gone since C++17, the replacements match the declarations of <new>
+#if __cplusplus < 201103L
+#define ALLOC_THROWS        throw(std::bad_alloc)
+#define ALLOC_NOTHROW       throw()
+#else
+#define ALLOC_THROWS
+#define ALLOC_NOTHROW       noexcept
+#endif
+
+void* operator new( size_t size ) ALLOC_THROWS
+{
+    void* pointer;
+
+    AllocCount( size );
+    pointer = malloc( size ? size : 1 );
+    if (pointer == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void* operator new[]( size_t size ) ALLOC_THROWS
+{
+    return operator new( size );
+}
+
+void operator delete( void* pointer ) ALLOC_NOTHROW
+{
+    free( pointer );
+}
+
+void operator delete[]( void* pointer ) ALLOC_NOTHROW
+{
+    free( pointer );
+}
+
+#if defined(__cpp_sized_deallocation)
+// The sized forms are replaced with the others, as -Wsized-deallocation asks
+void operator delete( void* pointer, size_t ) ALLOC_NOTHROW
+{
+    free( pointer );
+}
+
+void operator delete[]( void* pointer, size_t ) ALLOC_NOTHROW
+{
+    free( pointer );
+}
+#endif
+
+#endif // ALLOCS_MALLOC
+
+#endif // ALLOCS
@@ -0,0 +1,97 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CALLOCS_H
+#define CALLOCS_H
+
+#include <stdint.h>
+
+/** Allocations are only counted with -DALLOCS (make ALLOCS=1), debug builds count them as well. */
+#if defined(DEBUG) && !defined(ALLOCS)
+#define ALLOCS
+#endif
+
+#if defined(ALLOCS)
+#define ALLOCS_JOIN(X,Y)    X##Y
+#define ALLOCS_NAME(X,Y)    ALLOCS_JOIN(X,Y)
+#define ALLOCS_SCOPE(X)     CAllocScope ALLOCS_NAME(allocs_scope_,__LINE__)( X )    /**< Count the allocations until the end of the scope to a subsystem. */
+#define ALLOCS_FRAME()      AllocFrame()                                            /**< Mark the end of a frame. */
+#define ALLOCS_REPORT()     AllocReport()                                           /**< Log the counts of each subsystem. */
+#else
+#define ALLOCS_SCOPE(X)
+#define ALLOCS_FRAME()
+#define ALLOCS_REPORT()
+#endif
+
+/** @brief Subsystems the allocations are counted to
+ */
+enum ALLOC_SCOPES_T {
+    ALLOC_OTHER=0,                  /** @brief Anything outside a scope, including the other threads */
+    ALLOC_INPUT,                    /** @brief Polling the inputs and selecting the mode */
+    ALLOC_DRAW,                     /** @brief Drawing the screen */
+    ALLOC_NAMES,                    /** @brief Drawing the names of the list */
+    ALLOC_PRESENT,                  /** @brief Presenting the frame */
+    ALLOC_TOOLS,                    /** @brief Measuring, the performance display and the replay, not part of a steady frame */
+    ALLOC_TOTAL
+};
+
+#if defined(ALLOCS)
+
+/** @brief Set the subsystem the allocations of the calling thread are counted to.
+ * @param scope : the subsystem (index is defined in ALLOC_SCOPES_T)
+ * @return the subsystem set before
+ */
+uint8_t     AllocEnter      ( uint8_t scope );
+
+/** @brief Close the counts of a frame.
+ */
+void        AllocFrame      ( void );
+
+/** @brief Get the allocations the last frame made, only the subsystems of a steady frame are included.
+ * @return number of allocations
+ */
+uint32_t    AllocLastFrame  ( void );
+
+/** @brief Log the allocations, bytes and frames with allocations of each subsystem.
+ */
+void        AllocReport     ( void );
+
+/** @brief Counts the allocations in a scope to a subsystem, use ALLOCS_SCOPE to create one
+ */
+class CAllocScope
+{
+    public:
+        /** Constructor. */
+        CAllocScope( uint8_t scope ) : Previous(AllocEnter(scope)) {}
+        /** Destructor. */
+        ~CAllocScope() { AllocEnter( Previous ); }
+
+    private:
+        CAllocScope(const CAllocScope &);
+        CAllocScope & operator=(const CAllocScope&);
+
+        uint8_t         Previous;       /**< Subsystem to restore at the end of the scope. */
+};
+
+#endif // ALLOCS
+
+#endif // CALLOCS_H
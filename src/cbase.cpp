@@ -33,31 +33,19 @@ CBase::~CBase()
 void CBase::Log( const char* file, const int32_t line, const char* message, ... )
 {
     va_list fmtargs;
-    char buffer[1024];
 
     va_start( fmtargs, message );
-    vsnprintf( buffer, sizeof(buffer)-1, message, fmtargs );
+    LogWrite( LOG_INFO, file, line, message, fmtargs );
     va_end( fmtargs );
+}
 
-    if (file != NULL)
-    {
-        fprintf( stdout, "%-50s file:%-15s line:%d\n", buffer, file, line );
-    }
-    else
-    {
-        fprintf( stdout, "%s\n", buffer );
-    }
+void CBase::LogAt( uint8_t level, const char* file, const int32_t line, const char* message, ... )
+{
+    va_list fmtargs;
 
-#if defined(DEBUG)
-    FILE* fout = fopen( "/tmp/log.txt", "a" );
-    if (!fout)
-    {
-        printf( "Failed to open logfile\n" );
-        return;
-    }
-    fputs(buffer, fout);
-    fclose(fout);
-#endif
+    va_start( fmtargs, message );
+    LogWrite( level, file, line, message, fmtargs );
+    va_end( fmtargs );
 }
 
 uint32_t CBase::CheckRange( int32_t value, int32_t size )
@@ -115,6 +103,7 @@ SDL_Surface* CBase::LoadImage( const string& filename )
     SDL_Surface* loaded_image    = NULL; // The mpImage that's loaded
     SDL_Surface* optimized_image = NULL; // The optimized surface that will be used
 
+    IoCount( IO_IMAGE );
     loaded_image = IMG_Load( filename.c_str() ); //Load the mpImage
 
     // If the mpImage loaded
@@ -296,28 +285,54 @@ string CBase::strreplace( string& orig, const string& search, const string& repl
     return orig;
 }
 
-SDL_Surface* CBase::ScaleSurface( SDL_Surface *surface, uint16_t width, uint16_t height )
+int8_t CBase::SyncFile( const string& path )
+{
+    int32_t fd;
+    int8_t  result;
+
+    fd = open( path.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to open %s for flushing: %s", path.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    result = 0;
+    if (fsync( fd ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to flush %s: %s", path.c_str(), strerror(errno) );
+        result = 1;
+    }
+    close( fd );
+    return result;
+}
+
+SDL_Surface* CBase::ScaleSurface( SDL_Surface *surface, uint16_t width, uint16_t height, uint8_t mode )
 {
+    TRACE_SPAN( "CBase::ScaleSurface" );
+
     if((!surface) || (!width) || (!height))
         return 0;
 
     SDL_Surface *_ret = SDL_CreateRGBSurface(surface->flags, width, height, surface->format->BitsPerPixel,
         surface->format->Rmask, surface->format->Gmask, surface->format->Bmask, surface->format->Amask);
 
-    double _stretch_factor_x = ( static_cast<double>(width) / static_cast<double>(surface->w) );
-    double _stretch_factor_y = ( static_cast<double>(height) / static_cast<double>(surface->h) );
+    if (_ret == NULL)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to create scaled surface %dx%d: %s", width, height, SDL_GetError() );
+        return NULL;
+    }
 
 #if defined(DEBUG)
-    Log( __FILENAME__, __LINE__, "Scaling image %dx%d to %dx%d at BPP %d/%d", surface->w, surface->h, width, height, surface->format->BitsPerPixel, surface->format->BytesPerPixel);
-    Log( __FILENAME__, __LINE__, "  scale factor %f x %f", _stretch_factor_x, _stretch_factor_y );
+    Log( __FILENAME__, __LINE__, "Scaling image %dx%d to %dx%d at BPP %d/%d mode %d", surface->w, surface->h, width, height, surface->format->BitsPerPixel, surface->format->BytesPerPixel, mode );
 #endif
 
-    for (int32_t y = 0; y < surface->h; y++)
-        for (int32_t x = 0; x < surface->w; x++)
-            for (int32_t o_y = 0; o_y < _stretch_factor_y; ++o_y)
-                for (int32_t o_x = 0; o_x < _stretch_factor_x; ++o_x)
-                    putpixel( _ret, static_cast<int32_t>(_stretch_factor_x * x) + o_x,
-                        static_cast<int32_t>(_stretch_factor_y * y) + o_y, getpixel(surface, x, y) );
+    if (ScalePixels( surface, _ret, mode ))
+    {
+        Log( __FILENAME__, __LINE__, "Failed to scale image %dx%d to %dx%d", surface->w, surface->h, width, height );
+        SDL_FreeSurface( _ret );
+        return NULL;
+    }
 
     if (surface->format->BitsPerPixel <= 8) {
 #if SDL_VERSION_ATLEAST(2,0,0)
@@ -330,68 +345,11 @@ SDL_Surface* CBase::ScaleSurface( SDL_Surface *surface, uint16_t width, uint16_t
     return _ret;
 }
 
-uint32_t CBase::getpixel( SDL_Surface *surface, int16_t x, int16_t y )
-{
-    int16_t bpp = surface->format->BytesPerPixel;
-    /* Here p is the address to the pixel we want to retrieve */
-    uint8_t *p = static_cast<uint8_t*>(surface->pixels) + (y * surface->pitch) + (x * bpp);
-
-    switch (bpp) {
-        case 1:
-            //Log( __FILENAME__, __LINE__, "%dx%d %X", x, y, *p );
-            return *p;
-            break;
-
-        case 2:
-            return *(uint16_t *)p;
-            break;
-
-        case 3:
-            if(SDL_BYTEORDER == SDL_BIG_ENDIAN)
-                return p[0] << 16 | p[1] << 8 | p[2];
-            else
-                return p[0] | p[1] << 8 | p[2] << 16;
-            break;
-
-        case 4:
-            return *(uint32_t *)p;
-            break;
-
-        default:
-            return 0;       /* shouldn't happen, but avoids warnings */
-    }
-}
-
-void CBase::putpixel( SDL_Surface *surface, int16_t x, int16_t y, uint32_t pixel )
+uint32_t CBase::SurfaceBytes( SDL_Surface* surface )
 {
-    int16_t bpp = surface->format->BytesPerPixel;
-    /* Here p is the address to the pixel we want to set */
-    uint8_t *p = static_cast<uint8_t*>(surface->pixels) + (y * surface->pitch) + (x * bpp);
-
-    switch (bpp) {
-        case 1:
-            *p = pixel;
-            break;
-
-        case 2:
-            *(uint16_t *)p = pixel;
-            break;
-
-        case 3:
-            if(SDL_BYTEORDER == SDL_BIG_ENDIAN) {
-                p[0] = (pixel >> 16) & 0xff;
-                p[1] = (pixel >> 8) & 0xff;
-                p[2] = pixel & 0xff;
-            } else {
-                p[0] = pixel & 0xff;
-                p[1] = (pixel >> 8) & 0xff;
-                p[2] = (pixel >> 16) & 0xff;
-            }
-            break;
-
-        case 4:
-        default:
-            *(uint32_t *)p = pixel;
-            break;
+    if (surface == NULL)
+    {
+        return 0;
     }
+    return surface->h*surface->pitch + sizeof(SDL_Surface);
 }
@@ -44,12 +44,20 @@
 #include "SDL_ttf.h"
 #include "SDL_image.h"
 
+#include "clog.h"
+#include "ctrace.h"
+#include "callocs.h"
+#include "ciostats.h"
+#include "cscaler.h"
+
 using namespace std;
 
 #define MIN(X,Y) ((X) < (Y) ? (X) : (Y))    /**< Return minimum of two numbers. */
 #define MAX(X,Y) ((X) > (Y) ? (X) : (Y))    /**< Return maximum of two numbers. */
 #define __FILENAME__ (strrchr(__FILE__, '/') ? strrchr(__FILE__, '/') + 1 : __FILE__)
 
+#define FREE_IMAGE(X)   if (X != NULL) { SDL_FreeSurface(X); X = NULL; } /**< Macro for checking and releasing pointers to pixel data. */
+
 #if SDL_VERSION_ATLEAST(2,0,0)
 #define LOAD_IMAGE(x)   LoadImage(x,Window)
 #else /* SDL 1.2 */
@@ -73,6 +81,15 @@ class CBase
          */
         void            Log( const char* file, const int32_t line, const char* message, ... );
 
+        /** @brief Logging function for messages with a level other than LOG_INFO, messages in loops should
+         *         be guarded by LogEnabled so the arguments are not prepared when the level is off
+         * @param level : level of the message (defined by LOG_ERROR to LOG_TRACE)
+         * @param file : the path where the message was sent
+         * @param line : the numeric line the message was sent
+         * @param message : formatting string to write to the log
+         */
+        void            LogAt( uint8_t level, const char* file, const int32_t line, const char* message, ... );
+
         /** @brief Checks a value is between 0 and size
          * @param value : value for the range check
          * @param size : max that the value should be less than
@@ -171,28 +188,26 @@ class CBase
          */
         string          strreplace          ( string& orig, const string& search, const string& replace );
 
+        /** @brief Write the data of a file to storage
+         * @param path : file to flush
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          SyncFile            ( const string& path );
+
         /** @brief Scales the input surface to a new surface with the dimensions provided
          * @param surface : input image to be scaled
          * @param width : width of the new scaled image
          * @param height : height of the new scaled image
+         * @param mode : filter to use for scaling (index is defined in SCALE_MODE_T)
          * @return the new scaled image
          */
-        SDL_Surface*    ScaleSurface        ( SDL_Surface *surface, uint16_t width, uint16_t height );
-
-        /** @brief Gets the pixel data at the provided coordinates
-         * @param surface : input image to be read
-         * @param x : x position of the pixel
-         * @param y : y position of the pixel
-         * @return pixel data
-         */
-        uint32_t        getpixel            ( SDL_Surface *surface, int16_t x, int16_t y );
+        SDL_Surface*    ScaleSurface        ( SDL_Surface *surface, uint16_t width, uint16_t height, uint8_t mode );
 
-        /** @brief Writes the pixel data at the provided coordinates
-         * @param surface : input image to be modified
-         * @param x : x position of the pixel
-         * @param y : y position of the pixel
+        /** @brief Get the bytes of memory held by a surface
+         * @param surface : the surface, may be NULL
+         * @return the size of the pixels and the surface structure
          */
-        void            putpixel            ( SDL_Surface *surface, int16_t x, int16_t y, uint32_t pixel );
+        uint32_t        SurfaceBytes        ( SDL_Surface* surface );
 };
 
 #endif // CBASE_H
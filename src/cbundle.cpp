@@ -0,0 +1,419 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbundle.h"
+
+#include <string.h>
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+#define BUNDLE_COLORKEY     SDL_TRUE
+#else /* SDL 1.2 */
+#define BUNDLE_COLORKEY     SDL_RLEACCEL | SDL_SRCCOLORKEY
+#endif
+
+#define BUNDLE_ALIGNED(X)   (((X)+BUNDLE_ALIGN-1) & ~(BUNDLE_ALIGN-1))
+
+CBundle::CBundle() : CBase(),
+        Dirty       (false),
+        Path        (""),
+        Settings    (0),
+        Map         (NULL),
+        MapLength   (0),
+        Table       (),
+        Assets      ()
+{
+}
+
+CBundle::~CBundle()
+{
+    Close();
+}
+
+int8_t CBundle::Open( const string& path, SDL_PixelFormat* format, uint16_t width, uint16_t height, uint8_t mode )
+{
+    int32_t                 fd;
+    struct stat             info;
+    stringstream            settings;
+    const bundleheader_t*   header;
+    const bundleentry_t*    entries;
+
+    Close();
+
+    Path = path;
+    if (Path.length() == 0)
+    {
+        return 0;
+    }
+
+    settings << width << "x" << height << ":" << (int32_t)mode << ":" << (int32_t)format->BitsPerPixel << ":"
+             << hex << format->Rmask << ":" << format->Gmask << ":" << format->Bmask << ":" << format->Amask;
+    Settings = Hash( settings.str() );
+
+    // Until proven otherwise the bundle has to be built
+    Dirty = true;
+
+    fd = open( Path.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    if (fstat( fd, &info ) != 0 || info.st_size < (off_t)sizeof(bundleheader_t))
+    {
+        close( fd );
+        return 0;
+    }
+
+    // Private and writable so SDL may touch the pixels without changing the file
+    MapLength = info.st_size;
+    Map = mmap( NULL, MapLength, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (Map == MAP_FAILED)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to map bundle %s: %s", Path.c_str(), strerror(errno) );
+        Map = NULL;
+        MapLength = 0;
+        return 1;
+    }
+
+    header = static_cast<const bundleheader_t*>(Map);
+    if (header->Magic   != BUNDLE_MAGIC     ||
+        header->Version != BUNDLE_VERSION   ||
+        header->Settings!= Settings         ||
+        MapLength < sizeof(bundleheader_t) + header->Count*sizeof(bundleentry_t))
+    {
+        Log( __FILENAME__, __LINE__, "Bundle %s is out of date and will be rebuilt", Path.c_str() );
+        munmap( Map, MapLength );
+        Map = NULL;
+        MapLength = 0;
+        return 0;
+    }
+
+    entries = reinterpret_cast<const bundleentry_t*>(header+1);
+    for (uint16_t i=0; i<header->Count; i++)
+    {
+        if ((size_t)entries[i].Offset + entries[i].Length <= MapLength)
+        {
+            Table[entries[i].KeyHash] = &entries[i];
+        }
+    }
+
+    Dirty = false;
+    return 0;
+}
+
+int8_t CBundle::Save( void )
+{
+    int32_t                 fd;
+    bool                    failed;
+    uint32_t                offset;
+    uint32_t                position;
+    string                  temporary;
+    bundleheader_t          header;
+    vector<bundleentry_t>   entries;
+    uint8_t                 padding[BUNDLE_ALIGN];
+    list<bundleasset_t>::iterator it;
+
+    if (Path.length() == 0 || Dirty == false)
+    {
+        return 0;
+    }
+
+    memset( &header, 0, sizeof(header) );
+    header.Magic    = BUNDLE_MAGIC;
+    header.Version  = BUNDLE_VERSION;
+    header.Count    = Assets.size();
+    header.Settings = Settings;
+
+    offset = BUNDLE_ALIGNED( sizeof(bundleheader_t) + Assets.size()*sizeof(bundleentry_t) );
+    for (it=Assets.begin(); it!=Assets.end(); it++)
+    {
+        entries.push_back( it->Entry );
+        entries.back().Offset = offset;
+        offset = BUNDLE_ALIGNED( offset + it->Entry.Length );
+    }
+
+    temporary = Path + ".tmp";
+    fd = open( temporary.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+    if (fd < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write bundle %s: %s", temporary.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    memset( padding, 0, sizeof(padding) );
+    failed   = (write( fd, &header, sizeof(header) ) != (ssize_t)sizeof(header));
+    position = sizeof(header);
+    if (failed == false && entries.size() > 0)
+    {
+        failed    = (write( fd, &entries.at(0), entries.size()*sizeof(bundleentry_t) ) != (ssize_t)(entries.size()*sizeof(bundleentry_t)));
+        position += entries.size()*sizeof(bundleentry_t);
+    }
+
+    it = Assets.begin();
+    for (uint16_t i=0; i<entries.size() && failed == false; i++, it++)
+    {
+        if (position < entries.at(i).Offset)
+        {
+            failed   = (write( fd, padding, entries.at(i).Offset-position ) != (ssize_t)(entries.at(i).Offset-position));
+            position = entries.at(i).Offset;
+        }
+        if (failed == false)
+        {
+            failed    = (write( fd, it->Data, it->Entry.Length ) != (ssize_t)it->Entry.Length);
+            position += it->Entry.Length;
+        }
+    }
+
+    if (close( fd ) != 0)
+    {
+        failed = true;
+    }
+
+    // The old bundle stays mapped, renaming over it does not disturb the surfaces using it
+    if (failed == true || rename( temporary.c_str(), Path.c_str() ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write bundle %s: %s", Path.c_str(), strerror(errno) );
+        unlink( temporary.c_str() );
+        return 1;
+    }
+
+    Log( __FILENAME__, __LINE__, "Wrote bundle %s with %d assets", Path.c_str(), (int32_t)entries.size() );
+    Dirty = false;
+
+    // Copied images are only needed for writing, fonts still read from their copy
+    for (it=Assets.begin(); it!=Assets.end(); )
+    {
+        if (it->Entry.Type == BUNDLE_IMAGE && it->Copy.size() > 0)
+        {
+            it = Assets.erase( it );
+        }
+        else
+        {
+            it++;
+        }
+    }
+    return 0;
+}
+
+void CBundle::Close( void )
+{
+    Table.clear();
+    Assets.clear();
+    if (Map != NULL)
+    {
+        munmap( Map, MapLength );
+        Map = NULL;
+        MapLength = 0;
+    }
+    Dirty = false;
+}
+
+SDL_Surface* CBundle::Image( const string& source, uint16_t width, uint16_t height )
+{
+    bundleasset_t*  asset;
+    SDL_Surface*    image;
+
+    asset = Find( BUNDLE_IMAGE, source, width, height );
+    if (asset == NULL || asset->Entry.Length < asset->Entry.Pitch*asset->Entry.Height)
+    {
+        return NULL;
+    }
+
+    image = SDL_CreateRGBSurfaceFrom( const_cast<uint8_t*>(asset->Data), asset->Entry.Width, asset->Entry.Height,
+                                      asset->Entry.BitsPerPixel, asset->Entry.Pitch,
+                                      asset->Entry.Rmask, asset->Entry.Gmask, asset->Entry.Bmask, asset->Entry.Amask );
+    if (image != NULL && asset->Entry.ColorKey != 0)
+    {
+        SDL_SetColorKey( image, BUNDLE_COLORKEY, SDL_MapRGB( image->format, 0xFF, 0, 0xFF ) );
+    }
+    return image;
+}
+
+void CBundle::AddImage( const string& source, uint16_t width, uint16_t height, SDL_Surface* image )
+{
+    bundleasset_t*  asset;
+    uint32_t        length;
+    uint8_t*        row;
+
+    if (Path.length() == 0 || image == NULL)
+    {
+        return;
+    }
+
+    asset = Add( BUNDLE_IMAGE, source, width, height );
+    if (asset == NULL)
+    {
+        return;
+    }
+
+    // Rows are stored without the surface padding, rounded up to keep them 4 byte aligned
+    length = image->w*image->format->BytesPerPixel;
+    asset->Entry.Width          = image->w;
+    asset->Entry.Height         = image->h;
+    asset->Entry.Pitch          = (length+3) & ~3;
+    asset->Entry.Length         = asset->Entry.Pitch*image->h;
+    asset->Entry.BitsPerPixel   = image->format->BitsPerPixel;
+#if SDL_VERSION_ATLEAST(2,0,0)
+    asset->Entry.ColorKey       = (SDL_GetColorKey( image, NULL ) == 0) ? 1 : 0;
+#else /* SDL 1.2 */
+    asset->Entry.ColorKey       = (image->flags & SDL_SRCCOLORKEY) ? 1 : 0;
+#endif
+    asset->Entry.Rmask          = image->format->Rmask;
+    asset->Entry.Gmask          = image->format->Gmask;
+    asset->Entry.Bmask          = image->format->Bmask;
+    asset->Entry.Amask          = image->format->Amask;
+
+    asset->Copy.resize( MAX(asset->Entry.Length, 1) );
+    asset->Data = &asset->Copy.at(0);
+
+    if (SDL_MUSTLOCK(image))
+    {
+        SDL_LockSurface( image );
+    }
+    for (int32_t y=0; y<image->h; y++)
+    {
+        row = static_cast<uint8_t*>(image->pixels) + y*image->pitch;
+        memcpy( &asset->Copy.at(y*asset->Entry.Pitch), row, length );
+    }
+    if (SDL_MUSTLOCK(image))
+    {
+        SDL_UnlockSurface( image );
+    }
+}
+
+TTF_Font* CBundle::Font( const string& source, uint16_t size )
+{
+    bundleasset_t*  asset;
+    ifstream        fin;
+
+    if (Path.length() == 0)
+    {
+        return TTF_OpenFont( source.c_str(), size );
+    }
+
+    asset = Find( BUNDLE_FILE, source, 0, 0 );
+    if (asset == NULL)
+    {
+        asset = Add( BUNDLE_FILE, source, 0, 0 );
+        if (asset == NULL || asset->Entry.SourceSize <= 0)
+        {
+            return TTF_OpenFont( source.c_str(), size );
+        }
+
+        asset->Copy.resize( asset->Entry.SourceSize );
+        fin.open( source.c_str(), ios_base::in|ios_base::binary );
+        fin.read( reinterpret_cast<char*>(&asset->Copy.at(0)), asset->Copy.size() );
+        if (!fin)
+        {
+            Log( __FILENAME__, __LINE__, "Warning failed to read %s into the bundle", source.c_str() );
+            Assets.pop_back();
+            return TTF_OpenFont( source.c_str(), size );
+        }
+        asset->Entry.Length = asset->Copy.size();
+        asset->Data         = &asset->Copy.at(0);
+    }
+
+    // The sizes share one copy of the file, it stays in memory until Close
+    return TTF_OpenFontRW( SDL_RWFromConstMem( asset->Data, asset->Entry.Length ), 1, size );
+}
+
+bundleasset_t* CBundle::Find( uint8_t type, const string& source, uint16_t width, uint16_t height )
+{
+    uint64_t        key;
+    struct stat     info;
+    bundleasset_t   asset;
+    map<uint64_t, const bundleentry_t*>::iterator found;
+
+    if (Path.length() == 0)
+    {
+        return NULL;
+    }
+
+    key = Key( type, source, width, height );
+    for (list<bundleasset_t>::iterator it=Assets.begin(); it!=Assets.end(); it++)
+    {
+        if (it->Entry.KeyHash == key)
+        {
+            return &(*it);
+        }
+    }
+
+    found = Table.find( key );
+    if (found == Table.end())
+    {
+        return NULL;
+    }
+
+    if (stat( source.c_str(), &info ) != 0               ||
+        found->second->SourceTime != (int64_t)info.st_mtime ||
+        found->second->SourceSize != (int64_t)info.st_size)
+    {
+        return NULL;
+    }
+
+    asset.Entry = *found->second;
+    asset.Data  = static_cast<const uint8_t*>(Map) + found->second->Offset;
+    Assets.push_back( asset );
+    return &Assets.back();
+}
+
+bundleasset_t* CBundle::Add( uint8_t type, const string& source, uint16_t width, uint16_t height )
+{
+    struct stat     info;
+    bundleasset_t   asset;
+
+    if (stat( source.c_str(), &info ) != 0)
+    {
+        return NULL;
+    }
+
+    memset( &asset.Entry, 0, sizeof(asset.Entry) );
+    asset.Entry.KeyHash     = Key( type, source, width, height );
+    asset.Entry.SourceTime  = info.st_mtime;
+    asset.Entry.SourceSize  = info.st_size;
+    asset.Entry.Type        = type;
+
+    Dirty = true;
+    Assets.push_back( asset );
+    return &Assets.back();
+}
+
+uint64_t CBundle::Hash( const string& text )
+{
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (uint32_t i=0; i<text.length(); i++)
+    {
+        hash ^= (uint8_t)text.at(i);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+uint64_t CBundle::Key( uint8_t type, const string& source, uint16_t width, uint16_t height )
+{
+    stringstream key;
+
+    key << (int32_t)type << ":" << source << ":" << width << "x" << height;
+    return Hash( key.str() );
+}
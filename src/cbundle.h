@@ -0,0 +1,183 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CBUNDLE_H
+#define CBUNDLE_H
+
+#include <list>
+#include <map>
+
+#include "cbase.h"
+
+using namespace std;
+
+#define BUNDLE_MAGIC        0x4E424C50      /** "PLBN" identifies a bundle file. */
+#define BUNDLE_VERSION      1               /** Incremented when the layout of the bundle file changes. */
+#define BUNDLE_ALIGN        16              /** Alignment of each asset in the bundle file. */
+
+/** @brief Kinds of assets stored in a bundle
+ */
+enum BUNDLE_TYPES_T {
+    BUNDLE_IMAGE=0,                 /** @brief Surface in the screen format */
+    BUNDLE_FILE                     /** @brief Unmodified contents of a file */
+};
+
+/** @brief Header at the start of a bundle file, followed by the asset table
+ */
+struct bundleheader_t {
+    uint32_t    Magic;              /** @brief Always BUNDLE_MAGIC */
+    uint16_t    Version;            /** @brief Always BUNDLE_VERSION */
+    uint16_t    Count;              /** @brief Number of assets in the table */
+    uint64_t    Settings;           /** @brief Hash of the screen settings the images were converted for */
+};
+
+/** @brief Entry in the asset table of a bundle file
+ */
+struct bundleentry_t {
+    uint64_t    KeyHash;            /** @brief Hash of the type, source path and target size */
+    int64_t     SourceTime;         /** @brief Modification time of the source file */
+    int64_t     SourceSize;         /** @brief Size in bytes of the source file */
+    uint32_t    Offset;             /** @brief Start of the data from the beginning of the file */
+    uint32_t    Length;             /** @brief Length of the data */
+    uint16_t    Width;              /** @brief Width of the image */
+    uint16_t    Height;             /** @brief Height of the image */
+    uint32_t    Pitch;              /** @brief Bytes per row of the image */
+    uint8_t     Type;               /** @brief Kind of asset (index is defined in BUNDLE_TYPES_T) */
+    uint8_t     BitsPerPixel;       /** @brief Depth of the image */
+    uint8_t     ColorKey;           /** @brief 1 if the magenta color key is applied to the image */
+    uint8_t     Reserved;           /** @brief Always 0 */
+    uint32_t    Rmask;              /** @brief Red mask of the image */
+    uint32_t    Gmask;              /** @brief Green mask of the image */
+    uint32_t    Bmask;              /** @brief Blue mask of the image */
+    uint32_t    Amask;              /** @brief Alpha mask of the image */
+};
+
+/** @brief Data structure for an asset used since the bundle was opened
+ */
+struct bundleasset_t {
+    bundleasset_t() : Entry(), Data(NULL), Copy() {};
+    bundleentry_t       Entry;      /** @brief Table entry describing the asset */
+    const uint8_t*      Data;       /** @brief Points into the mapping or at Copy */
+    vector<uint8_t>     Copy;       /** @brief Data of an asset that was not in the bundle */
+};
+
+/** @brief This class keeps the launcher graphics and font in one file, already converted for the screen, and maps
+ *         it at startup. Assets that are missing or older than their source are loaded normally by the caller and
+ *         the bundle is rewritten by Save.
+ */
+class CBundle : public CBase
+{
+    public:
+        /** Constructor. */
+        CBundle();
+        /** Destructor. */
+        virtual ~CBundle();
+
+        /** @brief Map the bundle if it was built for the current screen settings.
+         * @param path : location of the bundle file, empty disables the bundle
+         * @param format : pixel format of the screen
+         * @param width : width of the screen
+         * @param height : height of the screen
+         * @param mode : filter used to scale images (index is defined in SCALE_MODE_T)
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( const string& path, SDL_PixelFormat* format, uint16_t width, uint16_t height, uint8_t mode );
+
+        /** @brief Write the bundle again if any asset had to be loaded from its source.
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Save        ( void );
+
+        /** @brief Unmap the bundle, every surface and font from it must have been freed.
+         */
+        void            Close       ( void );
+
+        /** @brief Get an image from the bundle.
+         * @param source : path to the image
+         * @param width : width the image was scaled to, 0 if not scaled
+         * @param height : height the image was scaled to, 0 if not scaled
+         * @return surface with the pixels in the bundle, NULL if the caller must load the image and call AddImage
+         */
+        SDL_Surface*    Image       ( const string& source, uint16_t width, uint16_t height );
+
+        /** @brief Store an image loaded by the caller in the next bundle.
+         * @param source : path to the image
+         * @param width : width the image was scaled to, 0 if not scaled
+         * @param height : height the image was scaled to, 0 if not scaled
+         * @param image : the loaded image, it is copied
+         */
+        void            AddImage    ( const string& source, uint16_t width, uint16_t height, SDL_Surface* image );
+
+        /** @brief Open a font from the bundle, reading the file into it first if needed.
+         * @param source : path to the ttf file
+         * @param size : point size of the font
+         * @return the font or NULL if it failed
+         */
+        TTF_Font*       Font        ( const string& source, uint16_t size );
+
+    private:
+        /** @brief Find an asset that is up to date with its source.
+         * @param type : kind of asset (index is defined in BUNDLE_TYPES_T)
+         * @param source : path to the source file
+         * @param width : width of the image, 0 for files
+         * @param height : height of the image, 0 for files
+         * @return the asset or NULL if it must be loaded from the source
+         */
+        bundleasset_t*  Find        ( uint8_t type, const string& source, uint16_t width, uint16_t height );
+
+        /** @brief Add an asset that was loaded from its source.
+         * @param type : kind of asset (index is defined in BUNDLE_TYPES_T)
+         * @param source : path to the source file
+         * @param width : width of the image, 0 for files
+         * @param height : height of the image, 0 for files
+         * @return the new asset, NULL if the source does not exist
+         */
+        bundleasset_t*  Add         ( uint8_t type, const string& source, uint16_t width, uint16_t height );
+
+        /** @brief Compute an FNV-1a hash.
+         * @param text : the values to hash
+         * @return the hash
+         */
+        uint64_t        Hash        ( const string& text );
+
+        /** @brief Compute the identifying hash of an asset.
+         * @param type : kind of asset (index is defined in BUNDLE_TYPES_T)
+         * @param source : path to the source file
+         * @param width : width of the image, 0 for files
+         * @param height : height of the image, 0 for files
+         * @return the hash
+         */
+        uint64_t        Key         ( uint8_t type, const string& source, uint16_t width, uint16_t height );
+
+        CBundle(const CBundle &);
+        CBundle & operator=(const CBundle&);
+
+        bool                            Dirty;      /**< An asset was loaded from its source since the bundle was opened. */
+        string                          Path;       /**< Location of the bundle file, empty if disabled. */
+        uint64_t                        Settings;   /**< Hash of the screen settings. */
+        void*                           Map;        /**< Start of the mapped bundle, NULL if not mapped. */
+        size_t                          MapLength;  /**< Length of the mapped bundle. */
+        map<uint64_t, const bundleentry_t*> Table;  /**< Lookup from key into the table of the mapped bundle. */
+        list<bundleasset_t>             Assets;     /**< Assets used since the bundle was opened, kept for Save. */
+};
+
+#endif // CBUNDLE_H
@@ -46,12 +46,17 @@ CConfig::CConfig() : CBase(),
         UnusedKeysLaunch        (false),
         UnusedJoysLaunch        (false),
         ReloadLauncher          (true),
+        Supervisor              (false),
+        LaunchShell             (false),
+        Readahead               (true),
         TextScrollOption        (true),
         AutoLayout              (true),
         FilenameArgNoExt        (false),
         FilenameAbsPath         (true),
         EntryFastMode           (ENTRY_FAST_MODE_FILTER),
         MaxEntries              (MAX_ENTRIES),
+        ScaleMode               (SCALE_BOX),
+        LogLevel                (LOG_LEVEL),
         ColorButton             (COLOR_BLUE),
         ColorFontButton         (COLOR_WHITE),
         ColorBackground         (COLOR_WHITE),
@@ -63,6 +68,10 @@ CConfig::CConfig() : CBase(),
         ScreenDepth             (SCREEN_DEPTH),
         PrevEntryIndex          (0),
         CPUClock                (CPU_CLOCK_DEF),
+        PreviewCache            (PREVIEW_CACHE),
+        MemoryLimit             (MEMORY_LIMIT),
+        ReadaheadDwell          (READAHEAD_DWELL),
+        JournalLimit            (JOURNAL_LIMIT),
         ScrollSpeed             (SCROLL_SPEED),
         ScrollPauseSpeed        (SCROLL_PAUSE_SPEED),
         PathYDelta              (0),
@@ -89,6 +98,9 @@ CConfig::CConfig() : CBase(),
         ScreenRatioH            ((float)ScreenHeight/(float)BASE_HEIGHT),
         ZipPath                 ("ziptemp"),
         PreviewsPath            ("previews"),
+        ThumbnailsPath          ("thumbnails"),
+        BundlePath              ("assets.bin"),
+        SnapshotPath            ("snapshot.bin"),
         PathFont                ("DejaVuSansMono-Bold.ttf"),
         PathBackground          ("images/background.png"),
         PathPointer             ("images/pointer.png"),
@@ -101,9 +113,12 @@ CConfig::CConfig() : CBase(),
         JoyMaps                 (),
         FontSizes               (),
         Colors                  (),
-        ColorNames              ()
+        ColorNames              (),
+        Options                 (),
+        OptionIndices           ()
 {
     SetDefaults();
+    DefineOptions();
 }
 
 CConfig::~CConfig()
@@ -129,6 +144,7 @@ void CConfig::SetDefaults( void )
     KeyMaps.at(EVENT_SELECT)     = SDLK_RETURN;
     KeyMaps.at(EVENT_BACK)       = SDLK_LCTRL;
     KeyMaps.at(EVENT_QUIT)       = SDLK_ESCAPE;
+    KeyMaps.at(EVENT_HUD)        = SDLK_F12;
 
     JoyMaps.resize(EVENT_TOTAL);
     JoyMaps.at(EVENT_ONE_UP)     = 0;
@@ -144,6 +160,7 @@ void CConfig::SetDefaults( void )
     JoyMaps.at(EVENT_SELECT)     = 10;
     JoyMaps.at(EVENT_BACK)       = 11;
     JoyMaps.at(EVENT_QUIT)       = 12;
+    JoyMaps.at(EVENT_HUD)        = JOY_UNMAPPED;
 
     PathButtons.resize(EVENT_TOTAL);
     PathButtons.at(EVENT_ONE_UP)        = "images/button_oneup.png";
@@ -199,17 +216,259 @@ void CConfig::SetDefaults( void )
     FilePathMaxWidth    = (int16_t)FILEPATH_MAX_W;
 }
 
-#define LOAD_INT(X,Y)  if (UnprefixString( line, line, X ) == true) { Y = a_to_i(line); }
-#define LOAD_KEY(X,Y)  if (UnprefixString( line, line, X ) == true) { Y = (KeyCode)a_to_i(line); }
-#define LOAD_STR(X,Y)  if (UnprefixString( Y, line, X ) == true) {}
+void CConfig::DefineOptions( void )
+{
+    string label;
+
+    // Same order as the config file is written
+    AddOption( OPTION_LABEL,    "# General Settings",       NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_INT16,    OPT_SCREEN_WIDTH,           &ScreenWidth,           -1,                 HELP_SCREEN_WIDTH );
+    AddOption( OPTION_INT16,    OPT_SCREEN_HEIGHT,          &ScreenHeight,          -1,                 HELP_SCREEN_HEIGHT );
+    AddOption( OPTION_INT16,    OPT_SCREEN_DEPTH,           &ScreenDepth,           -1,                 HELP_SCREEN_DEPTH );
+    AddOption( OPTION_UINT16,   OPT_PREV_ENTRY_INDEX,       &PrevEntryIndex,        -1,                 HELP_PREV_ENTRY_INDEX );
+    AddOption( OPTION_BOOL,     OPT_FULLSCREEN,             &Fullscreen,            -1,                 HELP_FULLSCREEN );
+    AddOption( OPTION_UINT16,   OPT_CPU_CLOCK,              &CPUClock,              -1,                 HELP_CPU_CLOCK );
+    AddOption( OPTION_BOOL,     OPT_USEZIPSUPPORT,          &UseZipSupport,         -1,                 HELP_USEZIPSUPPORT );
+    AddOption( OPTION_BOOL,     OPT_SHOWEXTS,               &ShowExts,              -1,                 HELP_SHOWEXTS );
+    AddOption( OPTION_BOOL,     OPT_SHOWHIDDEN,             &ShowHidden,            -1,                 HELP_SHOWHIDDEN );
+    AddOption( OPTION_BOOL,     OPT_SHOWPOINTER,            &ShowPointer,           -1,                 HELP_SHOWPOINTER );
+    AddOption( OPTION_BOOL,     OPT_SHOWLABELS,             &ShowLabels,            -1,                 HELP_SHOWLABELS );
+    AddOption( OPTION_BOOL,     OPT_UNUSED_KEYS_SELECT,     &UnusedKeysLaunch,      -1,                 HELP_UNUSED_KEYS_SELECT );
+    AddOption( OPTION_BOOL,     OPT_UNUSED_JOYS_SELECT,     &UnusedJoysLaunch,      -1,                 HELP_UNUSED_JOYS_SELECT );
+    AddOption( OPTION_BOOL,     OPT_RELOAD_LAUNCHER,        &ReloadLauncher,        -1,                 HELP_RELOAD_LAUNCHER );
+    AddOption( OPTION_BOOL,     OPT_SUPERVISOR,             &Supervisor,            -1,                 HELP_SUPERVISOR );
+    AddOption( OPTION_BOOL,     OPT_LAUNCH_SHELL,           &LaunchShell,           -1,                 HELP_LAUNCH_SHELL );
+    AddOption( OPTION_BOOL,     OPT_READAHEAD,              &Readahead,             -1,                 HELP_READAHEAD );
+    AddOption( OPTION_BOOL,     OPT_TEXT_SCROLL_OPTION,     &TextScrollOption,      -1,                 HELP_TEXT_SCROLL_OPTION );
+    AddOption( OPTION_BOOL,     OPT_FILENAMEARGNOEXT,       &FilenameArgNoExt,      -1,                 HELP_FILENAMEARGNOEXT );
+    AddOption( OPTION_BOOL,     OPT_FILEABSPATH,            &FilenameAbsPath,       -1,                 HELP_FILEABSPATH );
+    AddOption( OPTION_UINT8,    OPT_FONT_SIZE_SMALL,        &FontSizes,             FONT_SIZE_SMALL,    HELP_FONT_SIZE_SMALL );
+    AddOption( OPTION_UINT8,    OPT_FONT_SIZE_MEDIUM,       &FontSizes,             FONT_SIZE_MEDIUM,   HELP_FONT_SIZE_MEDIUM );
+    AddOption( OPTION_UINT8,    OPT_FONT_SIZE_LARGE,        &FontSizes,             FONT_SIZE_LARGE,    HELP_FONT_SIZE_LARGE );
+    AddOption( OPTION_UINT8,    OPT_ENTRY_FAST_MODE,        &EntryFastMode,         -1,                 HELP_ENTRY_FAST_MODE );
+    AddOption( OPTION_UINT8,    OPT_MAX_ENTRIES,            &MaxEntries,            -1,                 HELP_MAX_ENTRIES );
+    AddOption( OPTION_UINT8,    OPT_SCALE_MODE,             &ScaleMode,             -1,                 HELP_SCALE_MODE );
+    AddOption( OPTION_UINT16,   OPT_PREVIEW_CACHE,          &PreviewCache,          -1,                 HELP_PREVIEW_CACHE );
+    AddOption( OPTION_UINT16,   OPT_MEMORY_LIMIT,           &MemoryLimit,           -1,                 HELP_MEMORY_LIMIT );
+    AddOption( OPTION_UINT16,   OPT_READAHEAD_DWELL,        &ReadaheadDwell,        -1,                 HELP_READAHEAD_DWELL );
+    AddOption( OPTION_UINT16,   OPT_JOURNAL_LIMIT,          &JournalLimit,          -1,                 HELP_JOURNAL_LIMIT );
+    AddOption( OPTION_UINT8,    OPT_LOG_LEVEL,              &LogLevel,              -1,                 HELP_LOG_LEVEL );
+    AddOption( OPTION_UINT16,   OPT_SCROLL_SPEED,           &ScrollSpeed,           -1,                 HELP_SCROLL_SPEED );
+    AddOption( OPTION_UINT16,   OPT_SCROLL_PAUSE_SPEED,     &ScrollPauseSpeed,      -1,                 HELP_SCROLL_PAUSE_SPEED );
+    AddOption( OPTION_STRING,   OPT_PROFILE_DELIMITER,      &Delimiter,             -1,                 HELP_PROFILE_DELIMITER );
+    AddOption( OPTION_LABEL,    "# GUI Positions",          NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_BOOL,     OPT_AUTOLAYOUT,             &AutoLayout,            -1,                 HELP_AUTOLAYOUT );
+    AddOption( OPTION_UINT16,   OPT_POSX_TITLE,             &PosX_Title,            -1,                 HELP_POSX_TITLE );
+    AddOption( OPTION_UINT16,   OPT_POSY_TITLE,             &PosY_Title,            -1,                 HELP_POSY_TITLE );
+    AddOption( OPTION_UINT16,   OPT_POSX_BTNLEFT,           &PosX_ButtonLeft,       -1,                 HELP_POSX_BTNLEFT );
+    AddOption( OPTION_UINT16,   OPT_POSY_BTNLEFT,           &PosY_ButtonLeft,       -1,                 HELP_POSY_BTNLEFT );
+    AddOption( OPTION_UINT16,   OPT_POSX_BTNRIGHT,          &PosX_ButtonRight,      -1,                 HELP_POSX_BTNRIGHT );
+    AddOption( OPTION_UINT16,   OPT_POSY_BTNRIGHT,          &PosY_ButtonRight,      -1,                 HELP_POSY_BTNRIGHT );
+    AddOption( OPTION_UINT16,   OPT_POSX_LISTNAMES,         &PosX_ListNames,        -1,                 HELP_POSX_LISTNAMES );
+    AddOption( OPTION_UINT16,   OPT_POSY_LISTNAMES,         &PosY_ListNames,        -1,                 HELP_POSY_LISTNAMES );
+    AddOption( OPTION_LABEL,    "# GUI Options",            NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_UINT16,   OPT_PATH_Y_DELTA,           &PathYDelta,            -1,                 HELP_PATH_Y_DELTA );
+    AddOption( OPTION_UINT16,   OPT_ENTRY_Y_DELTA,          &EntryYDelta,           -1,                 HELP_ENTRY_Y_DELTA );
+    AddOption( OPTION_INT16,    OPT_ENTRY_X_OFFSET,         &EntryXOffset,          -1,                 HELP_ENTRY_X_OFFSET );
+    AddOption( OPTION_INT16,    OPT_ENTRY_Y_OFFSET,         &EntryYOffset,          -1,                 HELP_ENTRY_Y_OFFSET );
+    AddOption( OPTION_UINT16,   OPT_BUTTON_W_LEFT,          &ButtonWidthLeft,       -1,                 HELP_BUTTON_W_LEFT );
+    AddOption( OPTION_UINT16,   OPT_BUTTON_H_LEFT,          &ButtonHeightLeft,      -1,                 HELP_BUTTON_H_LEFT );
+    AddOption( OPTION_UINT16,   OPT_BUTTON_W_RIGHT,         &ButtonWidthRight,      -1,                 HELP_BUTTON_W_RIGHT );
+    AddOption( OPTION_UINT16,   OPT_BUTTON_H_RIGHT,         &ButtonHeightRight,     -1,                 HELP_BUTTON_H_RIGHT );
+    AddOption( OPTION_UINT16,   OPT_PREVIEW_W,              &PreviewWidth,          -1,                 HELP_PREVIEW_W );
+    AddOption( OPTION_UINT16,   OPT_PREVIEW_H,              &PreviewHeight,         -1,                 HELP_PREVIEW_H );
+    AddOption( OPTION_UINT16,   OPT_ENTRY_MAX_W,            &DisplayListMaxWidth,   -1,                 HELP_ENTRY_MAX_W );
+    AddOption( OPTION_UINT16,   OPT_FILEPATH_MAX_W,         &FilePathMaxWidth,      -1,                 HELP_FILEPATH_MAX_W );
+    AddOption( OPTION_LABEL,    "# Button Enable Options",  NULL,                   -1,                 HELP_DEFAULT );
+    for (uint8_t i=0; i<BUTTONS_MAX_LEFT; i++)
+    {
+        label = string(OPT_BUTTONLEFT_ENABLED) + "_"+ i_to_a(i);
+        AddOption( OPTION_BOOL, label,                      &ButtonModesLeftEnable, i,                  HELP_DEFAULT );
+    }
+    for (uint8_t i=0; i<BUTTONS_MAX_RIGHT; i++)
+    {
+        label = string(OPT_BUTTONRIGHT_ENABLED) + "_"+ i_to_a(i);
+        AddOption( OPTION_BOOL, label,                      &ButtonModesRightEnable, i,                 HELP_DEFAULT );
+    }
+    AddOption( OPTION_LABEL,    "# Paths",                  NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_STRING,   OPT_PATH_ZIPTEMP,           &ZipPath,               -1,                 HELP_PATH_ZIPTEMP );
+    AddOption( OPTION_STRING,   OPT_PATH_PREVIEWS,          &PreviewsPath,          -1,                 HELP_PATH_PREVIEWS );
+    AddOption( OPTION_STRING,   OPT_PATH_THUMBNAILS,        &ThumbnailsPath,        -1,                 HELP_PATH_THUMBNAILS );
+    AddOption( OPTION_STRING,   OPT_PATH_BUNDLE,            &BundlePath,            -1,                 HELP_PATH_BUNDLE );
+    AddOption( OPTION_STRING,   OPT_PATH_SNAPSHOT,          &SnapshotPath,          -1,                 HELP_PATH_SNAPSHOT );
+    AddOption( OPTION_STRING,   OPT_PATH_FONT,              &PathFont,              -1,                 HELP_PATH_FONT );
+    AddOption( OPTION_STRING,   OPT_PATH_BACKGND,           &PathBackground,        -1,                 HELP_PATH_BACKGND );
+    AddOption( OPTION_STRING,   OPT_PATH_POINTER,           &PathPointer,           -1,                 HELP_PATH_POINTER );
+    AddOption( OPTION_STRING,   OPT_PATH_SELECTPOINTER,     &PathSelectPointer,     -1,                 HELP_PATH_SELECTPOINTER );
+    AddOption( OPTION_STRING,   OPT_PATH_ONEUP,             &PathButtons,           EVENT_ONE_UP,       HELP_PATH_ONEUP );
+    AddOption( OPTION_STRING,   OPT_PATH_ONEDN,             &PathButtons,           EVENT_ONE_DOWN,     HELP_PATH_ONEDN );
+    AddOption( OPTION_STRING,   OPT_PATH_PGUP,              &PathButtons,           EVENT_PAGE_UP,      HELP_PATH_PGUP );
+    AddOption( OPTION_STRING,   OPT_PATH_PGDN,              &PathButtons,           EVENT_PAGE_DOWN,    HELP_PATH_PGDN );
+    AddOption( OPTION_STRING,   OPT_PATH_DIRUP,             &PathButtons,           EVENT_DIR_UP,       HELP_PATH_DIRUP );
+    AddOption( OPTION_STRING,   OPT_PATH_DIRDN,             &PathButtons,           EVENT_DIR_DOWN,     HELP_PATH_DIRDN );
+    AddOption( OPTION_STRING,   OPT_PATH_CFG_APP,           &PathButtons,           EVENT_CFG_APP,      HELP_PATH_CFG_APP );
+    AddOption( OPTION_STRING,   OPT_PATH_CFG_ITEM,          &PathButtons,           EVENT_CFG_ITEM,     HELP_PATH_CFG_ITEM );
+    AddOption( OPTION_STRING,   OPT_PATH_SELECT,            &PathButtons,           EVENT_SELECT,       HELP_PATH_SELECT );
+    AddOption( OPTION_STRING,   OPT_PATH_QUIT,              &PathButtons,           EVENT_QUIT,         HELP_PATH_QUIT );
+    AddOption( OPTION_LABEL,    "# Colors",                 NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_COLORS,   "",                         NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_COLOR_BUTTON,           &ColorButton,           -1,                 HELP_COLOR_BUTTON );
+    AddOption( OPTION_UINT8,    OPT_COLOR_FONTBUTTON,       &ColorFontButton,       -1,                 HELP_COLOR_FONTBUTTON );
+    AddOption( OPTION_UINT8,    OPT_COLOR_BACKGND,          &ColorBackground,       -1,                 HELP_COLOR_BACKGND );
+    AddOption( OPTION_UINT8,    OPT_COLOR_FONTFILES,        &ColorFontFiles,        -1,                 HELP_COLOR_FONTFILES );
+    AddOption( OPTION_UINT8,    OPT_COLOR_FONTFOLDERS,      &ColorFontFolders,      -1,                 HELP_COLOR_FONTFOLDERS );
+    AddOption( OPTION_LABEL,    "# Controls",               NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_LABEL,    "#   Keyboard",             NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYUP,                  &KeyMaps,               EVENT_ONE_UP,       HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYDOWN,                &KeyMaps,               EVENT_ONE_DOWN,     HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYLEFT,                &KeyMaps,               EVENT_PAGE_UP,      HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYRIGHT,               &KeyMaps,               EVENT_PAGE_DOWN,    HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYDIRUP,               &KeyMaps,               EVENT_DIR_UP,       HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYDIRDOWN,             &KeyMaps,               EVENT_DIR_DOWN,     HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYCFGAPP,              &KeyMaps,               EVENT_CFG_APP,      HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYCFGENTRY,            &KeyMaps,               EVENT_CFG_ITEM,     HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYSETONE,              &KeyMaps,               EVENT_SET_ONE,      HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYSETALL,              &KeyMaps,               EVENT_SET_ALL,      HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYSELECT,              &KeyMaps,               EVENT_SELECT,       HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYBACK,                &KeyMaps,               EVENT_BACK,         HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYQUIT,                &KeyMaps,               EVENT_QUIT,         HELP_DEFAULT );
+    AddOption( OPTION_KEY,      OPT_KEYHUD,                 &KeyMaps,               EVENT_HUD,          HELP_DEFAULT );
+    AddOption( OPTION_LABEL,    "#   Joystick",             NULL,                   -1,                 HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYUP,                  &JoyMaps,               EVENT_ONE_UP,       HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYDOWN,                &JoyMaps,               EVENT_ONE_DOWN,     HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYLEFT,                &JoyMaps,               EVENT_PAGE_UP,      HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYRIGHT,               &JoyMaps,               EVENT_PAGE_DOWN,    HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYDIRUP,               &JoyMaps,               EVENT_DIR_UP,       HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYDIRDOWN,             &JoyMaps,               EVENT_DIR_DOWN,     HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYCFGAPP,              &JoyMaps,               EVENT_CFG_APP,      HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYCFGENTRY,            &JoyMaps,               EVENT_CFG_ITEM,     HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYSETONE,              &JoyMaps,               EVENT_SET_ONE,      HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYSETALL,              &JoyMaps,               EVENT_SET_ALL,      HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYSELECT,              &JoyMaps,               EVENT_SELECT,       HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYBACK,                &JoyMaps,               EVENT_BACK,         HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYQUIT,                &JoyMaps,               EVENT_QUIT,         HELP_DEFAULT );
+    AddOption( OPTION_UINT8,    OPT_JOYHUD,                 &JoyMaps,               EVENT_HUD,          HELP_DEFAULT );
+    AddOption( OPTION_INT16,    OPT_DEADZONE,               &AnalogDeadZone,        -1,                 HELP_DEADZONE );
+}
+
+void CConfig::AddOption( uint8_t type, const string& key, void* field, int16_t index, const string& help )
+{
+    option_t option;
+
+    option.Type     = type;
+    option.Key      = key;
+    option.Field    = field;
+    option.Index    = index;
+    option.Help     = help;
+    Options.push_back( option );
+
+    if (field != NULL)
+    {
+        OptionIndices[key] = Options.size()-1;
+    }
+}
+
+void CConfig::SetOption( const option_t& option, const string& value )
+{
+    int32_t number;
+
+    number = a_to_i(value);
+    switch (option.Type)
+    {
+        case OPTION_BOOL:
+            if (option.Index >= 0)
+            {
+                static_cast<vector<bool>*>(option.Field)->at(option.Index) = number;
+            }
+            else
+            {
+                *static_cast<bool*>(option.Field) = number;
+            }
+            break;
+        case OPTION_UINT8:
+            if (option.Index >= 0)
+            {
+                static_cast<vector<uint8_t>*>(option.Field)->at(option.Index) = number;
+            }
+            else
+            {
+                *static_cast<uint8_t*>(option.Field) = number;
+            }
+            break;
+        case OPTION_INT16:
+            *static_cast<int16_t*>(option.Field) = number;
+            break;
+        case OPTION_UINT16:
+            *static_cast<uint16_t*>(option.Field) = number;
+            break;
+        case OPTION_STRING:
+            if (option.Index >= 0)
+            {
+                static_cast<vector<string>*>(option.Field)->at(option.Index) = value;
+            }
+            else
+            {
+                *static_cast<string*>(option.Field) = value;
+            }
+            break;
+        case OPTION_KEY:
+            static_cast<vector<KeyCode>*>(option.Field)->at(option.Index) = (KeyCode)number;
+            break;
+        default:
+            break;
+    }
+}
+
+string CConfig::GetOption( const option_t& option )
+{
+    stringstream text;
+
+    switch (option.Type)
+    {
+        case OPTION_BOOL:
+            if (option.Index >= 0)
+            {
+                return i_to_a( static_cast<vector<bool>*>(option.Field)->at(option.Index) );
+            }
+            return i_to_a( *static_cast<bool*>(option.Field) );
+        case OPTION_UINT8:
+            if (option.Index >= 0)
+            {
+                return i_to_a( static_cast<vector<uint8_t>*>(option.Field)->at(option.Index) );
+            }
+            return i_to_a( *static_cast<uint8_t*>(option.Field) );
+        case OPTION_INT16:
+            return i_to_a( *static_cast<int16_t*>(option.Field) );
+        case OPTION_UINT16:
+            return i_to_a( *static_cast<uint16_t*>(option.Field) );
+        case OPTION_STRING:
+            if (option.Index >= 0)
+            {
+                return static_cast<vector<string>*>(option.Field)->at(option.Index);
+            }
+            return *static_cast<string*>(option.Field);
+        case OPTION_KEY:
+            // Key codes do not all fit in 16 bits
+            text << (int32_t)static_cast<vector<KeyCode>*>(option.Field)->at(option.Index);
+            return text.str();
+        default:
+            return "";
+    }
+}
 
 int8_t CConfig::Load( const string& location )
 {
-    string          line;
-    string          label;
-    ifstream        fin;
+    TRACE_SPAN( "CConfig::Load" );
+
+    string                          line;
+    string                          key;
+    string                          value;
+    string::size_type               pos;
+    ifstream                        fin;
+    map<string, uint16_t>::iterator option;
 
     Log( __FILENAME__, __LINE__, "  from location %s", location.c_str() );
+    IoCount( IO_OPEN );
     fin.open(location.c_str(), ios_base::in);
 
     if (!fin)
@@ -229,120 +488,19 @@ int8_t CConfig::Load( const string& location )
             Log( __FILENAME__, __LINE__, "%s", line.c_str() );
 #endif
 
-            if (line.length() > 0)
+            // Each line is one lookup of its key, rather than a search for every option
+            pos = line.find('=');
+            if ((line.length() == 0) || (line.at(0) == '#') || (pos == string::npos))
             {
-                LOAD_INT( OPT_SCREEN_WIDTH,         ScreenWidth );
-                LOAD_INT( OPT_SCREEN_HEIGHT,        ScreenHeight );
-                LOAD_INT( OPT_SCREEN_DEPTH,         ScreenDepth );
-                LOAD_INT( OPT_PREV_ENTRY_INDEX,     PrevEntryIndex );
-                LOAD_INT( OPT_FULLSCREEN,           Fullscreen );
-                LOAD_INT( OPT_CPU_CLOCK,            CPUClock );
-                LOAD_INT( OPT_USEZIPSUPPORT,        UseZipSupport );
-                LOAD_INT( OPT_SHOWEXTS,             ShowExts );
-                LOAD_INT( OPT_SHOWHIDDEN,           ShowHidden );
-                LOAD_INT( OPT_SHOWPOINTER,          ShowPointer );
-                LOAD_INT( OPT_SHOWLABELS,           ShowLabels );
-                LOAD_INT( OPT_UNUSED_KEYS_SELECT,   UnusedKeysLaunch );
-                LOAD_INT( OPT_UNUSED_JOYS_SELECT,   UnusedJoysLaunch );
-                LOAD_INT( OPT_RELOAD_LAUNCHER,      ReloadLauncher );
-                LOAD_INT( OPT_TEXT_SCROLL_OPTION,   TextScrollOption );
-                LOAD_INT( OPT_FILENAMEARGNOEXT,     FilenameArgNoExt );
-                LOAD_INT( OPT_FILEABSPATH,          FilenameAbsPath );
-                LOAD_INT( OPT_FONT_SIZE_SMALL,      FontSizes.at(FONT_SIZE_SMALL) );
-                LOAD_INT( OPT_FONT_SIZE_MEDIUM,     FontSizes.at(FONT_SIZE_MEDIUM) );
-                LOAD_INT( OPT_FONT_SIZE_LARGE,      FontSizes.at(FONT_SIZE_LARGE) );
-                LOAD_INT( OPT_ENTRY_FAST_MODE,      EntryFastMode );
-                LOAD_INT( OPT_MAX_ENTRIES,          MaxEntries );
-                LOAD_INT( OPT_SCROLL_SPEED,         ScrollSpeed );
-                LOAD_INT( OPT_SCROLL_PAUSE_SPEED,   ScrollPauseSpeed );
-                LOAD_STR( OPT_PROFILE_DELIMITER,    Delimiter );
-                // GUI Positions
-                LOAD_INT( OPT_AUTOLAYOUT,           AutoLayout );
-                LOAD_INT( OPT_POSX_TITLE,           PosX_Title );
-                LOAD_INT( OPT_POSY_TITLE,           PosY_Title );
-                LOAD_INT( OPT_POSX_BTNLEFT,         PosX_ButtonLeft );
-                LOAD_INT( OPT_POSY_BTNLEFT,         PosY_ButtonLeft );
-                LOAD_INT( OPT_POSX_BTNRIGHT,        PosX_ButtonRight );
-                LOAD_INT( OPT_POSY_BTNRIGHT,        PosY_ButtonRight );
-                LOAD_INT( OPT_POSX_LISTNAMES,       PosX_ListNames );
-                LOAD_INT( OPT_POSY_LISTNAMES,       PosY_ListNames );
-                // GUI Options
-                LOAD_INT( OPT_PATH_Y_DELTA,         PathYDelta );
-                LOAD_INT( OPT_ENTRY_Y_DELTA,        EntryYDelta );
-                LOAD_INT( OPT_ENTRY_X_OFFSET,       EntryXOffset );
-                LOAD_INT( OPT_ENTRY_Y_OFFSET,       EntryYOffset );
-                LOAD_INT( OPT_BUTTON_W_LEFT,        ButtonWidthLeft );
-                LOAD_INT( OPT_BUTTON_H_LEFT,        ButtonHeightLeft );
-                LOAD_INT( OPT_BUTTON_W_RIGHT,       ButtonWidthRight );
-                LOAD_INT( OPT_BUTTON_H_RIGHT,       ButtonHeightRight );
-                LOAD_INT( OPT_PREVIEW_W,            PreviewWidth );
-                LOAD_INT( OPT_PREVIEW_H,            PreviewHeight );
-                LOAD_INT( OPT_ENTRY_MAX_W,          DisplayListMaxWidth );
-                LOAD_INT( OPT_FILEPATH_MAX_W,       FilePathMaxWidth );
-                // GUI Buttons
-                for (uint16_t i=0; i<ButtonModesLeftEnable.size(); i++)
-                {
-                    label = string(OPT_BUTTONLEFT_ENABLED) + "_"+ i_to_a(i);
-                    LOAD_INT( label,                ButtonModesLeftEnable.at(i) );
-                }
-                for (uint16_t i=0; i<ButtonModesRightEnable.size(); i++)
-                {
-                    label = string(OPT_BUTTONRIGHT_ENABLED) + "_"+ i_to_a(i);
-                    LOAD_INT( label,                ButtonModesRightEnable.at(i) );
-                }
-                // Paths
-                LOAD_STR( OPT_PATH_ZIPTEMP,         ZipPath );
-                LOAD_STR( OPT_PATH_PREVIEWS,        PreviewsPath );
-                LOAD_STR( OPT_PATH_FONT,            PathFont );
-                LOAD_STR( OPT_PATH_BACKGND,         PathBackground );
-                LOAD_STR( OPT_PATH_POINTER,         PathPointer );
-                LOAD_STR( OPT_PATH_POINTER,         PathPointer );
-                LOAD_STR( OPT_PATH_ONEUP,           PathButtons.at(EVENT_ONE_UP) );
-                LOAD_STR( OPT_PATH_ONEDN,           PathButtons.at(EVENT_ONE_DOWN) );
-                LOAD_STR( OPT_PATH_PGUP,            PathButtons.at(EVENT_PAGE_UP) );
-                LOAD_STR( OPT_PATH_PGDN,            PathButtons.at(EVENT_PAGE_DOWN) );
-                LOAD_STR( OPT_PATH_DIRUP,           PathButtons.at(EVENT_DIR_UP) );
-                LOAD_STR( OPT_PATH_DIRDN,           PathButtons.at(EVENT_DIR_DOWN) );
-                LOAD_STR( OPT_PATH_CFG_APP,         PathButtons.at(EVENT_CFG_APP) );
-                LOAD_STR( OPT_PATH_CFG_ITEM,        PathButtons.at(EVENT_CFG_ITEM) );
-                LOAD_STR( OPT_PATH_SELECT,          PathButtons.at(EVENT_SELECT) );
-                LOAD_STR( OPT_PATH_QUIT,            PathButtons.at(EVENT_QUIT) );
-                // Color mappings
-                LOAD_INT( OPT_COLOR_BUTTON,         ColorButton );
-                LOAD_INT( OPT_COLOR_FONTBUTTON,     ColorFontButton );
-                LOAD_INT( OPT_COLOR_BACKGND,        ColorBackground );
-                LOAD_INT( OPT_COLOR_FONTFILES,      ColorFontFiles );
-                LOAD_INT( OPT_COLOR_FONTFOLDERS,    ColorFontFolders );
-                // Keyboard mappings
-                LOAD_KEY( OPT_KEYUP,                KeyMaps.at(EVENT_ONE_UP) );
-                LOAD_KEY( OPT_KEYDOWN,              KeyMaps.at(EVENT_ONE_DOWN) );
-                LOAD_KEY( OPT_KEYLEFT ,             KeyMaps.at(EVENT_PAGE_UP) );
-                LOAD_KEY( OPT_KEYRIGHT,             KeyMaps.at(EVENT_PAGE_DOWN) );
-                LOAD_KEY( OPT_KEYDIRUP,             KeyMaps.at(EVENT_DIR_UP) );
-                LOAD_KEY( OPT_KEYDIRDOWN,           KeyMaps.at(EVENT_DIR_DOWN) );
-                LOAD_KEY( OPT_KEYCFGAPP,            KeyMaps.at(EVENT_CFG_APP) );
-                LOAD_KEY( OPT_KEYCFGENTRY,          KeyMaps.at(EVENT_CFG_ITEM) );
-				LOAD_KEY( OPT_KEYSETONE,            KeyMaps.at(EVENT_SET_ONE) );
-				LOAD_KEY( OPT_KEYSETALL,            KeyMaps.at(EVENT_SET_ALL) );
-                LOAD_KEY( OPT_KEYSELECT,            KeyMaps.at(EVENT_SELECT) );
-				LOAD_KEY( OPT_KEYBACK,              KeyMaps.at(EVENT_BACK) );
-                LOAD_KEY( OPT_KEYQUIT,              KeyMaps.at(EVENT_QUIT) );
-                // Joystick mappings
-                LOAD_INT( OPT_JOYUP,                JoyMaps.at(EVENT_ONE_UP) );
-                LOAD_INT( OPT_JOYDOWN,              JoyMaps.at(EVENT_ONE_DOWN) );
-                LOAD_INT( OPT_JOYLEFT,              JoyMaps.at(EVENT_PAGE_UP) );
-                LOAD_INT( OPT_JOYRIGHT,             JoyMaps.at(EVENT_PAGE_DOWN) );
-                LOAD_INT( OPT_JOYDIRUP,             JoyMaps.at(EVENT_DIR_UP) );
-                LOAD_INT( OPT_JOYDIRDOWN,           JoyMaps.at(EVENT_DIR_DOWN) );
-                LOAD_INT( OPT_JOYCFGAPP,            JoyMaps.at(EVENT_CFG_APP) );
-                LOAD_INT( OPT_JOYCFGENTRY,          JoyMaps.at(EVENT_CFG_ITEM) );
-				LOAD_INT( OPT_JOYSETONE,            JoyMaps.at(EVENT_SET_ONE) );
-				LOAD_INT( OPT_JOYSETALL,            JoyMaps.at(EVENT_SET_ALL) );
-                LOAD_INT( OPT_JOYSELECT,            JoyMaps.at(EVENT_SELECT) );
-                LOAD_INT( OPT_JOYBACK,              JoyMaps.at(EVENT_BACK) );
-                LOAD_INT( OPT_JOYQUIT,              JoyMaps.at(EVENT_QUIT) );
-                // Analog joystick mappings
-                LOAD_INT( OPT_DEADZONE,             AnalogDeadZone );
+                continue;
+            }
+            key = line.substr( 0, pos );
+            key.erase( key.find_last_not_of(" \t") + 1 );
+
+            option = OptionIndices.find( key );
+            if ((option != OptionIndices.end()) && (UnprefixString( value, line, key ) == true))
+            {
+                SetOption( Options.at(option->second), value );
             }
         }
         fin.close();
@@ -364,156 +522,79 @@ int8_t CConfig::Load( const string& location )
     return 0;
 }
 
-#define SAVE_LBL(X)         fout << endl << X << endl;
-#define SAVE_INT(X,H,V)     fout << setw(CFG_LBL_W) << X << "= " << setw(CFG_VAL_W) << i_to_a(V) << "# " << H << endl
-#define SAVE_STR(X,H,V)     fout << setw(CFG_LBL_W) << X << "= " << setw(CFG_VAL_W) << V << "# " << H << endl
-#define GET_KEY_NAME(X)     SDL_GetKeyName(KeyMaps.at(X))
-
 int8_t CConfig::Save( const string& location )
 {
-    ofstream    fout;
-    string      label;
-
-    fout.open(location.c_str(), ios_base::trunc);
-
-    if (!fout)
-    {
-        Log( __FILENAME__, __LINE__, "Failed to open profile" );
-        return 1;
-    }
+    ofstream        fout;
+    ifstream        fin;
+    stringstream    text;
+    stringstream    current;
+    string          temporary;
+    string          help;
 
     // Write out the profile
-    if (fout.is_open())
+    text.setf( ios::left, ios::adjustfield );
+    for (uint16_t index=0; index<Options.size(); index++)
     {
-        fout.setf( ios::left, ios::adjustfield );
-        SAVE_LBL( "# General Settings" );
-        SAVE_INT( OPT_SCREEN_WIDTH,         HELP_SCREEN_WIDTH,          ScreenWidth );
-        SAVE_INT( OPT_SCREEN_HEIGHT,        HELP_SCREEN_HEIGHT,         ScreenHeight );
-        SAVE_INT( OPT_SCREEN_DEPTH,         HELP_SCREEN_DEPTH,          ScreenDepth );
-        SAVE_INT( OPT_PREV_ENTRY_INDEX,     HELP_PREV_ENTRY_INDEX,      PrevEntryIndex );
-        SAVE_INT( OPT_FULLSCREEN,           HELP_FULLSCREEN,            Fullscreen );
-        SAVE_INT( OPT_CPU_CLOCK,            HELP_CPU_CLOCK,             CPUClock );
-        SAVE_INT( OPT_USEZIPSUPPORT,        HELP_USEZIPSUPPORT,         UseZipSupport );
-        SAVE_INT( OPT_SHOWEXTS,             HELP_SHOWEXTS,              ShowExts );
-        SAVE_INT( OPT_SHOWHIDDEN,           HELP_SHOWHIDDEN,            ShowHidden );
-        SAVE_INT( OPT_SHOWPOINTER,          HELP_SHOWPOINTER,           ShowPointer );
-        SAVE_INT( OPT_SHOWLABELS,           HELP_SHOWLABELS,            ShowLabels );
-        SAVE_INT( OPT_UNUSED_KEYS_SELECT,   HELP_UNUSED_KEYS_SELECT,    UnusedKeysLaunch );
-        SAVE_INT( OPT_UNUSED_JOYS_SELECT,   HELP_UNUSED_JOYS_SELECT,    UnusedJoysLaunch );
-        SAVE_INT( OPT_RELOAD_LAUNCHER,      HELP_RELOAD_LAUNCHER,       ReloadLauncher );
-        SAVE_INT( OPT_TEXT_SCROLL_OPTION,   HELP_TEXT_SCROLL_OPTION,    TextScrollOption );
-        SAVE_INT( OPT_FILENAMEARGNOEXT,     HELP_FILENAMEARGNOEXT,      FilenameArgNoExt );
-        SAVE_INT( OPT_FILEABSPATH,          HELP_FILEABSPATH,           FilenameAbsPath );
-        SAVE_INT( OPT_FONT_SIZE_SMALL,      HELP_FONT_SIZE_SMALL,       FontSizes.at(FONT_SIZE_SMALL) );
-        SAVE_INT( OPT_FONT_SIZE_MEDIUM,     HELP_FONT_SIZE_MEDIUM,      FontSizes.at(FONT_SIZE_MEDIUM) );
-        SAVE_INT( OPT_FONT_SIZE_LARGE,      HELP_FONT_SIZE_LARGE,       FontSizes.at(FONT_SIZE_LARGE) );
-        SAVE_INT( OPT_ENTRY_FAST_MODE,      HELP_ENTRY_FAST_MODE,       EntryFastMode );
-        SAVE_INT( OPT_MAX_ENTRIES,          HELP_MAX_ENTRIES,           MaxEntries );
-        SAVE_INT( OPT_SCROLL_SPEED,         HELP_SCROLL_SPEED,          ScrollSpeed );
-        SAVE_INT( OPT_SCROLL_PAUSE_SPEED,   HELP_SCROLL_PAUSE_SPEED,    ScrollPauseSpeed );
-        SAVE_STR( OPT_PROFILE_DELIMITER,    HELP_PROFILE_DELIMITER,     Delimiter );
-        SAVE_LBL( "# GUI Positions" );
-        SAVE_INT( OPT_AUTOLAYOUT,           HELP_AUTOLAYOUT,            AutoLayout );
-        SAVE_INT( OPT_POSX_TITLE,           HELP_POSX_TITLE,            PosX_Title );
-        SAVE_INT( OPT_POSY_TITLE,           HELP_POSY_TITLE,            PosY_Title );
-        SAVE_INT( OPT_POSX_BTNLEFT,         HELP_POSX_BTNLEFT,          PosX_ButtonLeft );
-        SAVE_INT( OPT_POSY_BTNLEFT,         HELP_POSY_BTNLEFT,          PosY_ButtonLeft );
-        SAVE_INT( OPT_POSX_BTNRIGHT,        HELP_POSX_BTNRIGHT,         PosX_ButtonRight );
-        SAVE_INT( OPT_POSY_BTNRIGHT,        HELP_POSY_BTNRIGHT,         PosY_ButtonRight );
-        SAVE_INT( OPT_POSX_LISTNAMES,       HELP_POSX_LISTNAMES,        PosX_ListNames );
-        SAVE_INT( OPT_POSY_LISTNAMES,       HELP_POSY_LISTNAMES,        PosY_ListNames );
-        SAVE_LBL( "# GUI Options" );
-        SAVE_INT( OPT_PATH_Y_DELTA,         HELP_PATH_Y_DELTA,          PathYDelta );
-        SAVE_INT( OPT_ENTRY_Y_DELTA,        HELP_ENTRY_Y_DELTA,         EntryYDelta );
-        SAVE_INT( OPT_ENTRY_X_OFFSET,       HELP_ENTRY_X_OFFSET,        EntryXOffset );
-        SAVE_INT( OPT_ENTRY_Y_OFFSET,       HELP_ENTRY_Y_OFFSET,        EntryYOffset );
-        SAVE_INT( OPT_BUTTON_W_LEFT,        HELP_BUTTON_W_LEFT,         ButtonWidthLeft );
-        SAVE_INT( OPT_BUTTON_H_LEFT,        HELP_BUTTON_H_LEFT,         ButtonHeightLeft );
-        SAVE_INT( OPT_BUTTON_W_RIGHT,       HELP_BUTTON_W_RIGHT,        ButtonWidthRight );
-        SAVE_INT( OPT_BUTTON_H_RIGHT,       HELP_BUTTON_H_RIGHT,        ButtonHeightRight );
-        SAVE_INT( OPT_PREVIEW_W,            HELP_PREVIEW_W,             PreviewWidth );
-        SAVE_INT( OPT_PREVIEW_H,            HELP_PREVIEW_H,             PreviewHeight );
-        SAVE_INT( OPT_ENTRY_MAX_W,          HELP_ENTRY_MAX_W,           DisplayListMaxWidth );
-        SAVE_INT( OPT_FILEPATH_MAX_W,       HELP_FILEPATH_MAX_W,        FilePathMaxWidth );
-        SAVE_LBL( "# Button Enable Options" );
-        for (uint8_t i=0; i<ButtonModesLeftEnable.size(); i++)
-        {
-            label = string(OPT_BUTTONLEFT_ENABLED) + "_"+ i_to_a(i);
-            SAVE_INT( label,                HELP_DEFAULT,               ButtonModesLeftEnable.at(i) );
-        }
-        for (uint8_t i=0; i<ButtonModesRightEnable.size(); i++)
+        const option_t& option = Options.at(index);
+
+        switch (option.Type)
         {
-            label = string(OPT_BUTTONRIGHT_ENABLED) + "_"+ i_to_a(i);
-            SAVE_INT( label,                HELP_DEFAULT,               ButtonModesRightEnable.at(i) );
+            case OPTION_LABEL:
+                text << endl << option.Key << endl;
+                break;
+            case OPTION_COLORS:
+                text << "#   ";
+                for (uint8_t i=0; i<ColorNames.size(); i++)
+                {
+                    text << setw(4) << i_to_a(i) << setw(20) << ColorNames.at(i);
+                    if ((i+1) % 3 == 0)
+                    {
+                        text << endl << "#   ";
+                    }
+                }
+                text << endl;
+                break;
+            default:
+                help = option.Help;
+                if (option.Type == OPTION_KEY)
+                {
+                    help = SDL_GetKeyName( static_cast<vector<KeyCode>*>(option.Field)->at(option.Index) );
+                }
+                text << setw(CFG_LBL_W) << option.Key << "= " << setw(CFG_VAL_W) << GetOption( option ) << "# " << help << endl;
+                break;
         }
-        SAVE_LBL( "# Paths" );
-        SAVE_STR( OPT_PATH_ZIPTEMP,         HELP_PATH_ZIPTEMP,          ZipPath );
-        SAVE_STR( OPT_PATH_PREVIEWS,        HELP_PATH_PREVIEWS,         PreviewsPath );
-        SAVE_STR( OPT_PATH_FONT,            HELP_PATH_FONT,             PathFont );
-        SAVE_STR( OPT_PATH_BACKGND,         HELP_PATH_BACKGND,          PathBackground );
-        SAVE_STR( OPT_PATH_POINTER,         HELP_PATH_POINTER,          PathPointer );
-        SAVE_STR( OPT_PATH_SELECTPOINTER,   HELP_PATH_SELECTPOINTER,    PathSelectPointer );
-        SAVE_STR( OPT_PATH_ONEUP,           HELP_PATH_ONEUP,            PathButtons.at(EVENT_ONE_UP) );
-        SAVE_STR( OPT_PATH_ONEDN,           HELP_PATH_ONEDN,            PathButtons.at(EVENT_ONE_DOWN) );
-        SAVE_STR( OPT_PATH_PGUP,            HELP_PATH_PGUP,             PathButtons.at(EVENT_PAGE_UP) );
-        SAVE_STR( OPT_PATH_PGDN,            HELP_PATH_PGDN,             PathButtons.at(EVENT_PAGE_DOWN) );
-        SAVE_STR( OPT_PATH_DIRUP,           HELP_PATH_DIRUP,            PathButtons.at(EVENT_DIR_UP) );
-        SAVE_STR( OPT_PATH_DIRDN,           HELP_PATH_DIRDN,            PathButtons.at(EVENT_DIR_DOWN) );
-        SAVE_STR( OPT_PATH_CFG_APP,         HELP_PATH_CFG_APP,          PathButtons.at(EVENT_CFG_APP) );
-        SAVE_STR( OPT_PATH_CFG_ITEM,        HELP_PATH_CFG_ITEM,         PathButtons.at(EVENT_CFG_ITEM) );
-        SAVE_STR( OPT_PATH_SELECT,          HELP_PATH_SELECT,           PathButtons.at(EVENT_SELECT) );
-        SAVE_STR( OPT_PATH_QUIT,            HELP_PATH_QUIT,             PathButtons.at(EVENT_QUIT) );
-        SAVE_LBL( "# Colors" );
-        fout << "#   ";
-        for (uint8_t i=0; i<ColorNames.size(); i++)
+    }
+
+    // Nothing is written when the options are the same as in the file
+    fin.open( location.c_str(), ios_base::in );
+    if (fin.is_open())
+    {
+        current << fin.rdbuf();
+        fin.close();
+        if (current.str() == text.str())
         {
-            fout << setw(4) << i_to_a(i) << setw(20) << ColorNames.at(i);
-            if ((i+1) % 3 == 0)
-            {
-                fout << endl << "#   ";
-            }
+            return 0;
         }
-        fout << endl;
-        SAVE_INT( OPT_COLOR_BUTTON,         HELP_COLOR_BUTTON,          ColorButton );
-        SAVE_INT( OPT_COLOR_FONTBUTTON,     HELP_COLOR_FONTBUTTON,      ColorFontButton );
-        SAVE_INT( OPT_COLOR_BACKGND,        HELP_COLOR_BACKGND,         ColorBackground );
-        SAVE_INT( OPT_COLOR_FONTFILES,      HELP_COLOR_FONTFILES,       ColorFontFiles );
-        SAVE_INT( OPT_COLOR_FONTFOLDERS,    HELP_COLOR_FONTFOLDERS,     ColorFontFolders );
-        SAVE_LBL( "# Controls" );
-        SAVE_LBL( "#   Keyboard" );
-        SAVE_STR( OPT_KEYUP,                GET_KEY_NAME(EVENT_ONE_UP),     KeyMaps.at(EVENT_ONE_UP) );
-        SAVE_STR( OPT_KEYDOWN,              GET_KEY_NAME(EVENT_ONE_DOWN),   KeyMaps.at(EVENT_ONE_DOWN) );
-        SAVE_STR( OPT_KEYLEFT,              GET_KEY_NAME(EVENT_PAGE_UP),    KeyMaps.at(EVENT_PAGE_UP) );
-        SAVE_STR( OPT_KEYRIGHT,             GET_KEY_NAME(EVENT_PAGE_DOWN),  KeyMaps.at(EVENT_PAGE_DOWN) );
-        SAVE_STR( OPT_KEYDIRUP,             GET_KEY_NAME(EVENT_DIR_UP),     KeyMaps.at(EVENT_DIR_UP) );
-        SAVE_STR( OPT_KEYDIRDOWN,           GET_KEY_NAME(EVENT_DIR_DOWN),   KeyMaps.at(EVENT_DIR_DOWN) );
-        SAVE_STR( OPT_KEYCFGAPP,            GET_KEY_NAME(EVENT_CFG_APP),    KeyMaps.at(EVENT_CFG_APP) );
-        SAVE_STR( OPT_KEYCFGENTRY,          GET_KEY_NAME(EVENT_CFG_ITEM),   KeyMaps.at(EVENT_CFG_ITEM) );
-		SAVE_STR( OPT_KEYSETONE,            GET_KEY_NAME(EVENT_SET_ONE),    KeyMaps.at(EVENT_SET_ONE) );
-		SAVE_STR( OPT_KEYSETALL,            GET_KEY_NAME(EVENT_SET_ALL),    KeyMaps.at(EVENT_SET_ALL) );
-        SAVE_STR( OPT_KEYSELECT,            GET_KEY_NAME(EVENT_SELECT),     KeyMaps.at(EVENT_SELECT) );
-        SAVE_STR( OPT_KEYBACK,              GET_KEY_NAME(EVENT_BACK),       KeyMaps.at(EVENT_BACK) );
-        SAVE_STR( OPT_KEYQUIT,              GET_KEY_NAME(EVENT_QUIT),       KeyMaps.at(EVENT_QUIT) );
-        SAVE_LBL( "#   Joystick" );
-        SAVE_INT( OPT_JOYUP,                HELP_DEFAULT,                   JoyMaps.at(EVENT_ONE_UP) );
-        SAVE_INT( OPT_JOYDOWN,              HELP_DEFAULT,                   JoyMaps.at(EVENT_ONE_DOWN) );
-        SAVE_INT( OPT_JOYLEFT,              HELP_DEFAULT,                   JoyMaps.at(EVENT_PAGE_UP) );
-        SAVE_INT( OPT_JOYRIGHT,             HELP_DEFAULT,                   JoyMaps.at(EVENT_PAGE_DOWN) );
-        SAVE_INT( OPT_JOYDIRUP,             HELP_DEFAULT,                   JoyMaps.at(EVENT_DIR_UP) );
-        SAVE_INT( OPT_JOYDIRDOWN,           HELP_DEFAULT,                   JoyMaps.at(EVENT_DIR_DOWN) );
-        SAVE_INT( OPT_JOYCFGAPP,            HELP_DEFAULT,                   JoyMaps.at(EVENT_CFG_APP) );
-        SAVE_INT( OPT_JOYCFGENTRY,          HELP_DEFAULT,                   JoyMaps.at(EVENT_CFG_ITEM) );
-		SAVE_INT( OPT_JOYSETONE,            HELP_DEFAULT,                   JoyMaps.at(EVENT_SET_ONE) );
-		SAVE_INT( OPT_JOYSETALL,            HELP_DEFAULT,                   JoyMaps.at(EVENT_SET_ALL) );
-        SAVE_INT( OPT_JOYSELECT,            HELP_DEFAULT,                   JoyMaps.at(EVENT_SELECT) );
-        SAVE_INT( OPT_JOYBACK,              HELP_DEFAULT,                   JoyMaps.at(EVENT_BACK) );
-        SAVE_INT( OPT_JOYQUIT,              HELP_DEFAULT,                   JoyMaps.at(EVENT_QUIT) );
-        SAVE_INT( OPT_DEADZONE,             HELP_DEADZONE,                  AnalogDeadZone );
-        fout.close();
     }
-    else
+
+    // Written beside the config and renamed over it, so a power loss leaves either the old or the new config
+    temporary = location + ".tmp";
+    fout.open( temporary.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open config" );
+        return 1;
+    }
+
+    fout << text.str();
+    fout.close();
+
+    // Only this file is flushed, not everything dirty on the device
+    SyncFile( temporary );
+    if (fout.fail() || rename( temporary.c_str(), location.c_str() ) != 0)
     {
-        Log( __FILENAME__, __LINE__, "Failed to open profile" );
+        Log( __FILENAME__, __LINE__, "Failed to write config %s", location.c_str() );
+        unlink( temporary.c_str() );
         return 1;
     }
     return 0;
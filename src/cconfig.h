@@ -23,6 +23,8 @@
 #ifndef CCONFIG_H
 #define CCONFIG_H
 
+#include <map>
+
 #include "cbase.h"
 #include "csystem.h"
 
@@ -53,7 +55,16 @@ using namespace std;
 #define MAX_ENTRIES         10                      /**< Default maximum entries in the display list. */
 #define SCROLL_SPEED        2                       /**< Default speed for scrolling text. */
 #define SCROLL_PAUSE_SPEED  100                     /**< Default speed for pausing scrolling text when left or right ends are reached. */
+#define PREVIEW_CACHE       16                      /**< Default number of scaled previews kept in memory. */
+#if defined(GP2X) || defined(WIZ)
+#define MEMORY_LIMIT        4096                    /**< Default memory the images, text and lists may hold on the 64 MB devices (kilobytes). */
+#else
+#define MEMORY_LIMIT        0                       /**< Default memory the images, text and lists may hold, no limit (kilobytes). */
+#endif
+#define READAHEAD_DWELL     500                     /**< Default time in the argument list before the entry is read ahead (milliseconds). */
+#define JOURNAL_LIMIT       16                      /**< Default size of the profile journal before it is compacted (kilobytes). */
 #define DEAD_ZONE           10000                   /**< Default analog joystick deadzone. */
+#define JOY_UNMAPPED        0xFF                    /**< Joystick button value for an action without a button. */
 #define DELIMITER           ";"                     /**< Default profile delimiter. */
 #define CFG_LBL_W           30                      /**< Minimum character width for the profile label. */
 #define CFG_VAL_W           30                      /**< Minimum character width for the profile value. */
@@ -127,6 +138,15 @@ using namespace std;
 #define OPT_RELOAD_LAUNCHER         "reload_launcher"
 #define HELP_RELOAD_LAUNCHER        "True if the launcher should reload following the shutdown of the target application, otherwise false."
 
+#define OPT_SUPERVISOR              "supervisor"
+#define HELP_SUPERVISOR             "True if the launcher should stay in memory while the target application runs and return as soon as it exits, otherwise false."
+
+#define OPT_LAUNCH_SHELL            "launch_shell"
+#define HELP_LAUNCH_SHELL           "True if the target application should always be started through /bin/sh, otherwise false to start it directly when the profile allows."
+
+#define OPT_READAHEAD               "readahead"
+#define HELP_READAHEAD              "True if the selected file, the target application and its libraries should be read into memory in the background before launch, otherwise false."
+
 #define OPT_TEXT_SCROLL_OPTION      "text_scroll_option"
 #define HELP_TEXT_SCROLL_OPTION     "True if horizontal the text scroll option should enabled, otherwise false."
 
@@ -142,6 +162,24 @@ using namespace std;
 #define OPT_MAX_ENTRIES             "max_entries"
 #define HELP_MAX_ENTRIES            "Maximum number of entries to be in the display list."
 
+#define OPT_SCALE_MODE              "scale_mode"
+#define HELP_SCALE_MODE             "Filter used to scale the background and previews, 0 for nearest 1 for bilinear 2 for box."
+
+#define OPT_PREVIEW_CACHE           "preview_cache"
+#define HELP_PREVIEW_CACHE          "Number of scaled preview images kept in memory."
+
+#define OPT_MEMORY_LIMIT            "memory_limit"
+#define HELP_MEMORY_LIMIT           "Kilobytes the images, text and lists may hold before the previews and text are freed, 0 for no limit."
+
+#define OPT_READAHEAD_DWELL         "readahead_dwell"
+#define HELP_READAHEAD_DWELL        "Milliseconds spent editing the arguments of an entry before it is read ahead, 0 to only read ahead on launch."
+
+#define OPT_JOURNAL_LIMIT           "journal_limit"
+#define HELP_JOURNAL_LIMIT          "Kilobytes of entry changes kept in the profile journal before the profile is rewritten with them, 0 to rewrite it on every close with changes."
+
+#define OPT_LOG_LEVEL               "log_level"
+#define HELP_LOG_LEVEL              "Highest level of messages logged, 0 for none 1 for errors 2 for warnings 3 for information 4 for debug detail like archive contents."
+
 #define OPT_SCROLL_SPEED            "scroll_speed"
 #define HELP_SCROLL_SPEED           "The speed of the horizontal the text scroll speed, lower faster, higher slower.."
 
@@ -210,6 +248,15 @@ using namespace std;
 #define OPT_PATH_PREVIEWS           "previews_path"
 #define HELP_PATH_PREVIEWS          "Path to read preview graphics."
 
+#define OPT_PATH_THUMBNAILS         "thumbnails_path"
+#define HELP_PATH_THUMBNAILS        "Path to store previews already scaled to the screen, leave empty to decode previews every time."
+
+#define OPT_PATH_BUNDLE             "bundle_path"
+#define HELP_PATH_BUNDLE            "File to store the graphics and font ready for the screen, leave empty to load them every time."
+
+#define OPT_PATH_SNAPSHOT           "snapshot_path"
+#define HELP_PATH_SNAPSHOT          "File to keep the file list between runs so it is shown before the profile is loaded, leave empty to always scan on start."
+
 #define OPT_PATH_FONT               "font_path"
 #define HELP_PATH_FONT              "Path to ttf font file."
 
@@ -291,6 +338,7 @@ using namespace std;
 #define OPT_KEYSELECT               "key_select"
 #define OPT_KEYBACK                 "key_back"
 #define OPT_KEYQUIT                 "key_quit"
+#define OPT_KEYHUD                  "key_hud"
 
 // Joystick
 #define OPT_JOYUP                   "button_up"
@@ -306,6 +354,7 @@ using namespace std;
 #define OPT_JOYSELECT               "button_select"
 #define OPT_JOYBACK                 "button_back"
 #define OPT_JOYQUIT                 "button_quit"
+#define OPT_JOYHUD                  "button_hud"
 
 #define OPT_DEADZONE                "deadzone"
 #define HELP_DEADZONE               "Deadzone for analog joysticks."
@@ -327,8 +376,9 @@ enum EVENT_T {
     EVENT_SELECT,       /**< 11 Select the current item. */
     EVENT_BACK,         /**< 12 Go back from the current mode and return to the previous mode. */
     EVENT_QUIT,         /**< 13 Quit the launcher. */
-    EVENT_TOTAL,        /**< 14 Total number of events. */
-    EVENT_NONE          /**< 15 No event. */
+    EVENT_HUD,          /**< 14 Show or hide the performance display. */
+    EVENT_TOTAL,        /**< 15 Total number of events. */
+    EVENT_NONE          /**< 16 No event. */
 };
 
 /** @brief Mode for navagating to an entry quickly.
@@ -369,6 +419,30 @@ enum FONT_SIZE_T {
     FONT_SIZE_TOTAL
 };
 
+/** @brief Kinds of configurable options, which decide how the value is read and written
+ */
+enum OPTIONTYPES_T {
+    OPTION_LABEL=0,                 /** @brief Heading written to the file, there is no value */
+    OPTION_COLORS,                  /** @brief Table of the color names written to the file, there is no value */
+    OPTION_BOOL,                    /** @brief bool, or vector<bool> with an index */
+    OPTION_UINT8,                   /** @brief uint8_t, or vector<uint8_t> with an index */
+    OPTION_INT16,                   /** @brief int16_t */
+    OPTION_UINT16,                  /** @brief uint16_t */
+    OPTION_STRING,                  /** @brief string, or vector<string> with an index */
+    OPTION_KEY                      /** @brief vector<KeyCode> with an index, the key name is written as the help */
+};
+
+/** @brief Data structure for a configurable option
+ */
+struct option_t {
+    option_t() : Type(OPTION_LABEL), Index(-1), Field(NULL), Key(""), Help("") {};
+    uint8_t     Type;               /** @brief Kind of value (index is defined in OPTIONTYPES_T) */
+    int16_t     Index;              /** @brief Index into a vector field, -1 if the field is the value */
+    void*       Field;              /** @brief Member holding the value */
+    string      Key;                /** @brief Name of the option in the file, or the text of a heading */
+    string      Help;               /** @brief Comment written after the value */
+};
+
 /** @brief Class that handles loading and saving of all configurable options
  */
 class CConfig : public CBase
@@ -406,12 +480,17 @@ class CConfig : public CBase
         bool                UnusedKeysLaunch;       /**< CONFIGURABLE Refer to HELP_UNUSED_KEYS_SELECT */
         bool                UnusedJoysLaunch;       /**< CONFIGURABLE Refer to HELP_UNUSED_JOYS_SELECT */
         bool                ReloadLauncher;         /**< CONFIGURABLE Refer to HELP_RELOAD_LAUNCHER */
+        bool                Supervisor;             /**< CONFIGURABLE Refer to HELP_SUPERVISOR */
+        bool                LaunchShell;            /**< CONFIGURABLE Refer to HELP_LAUNCH_SHELL */
+        bool                Readahead;              /**< CONFIGURABLE Refer to HELP_READAHEAD */
         bool                TextScrollOption;       /**< CONFIGURABLE Refer to HELP_TEXT_SCROLL_OPTION */
         bool                AutoLayout;             /**< CONFIGURABLE Refer to HELP_AUTOLAYOUT */
         bool                FilenameArgNoExt;       /**< CONFIGURABLE Refer to HELP_FILENAMEARGNOEXT */
         bool                FilenameAbsPath;        /**< CONFIGURABLE Refer to HELP_FILEABSPATH */
         uint8_t             EntryFastMode;          /**< CONFIGURABLE Refer to HELP_ENTRY_FAST_MODE */
         uint8_t             MaxEntries;             /**< CONFIGURABLE Refer to HELP_MAX_ENTRIES */
+        uint8_t             ScaleMode;              /**< CONFIGURABLE Refer to HELP_SCALE_MODE */
+        uint8_t             LogLevel;               /**< CONFIGURABLE Refer to HELP_LOG_LEVEL */
         uint8_t             ColorButton;            /**< CONFIGURABLE Refer to HELP_COLOR_BUTTON */
         uint8_t             ColorFontButton;        /**< CONFIGURABLE Refer to HELP_COLOR_FONTBUTTON */
         uint8_t             ColorBackground;        /**< CONFIGURABLE Refer to HELP_COLOR_BACKGND */
@@ -423,6 +502,10 @@ class CConfig : public CBase
         int16_t             ScreenDepth;            /**< CONFIGURABLE Refer to HELP_SCREEN_DEPTH */
         uint16_t            PrevEntryIndex;         /**< CONFIGURABLE Refer to HELP_PREV_ENTRY_INDEX */
         uint16_t            CPUClock;               /**< CONFIGURABLE Refer to HELP_CPU_CLOCK */
+        uint16_t            PreviewCache;           /**< CONFIGURABLE Refer to HELP_PREVIEW_CACHE */
+        uint16_t            MemoryLimit;            /**< CONFIGURABLE Refer to HELP_MEMORY_LIMIT */
+        uint16_t            ReadaheadDwell;         /**< CONFIGURABLE Refer to HELP_READAHEAD_DWELL */
+        uint16_t            JournalLimit;           /**< CONFIGURABLE Refer to HELP_JOURNAL_LIMIT */
         uint16_t            ScrollSpeed;            /**< CONFIGURABLE Refer to HELP_SCROLL_PAUSE_SPEED */
         uint16_t            ScrollPauseSpeed;       /**< CONFIGURABLE Refer to HELP_SCROLL_PAUSE_SPEED */
         uint16_t            PathYDelta;             /**< CONFIGURABLE Refer to HELP_SCROLL_PAUSE_SPEED */
@@ -449,6 +532,9 @@ class CConfig : public CBase
         float               ScreenRatioH;           /**< NOT CONFIGURABLE The ratio of the current resolution to the base resolution, used for scaling. */
         string              ZipPath;                /**< CONFIGURABLE Refer to HELP_PATH_ZIPTEMP */
         string              PreviewsPath;           /**< CONFIGURABLE Refer to HELP_PATH_PREVIEWS */
+        string              ThumbnailsPath;         /**< CONFIGURABLE Refer to HELP_PATH_THUMBNAILS */
+        string              BundlePath;             /**< CONFIGURABLE Refer to HELP_PATH_BUNDLE */
+        string              SnapshotPath;           /**< CONFIGURABLE Refer to HELP_PATH_SNAPSHOT */
         string              PathFont;               /**< CONFIGURABLE Refer to HELP_PATH_FONT */
         string              PathBackground;         /**< CONFIGURABLE Refer to HELP_PATH_BACKGND */
         string              PathPointer;            /**< CONFIGURABLE Refer to HELP_PATH_POINTER */
@@ -462,6 +548,38 @@ class CConfig : public CBase
         vector<uint8_t>     FontSizes;              /**< CONFIGURABLE Point size of the font sizes */
         vector<SDL_Color>   Colors;                 /**< NOT CONFIGURABLE Basic color types */
         vector<string>      ColorNames;             /**< NOT CONFIGURABLE Basic color names */
+
+    private:
+        /** @brief Describe every option in the order they are written to the file
+         */
+        void    DefineOptions   ( void );
+
+        /** @brief Add an option to the description
+         * @param type : kind of value (index is defined in OPTIONTYPES_T)
+         * @param key : name of the option in the file, or the text of a heading
+         * @param field : member holding the value, NULL if there is none
+         * @param index : index into a vector field, -1 if the field is the value
+         * @param help : comment written after the value
+         */
+        void    AddOption       ( uint8_t type, const string& key, void* field, int16_t index, const string& help );
+
+        /** @brief Set the value of an option from its text in the file
+         * @param option : the option
+         * @param value : the text of the value
+         */
+        void    SetOption       ( const option_t& option, const string& value );
+
+        /** @brief Get the text of the value of an option for the file
+         * @param option : the option
+         * @return the text of the value
+         */
+        string  GetOption       ( const option_t& option );
+
+        CConfig(const CConfig &);
+        CConfig & operator=(const CConfig&);
+
+        vector<option_t>        Options;            /**< Every option in the order they are written to the file. */
+        map<string, uint16_t>   OptionIndices;      /**< Lookup from key to the index of its option. */
 };
 
 #endif // CCONFIG_H
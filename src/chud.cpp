@@ -0,0 +1,333 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "chud.h"
+
+CHud::CHud() : CBase(),
+        Shown       (false),
+        FrameStart  (0),
+        Spent       (0),
+        CostPeak    (0),
+        Samples     (HUD_SAMPLES, 0),
+        Next        (0),
+        ScanTime    (0),
+        Rendered    (0),
+        Resident    (0),
+        MinorFaults (0),
+        MajorFaults (0),
+        MinorLast   (0),
+        MajorLast   (0),
+        Lines       ()
+{
+    for (uint8_t index=0; index<HUD_TOTAL; index++)
+    {
+        Counts[index] = 0;
+    }
+}
+
+CHud::~CHud()
+{
+    Close();
+}
+
+void CHud::Close( void )
+{
+    for (uint16_t index=0; index<Lines.size(); index++)
+    {
+        SDL_FreeSurface( Lines.at(index) );
+    }
+    Lines.clear();
+}
+
+void CHud::Toggle( void )
+{
+    Shown = !Shown;
+
+    // Start from a clean graph, nothing was measured while hidden
+    Samples.assign( HUD_SAMPLES, 0 );
+    Next       = 0;
+    Spent      = 0;
+    CostPeak   = 0;
+    FrameStart = Now();
+    Rendered   = 0;
+    for (uint8_t index=0; index<HUD_TOTAL; index++)
+    {
+        Counts[index] = 0;
+    }
+    ReadProc();
+    MinorLast  = MinorFaults;
+    MajorLast  = MajorFaults;
+
+    if (Shown == false)
+    {
+        Close();
+    }
+}
+
+bool CHud::Visible( void )
+{
+    return Shown;
+}
+
+void CHud::Start( void )
+{
+    if (Shown == true)
+    {
+        FrameStart = Now();
+    }
+}
+
+void CHud::Frame( uint8_t kind )
+{
+    uint32_t elapsed;
+
+    if (Shown == false)
+    {
+        return;
+    }
+
+    elapsed = Now() - FrameStart;
+    Samples.at(Next) = (elapsed > Spent) ? elapsed - Spent : 0;
+    Next = (Next + 1) % HUD_SAMPLES;
+
+    if (kind < HUD_TOTAL)
+    {
+        Counts[kind]++;
+    }
+    if (Spent > CostPeak)
+    {
+        CostPeak = Spent;
+    }
+    Spent = 0;
+}
+
+void CHud::Scanned( uint32_t elapsed )
+{
+    ScanTime = elapsed;
+}
+
+bool CHud::Due( bool redraw )
+{
+    return (Shown == true) && ((redraw == true) || (SDL_GetTicks() - Rendered >= HUD_REFRESH));
+}
+
+int8_t CHud::Draw( SDL_Surface* screen, TTF_Font* font, SDL_Color color, const previewstats_t& previews,
+                   const memstats_t& memory, SDL_Rect& area )
+{
+    uint64_t    start;
+    uint16_t    width;
+    uint16_t    height;
+    int16_t     y;
+    uint32_t    bar;
+    uint32_t    foreground;
+    uint32_t    over;
+    SDL_Rect    fill;
+
+    start = Now();
+
+    if ((Lines.size() == 0) || (SDL_GetTicks() - Rendered >= HUD_REFRESH))
+    {
+        if (Render( font, color, previews, memory ))
+        {
+            return 1;
+        }
+    }
+
+    width  = HUD_SAMPLES*HUD_BAR_WIDTH;
+    height = HUD_GRAPH_HEIGHT;
+    for (uint16_t index=0; index<Lines.size(); index++)
+    {
+        width   = MAX( width, Lines.at(index)->w );
+        height += Lines.at(index)->h;
+    }
+    width  += 2*HUD_MARGIN;
+    height += 3*HUD_MARGIN;
+
+    area.x = MAX( screen->w - width, 0 );
+    area.y = MAX( screen->h - height, 0 );
+    area.w = width;
+    area.h = height;
+
+    // The box is opaque so the overlay can be drawn over itself when nothing below changed
+    fill = area;
+    SDL_FillRect( screen, &fill, SDL_MapRGB( screen->format, 0, 0, 0 ) );
+
+    y = area.y + HUD_MARGIN;
+    for (uint16_t index=0; index<Lines.size(); index++)
+    {
+        ApplyImage( area.x + HUD_MARGIN, y, Lines.at(index), screen, NULL );
+        y += Lines.at(index)->h;
+    }
+    y += HUD_MARGIN + HUD_GRAPH_HEIGHT;
+
+    // Bars reach the middle at the frame budget and turn red past it
+    foreground = SDL_MapRGB( screen->format, color.r, color.g, color.b );
+    over       = SDL_MapRGB( screen->format, 255, 0, 0 );
+    for (uint16_t index=0; index<HUD_SAMPLES; index++)
+    {
+        bar = Samples.at((Next + index) % HUD_SAMPLES);
+
+        fill.x = area.x + HUD_MARGIN + index*HUD_BAR_WIDTH;
+        fill.w = HUD_BAR_WIDTH;
+        fill.h = MIN( (uint64_t)bar*(HUD_GRAPH_HEIGHT/2)/HUD_BUDGET, (uint64_t)HUD_GRAPH_HEIGHT );
+        fill.y = y - fill.h;
+        SDL_FillRect( screen, &fill, (bar > HUD_BUDGET) ? over : foreground );
+    }
+    fill.x = area.x + HUD_MARGIN;
+    fill.y = y - HUD_GRAPH_HEIGHT/2;
+    fill.w = HUD_SAMPLES*HUD_BAR_WIDTH;
+    fill.h = 1;
+    SDL_FillRect( screen, &fill, over );
+
+    Spent += Now() - start;
+    return 0;
+}
+
+int8_t CHud::Render( TTF_Font* font, SDL_Color color, const previewstats_t& previews, const memstats_t& memory )
+{
+    uint32_t        now;
+    uint32_t        period;
+    uint64_t        total;
+    uint32_t        peak;
+    uint32_t        lookups;
+    SDL_Surface*    line;
+    vector<string>  texts;
+    stringstream    text;
+
+    now    = SDL_GetTicks();
+    period = MAX( now - Rendered, 1 );
+    if (Rendered == 0)
+    {
+        period = 1000;
+    }
+
+    ReadProc();
+
+    text << "fps " << Counts[HUD_DRAWN]*1000/period
+         << " skip " << Counts[HUD_SKIPPED]*1000/period
+         << " sleep " << Counts[HUD_SLEEP]*1000/period;
+    texts.push_back( text.str() );
+
+    total = 0;
+    peak  = 0;
+    for (uint16_t index=0; index<HUD_SAMPLES; index++)
+    {
+        total += Samples.at(index);
+        peak   = MAX( peak, Samples.at(index) );
+    }
+    text.str( "" );
+    text << fixed << setprecision(1)
+         << "frame avg " << total/HUD_SAMPLES/1000.0 << " max " << peak/1000.0 << " ms"
+         << " hud " << CostPeak << " us";
+    texts.push_back( text.str() );
+
+    text.str( "" );
+    text << "scan " << ScanTime << " ms";
+    texts.push_back( text.str() );
+
+    lookups = previews.Hits + previews.Misses;
+    text.str( "" );
+    text << "preview " << previews.DecodeLast << " ms avg " << ((previews.Decodes > 0) ? previews.DecodeTotal/previews.Decodes : 0)
+         << " ms hit " << ((lookups > 0) ? previews.Hits*100/lookups : 0) << "%";
+    texts.push_back( text.str() );
+
+    text.str( "" );
+    text << "rss " << Resident << " kB flt " << MinorFaults << " (+" << MinorFaults - MinorLast << ")"
+         << " maj " << MajorFaults << " (+" << MajorFaults - MajorLast << ")";
+    texts.push_back( text.str() );
+
+    text.str( "" );
+    text << "mem " << memory.Held/1024 << " kB";
+    if (memory.Limit > 0)
+    {
+        text << " of " << memory.Limit/1024 << " kB";
+    }
+    text << " evict " << memory.Evictions << " (" << memory.Evicted/1024 << " kB)" << (memory.Pressure ? " pressure" : "");
+    texts.push_back( text.str() );
+
+    Close();
+    for (uint16_t index=0; index<texts.size(); index++)
+    {
+        line = TTF_RenderText_Solid( font, texts.at(index).c_str(), color );
+        if (line == NULL)
+        {
+            Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
+            return 1;
+        }
+        Lines.push_back( line );
+    }
+
+    for (uint8_t index=0; index<HUD_TOTAL; index++)
+    {
+        Counts[index] = 0;
+    }
+    CostPeak  = 0;
+    MinorLast = MinorFaults;
+    MajorLast = MajorFaults;
+    Rendered  = now;
+    return 0;
+}
+
+void CHud::ReadProc( void )
+{
+    ifstream        fin;
+    string          line;
+    uint32_t        pages;
+    uint32_t        size;
+    stringstream    fields;
+    vector<string>  values;
+
+    // statm is in pages: total size then resident
+    fin.open( HUD_PROC_STATM, ios_base::in );
+    if (fin && (fin >> size >> pages))
+    {
+        Resident = pages * (sysconf( _SC_PAGESIZE ) / 1024);
+    }
+    fin.close();
+    fin.clear();
+
+    // The name of the program is in brackets and may hold spaces, the fields are counted after it
+    fin.open( HUD_PROC_STAT, ios_base::in );
+    if (fin && getline( fin, line ) && (line.find_last_of( ')' ) != string::npos))
+    {
+        fields.str( line.substr( line.find_last_of( ')' )+1 ) );
+        while (fields >> line)
+        {
+            values.push_back( line );
+        }
+        // minflt and majflt are fields 10 and 12 of the status, the first field after the name is 3
+        if (values.size() > 9)
+        {
+            MinorFaults = a_to_i( values.at(7) );
+            MajorFaults = a_to_i( values.at(9) );
+        }
+    }
+    fin.close();
+}
+
+uint64_t CHud::Now( void )
+{
+    struct timeval now;
+
+    gettimeofday( &now, NULL );
+    return (uint64_t)now.tv_sec*1000000 + now.tv_usec;
+}
@@ -0,0 +1,150 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CHUD_H
+#define CHUD_H
+
+#include <sys/time.h>
+
+#include "cbase.h"
+#include "cpreview.h"
+#include "cmembudget.h"
+
+using namespace std;
+
+#define HUD_SAMPLES         120                 /** Number of frames shown in the graph. */
+#define HUD_BAR_WIDTH       2                   /** Width of a frame in the graph. */
+#define HUD_GRAPH_HEIGHT    48                  /** Height of the graph. */
+#define HUD_BUDGET          16667               /** Time of one frame at 60 fps in microseconds, drawn at half the graph height. */
+#define HUD_REFRESH         250                 /** Milliseconds between updates of the overlay if nothing below it is redrawn. */
+#define HUD_MARGIN          4                   /** Space around the text and the graph. */
+#define HUD_PROC_STAT       "/proc/self/stat"   /** Status of the process holding the page fault counts. */
+#define HUD_PROC_STATM      "/proc/self/statm"  /** Memory usage of the process in pages. */
+
+/** @brief Kinds of frames counted by the display
+ */
+enum HUD_FRAMES_T {
+    HUD_DRAWN=0,                    /** @brief Frame presented to the screen */
+    HUD_SKIPPED,                    /** @brief Frame not presented to catch up */
+    HUD_SLEEP,                      /** @brief Frame not presented as nothing changed */
+    HUD_TOTAL
+};
+
+/** @brief This class shows the frame times and counters of the launcher on top of the screen
+ *
+ *  The text is rendered again at most every HUD_REFRESH ms, between updates only the cached surfaces are
+ *  blitted when the screen below was redrawn. The time spent drawing the overlay is shown on its own and taken
+ *  out of the frame times in the graph.
+ */
+class CHud : public CBase
+{
+    public:
+        /** Constructor. */
+        CHud();
+        /** Destructor. */
+        virtual ~CHud();
+
+        /** @brief Free the rendered text.
+         */
+        void            Close       ( void );
+
+        /** @brief Show or hide the overlay.
+         */
+        void            Toggle      ( void );
+
+        /** @brief Check if the overlay is shown.
+         * @return true if shown
+         */
+        bool            Visible     ( void );
+
+        /** @brief Note the start of the work of a frame, after the delay of the last one.
+         */
+        void            Start       ( void );
+
+        /** @brief Note the end of the work of a frame, before the delay.
+         * @param kind : how the frame ended (index is defined in HUD_FRAMES_T)
+         */
+        void            Frame       ( uint8_t kind );
+
+        /** @brief Note the time taken by the last directory scan.
+         * @param elapsed : time in milliseconds
+         */
+        void            Scanned     ( uint32_t elapsed );
+
+        /** @brief Check if the overlay has to be drawn this frame.
+         * @param redraw : true if the screen below was drawn this frame
+         * @return true if it has to be drawn
+         */
+        bool            Due         ( bool redraw );
+
+        /** @brief Draw the overlay in the bottom right corner of the screen.
+         * @param screen : surface to draw on
+         * @param font : font for the text
+         * @param color : color of the text and the graph
+         * @param previews : counters of the previews
+         * @param memory : counters of the memory budget
+         * @param area : set to the area covered by the overlay
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Draw        ( SDL_Surface* screen, TTF_Font* font, SDL_Color color,
+                                      const previewstats_t& previews, const memstats_t& memory, SDL_Rect& area );
+
+    private:
+        /** @brief Render the text with the counters since the last render.
+         * @param font : font for the text
+         * @param color : color of the text
+         * @param previews : counters of the previews
+         * @param memory : counters of the memory budget
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Render      ( TTF_Font* font, SDL_Color color, const previewstats_t& previews, const memstats_t& memory );
+
+        /** @brief Read the resident memory and page fault counts of the process.
+         */
+        void            ReadProc    ( void );
+
+        /** @brief Get the current time.
+         * @return time in microseconds
+         */
+        uint64_t        Now         ( void );
+
+        CHud(const CHud &);
+        CHud & operator=(const CHud&);
+
+        bool                    Shown;              /**< True if the overlay is drawn. */
+        uint64_t                FrameStart;         /**< Time the work of the current frame started. */
+        uint32_t                Spent;              /**< Time spent drawing the overlay in the current frame. */
+        uint32_t                CostPeak;           /**< Highest time spent drawing the overlay in a frame since the last render. */
+        vector<uint32_t>        Samples;            /**< Work time of the last frames without the overlay, in microseconds. */
+        uint16_t                Next;               /**< Index of the sample written next. */
+        uint16_t                Counts[HUD_TOTAL];  /**< Frames of each kind since the last render. */
+        uint32_t                ScanTime;           /**< Time taken by the last directory scan in milliseconds. */
+        uint32_t                Rendered;           /**< Tick count when the text was last rendered. */
+        uint32_t                Resident;           /**< Resident memory of the process in kB. */
+        uint32_t                MinorFaults;        /**< Minor page faults of the process. */
+        uint32_t                MajorFaults;        /**< Major page faults of the process. */
+        uint32_t                MinorLast;          /**< Minor page faults at the previous render. */
+        uint32_t                MajorLast;          /**< Major page faults at the previous render. */
+        vector<SDL_Surface*>    Lines;              /**< Rendered lines of text. */
+};
+
+#endif // CHUD_H
@@ -0,0 +1,98 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbase.h"
+
+#include <stdarg.h>
+
+/* Counts are added atomically where the compiler can, otherwise the other threads may lose a few */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define IO_ADD(X,Y)         __sync_fetch_and_add( &(X), (Y) )
+#else
+#define IO_ADD(X,Y)         ((X) += (Y))
+#endif
+
+static const char* IoActionNames[IO_ACTIONS] = { "startup", "navigate", "filter", "launch" };
+static const char* IoCallNames[IO_CALLS] = { "open", "stat", "opendir", "readdir", "image", "mkdir", "remove", "write" };
+
+static volatile uint32_t    IoCounts[IO_ACTIONS][IO_CALLS];     // Calls since the start
+static volatile uint32_t    IoTotals[IO_ACTIONS];               // Bytes read and written since the start
+static volatile uint8_t     IoCurrent = IO_STARTUP;             // Action the calls are counted to
+
+static void IoLog( const char* message, ... )
+{
+    va_list args;
+
+    va_start( args, message );
+    LogWrite( LOG_INFO, __FILENAME__, __LINE__, message, args );
+    va_end( args );
+}
+
+void IoAction( uint8_t action )
+{
+    if (action < IO_ACTIONS)
+    {
+        IoCurrent = action;
+    }
+}
+
+void IoCount( uint8_t call, uint32_t bytes )
+{
+    uint8_t action = IoCurrent;
+
+    if (call < IO_CALLS)
+    {
+        IO_ADD( IoCounts[action][call], 1 );
+        IO_ADD( IoTotals[action], bytes );
+    }
+}
+
+uint32_t IoCalls( uint8_t action, uint8_t call )
+{
+    return (action < IO_ACTIONS && call < IO_CALLS) ? IoCounts[action][call] : 0;
+}
+
+uint32_t IoBytes( uint8_t action )
+{
+    return (action < IO_ACTIONS) ? IoTotals[action] : 0;
+}
+
+const char* IoActionName( uint8_t action )
+{
+    return (action < IO_ACTIONS) ? IoActionNames[action] : "";
+}
+
+const char* IoCallName( uint8_t call )
+{
+    return (call < IO_CALLS) ? IoCallNames[call] : "";
+}
+
+void IoReport( void )
+{
+    for (uint8_t action=0; action<IO_ACTIONS; action++)
+    {
+        IoLog( "I/O %-8s open %6u stat %6u opendir %6u readdir %8u image %6u mkdir %4u remove %4u write %6u bytes %10u",
+               IoActionNames[action], IoCounts[action][IO_OPEN], IoCounts[action][IO_STAT], IoCounts[action][IO_OPENDIR],
+               IoCounts[action][IO_READDIR], IoCounts[action][IO_IMAGE], IoCounts[action][IO_MKDIR],
+               IoCounts[action][IO_REMOVE], IoCounts[action][IO_WRITE], IoTotals[action] );
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CIOSTATS_H
+#define CIOSTATS_H
+
+#include <stdint.h>
+
+/** @brief User actions the file system calls are counted to, each lasts until the next one
+ */
+enum IO_ACTIONS_T {
+    IO_STARTUP=0,                   /** @brief Loading the resources before any input */
+    IO_NAVIGATE,                    /** @brief Moving through the list, folders, archives and menus */
+    IO_FILTER,                      /** @brief Typing or erasing a letter of the filter */
+    IO_LAUNCH,                      /** @brief Preparing and running the selected entry */
+    IO_ACTIONS
+};
+
+/** @brief Kinds of file system calls that are counted
+ */
+enum IO_CALLS_T {
+    IO_OPEN=0,                      /** @brief A file opened, by open, fopen, a stream or the zip reader */
+    IO_STAT,                        /** @brief A stat of a path */
+    IO_OPENDIR,                     /** @brief A directory opened for listing */
+    IO_READDIR,                     /** @brief A directory entry read */
+    IO_IMAGE,                       /** @brief An image file decoded by SDL_image */
+    IO_MKDIR,                       /** @brief A directory created */
+    IO_REMOVE,                      /** @brief A file removed */
+    IO_WRITE,                       /** @brief A block written to a file */
+    IO_CALLS
+};
+
+/** @brief Set the user action the following calls are counted to.
+ * @param action : the action (index is defined in IO_ACTIONS_T)
+ */
+void        IoAction        ( uint8_t action );
+
+/** @brief Count a call to the current action, from any thread.
+ * @param call : the kind of call (index is defined in IO_CALLS_T)
+ * @param bytes : bytes read or written by it, if known
+ */
+void        IoCount         ( uint8_t call, uint32_t bytes = 0 );
+
+/** @brief Get the calls of a kind counted to an action.
+ * @param action : the action (index is defined in IO_ACTIONS_T)
+ * @param call : the kind of call (index is defined in IO_CALLS_T)
+ * @return number of calls
+ */
+uint32_t    IoCalls         ( uint8_t action, uint8_t call );
+
+/** @brief Get the bytes read and written for an action.
+ * @param action : the action (index is defined in IO_ACTIONS_T)
+ * @return number of bytes
+ */
+uint32_t    IoBytes         ( uint8_t action );
+
+/** @brief Get the name of an action, as used in the log and reports.
+ * @param action : the action (index is defined in IO_ACTIONS_T)
+ * @return the name
+ */
+const char* IoActionName    ( uint8_t action );
+
+/** @brief Get the name of a kind of call, as used in the log and reports.
+ * @param call : the kind of call (index is defined in IO_CALLS_T)
+ * @return the name
+ */
+const char* IoCallName      ( uint8_t call );
+
+/** @brief Log the calls and bytes of each action.
+ */
+void        IoReport        ( void );
+
+#endif // CIOSTATS_H
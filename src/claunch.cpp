@@ -0,0 +1,473 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "claunch.h"
+
+#include <string.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+/** Shell builtins that change the shell itself or have no program of the same name, a step starting with one needs the shell. */
+static const char* LaunchBuiltins[] = { ".", ":", "alias", "bg", "break", "cd", "continue", "eval", "exec", "exit", "export",
+                                        "fg", "getopts", "hash", "jobs", "local", "read", "readonly", "return", "set", "shift",
+                                        "source", "times", "trap", "type", "ulimit", "umask", "unalias", "unset", "wait" };
+#define LAUNCH_BUILTIN_TOTAL    (sizeof(LaunchBuiltins)/sizeof(LaunchBuiltins[0]))
+
+CLaunch::CLaunch() : CBase(),
+        SyncPaths   (),
+        SelectTime  (""),
+        Steps       (),
+        ReloadPath  (""),
+        Reload      ()
+{
+}
+
+CLaunch::~CLaunch()
+{
+}
+
+void CLaunch::Clear( void )
+{
+    SyncPaths.clear();
+    SelectTime.clear();
+    Steps.clear();
+    ReloadPath.clear();
+    Reload.clear();
+}
+
+void CLaunch::Begin( const string& path, bool library )
+{
+    Steps.push_back( launchstep_t() );
+    Steps.back().Path    = path;
+    Steps.back().Library = library;
+}
+
+void CLaunch::AddText( const string& text )
+{
+    launchword_t word;
+
+    if (Steps.size() > 0 && text.length() > 0)
+    {
+        word.Literal = false;
+        word.Text    = text;
+        Steps.back().Words.push_back( word );
+    }
+}
+
+void CLaunch::AddLiteral( const string& text )
+{
+    launchword_t word;
+
+    if (Steps.size() > 0)
+    {
+        word.Literal = true;
+        word.Text    = text;
+        Steps.back().Words.push_back( word );
+    }
+}
+
+bool CLaunch::Direct( void )
+{
+    vector<string> arguments;
+
+    for (uint16_t i=0; i<Steps.size(); i++)
+    {
+        for (uint16_t j=0; j<Steps.at(i).Words.size(); j++)
+        {
+            if (   (Steps.at(i).Words.at(j).Literal == false)
+                && (Steps.at(i).Words.at(j).Text.find_first_of( LAUNCH_SHELL_CHARS ) != string::npos)
+               )
+            {
+                return false;
+            }
+        }
+
+        // A leading assignment or a builtin is only understood by the shell
+        Arguments( Steps.at(i), arguments );
+        if (arguments.size() > 0 && (arguments.at(0).find('=') != string::npos || Builtin( arguments.at(0) ) == true))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+string CLaunch::Script( void )
+{
+    string script;
+
+    for (uint16_t i=0; i<Steps.size(); i++)
+    {
+        if (Steps.at(i).Path.length() > 0)
+        {
+            script += "cd " + Quote(Steps.at(i).Path) + "; ";
+        }
+        if (Steps.at(i).Library == true)
+        {
+            script += string(LAUNCH_ENV_LIBRARY) + "=./; export " + string(LAUNCH_ENV_LIBRARY) + "; ";
+        }
+        for (uint16_t j=0; j<Steps.at(i).Words.size(); j++)
+        {
+            if (Steps.at(i).Words.at(j).Literal == true)
+            {
+                script += Quote(Steps.at(i).Words.at(j).Text);
+            }
+            else
+            {
+                script += Steps.at(i).Words.at(j).Text;
+            }
+        }
+        script += "; ";
+    }
+    return script;
+}
+
+int8_t CLaunch::Execute( bool shell )
+{
+    int8_t          result;
+    launchstep_t    step;
+    vector<string>  arguments;
+
+    result = 0;
+    if ((shell == true) || (Direct() == false))
+    {
+        Log( __FILENAME__, __LINE__, "Running the selection through %s", LAUNCH_SHELL );
+
+        arguments.push_back( LAUNCH_SHELL );
+        arguments.push_back( "-c" );
+        arguments.push_back( Script() );
+        result = Spawn( step, arguments );
+        Flush();
+        return result;
+    }
+
+    for (uint16_t i=0; i<Steps.size(); i++)
+    {
+        Arguments( Steps.at(i), arguments );
+        if (arguments.size() > 0)
+        {
+            // Like the shell a failed command does not stop the ones after it
+            if (Spawn( Steps.at(i), arguments ))
+            {
+                result = 1;
+            }
+        }
+    }
+
+    Flush();
+    return result;
+}
+
+int8_t CLaunch::Replace( bool shell )
+{
+    string          script;
+    launchstep_t    step;
+    vector<string>  arguments;
+    vector<char*>   argv;
+
+    // With nothing to run after it, a single direct step takes the place of the launcher
+    if ((shell == false) && (Steps.size() == 1) && (SyncPaths.size() == 0) && (Reload.size() == 0) && (Direct() == true))
+    {
+        Arguments( Steps.at(0), arguments );
+        step = Steps.at(0);
+    }
+
+    if (arguments.size() == 0)
+    {
+        Log( __FILENAME__, __LINE__, "Running the selection through %s", LAUNCH_SHELL );
+
+        script = Script();
+        // Like Flush only the file system of each path, a sync without -f flushes them all instead
+        for (uint16_t i=0; i<SyncPaths.size(); i++)
+        {
+            if (SyncPaths.at(i).length() <= 0)
+            {
+                continue;
+            }
+            if (SyncPaths.at(i).compare(LAUNCH_SYNC_ALL) == 0)
+            {
+                script += "sync; ";
+                break;
+            }
+            script += "sync -f " + Quote(SyncPaths.at(i)) + " 2>/dev/null || sync; ";
+        }
+        if (Reload.size() > 0)
+        {
+            if (ReloadPath.length() > 0)
+            {
+                script += "cd " + Quote(ReloadPath) + "; ";
+            }
+            script += "exec";
+            for (uint16_t i=0; i<Reload.size(); i++)
+            {
+                script += " " + Quote(Reload.at(i));
+            }
+        }
+        arguments.push_back( LAUNCH_SHELL );
+        arguments.push_back( "-c" );
+        arguments.push_back( script );
+    }
+
+    for (uint16_t i=0; i<arguments.size(); i++)
+    {
+        argv.push_back( const_cast<char*>(arguments.at(i).c_str()) );
+    }
+    argv.push_back( NULL );
+
+    LogFlush();
+    Exec( step, argv );
+
+    Log( __FILENAME__, __LINE__, "Error failed to run %s: %s", arguments.at(0).c_str(), strerror(errno) );
+    return 1;
+}
+
+void CLaunch::Flush( void )
+{
+    int32_t fd;
+
+    for (uint16_t i=0; i<SyncPaths.size(); i++)
+    {
+        if (SyncPaths.at(i).length() <= 0)
+        {
+            continue;
+        }
+
+        if (SyncPaths.at(i).compare(LAUNCH_SYNC_ALL) == 0)
+        {
+            Log( __FILENAME__, __LINE__, "Flushing all file systems" );
+            sync();
+            return;
+        }
+
+        fd = open( SyncPaths.at(i).c_str(), O_RDONLY );
+        if (fd < 0)
+        {
+            Log( __FILENAME__, __LINE__, "Warning failed to open sync path %s: %s", SyncPaths.at(i).c_str(), strerror(errno) );
+            continue;
+        }
+
+        Log( __FILENAME__, __LINE__, "Flushing the file system of %s", SyncPaths.at(i).c_str() );
+#if defined(SYS_syncfs)
+        if (syscall( SYS_syncfs, fd ) != 0)
+        {
+            Log( __FILENAME__, __LINE__, "Warning syncfs failed for %s: %s", SyncPaths.at(i).c_str(), strerror(errno) );
+            sync();
+        }
+#else
+        sync();
+#endif
+        close( fd );
+    }
+}
+
+void CLaunch::Arguments( const launchstep_t& step, vector<string>& arguments )
+{
+    bool    started;
+    string  current;
+
+    arguments.clear();
+
+    // Text is split on spaces, literals join the argument they touch
+    started = false;
+    for (uint16_t i=0; i<step.Words.size(); i++)
+    {
+        if (step.Words.at(i).Literal == true)
+        {
+            current += step.Words.at(i).Text;
+            started  = true;
+            continue;
+        }
+
+        for (uint32_t j=0; j<step.Words.at(i).Text.length(); j++)
+        {
+            if (isspace( step.Words.at(i).Text.at(j) ))
+            {
+                if (started == true)
+                {
+                    arguments.push_back( current );
+                    current.clear();
+                    started = false;
+                }
+            }
+            else
+            {
+                current += step.Words.at(i).Text.at(j);
+                started  = true;
+            }
+        }
+    }
+    if (started == true)
+    {
+        arguments.push_back( current );
+    }
+}
+
+bool CLaunch::Builtin( const string& name )
+{
+    for (uint16_t i=0; i<LAUNCH_BUILTIN_TOTAL; i++)
+    {
+        if (name.compare( LaunchBuiltins[i] ) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CLaunch::Exec( const launchstep_t& step, vector<char*>& argv )
+{
+    if (step.Path.length() > 0 && chdir( step.Path.c_str() ) != 0)
+    {
+        return;
+    }
+    if (step.Library == true)
+    {
+        setenv( LAUNCH_ENV_LIBRARY, "./", 1 );
+    }
+    if (SelectTime.length() > 0)
+    {
+        setenv( LAUNCH_ENV_TIME, SelectTime.c_str(), 1 );
+    }
+
+    execvp( argv.at(0), &argv.at(0) );
+    if (errno == ENOEXEC)
+    {
+        // A script without an interpreter line, let the shell read it
+        argv.insert( argv.begin(), const_cast<char*>(LAUNCH_SHELL) );
+        execv( LAUNCH_SHELL, &argv.at(0) );
+    }
+}
+
+int8_t CLaunch::Spawn( const launchstep_t& step, const vector<string>& arguments )
+{
+    pid_t           child;
+    int             status;
+    int             error;
+    int             report[2];
+    ssize_t         length;
+    vector<char*>   argv;
+
+    for (uint16_t i=0; i<arguments.size(); i++)
+    {
+        argv.push_back( const_cast<char*>(arguments.at(i).c_str()) );
+    }
+    argv.push_back( NULL );
+
+    // A failed exec is reported through a pipe that a working exec closes
+    if (pipe( report ) == 0)
+    {
+        fcntl( report[0], F_SETFD, FD_CLOEXEC );
+        fcntl( report[1], F_SETFD, FD_CLOEXEC );
+    }
+    else
+    {
+        report[0] = -1;
+        report[1] = -1;
+    }
+
+    // Lines queued by the launcher are written before any output of the child
+    LogFlush();
+
+    child = fork();
+    if (child == 0)
+    {
+        // The only other thread left is the log writer which does not allocate, changing the environment is safe
+        Exec( step, argv );
+        error = errno;
+        if (report[1] >= 0 && write( report[1], &error, sizeof(error) ) < 0)
+        {
+            // The exit status still tells the launcher
+        }
+        _exit( LAUNCH_NOT_FOUND );
+    }
+
+    if (report[1] >= 0)
+    {
+        close( report[1] );
+    }
+
+    if (child < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Error failed to fork %s: %s", arguments.at(0).c_str(), strerror(errno) );
+        if (report[0] >= 0)
+        {
+            close( report[0] );
+        }
+        return 1;
+    }
+
+    length = 0;
+    if (report[0] >= 0)
+    {
+        while (((length = read( report[0], &error, sizeof(error) )) < 0) && (errno == EINTR))
+        {
+        }
+        close( report[0] );
+    }
+
+    status = 0;
+    while ((waitpid( child, &status, 0 ) < 0) && (errno == EINTR))
+    {
+    }
+
+    if (length == sizeof(error))
+    {
+        Log( __FILENAME__, __LINE__, "Error failed to run %s: %s", arguments.at(0).c_str(), strerror(error) );
+        return 1;
+    }
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == LAUNCH_NOT_FOUND)
+    {
+        Log( __FILENAME__, __LINE__, "Error %s could not be run, it exited with status %d", arguments.at(0).c_str(), LAUNCH_NOT_FOUND );
+        return 1;
+    }
+    else if (WIFEXITED(status) && WEXITSTATUS(status) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "%s exited with status %d", arguments.at(0).c_str(), WEXITSTATUS(status) );
+    }
+    else if (WIFSIGNALED(status))
+    {
+        Log( __FILENAME__, __LINE__, "%s was terminated by signal %d", arguments.at(0).c_str(), WTERMSIG(status) );
+    }
+    return 0;
+}
+
+string CLaunch::Quote( const string& text )
+{
+    string quoted;
+
+    quoted = "'";
+    for (uint32_t i=0; i<text.length(); i++)
+    {
+        if (text.at(i) == '\'')
+        {
+            quoted += "'\\''";
+        }
+        else
+        {
+            quoted += text.at(i);
+        }
+    }
+    quoted += "'";
+    return quoted;
+}
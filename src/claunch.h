@@ -0,0 +1,151 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CLAUNCH_H
+#define CLAUNCH_H
+
+#include "cbase.h"
+
+using namespace std;
+
+#define LAUNCH_SHELL            "/bin/sh"           /** Shell used when a plan cannot be run directly. */
+#define LAUNCH_ENV_LIBRARY      "LD_LIBRARY_PATH"   /** Variable set for the target so it finds libraries next to it. */
+#define LAUNCH_ENV_TIME         "PL_SELECT_TIME"    /** Variable holding the time the entry was selected, seconds.microseconds. */
+#define LAUNCH_SYNC_ALL         "all"               /** Sync path that flushes every file system like sync does. */
+#define LAUNCH_SHELL_CHARS      "|&;<>()$`\\\"'*?[]#~{}\n"  /** Characters that need the shell to interpret them. */
+#define LAUNCH_NOT_FOUND        127                 /** Exit status of a child whose program could not be run, as the shell uses it. */
+
+/** @brief Piece of a command line
+ */
+struct launchword_t {
+    launchword_t() : Literal(false), Text("") {};
+    bool        Literal;            /** @brief True if the text is a single argument as is, false if it is split on spaces like the shell would */
+    string      Text;               /** @brief The text of the word */
+};
+
+/** @brief Program run by a launch plan
+ */
+struct launchstep_t {
+    launchstep_t() : Library(false), Path(""), Words() {};
+    bool                    Library;    /** @brief True if the libraries in the working directory are used */
+    string                  Path;       /** @brief Working directory, empty to stay in the current one */
+    vector<launchword_t>    Words;      /** @brief Program and arguments, concatenated like the shell would */
+};
+
+/** @brief This class holds the programs to run for a selection and runs them with or without the shell
+ */
+class CLaunch : public CBase
+{
+    public:
+        /** Constructor. */
+        CLaunch();
+        /** Destructor. */
+        virtual ~CLaunch();
+
+        /** @brief Remove all steps from the plan. */
+        void            Clear       ( void );
+
+        /** @brief Start a new step, following words are added to it.
+         * @param path : working directory for the step, empty to stay in the current one
+         * @param library : true if the libraries in the working directory are used
+         */
+        void            Begin       ( const string& path, bool library );
+
+        /** @brief Add profile text to the current step, it is split on spaces.
+         * @param text : the text
+         */
+        void            AddText     ( const string& text );
+
+        /** @brief Add text to the current step that must reach the program unchanged.
+         * @param text : the text
+         */
+        void            AddLiteral  ( const string& text );
+
+        /** @brief Check if every step can be run without the shell.
+         * @return true if the plan can be run directly
+         */
+        bool            Direct      ( void );
+
+        /** @brief Build the shell command equivalent to the plan.
+         * @return the command
+         */
+        string          Script      ( void );
+
+        /** @brief Run every step in order and wait for each one to exit, the launcher stays in memory so only supervisor mode uses it.
+         * @param shell : true to always run the plan through the shell
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Execute     ( bool shell );
+
+        /** @brief Run the plan in place of the launcher so none of its memory is held while the target runs.
+         *         A single direct step is exec'd as is, anything else including the sync and the reload is
+         *         handed to the shell which execs the reload when the plan is done. The shell flushes the
+         *         file system of each sync path with sync -f, or all of them if sync -f fails or for LAUNCH_SYNC_ALL.
+         * @param shell : true to always run the plan through the shell
+         * @return only returns if the exec failed, 1
+         */
+        int8_t          Replace     ( bool shell );
+
+        vector<string>          SyncPaths;      /**< Paths whose file systems are flushed after the last step, LAUNCH_SYNC_ALL for all. */
+        string                  SelectTime;     /**< Time the entry was selected, passed to the steps in LAUNCH_ENV_TIME. */
+        vector<launchstep_t>    Steps;          /**< Programs to run in order, the target application is last. */
+        string                  ReloadPath;     /**< Working directory of the reload, only used by Replace. */
+        vector<string>          Reload;         /**< Program and arguments exec'd once the plan exits, only used by Replace, empty for none. */
+
+    private:
+        /** @brief Flush the file systems holding the sync paths.
+         */
+        void            Flush       ( void );
+
+        /** @brief Split the words of a step into arguments like the shell would.
+         * @param step : the step
+         * @param arguments : the arguments, the first is the program
+         */
+        void            Arguments   ( const launchstep_t& step, vector<string>& arguments );
+
+        /** @brief Check if a program name is a shell builtin, which only has its effect inside the shell.
+         * @param name : the program name
+         * @return true if it has to be run by the shell
+         */
+        bool            Builtin     ( const string& name );
+
+        /** @brief Change to the directory and environment of a step and exec its program, only returns on failure.
+         * @param step : the step the program belongs to
+         * @param argv : the arguments ending with NULL, the first is the program
+         */
+        void            Exec        ( const launchstep_t& step, vector<char*>& argv );
+
+        /** @brief Run a program in a child process and wait for it to exit.
+         * @param step : the step the program belongs to
+         * @param arguments : the arguments, the first is the program
+         * @return 0 if the program ran, 1 if it could not be started or exited with 127 like the shell does for that
+         */
+        int8_t          Spawn       ( const launchstep_t& step, const vector<string>& arguments );
+
+        /** @brief Quote text so the shell passes it as a single argument.
+         * @param text : the text
+         * @return the quoted text
+         */
+        string          Quote       ( const string& text );
+};
+
+#endif // CLAUNCH_H
@@ -0,0 +1,399 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "clog.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "SDL.h"
+
+// Without atomic builtins the slots are reserved and published under a mutex
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+#define LOG_ATOMIC
+#endif
+
+/** @brief A message waiting in the ring buffer
+ */
+struct logslot_t {
+    logslot_t() : Sequence(0), Length(0) {}
+    volatile uint32_t   Sequence;               /** @brief Position the slot is free for, one past it once the message is written */
+    uint16_t            Length;                 /** @brief Length of the formatted line */
+    char                Text[LOG_SLOT_SIZE];    /** @brief The formatted line */
+};
+
+uint8_t                 LogThreshold = LOG_LEVEL;
+
+static logslot_t        LogSlots[LOG_SLOTS];
+static volatile uint32_t LogHead    = 0;        // Next position to be reserved by a caller
+static uint32_t         LogTail     = 0;        // Next position to be written, only used by the writer thread
+static volatile uint32_t LogWritten = 0;        // Positions before this one have been written
+static volatile uint32_t LogDropped = 0;        // Messages dropped because the ring buffer was full
+static volatile uint32_t LogQuit    = 0;        // Set to stop the writer thread once the ring buffer is empty
+static SDL_Thread*      LogThread   = NULL;
+static SDL_sem*         LogWake     = NULL;
+#if !defined(LOG_ATOMIC)
+static SDL_mutex*       LogLock     = NULL;
+#endif
+static int              LogFile     = -1;
+
+// The counters shared between threads are only accessed through these, which also order them with the text of the slots
+static uint32_t LogLoad( volatile uint32_t& value )
+{
+#if defined(LOG_ATOMIC)
+    return __sync_fetch_and_add( &value, 0 );
+#else
+    uint32_t loaded;
+
+    SDL_LockMutex( LogLock );
+    loaded = value;
+    SDL_UnlockMutex( LogLock );
+    return loaded;
+#endif
+}
+
+static void LogStore( volatile uint32_t& value, uint32_t stored )
+{
+#if defined(LOG_ATOMIC)
+    uint32_t expected;
+    uint32_t previous;
+
+    // Only a full barrier exchange is available, it takes a second try when the guess is wrong
+    expected = stored-1;
+    while ((previous = __sync_val_compare_and_swap( &value, expected, stored )) != expected)
+    {
+        expected = previous;
+    }
+#else
+    SDL_LockMutex( LogLock );
+    value = stored;
+    SDL_UnlockMutex( LogLock );
+#endif
+}
+
+static bool LogReserve( uint32_t& position )
+{
+#if defined(LOG_ATOMIC)
+    int32_t difference;
+
+    position = LogLoad( LogHead );
+    for (;;)
+    {
+        difference = (int32_t)(LogLoad( LogSlots[position & (LOG_SLOTS-1)].Sequence ) - position);
+        if (difference == 0)
+        {
+            if (__sync_bool_compare_and_swap( &LogHead, position, position+1 ))
+            {
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The writer has not caught up with the oldest slot
+            __sync_fetch_and_add( &LogDropped, 1 );
+            return false;
+        }
+        position = LogLoad( LogHead );
+    }
+#else
+    bool reserved;
+
+    SDL_LockMutex( LogLock );
+    position = LogHead;
+    reserved = (LogSlots[position & (LOG_SLOTS-1)].Sequence == position);
+    if (reserved == true)
+    {
+        LogHead++;
+    }
+    else
+    {
+        LogDropped++;
+    }
+    SDL_UnlockMutex( LogLock );
+    return reserved;
+#endif
+}
+
+static uint16_t LogFormat( char* text, const char* file, int32_t line, const char* message, va_list args )
+{
+    int32_t length;
+    int32_t suffix;
+
+    length = vsnprintf( text, LOG_SLOT_SIZE, message, args );
+    if (length < 0)
+    {
+        length = 0;
+    }
+    else if (length > LOG_SLOT_SIZE-1)
+    {
+        length = LOG_SLOT_SIZE-1;
+    }
+
+    if (file != NULL)
+    {
+        // Same layout as a %-50s message column
+        suffix = snprintf( text+length, LOG_SLOT_SIZE-length, "%*s file:%-15s line:%d\n",
+                           (length < 50) ? 50-length : 0, "", file, line );
+    }
+    else
+    {
+        suffix = snprintf( text+length, LOG_SLOT_SIZE-length, "\n" );
+    }
+    if (suffix > 0)
+    {
+        length += suffix;
+    }
+
+    if (length >= LOG_SLOT_SIZE-1)
+    {
+        length = LOG_SLOT_SIZE-1;
+        text[length-1] = '\n';
+    }
+    return length;
+}
+
+static void LogOutputTo( int fd, const char* text, uint32_t length )
+{
+    ssize_t written;
+
+    while (length > 0)
+    {
+        written = write( fd, text, length );
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+        text    += written;
+        length  -= written;
+    }
+}
+
+static void LogOutput( const char* text, uint32_t length )
+{
+    LogOutputTo( STDOUT_FILENO, text, length );
+
+#if defined(DEBUG)
+    if (LogFile < 0)
+    {
+        LogFile = open( LOG_FILE, O_WRONLY|O_CREAT|O_APPEND, 0644 );
+        if (LogFile < 0)
+        {
+            static const char failed[] = "Failed to open logfile\n";
+            LogOutputTo( STDOUT_FILENO, failed, sizeof(failed)-1 );
+            return;
+        }
+    }
+    LogOutputTo( LogFile, text, length );
+#endif
+}
+
+static int LogWriter( void* data )
+{
+    char        batch[LOG_BATCH];
+    uint32_t    length;
+    uint32_t    reported;
+    uint32_t    dropped;
+    bool        quit;
+    logslot_t*  slot;
+
+    (void)data;
+
+    reported = 0;
+    do
+    {
+        // Anything queued before quit was set is still written
+        quit    = (LogLoad( LogQuit ) != 0);
+        length  = 0;
+
+        for (;;)
+        {
+            slot = &LogSlots[LogTail & (LOG_SLOTS-1)];
+            if (LogLoad( slot->Sequence ) != LogTail+1)
+            {
+                break;
+            }
+
+            if (length + slot->Length > LOG_BATCH)
+            {
+                LogOutput( batch, length );
+                length = 0;
+            }
+            memcpy( batch+length, slot->Text, slot->Length );
+            length += slot->Length;
+
+            LogStore( slot->Sequence, LogTail+LOG_SLOTS );
+            LogTail++;
+        }
+
+        dropped = LogLoad( LogDropped );
+        if (dropped != reported)
+        {
+            if (length + 64 > LOG_BATCH)
+            {
+                LogOutput( batch, length );
+                length = 0;
+            }
+            length += snprintf( batch+length, 64, "Log dropped %d messages\n", (int32_t)(dropped-reported) );
+            reported = dropped;
+        }
+
+        if (length > 0)
+        {
+            LogOutput( batch, length );
+        }
+        LogStore( LogWritten, LogTail );
+
+        if (quit == false)
+        {
+            SDL_SemWaitTimeout( LogWake, LOG_DWELL );
+        }
+    } while (quit == false);
+
+    return 0;
+}
+
+int8_t LogOpen( void )
+{
+    if (LogThread != NULL)
+    {
+        return 0;
+    }
+
+    for (uint32_t index=0; index<LOG_SLOTS; index++)
+    {
+        LogSlots[index].Sequence = index;
+    }
+    LogHead     = 0;
+    LogTail     = 0;
+    LogWritten  = 0;
+    LogDropped  = 0;
+    LogQuit     = 0;
+
+#if !defined(LOG_ATOMIC)
+    LogLock = SDL_CreateMutex();
+#endif
+    LogWake = SDL_CreateSemaphore( 0 );
+    if (LogWake != NULL
+#if !defined(LOG_ATOMIC)
+        && LogLock != NULL
+#endif
+       )
+    {
+#if SDL_VERSION_ATLEAST(2,0,0)
+        LogThread = SDL_CreateThread( LogWriter, "log", NULL );
+#else /* SDL 1.2 */
+        LogThread = SDL_CreateThread( LogWriter, NULL );
+#endif
+    }
+
+    if (LogThread == NULL)
+    {
+        // Messages are written by the caller
+        LogClose();
+        return 1;
+    }
+    return 0;
+}
+
+void LogClose( void )
+{
+    if (LogThread != NULL)
+    {
+        LogStore( LogQuit, 1 );
+        SDL_SemPost( LogWake );
+        SDL_WaitThread( LogThread, NULL );
+        LogThread = NULL;
+    }
+
+    if (LogWake != NULL)
+    {
+        SDL_DestroySemaphore( LogWake );
+        LogWake = NULL;
+    }
+#if !defined(LOG_ATOMIC)
+    if (LogLock != NULL)
+    {
+        SDL_DestroyMutex( LogLock );
+        LogLock = NULL;
+    }
+#endif
+    if (LogFile >= 0)
+    {
+        close( LogFile );
+        LogFile = -1;
+    }
+}
+
+void LogFlush( void )
+{
+    uint32_t position;
+
+    if (LogThread == NULL)
+    {
+        return;
+    }
+
+    position = LogLoad( LogHead );
+    SDL_SemPost( LogWake );
+    while ((int32_t)(LogLoad( LogWritten ) - position) < 0)
+    {
+        SDL_Delay( 1 );
+    }
+}
+
+void LogWrite( uint8_t level, const char* file, int32_t line, const char* message, va_list args )
+{
+    uint32_t    position;
+    logslot_t*  slot;
+
+    if (LogEnabled( level ) == false)
+    {
+        return;
+    }
+
+    if (LogThread == NULL)
+    {
+        char text[LOG_SLOT_SIZE];
+
+        LogOutput( text, LogFormat( text, file, line, message, args ) );
+        return;
+    }
+
+    if (LogReserve( position ) == false)
+    {
+        return;
+    }
+
+    slot = &LogSlots[position & (LOG_SLOTS-1)];
+    slot->Length = LogFormat( slot->Text, file, line, message, args );
+
+    // The text is visible to the writer before the slot is
+    LogStore( slot->Sequence, position+1 );
+    SDL_SemPost( LogWake );
+}
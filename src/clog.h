@@ -0,0 +1,86 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CLOG_H
+#define CLOG_H
+
+#include <stdint.h>
+#include <stdarg.h>
+
+#define LOG_NONE            0       /**< Nothing is logged. */
+#define LOG_ERROR           1       /**< Failures that stop an action. */
+#define LOG_WARN            2       /**< Problems the launcher works around. */
+#define LOG_INFO            3       /**< Progress of the launcher, the level of CBase::Log. */
+#define LOG_DEBUG           4       /**< Detail only useful when looking into a problem, like the contents of archives. */
+#define LOG_TRACE           5       /**< Detail from inner loops. */
+
+/** Highest level compiled in, messages above it cost nothing. Can be set from the build with -DLOG_LEVEL=n. */
+#if !defined(LOG_LEVEL)
+#if defined(DEBUG)
+#define LOG_LEVEL           LOG_DEBUG
+#else
+#define LOG_LEVEL           LOG_INFO
+#endif
+#endif
+
+#define LOG_FILE            "/tmp/log.txt"  /**< In debug builds the log is also appended to this file. */
+#define LOG_SLOTS           128             /**< Messages the ring buffer holds before new ones are dropped, must be a power of 2. */
+#define LOG_SLOT_SIZE       512             /**< Longest line kept for a message, longer lines are cut. */
+#define LOG_BATCH           4096            /**< Bytes collected by the writer thread before they are written. */
+#define LOG_DWELL           250             /**< Longest time the writer thread waits before it looks at the ring buffer again (milliseconds). */
+
+extern uint8_t LogThreshold;                /**< Highest level logged at run time, set from the config. */
+
+/** @brief Checks if messages of a level are logged, when the level is above LOG_LEVEL the check and
+ *         the code it guards are removed by the compiler.
+ * @param level : level of the message (defined by LOG_ERROR to LOG_TRACE)
+ * @return true if the message is logged
+ */
+inline bool LogEnabled( uint8_t level )
+{
+    return (level <= LOG_LEVEL) && (level <= LogThreshold);
+}
+
+/** @brief Start the writer thread, until then and if it cannot be created messages are written by the caller.
+ * @return 0 if passed 1 if failed
+ */
+int8_t LogOpen( void );
+
+/** @brief Write out every queued message and stop the writer thread.
+ */
+void LogClose( void );
+
+/** @brief Wait until every message queued so far has been written, to be called before the process is
+ *         replaced or forked.
+ */
+void LogFlush( void );
+
+/** @brief Format a message into the ring buffer for the writer thread.
+ * @param level : level of the message (defined by LOG_ERROR to LOG_TRACE)
+ * @param file : the path where the message was sent, NULL to write only the message
+ * @param line : the numeric line the message was sent
+ * @param message : formatting string
+ * @param args : arguments of the formatting string
+ */
+void LogWrite( uint8_t level, const char* file, int32_t line, const char* message, va_list args );
+
+#endif // CLOG_H
@@ -0,0 +1,215 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cmembudget.h"
+
+#include <stdio.h>
+
+/* Names used in the log, index is defined in MEM_ACCOUNTS_T */
+static const char* MemAccounts[MEM_ACCOUNTS] = { "background", "buttons", "listing", "text", "previews" };
+
+CMemBudget::CMemBudget() : CBase(),
+        Limit       (0),
+        Checked     (0),
+        Pressure    (false),
+        HasPsi      (true),
+        Resident    (0)
+{
+    for (uint8_t index=0; index<MEM_ACCOUNTS; index++)
+    {
+        Held[index]      = 0;
+        Evictions[index] = 0;
+        Freed[index]     = 0;
+    }
+}
+
+CMemBudget::~CMemBudget()
+{
+}
+
+void CMemBudget::Open( uint32_t limit )
+{
+    Limit    = limit;
+    Checked  = 0;
+    Pressure = false;
+    Resident = 0;
+    for (uint8_t index=0; index<MEM_ACCOUNTS; index++)
+    {
+        Held[index]      = 0;
+        Evictions[index] = 0;
+        Freed[index]     = 0;
+    }
+
+    if (Limit > 0)
+    {
+        Log( __FILENAME__, __LINE__, "Memory budget of %d kB for the images, text and lists", Limit/1024 );
+    }
+}
+
+bool CMemBudget::Due( void )
+{
+    uint32_t now;
+
+    now = SDL_GetTicks();
+    if ((Checked > 0) && (now - Checked < MEM_CHECK))
+    {
+        return false;
+    }
+    Checked = MAX( now, 1 );
+
+    if (ReadPressure() != Pressure)
+    {
+        Pressure = !Pressure;
+        Log( __FILENAME__, __LINE__, "Memory pressure %s", (Pressure == true) ? "started, trimming the caches" : "ended" );
+    }
+    Resident = ReadResident();
+    return true;
+}
+
+void CMemBudget::Set( uint8_t account, uint32_t bytes )
+{
+    if (account < MEM_ACCOUNTS)
+    {
+        Held[account] = bytes;
+    }
+}
+
+uint32_t CMemBudget::Excess( void )
+{
+    uint32_t held;
+    uint32_t target;
+
+    held = 0;
+    for (uint8_t index=0; index<MEM_ACCOUNTS; index++)
+    {
+        held += Held[index];
+    }
+
+    target = Limit;
+    if (Pressure == true)
+    {
+        target = (target > 0) ? MIN( target, held/2 ) : held/2;
+    }
+
+    if ((target == 0) || (held <= target))
+    {
+        return 0;
+    }
+    return held - target;
+}
+
+void CMemBudget::Evicted( uint8_t account, uint32_t bytes )
+{
+    if ((account < MEM_ACCOUNTS) && (bytes > 0))
+    {
+        Evictions[account]++;
+        Freed[account]  += bytes;
+        Held[account]   -= MIN( bytes, Held[account] );
+        LogAt( LOG_DEBUG, __FILENAME__, __LINE__, "Memory evicted %d bytes of %s", bytes, MemAccounts[account] );
+    }
+}
+
+void CMemBudget::Stats( memstats_t& stats )
+{
+    stats = memstats_t();
+    for (uint8_t index=0; index<MEM_ACCOUNTS; index++)
+    {
+        stats.Held      += Held[index];
+        stats.Evictions += Evictions[index];
+        stats.Evicted   += Freed[index];
+    }
+    stats.Limit    = Limit;
+    stats.Resident = Resident;
+    stats.Pressure = Pressure;
+}
+
+void CMemBudget::Report( void )
+{
+    for (uint8_t index=0; index<MEM_ACCOUNTS; index++)
+    {
+        Log( __FILENAME__, __LINE__, "Memory %-10s held %8d kB evictions %6d evicted %8d kB", MemAccounts[index],
+             Held[index]/1024, Evictions[index], Freed[index]/1024 );
+    }
+    Log( __FILENAME__, __LINE__, "Memory resident %d kB limit %d kB", ReadResident(), Limit/1024 );
+}
+
+bool CMemBudget::ReadPressure( void )
+{
+    ifstream    fin;
+    string      line;
+    float       stalled;
+    uint32_t    value;
+    uint32_t    available;
+    uint32_t    found;
+    char        name[32];
+
+    // Stalls are the best measure, a low-RAM system has little free memory most of the time
+    if (HasPsi == true)
+    {
+        fin.open( MEM_PROC_PSI, ios_base::in );
+        if (fin && getline( fin, line ) && (sscanf( line.c_str(), "some avg10=%f", &stalled ) == 1))
+        {
+            return stalled >= MEM_PSI_SOME;
+        }
+        fin.close();
+        fin.clear();
+        HasPsi = false;
+        Log( __FILENAME__, __LINE__, "No memory pressure information in %s, checking %s", MEM_PROC_PSI, MEM_PROC_MEMINFO );
+    }
+
+    // Kernels before 3.14 have no MemAvailable, free memory and the page cache are close to it
+    available = 0;
+    found     = 0;
+    fin.open( MEM_PROC_MEMINFO, ios_base::in );
+    while (fin && getline( fin, line ))
+    {
+        if (sscanf( line.c_str(), "%31[^:]: %u", name, &value ) != 2)
+        {
+            continue;
+        }
+        if (strcmp( name, "MemAvailable" ) == 0)
+        {
+            return value < MEM_AVAILABLE_MIN;
+        }
+        else if (strcmp( name, "MemFree" ) == 0 || strcmp( name, "Buffers" ) == 0 || strcmp( name, "Cached" ) == 0)
+        {
+            found++;
+            available += value;
+        }
+    }
+    return (found > 0) && (available < MEM_AVAILABLE_MIN);
+}
+
+uint32_t CMemBudget::ReadResident( void )
+{
+    ifstream    fin;
+    uint32_t    size;
+    uint32_t    pages;
+
+    // statm is in pages: total size then resident
+    fin.open( MEM_PROC_STATM, ios_base::in );
+    if (fin && (fin >> size >> pages))
+    {
+        return pages * (sysconf( _SC_PAGESIZE ) / 1024);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CMEMBUDGET_H
+#define CMEMBUDGET_H
+
+#include "cbase.h"
+
+using namespace std;
+
+#define MEM_CHECK           1000                    /** Milliseconds between checks of the budget and the memory pressure. */
+#define MEM_PROC_PSI        "/proc/pressure/memory" /** Memory pressure stall information, kernels from 4.20. */
+#define MEM_PROC_MEMINFO    "/proc/meminfo"         /** Memory of the system, used when the pressure is not available. */
+#define MEM_PROC_STATM      "/proc/self/statm"      /** Memory usage of the process in pages. */
+#define MEM_PSI_SOME        10                      /** Percent of the last 10 seconds some task stalled on memory that is pressure. */
+#define MEM_AVAILABLE_MIN   4096                    /** kB of available memory under which the system is under pressure. */
+
+/** @brief Holders of memory that are accounted, the caches are evicted from the end of the list first
+ */
+enum MEM_ACCOUNTS_T {
+    MEM_BACKGROUND=0,               /** @brief The background image */
+    MEM_BUTTONS,                    /** @brief The button and pointer images */
+    MEM_LISTING,                    /** @brief The items of the list, including the contents of archives */
+    MEM_TEXT,                       /** @brief Rendered text, evicted after the previews */
+    MEM_PREVIEWS,                   /** @brief Scaled previews, evicted first */
+    MEM_ACCOUNTS
+};
+
+/** @brief Counters of the memory budget, for the performance display and the reports
+ */
+struct memstats_t {
+    memstats_t() : Held(0), Limit(0), Resident(0), Evictions(0), Evicted(0), Pressure(false) {};
+    uint32_t        Held;           /** @brief Bytes held by all accounts */
+    uint32_t        Limit;          /** @brief Bytes the accounts may hold, 0 for no limit */
+    uint32_t        Resident;       /** @brief Resident memory of the process in kB */
+    uint32_t        Evictions;      /** @brief Times a cache was trimmed */
+    uint32_t        Evicted;        /** @brief Bytes freed by trimming the caches */
+    bool            Pressure;       /** @brief True if the system was under memory pressure at the last check */
+};
+
+/** @brief This class keeps the bytes held by the images, text and lists within a limit
+ *
+ *  The owners report what they hold when the check is due, the budget answers how much has to be freed. Under
+ *  memory pressure the caches are trimmed to half of what is held, even without a limit.
+ */
+class CMemBudget : public CBase
+{
+    public:
+        /** Constructor. */
+        CMemBudget();
+        /** Destructor. */
+        virtual ~CMemBudget();
+
+        /** @brief Set the limit and clear the accounts and counters.
+         * @param limit : bytes the accounts may hold, 0 for no limit
+         */
+        void            Open        ( uint32_t limit );
+
+        /** @brief Check if MEM_CHECK ms passed since the last check, if so the pressure and resident memory are read.
+         * @return true if the accounts should be measured and the caches trimmed
+         */
+        bool            Due         ( void );
+
+        /** @brief Set the bytes held by an account.
+         * @param account : the account (index is defined in MEM_ACCOUNTS_T)
+         * @param bytes : bytes held
+         */
+        void            Set         ( uint8_t account, uint32_t bytes );
+
+        /** @brief Get the bytes that have to be freed to get within the limit, or the pressure target.
+         * @return number of bytes, 0 if within
+         */
+        uint32_t        Excess      ( void );
+
+        /** @brief Count bytes freed by trimming a cache.
+         * @param account : the account (index is defined in MEM_ACCOUNTS_T)
+         * @param bytes : bytes freed
+         */
+        void            Evicted     ( uint8_t account, uint32_t bytes );
+
+        /** @brief Get a copy of the counters.
+         * @param stats : set to the counters
+         */
+        void            Stats       ( memstats_t& stats );
+
+        /** @brief Log the bytes held by each account and the evictions.
+         */
+        void            Report      ( void );
+
+    private:
+        /** @brief Read the memory pressure of the system, from the stall information or the available memory.
+         * @return true if under pressure
+         */
+        bool            ReadPressure( void );
+
+        /** @brief Read the resident memory of the process.
+         * @return resident memory in kB
+         */
+        uint32_t        ReadResident( void );
+
+        CMemBudget(const CMemBudget &);
+        CMemBudget & operator=(const CMemBudget&);
+
+        uint32_t                Limit;              /**< Bytes the accounts may hold, 0 for no limit. */
+        uint32_t                Checked;            /**< Tick count of the last check. */
+        bool                    Pressure;           /**< True if the system was under pressure at the last check. */
+        bool                    HasPsi;             /**< False once the stall information failed to open. */
+        uint32_t                Resident;           /**< Resident memory of the process in kB at the last check. */
+        uint32_t                Held[MEM_ACCOUNTS];     /**< Bytes held by each account. */
+        uint32_t                Evictions[MEM_ACCOUNTS];/**< Times each account was trimmed. */
+        uint32_t                Freed[MEM_ACCOUNTS];    /**< Bytes freed from each account. */
+};
+
+#endif // CMEMBUDGET_H
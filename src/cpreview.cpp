@@ -0,0 +1,639 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cpreview.h"
+
+#include <string.h>
+
+/** Extensions of the preview images, a file with an earlier extension wins over a later one. */
+static const char* PreviewExtensions[] = { ".png", ".jpg", ".jpeg", ".bmp", ".gif" };
+#define PREVIEW_EXT_TOTAL   (sizeof(PreviewExtensions)/sizeof(PreviewExtensions[0]))
+
+/* Magenta is transparent in the previews, the scaler keeps it out of the filtered colors */
+static void PreviewKey( SDL_Surface* image )
+{
+#if SDL_VERSION_ATLEAST(2,0,0)
+    SDL_SetColorKey( image, SDL_TRUE, SDL_MapRGB( image->format, 0xFF, 0, 0xFF ) );
+#else /* SDL 1.2 */
+    SDL_SetColorKey( image, SDL_SRCCOLORKEY, SDL_MapRGB( image->format, 0xFF, 0, 0xFF ) );
+#endif
+}
+
+static int PreviewThread( void* data )
+{
+    TRACE_THREAD( "preview" );
+    return static_cast<CPreview*>(data)->Worker();
+}
+
+CPreview::CPreview() : CBase(),
+        Quit        (false),
+        Ready       (false),
+        Path        (""),
+        Width       (0),
+        Height      (0),
+        Mode        (0),
+        Capacity    (PREVIEW_CACHE_MIN),
+        Format      (NULL),
+        Thread      (NULL),
+        Lock        (NULL),
+        Wake        (NULL),
+        IndexPath   (""),
+        IndexTime   (0),
+        Index       (),
+        Selected    (""),
+        Queue       (),
+        Cache       (),
+        CacheIndex  (),
+        Released    (),
+        Thumbnails  (),
+        Counters    ()
+{
+}
+
+CPreview::~CPreview()
+{
+    Close();
+}
+
+int8_t CPreview::Open( const string& path, uint16_t width, uint16_t height, uint8_t mode,
+                       SDL_PixelFormat* format, uint16_t capacity, const string& thumbnails )
+{
+    Close();
+
+    Path        = path;
+    Width       = width;
+    Height      = height;
+    Mode        = mode;
+    Format      = format;
+    Capacity    = MAX(capacity, PREVIEW_CACHE_MIN);
+    Quit        = false;
+    Ready       = false;
+
+    // Without the cache previews are still decoded, just every time
+    Thumbnails.Open( thumbnails, Format );
+
+    Lock = SDL_CreateMutex();
+    Wake = SDL_CreateCond();
+    if (Lock == NULL || Wake == NULL)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to create preview mutex: %s", SDL_GetError() );
+        return 1;
+    }
+
+    Refresh();
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    Thread = SDL_CreateThread( PreviewThread, "preview", this );
+#else /* SDL 1.2 */
+    Thread = SDL_CreateThread( PreviewThread, this );
+#endif
+    if (Thread == NULL)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to create preview thread, previews will load synchronously: %s", SDL_GetError() );
+    }
+    return 0;
+}
+
+void CPreview::Close( void )
+{
+    if (Thread != NULL)
+    {
+        SDL_LockMutex( Lock );
+        Quit = true;
+        SDL_CondSignal( Wake );
+        SDL_UnlockMutex( Lock );
+
+        SDL_WaitThread( Thread, NULL );
+        Thread = NULL;
+    }
+
+    if (Wake != NULL)
+    {
+        SDL_DestroyCond( Wake );
+        Wake = NULL;
+    }
+    if (Lock != NULL)
+    {
+        SDL_DestroyMutex( Lock );
+        Lock = NULL;
+    }
+
+    // The worker has stopped, whatever it left to free is freed here
+    Release();
+    for (list<previewitem_t>::iterator it=Cache.begin(); it!=Cache.end(); it++)
+    {
+        Thumbnails.Free( it->Image );
+    }
+    Cache.clear();
+    CacheIndex.clear();
+    // The index is kept for the next Open, Refresh checks it is still current
+    Queue.clear();
+    Selected.clear();
+    Ready = false;
+}
+
+int8_t CPreview::Refresh( void )
+{
+    DIR*                dir;
+    struct dirent*      dirp;
+    struct stat         info;
+    string              name;
+    string              ext;
+    map<string, string> index;
+    map<string, uint8_t> rank;
+    map<string, uint8_t>::iterator found;
+    list<previewitem_t>::iterator it;
+
+    if (Lock == NULL)
+    {
+        return 1;
+    }
+
+    // A missing directory simply means no entry has a preview
+    if (stat( Path.c_str(), &info ) != 0)
+    {
+        info.st_mtime = 0;
+    }
+    if (info.st_mtime == IndexTime && IndexPath == Path)
+    {
+        return 0;
+    }
+
+    if (info.st_mtime != 0)
+    {
+        dir = opendir( Path.c_str() );
+        if (dir == NULL)
+        {
+            Log( __FILENAME__, __LINE__, "Warning failed to open previews path %s: %s", Path.c_str(), strerror(errno) );
+            return 1;
+        }
+
+        while ((dirp = readdir(dir)) != NULL)
+        {
+            name = dirp->d_name;
+            if (name.find_last_of(".") == string::npos)
+            {
+                continue;
+            }
+            ext = lowercase( name.substr( name.find_last_of(".") ) );
+
+            for (uint8_t i=0; i<PREVIEW_EXT_TOTAL; i++)
+            {
+                if (ext == PreviewExtensions[i])
+                {
+                    found = rank.find( Key(name) );
+                    if (found == rank.end() || i < found->second)
+                    {
+                        rank[Key(name)]  = i;
+                        index[Key(name)] = name;
+                    }
+                    break;
+                }
+            }
+        }
+        closedir( dir );
+    }
+
+#if defined(DEBUG)
+    Log( __FILENAME__, __LINE__, "Indexed %d previews in %s", (int32_t)index.size(), Path.c_str() );
+#endif
+
+    SDL_LockMutex( Lock );
+    Index.swap( index );
+    IndexPath = Path;
+    IndexTime = info.st_mtime;
+
+    // Entries remembered as missing may have gained a preview
+    for (it=Cache.begin(); it!=Cache.end(); )
+    {
+        if (it->Image == NULL && Index.find( it->Name ) != Index.end())
+        {
+            CacheIndex.erase( it->Name );
+            it = Cache.erase( it );
+        }
+        else
+        {
+            it++;
+        }
+    }
+    SDL_UnlockMutex( Lock );
+
+    return 0;
+}
+
+void CPreview::CopyIndex( string& path, time_t& time, map<string, string>& index )
+{
+    if (Lock != NULL)
+    {
+        SDL_LockMutex( Lock );
+    }
+    path  = IndexPath;
+    time  = IndexTime;
+    index = Index;
+    if (Lock != NULL)
+    {
+        SDL_UnlockMutex( Lock );
+    }
+}
+
+void CPreview::RestoreIndex( const string& path, time_t time, const map<string, string>& index )
+{
+    if (Lock != NULL)
+    {
+        SDL_LockMutex( Lock );
+    }
+    IndexPath = path;
+    IndexTime = time;
+    Index     = index;
+    if (Lock != NULL)
+    {
+        SDL_UnlockMutex( Lock );
+    }
+}
+
+void CPreview::Request( const string& name, const vector<string>& neighbors )
+{
+    uint32_t       start;
+    vector<string> keys;
+    map<string, list<previewitem_t>::iterator>::iterator found;
+
+    if (Lock == NULL)
+    {
+        return;
+    }
+
+    // Neighbors first so the selection ends up as the most recently used
+    for (uint16_t i=0; i<neighbors.size(); i++)
+    {
+        keys.push_back( Key(neighbors.at(i)) );
+    }
+    keys.push_back( Key(name) );
+
+    SDL_LockMutex( Lock );
+    Selected = keys.back();
+    Ready    = false;
+    Queue.clear();
+    for (uint16_t i=0; i<keys.size(); i++)
+    {
+        // Entries without a preview file are answered from the index without touching the disk
+        if (Index.find( keys.at(i) ) == Index.end())
+        {
+            continue;
+        }
+
+        found = CacheIndex.find( keys.at(i) );
+        if (found != CacheIndex.end())
+        {
+            Cache.splice( Cache.begin(), Cache, found->second );
+        }
+        else if (find( Queue.begin(), Queue.end(), keys.at(i) ) == Queue.end())
+        {
+            Queue.push_back( keys.at(i) );
+        }
+    }
+
+    if (Index.find( Selected ) == Index.end())
+    {
+        Ready = true;
+    }
+    else if (CacheIndex.find( Selected ) != CacheIndex.end())
+    {
+        Counters.Hits++;
+        Ready = true;
+    }
+    else
+    {
+        Counters.Misses++;
+        // The selection is decoded before its neighbors
+        Queue.erase( remove( Queue.begin(), Queue.end(), Selected ), Queue.end() );
+        Queue.insert( Queue.begin(), Selected );
+    }
+
+    if (Thread != NULL)
+    {
+        SDL_CondSignal( Wake );
+    }
+    else
+    {
+        for (uint16_t i=0; i<Queue.size(); i++)
+        {
+            start = SDL_GetTicks();
+            Insert( Queue.at(i), Decode( Index[Queue.at(i)] ) );
+            CountDecode( start );
+        }
+        Queue.clear();
+        Ready = true;
+    }
+    SDL_UnlockMutex( Lock );
+}
+
+bool CPreview::Fetch( SDL_Surface*& image )
+{
+    bool result = false;
+    map<string, list<previewitem_t>::iterator>::iterator found;
+
+    if (Lock == NULL)
+    {
+        return false;
+    }
+
+    SDL_LockMutex( Lock );
+    if (Ready == true)
+    {
+        found = CacheIndex.find( Selected );
+        image = (found != CacheIndex.end()) ? found->second->Image : NULL;
+        Ready  = false;
+        result = true;
+    }
+    SDL_UnlockMutex( Lock );
+
+    return result;
+}
+
+int32_t CPreview::Worker( void )
+{
+    string          key;
+    string          filename;
+    SDL_Surface*    image;
+    uint32_t        start;
+    map<string, string>::iterator found;
+
+    SDL_LockMutex( Lock );
+    while (Quit == false)
+    {
+        Release();
+
+        if (Queue.size() == 0)
+        {
+            SDL_CondWait( Wake, Lock );
+            continue;
+        }
+
+        key = Queue.front();
+        Queue.erase( Queue.begin() );
+
+        // The index may have been refreshed since the key was queued
+        found = Index.find( key );
+        if (found == Index.end())
+        {
+            continue;
+        }
+        filename = found->second;
+        SDL_UnlockMutex( Lock );
+
+        start = SDL_GetTicks();
+        image = Decode( filename );
+
+        SDL_LockMutex( Lock );
+        CountDecode( start );
+        // Results for a selection that has moved on are kept, the cursor often comes back
+        if (CacheIndex.find( key ) == CacheIndex.end())
+        {
+            Insert( key, image );
+        }
+        else
+        {
+            Thumbnails.Free( image );
+        }
+
+        if (key == Selected)
+        {
+            Ready = true;
+        }
+    }
+    SDL_UnlockMutex( Lock );
+
+    return 0;
+}
+
+void CPreview::Stats( previewstats_t& stats )
+{
+    if (Lock == NULL)
+    {
+        stats = Counters;
+        return;
+    }
+
+    SDL_LockMutex( Lock );
+    stats = Counters;
+    SDL_UnlockMutex( Lock );
+}
+
+uint32_t CPreview::Held( void )
+{
+    uint32_t bytes;
+    list<previewitem_t>::iterator item;
+
+    if (Lock != NULL)
+    {
+        SDL_LockMutex( Lock );
+    }
+    bytes = 0;
+    for (item=Cache.begin(); item!=Cache.end(); item++)
+    {
+        bytes += SurfaceBytes( item->Image ) + sizeof(previewitem_t);
+    }
+    if (Lock != NULL)
+    {
+        SDL_UnlockMutex( Lock );
+    }
+    return bytes;
+}
+
+uint32_t CPreview::Trim( uint32_t bytes )
+{
+    uint32_t freed;
+    uint32_t evicted;
+
+    if (Lock != NULL)
+    {
+        SDL_LockMutex( Lock );
+    }
+    freed = 0;
+    while (freed < bytes)
+    {
+        evicted = Evict();
+        if (evicted == 0)
+        {
+            break;
+        }
+        freed += evicted;
+    }
+
+    // The worker may be mapping a thumbnail right now, it frees the surfaces itself
+    if (Thread != NULL)
+    {
+        SDL_CondSignal( Wake );
+    }
+    else
+    {
+        Release();
+    }
+
+    if (Lock != NULL)
+    {
+        SDL_UnlockMutex( Lock );
+    }
+    return freed;
+}
+
+void CPreview::CountDecode( uint32_t start )
+{
+    Counters.DecodeLast   = SDL_GetTicks() - start;
+    Counters.DecodeTotal += Counters.DecodeLast;
+    Counters.Decodes++;
+}
+
+string CPreview::Key( const string& name )
+{
+    return name.substr( 0, name.find_last_of(".") );
+}
+
+SDL_Surface* CPreview::Decode( const string& filename )
+{
+    TRACE_SPAN( "CPreview::Decode" );
+
+    string          location;
+    struct stat     info;
+    SDL_Surface*    loaded;
+    SDL_Surface*    converted;
+    SDL_Surface*    scaled;
+
+    location = Path + "/" + filename;
+
+#if defined(DEBUG)
+    Log( __FILENAME__, __LINE__, "Loading preview picture: %s", location.c_str() );
+#endif
+
+    IoCount( IO_STAT );
+    if (stat( location.c_str(), &info ) != 0)
+    {
+        return NULL;
+    }
+
+    // A thumbnail made from the same source at the same size is ready to blit
+    scaled = Thumbnails.Load( location, info, Width, Height );
+    if (scaled != NULL)
+    {
+        return scaled;
+    }
+
+    IoCount( IO_IMAGE, info.st_size );
+    loaded = IMG_Load( location.c_str() );
+    if (loaded == NULL)
+    {
+        return NULL;
+    }
+
+    if (loaded->format->Amask != 0)
+    {
+        // Keep the alpha channel, the blit will blend it
+        scaled = ScaleSurface( loaded, Width, Height, Mode );
+        SDL_FreeSurface( loaded );
+        Thumbnails.Save( location, info, scaled );
+        return scaled;
+    }
+
+    if (loaded->format->BytesPerPixel < 3)
+    {
+        // Palette images are converted first so they can be filtered
+        converted = SDL_ConvertSurface( loaded, Format, SDL_SWSURFACE );
+        SDL_FreeSurface( loaded );
+        if (converted == NULL)
+        {
+            return NULL;
+        }
+        PreviewKey( converted );
+        scaled = ScaleSurface( converted, Width, Height, Mode );
+        SDL_FreeSurface( converted );
+    }
+    else
+    {
+        // Convert after scaling so only the small image is touched
+        PreviewKey( loaded );
+        scaled = ScaleSurface( loaded, Width, Height, Mode );
+        SDL_FreeSurface( loaded );
+        if (scaled == NULL)
+        {
+            return NULL;
+        }
+        converted = SDL_ConvertSurface( scaled, Format, SDL_SWSURFACE );
+        SDL_FreeSurface( scaled );
+        scaled = converted;
+    }
+
+    if (scaled != NULL)
+    {
+        PreviewKey( scaled );
+        Thumbnails.Save( location, info, scaled );
+    }
+    return scaled;
+}
+
+void CPreview::Insert( const string& key, SDL_Surface* image )
+{
+    previewitem_t item;
+
+    item.Name  = key;
+    item.Image = image;
+    Cache.push_front( item );
+    CacheIndex[key] = Cache.begin();
+
+    while (Cache.size() > Capacity)
+    {
+        Evict();
+    }
+    Release();
+}
+
+uint32_t CPreview::Evict( void )
+{
+    uint32_t bytes;
+    list<previewitem_t>::iterator victim;
+
+    if (Cache.size() == 0 || (Cache.size() == 1 && Cache.front().Name == Selected))
+    {
+        return 0;
+    }
+
+    // The selected preview may be on screen, it is never evicted
+    victim = --Cache.end();
+    if (victim->Name == Selected)
+    {
+        --victim;
+    }
+
+    bytes = SurfaceBytes( victim->Image ) + sizeof(previewitem_t);
+    Released.push_back( victim->Image );
+    CacheIndex.erase( victim->Name );
+    Cache.erase( victim );
+    return bytes;
+}
+
+void CPreview::Release( void )
+{
+    for (uint16_t i=0; i<Released.size(); i++)
+    {
+        Thumbnails.Free( Released.at(i) );
+    }
+    Released.clear();
+}
@@ -0,0 +1,197 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CPREVIEW_H
+#define CPREVIEW_H
+
+#include <list>
+#include <map>
+
+#include "cbase.h"
+#include "cthumbnail.h"
+
+using namespace std;
+
+#define PREVIEW_PREFETCH        1           /** Number of entries above and below the selection to decode ahead. */
+#define PREVIEW_CACHE_MIN       (PREVIEW_PREFETCH*2+1)  /** The cache must hold the selection and its neighbors. */
+
+/** @brief Data structure for a decoded preview
+ */
+struct previewitem_t {
+    previewitem_t() : Name(""), Image(NULL) {};
+    string          Name;           /** @brief Entry name without the extension */
+    SDL_Surface*    Image;          /** @brief Scaled image in the screen format, NULL if the entry has no preview */
+};
+
+/** @brief Counters of the previews shown, for the performance display
+ */
+struct previewstats_t {
+    previewstats_t() : Hits(0), Misses(0), Decodes(0), DecodeLast(0), DecodeTotal(0) {};
+    uint32_t        Hits;           /** @brief Selections whose preview was already in the cache */
+    uint32_t        Misses;         /** @brief Selections whose preview had to be decoded */
+    uint32_t        Decodes;        /** @brief Previews decoded */
+    uint32_t        DecodeLast;     /** @brief Milliseconds taken by the last decode */
+    uint32_t        DecodeTotal;    /** @brief Milliseconds taken by all decodes */
+};
+
+/** @brief This class decodes and scales preview images on a worker thread and keeps the results in a LRU cache
+ */
+class CPreview : public CBase
+{
+    public:
+        /** Constructor. */
+        CPreview();
+        /** Destructor. */
+        virtual ~CPreview();
+
+        /** @brief Start the worker thread, falls back to decoding on the calling thread if it cannot be created.
+         * @param path : directory holding the preview images
+         * @param width : width the previews are scaled to
+         * @param height : height the previews are scaled to
+         * @param mode : filter used to scale (index is defined in SCALE_MODE_T)
+         * @param format : pixel format of the screen, must stay valid until Close
+         * @param capacity : maximum number of decoded previews held in memory
+         * @param thumbnails : directory for the scaled copies of the previews, empty to always decode
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( const string& path, uint16_t width, uint16_t height, uint8_t mode,
+                                      SDL_PixelFormat* format, uint16_t capacity, const string& thumbnails );
+
+        /** @brief Stop the worker thread and free every cached preview.
+         */
+        void            Close       ( void );
+
+        /** @brief Rebuild the index of preview files if the directory has been modified since the last scan.
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Refresh     ( void );
+
+        /** @brief Get a copy of the index of preview files.
+         * @param path : set to the directory the index was built from
+         * @param time : set to the modification time of the directory when it was built
+         * @param index : set to the lookup from key to file name
+         */
+        void            CopyIndex   ( string& path, time_t& time, map<string, string>& index );
+
+        /** @brief Use an index saved earlier, Refresh rebuilds it if the directory has changed since.
+         * @param path : the directory the index was built from
+         * @param time : the modification time of the directory when it was built
+         * @param index : the lookup from key to file name
+         */
+        void            RestoreIndex( const string& path, time_t time, const map<string, string>& index );
+
+        /** @brief Select the preview to display and queue it with its neighbors, anything queued before is dropped.
+         * @param name : display name of the selected entry
+         * @param neighbors : display names of the entries around the selection to decode ahead
+         */
+        void            Request     ( const string& name, const vector<string>& neighbors );
+
+        /** @brief Check if the selected preview finished decoding since the last call.
+         * @param image : set to the preview, NULL if the entry has none. The surface is owned by the cache and
+         *                stays valid until another entry is selected.
+         * @return true if the selected preview is ready
+         */
+        bool            Fetch       ( SDL_Surface*& image );
+
+        /** @brief Get a copy of the counters.
+         * @param stats : set to the counters
+         */
+        void            Stats       ( previewstats_t& stats );
+
+        /** @brief Get the memory held by the cached previews.
+         * @return number of bytes
+         */
+        uint32_t        Held        ( void );
+
+        /** @brief Drop the least recently used previews, the selected one is kept. With a worker thread
+         *         the surfaces are freed by the worker, which owns the thumbnail mappings.
+         * @param bytes : bytes to free
+         * @return bytes freed, less than asked if only the selection is left
+         */
+        uint32_t        Trim        ( uint32_t bytes );
+
+        /** @brief Loop of the worker thread, only to be called by the thread entry.
+         * @return 0 if passed 1 if failed
+         */
+        int32_t         Worker      ( void );
+
+    private:
+        /** @brief Strip the extension from a display name.
+         * @param name : display name
+         * @return the name used for the preview file and as the cache key
+         */
+        string          Key         ( const string& name );
+
+        /** @brief Map the thumbnail of one preview, or read and scale the image and store its thumbnail.
+         * @param filename : the preview file name in the previews directory
+         * @return the scaled preview or NULL if it does not exist
+         */
+        SDL_Surface*    Decode      ( const string& filename );
+
+        /** @brief Count a finished decode. Mutex must be held.
+         * @param start : tick count when the decode started
+         */
+        void            CountDecode ( uint32_t start );
+
+        /** @brief Add a decoded preview to the cache, evicting the least recently used. Mutex must be held.
+         * @param key : the preview file name without extension
+         * @param image : the decoded preview
+         */
+        void            Insert      ( const string& key, SDL_Surface* image );
+
+        /** @brief Drop the least recently used preview that is not selected and queue its surface for Release. Mutex must be held.
+         * @return bytes dropped, 0 if only the selection is left
+         */
+        uint32_t        Evict       ( void );
+
+        /** @brief Free the surfaces dropped from the cache. Mutex must be held and only the decoding thread may call it.
+         */
+        void            Release     ( void );
+
+        CPreview(const CPreview &);
+        CPreview & operator=(const CPreview&);
+
+        bool                    Quit;           /**< Set to stop the worker thread. */
+        bool                    Ready;          /**< The selected preview has been decoded but not fetched. */
+        string                  Path;           /**< Directory holding the preview images. */
+        uint16_t                Width;          /**< Width previews are scaled to. */
+        uint16_t                Height;         /**< Height previews are scaled to. */
+        uint8_t                 Mode;           /**< Filter used when scaling. */
+        uint16_t                Capacity;       /**< Maximum cache entries. */
+        uint32_t                Generation;     /**< Incremented on each request, a decode from an older generation is stale. */
+        SDL_PixelFormat*        Format;         /**< Pixel format of the screen. */
+        SDL_Thread*             Thread;         /**< Worker thread, NULL when decoding synchronously. */
+        SDL_mutex*              Lock;           /**< Guards the queue, the cache and the selection. */
+        SDL_cond*               Wake;           /**< Signaled when the queue changes or on quit. */
+        string                  IndexPath;      /**< Directory the index was built from. */
+        time_t                  IndexTime;      /**< Modification time of the directory when the index was built. */
+        map<string, string>     Index;          /**< Lookup from key to file name for every preview that exists. */
+        string                  Selected;       /**< Key of the selected preview, this entry is never evicted. */
+        vector<string>          Queue;          /**< Keys waiting to be decoded, in priority order. */
+        list<previewitem_t>     Cache;          /**< Decoded previews, most recently used first. */
+        map<string, list<previewitem_t>::iterator> CacheIndex;  /**< Lookup from key into the cache list. */
+        vector<SDL_Surface*>    Released;       /**< Surfaces dropped from the cache, waiting for the decoding thread to free them. */
+        CThumbnail              Thumbnails;     /**< Scaled previews on disk, only used by the decoding thread. */
+        previewstats_t          Counters;       /**< Counters of the previews shown, guarded by the mutex. */
+};
+
+#endif // CPREVIEW_H
@@ -21,6 +21,7 @@
  */
 
 #include "cprofile.h"
+#include "cprofilecache.h"
 
 CProfile::CProfile() : CBase(),
     LaunchableDirs      (false),
@@ -30,11 +31,17 @@ CProfile::CProfile() : CBase(),
     TargetApp           (""),
     ZipFile             (""),
     EntryFilter         (""),
+    SyncAfter           (),
     Commands            (),
     Extensions          (),
     Entries             (),
+    CmdPlans            (),
+    ExtPlans            (),
     AlphabeticIndices   (),
-    Minizip             ()
+    Minizip             (),
+    Fields              (),
+    SavedFilePath       (""),
+    Journaled           (false)
 {
     AlphabeticIndices.resize(TOTAL_LETTERS, 0);
 }
@@ -45,125 +52,163 @@ CProfile::~CProfile()
 
 int8_t CProfile::Load( const string& location, const string& delimiter )
 {
-    string          line;
-    ifstream        fin;
+    TRACE_SPAN( "CProfile::Load" );
+
+    bool            compiled;
+    CProfileCache   cache;
 
     Log( __FILENAME__, __LINE__, "  from location %s", location.c_str() );
-    fin.open(location.c_str(), ios_base::in);
 
-    if (!fin)
+    // The text is only parsed when it changed since the compiled form was written
+    compiled = (cache.Load( location, delimiter, *this ) == 0);
+    if (compiled == true)
+    {
+        Log( __FILENAME__, __LINE__, "  from compiled profile %s%s", location.c_str(), PROFILECACHE_EXT );
+    }
+    else if (LoadText( location, delimiter ))
     {
-        Log( __FILENAME__, __LINE__, "Error: Failed to open profile" );
         return 1;
     }
 
-    // Read in the profile
-    if (fin.is_open())
+    // Sanity checks
+    if (FilePath.length() == 0)
     {
-        bool readline = true;
+        Log( __FILENAME__, __LINE__, "Error: file path was not read from profile" );
+        return 1;
+    }
+    if (Extensions.size() == 0)
+    {
+        Log( __FILENAME__, __LINE__, "Error: no extensions were read from profile" );
+        return 1;
+    }
 
-        while (!fin.eof())
+    if (compiled == false)
+    {
+        cache.Save( location, delimiter, *this );
+    }
+
+    // Changes made since the profile was written, a damaged journal only loses what it could not read
+    if (LoadJournal( location, delimiter ))
+    {
+        Log( __FILENAME__, __LINE__, "Warning: journal %s%s was not fully replayed", location.c_str(), PROFILE_JOURNAL_EXT );
+    }
+    SavedFilePath = FilePath;
+
+    // Problems are reported now, the launch of an affected entry fails later
+    if (Compile())
+    {
+        Log( __FILENAME__, __LINE__, "Warning: profile %s has errors", location.c_str() );
+    }
+
+    return 0;
+}
+
+int8_t CProfile::LoadText( const string& location, const string& delimiter )
+{
+    bool            readline;
+    textview_t      line;
+    textview_t      value;
+    CTokenizer      tokens;
+
+    if (tokens.Open( location ))
+    {
+        Log( __FILENAME__, __LINE__, "Error: Failed to open profile" );
+        return 1;
+    }
+
+    // Read in the profile, a block loader leaves the line after the block for the next pass
+    readline = true;
+    while ((readline == false) || (tokens.Next( line ) == true))
+    {
+        readline = true;
+        if (line.Length == 0)
         {
-            if (readline == true)
-            {
-                getline(fin,line);
-            }
+            continue;
+        }
 
-            if (line.length() > 0)
-            {
-                // Common options
-                if (UnprefixString( TargetApp, line, PROFILE_TARGETAPP ) == true)
-                {
-                    readline = true;
-                }
-                else
-                if (UnprefixString( FilePath, line, PROFILE_FILEPATH ) == true)
-                {
-                    CheckPath(FilePath);
-                    readline = true;
-                }
-                else    // Commands
-                if ((line.at(0) == '<') && (line.at(line.length()-1) == '>'))
+        switch (line.Data[0])
+        {
+            case '<':   // Commands
+                if (line.Data[line.Length-1] == '>')
                 {
-                    if (LoadCmd(fin, line, delimiter))
+                    if (LoadCmd( tokens, line, delimiter ))
                     {
                         Log( __FILENAME__, __LINE__, "Error: Loading command from %s", location.c_str() );
                         return 1;
                     }
                     readline = false;
                 }
-                else    // Extensions
-                if ((line.at(0) == '[') && (line.at(line.length()-1) == ']'))
+                break;
+            case '[':   // Extensions
+                if (line.Data[line.Length-1] == ']')
                 {
-                    if (LoadExt(fin, line, delimiter))
+                    if (LoadExt( tokens, line, delimiter ))
                     {
                         Log( __FILENAME__, __LINE__, "Error: Loading extension from %s", location.c_str() );
                         return 1;
                     }
                     readline = false;
                 }
-                else    // Entries
-                if ((line.at(0) == '{') && (line.at(line.length()-1) == '}'))
+                break;
+            case '{':   // Entries
+                if (line.Data[line.Length-1] == '}')
                 {
-                    if (LoadEntry(fin, line, delimiter))
+                    if (LoadEntry( tokens, line, delimiter ))
                     {
                         Log( __FILENAME__, __LINE__, "Error: Loading entry from %s", location.c_str() );
                         return 1;
                     }
                     readline = false;
                 }
-                else
+                break;
+            default:    // Common options
+                if (tokens.Unprefix( line, PROFILE_TARGETAPP, value ) == true)
                 {
-                    readline = true;
+                    TargetApp = tokens.Text( value );
                 }
-            }
-            else
-            {
-                readline = true;
-            }
+                else if (tokens.Unprefix( line, PROFILE_FILEPATH, value ) == true)
+                {
+                    FilePath = tokens.Text( value );
+                    CheckPath(FilePath);
+                }
+                else if (tokens.Unprefix( line, PROFILE_SYNCAFTER, value ) == true)
+                {
+                    tokens.Split( value, delimiter, Fields );
+                    SyncAfter.clear();
+                    for (uint16_t i=0; i<Fields.size(); i++)
+                    {
+                        SyncAfter.push_back( tokens.Text( Fields.at(i) ) );
+                    }
+                }
+                break;
         }
-        fin.close();
-    }
-    else
-    {
-        Log( __FILENAME__, __LINE__, "Error: Failed to open profile" );
-        return 1;
-    }
-
-    // Sanity checks
-    if (FilePath.length() == 0)
-    {
-        Log( __FILENAME__, __LINE__, "Error: file path was not read from profile" );
-        return 1;
-    }
-    if (Extensions.size() == 0)
-    {
-        Log( __FILENAME__, __LINE__, "Error: no extensions were read from profile" );
-        return 1;
     }
+    tokens.Close();
 
     return 0;
 }
 
-int8_t CProfile::LoadCmd( ifstream& fin, string& line, const string& delimiter )
+int8_t CProfile::LoadCmd( CTokenizer& tokens, textview_t& line, const string& delimiter )
 {
     uint8_t         count;
+    string          text;
     command_t       cmd;
     argument_t      arg;
-    vector<string>  parts;
+    textview_t      value;
 
     // Command name
-    cmd.Name = line.substr( 1, line.length()-2 );
+    cmd.Name = tokens.Text( textview_t( line.Data+1, line.Length-2 ) );
 
     // Command location and script
-    getline(fin,line);
-    if (UnprefixString( line, line, PROFILE_CMDPATH ) == true)
+    tokens.Next( line );
+    if (tokens.Unprefix( line, PROFILE_CMDPATH, value ) == true)
     {
-        cmd.Command = line.substr( line.find_last_of('/')+1 );
-        cmd.Path    = line.substr( 0, line.find_last_of('/')+1 );
+        text        = tokens.Text( value );
+        cmd.Command = text.substr( text.find_last_of('/')+1 );
+        cmd.Path    = text.substr( 0, text.find_last_of('/')+1 );
         CheckPath( cmd.Path );
 
-        getline(fin,line);
+        tokens.Next( line );
     }
     else
     {
@@ -173,29 +218,29 @@ int8_t CProfile::LoadCmd( ifstream& fin, string& line, const string& delimiter )
 
     // Command arguments and values
     count = 0;
-    while (UnprefixString( line, line, PROFILE_CMDARG ) == true)
+    while (tokens.Unprefix( line, PROFILE_CMDARG, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (parts.size() >= ARG_MIN_COUNT)
+        if (Fields.size() >= ARG_MIN_COUNT)
         {
-            arg.Name    = parts.at(0);
-            arg.Flag    = parts.at(1);
-            arg.Default = a_to_i( parts.at(2) );
+            arg.Name    = tokens.Text( Fields.at(0) );
+            arg.Flag    = tokens.Text( Fields.at(1) );
+            arg.Default = tokens.Integer( Fields.at(2) );
 
             arg.Names.clear();
             arg.Values.clear();
-            for (uint8_t i=3; i<parts.size(); i++)
+            for (uint8_t i=3; i<Fields.size(); i++)
             {
-                arg.Names.push_back( parts.at(i) );
+                arg.Names.push_back( tokens.Text( Fields.at(i) ) );
                 i++;
-                if (i<parts.size())
+                if (i<Fields.size())
                 {
-                    arg.Values.push_back( parts.at(i) );
+                    arg.Values.push_back( tokens.Text( Fields.at(i) ) );
                 }
                 else
                 {
-                    Log( __FILENAME__, __LINE__, "Error: Uneven number of argument names to values\n line:'%s'", line.c_str() );
+                    Log( __FILENAME__, __LINE__, "Error: Uneven number of argument names to values\n line:'%s'", tokens.Text( value ).c_str() );
                     return 1;
                 }
             }
@@ -208,11 +253,11 @@ int8_t CProfile::LoadCmd( ifstream& fin, string& line, const string& delimiter )
             cmd.Arguments.push_back( arg );
 
             count++;
-            getline( fin, line );
+            tokens.Next( line );
         }
         else
         {
-            Log( __FILENAME__, __LINE__, "Error: Not enough argument parts detected\n line:'%s'", line.c_str() );
+            Log( __FILENAME__, __LINE__, "Error: Not enough argument parts detected\n line:'%s'", tokens.Text( value ).c_str() );
             return 1;
         }
     }
@@ -227,23 +272,22 @@ int8_t CProfile::LoadCmd( ifstream& fin, string& line, const string& delimiter )
     return 0;
 }
 
-int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
+int8_t CProfile::LoadExt( CTokenizer& tokens, textview_t& line, const string& delimiter )
 {
     uint8_t         count;
-    vector<string>  parts;
+    string          text;
     extension_t     ext;
     argument_t      arg;
     argforce_t      argforce;
     exeforce_t      exeforce;
-    string          extensions;
+    textview_t      value;
 
     // Extension names
-    extensions = line.substr(1, line.length()-2);
-    SplitString( delimiter, extensions, parts );
+    tokens.Split( textview_t( line.Data+1, line.Length-2 ), delimiter, Fields );
     ext.extName.clear();
-    for (uint8_t i=0; i<parts.size(); i++)
+    for (uint8_t i=0; i<Fields.size(); i++)
     {
-        ext.extName.push_back( lowercase(parts.at(i)) );
+        ext.extName.push_back( lowercase( tokens.Text( Fields.at(i) ) ) );
     }
 
     if (ext.extName.size() == 0)
@@ -253,14 +297,15 @@ int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
     }
 
     // Extension executable
-    getline(fin,line);
-    if (UnprefixString( line, line, PROFILE_EXEPATH ) == true)
+    tokens.Next( line );
+    if (tokens.Unprefix( line, PROFILE_EXEPATH, value ) == true)
     {
-        ext.exeName = line.substr( line.find_last_of('/')+1 );
-        ext.exePath = line.substr( 0, line.find_last_of('/')+1 );
+        text        = tokens.Text( value );
+        ext.exeName = text.substr( text.find_last_of('/')+1 );
+        ext.exePath = text.substr( 0, text.find_last_of('/')+1 );
         CheckPath( ext.exePath );
 
-        getline(fin,line);
+        tokens.Next( line );
     }
     else
     {
@@ -269,38 +314,42 @@ int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
     }
 
     // Extension blacklist
-    if (UnprefixString( line, line, PROFILE_BLACKLIST ) == true)
+    if (tokens.Unprefix( line, PROFILE_BLACKLIST, value ) == true)
     {
-        SplitString( delimiter, line, ext.Blacklist );
+        tokens.Split( value, delimiter, Fields );
+        for (uint16_t i=0; i<Fields.size(); i++)
+        {
+            ext.Blacklist.push_back( tokens.Text( Fields.at(i) ) );
+        }
 
-        getline(fin,line);
+        tokens.Next( line );
     }
 
     // Extension arguments
     count = 0;
-    while (UnprefixString( line, line, PROFILE_EXTARG ) == true)
+    while (tokens.Unprefix( line, PROFILE_EXTARG, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (parts.size() >= ARG_MIN_COUNT)
+        if (Fields.size() >= ARG_MIN_COUNT)
         {
-            arg.Name    = parts.at(0);
-            arg.Flag    = parts.at(1);
-            arg.Default = a_to_i( parts.at(2) );
+            arg.Name    = tokens.Text( Fields.at(0) );
+            arg.Flag    = tokens.Text( Fields.at(1) );
+            arg.Default = tokens.Integer( Fields.at(2) );
 
             arg.Names.clear();
             arg.Values.clear();
-            for (uint8_t i=3; i<parts.size(); i++)
+            for (uint8_t i=3; i<Fields.size(); i++)
             {
-                arg.Names.push_back( parts.at(i) );
+                arg.Names.push_back( tokens.Text( Fields.at(i) ) );
                 i++;
-                if (i<parts.size())
+                if (i<Fields.size())
                 {
-                    arg.Values.push_back( parts.at(i) );
+                    arg.Values.push_back( tokens.Text( Fields.at(i) ) );
                 }
                 else
                 {
-                    Log( __FILENAME__, __LINE__, "Error: Uneven number of argument names to values\n line:'%s'", line.c_str() );
+                    Log( __FILENAME__, __LINE__, "Error: Uneven number of argument names to values\n line:'%s'", tokens.Text( value ).c_str() );
                     return 1;
                 }
             }
@@ -313,11 +362,11 @@ int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
             ext.Arguments.push_back(arg);
 
             count++;
-            getline(fin,line);
+            tokens.Next( line );
         }
         else
         {
-            Log( __FILENAME__, __LINE__, "Error: Not enough argument parts detected\n line:'%s'", line.c_str() );
+            Log( __FILENAME__, __LINE__, "Error: Not enough argument parts detected\n line:'%s'", tokens.Text( value ).c_str() );
             return 1;
         }
     }
@@ -329,51 +378,52 @@ int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
     }
 
     // Extension argforces
-    while (UnprefixString( line, line, PROFILE_ARGFORCE ) == true)
+    while (tokens.Unprefix( line, PROFILE_ARGFORCE, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (parts.size() == ARGFORCE_COUNT)
+        if (Fields.size() == ARGFORCE_COUNT)
         {
-            argforce.Path = parts.at(0);
+            argforce.Path = tokens.Text( Fields.at(0) );
             CheckPath(argforce.Path);
 
-            argforce.Argument   = a_to_i( parts.at(1) );
-            argforce.Value      = parts.at(2);
+            argforce.Argument   = tokens.Integer( Fields.at(1) );
+            argforce.Value      = tokens.Text( Fields.at(2) );
             ext.ArgForces.push_back( argforce );
         }
         else
         {
-            Log( __FILENAME__, __LINE__, "Error: %s wrong number of parts actual: %d expected: %s", PROFILE_ARGFORCE, parts.size(), ARGFORCE_COUNT );
+            Log( __FILENAME__, __LINE__, "Error: %s wrong number of parts actual: %d expected: %d", PROFILE_ARGFORCE, (int32_t)Fields.size(), ARGFORCE_COUNT );
             return 1;
         }
-        getline( fin, line );
+        tokens.Next( line );
     }
 
     // Exe path forces
-    while (UnprefixString( line, line, PROFILE_EXEFORCE ) == true)
+    while (tokens.Unprefix( line, PROFILE_EXEFORCE, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (parts.size()>=EXEFORCE_COUNT)
+        if (Fields.size()>=EXEFORCE_COUNT)
         {
-            exeforce.exeName = parts.at(0).substr( line.find_last_of('/')+1 );
-            exeforce.exePath = parts.at(0).substr( 0, line.find_last_of('/')+1 );
+            text             = tokens.Text( Fields.at(0) );
+            exeforce.exeName = text.substr( text.find_last_of('/')+1 );
+            exeforce.exePath = text.substr( 0, text.find_last_of('/')+1 );
             CheckPath( exeforce.exePath );
 
             exeforce.Files.clear();
-            for (uint8_t i=1; i<parts.size(); i++)
+            for (uint8_t i=1; i<Fields.size(); i++)
             {
-                exeforce.Files.push_back( parts.at(i) );
+                exeforce.Files.push_back( tokens.Text( Fields.at(i) ) );
             }
             ext.ExeForces.push_back( exeforce );
         }
         else
         {
-            Log( __FILENAME__, __LINE__, "Error: %s wrong number of parts actual: %d expected: %s", PROFILE_EXEFORCE, parts.size(), EXEFORCE_COUNT );
+            Log( __FILENAME__, __LINE__, "Error: %s wrong number of parts actual: %d expected: %d", PROFILE_EXEFORCE, (int32_t)Fields.size(), EXEFORCE_COUNT );
             return 1;
         }
-        getline( fin, line );
+        tokens.Next( line );
     }
     Extensions.push_back(ext);
 
@@ -392,59 +442,86 @@ int8_t CProfile::LoadExt( ifstream& fin, string& line, const string& delimiter )
     return 0;
 }
 
-int8_t CProfile::LoadEntry( ifstream& fin, string& line, const string& delimiter )
+int8_t CProfile::LoadEntry( CTokenizer& tokens, textview_t& line, const string& delimiter )
 {
-    string::size_type   pos1,pos2;
     entry_t             entry;
-    vector<string>      parts;
 
-    // Extension name
-    pos1 = line.find_last_of('/');
-    pos2 = line.find_last_of(delimiter);
+    if (ReadEntry( tokens, line, delimiter, entry ))
+    {
+        return 1;
+    }
 
-    if ((pos1 == string::npos) || (pos1 > pos2))
+    if ((entry.Alias.length() > 0) || (entry.Custom == true))
     {
-        entry.Path  = "./"; // default path
-        pos1 = 0;
+        Entries.push_back( entry );
     }
-    else
+
+    return 0;
+}
+
+int8_t CProfile::ReadEntry( CTokenizer& tokens, textview_t& line, const string& delimiter, entry_t& entry )
+{
+    int32_t             pos1,pos2;
+    textview_t          value;
+
+    // Entry path, name and alias: {path/name<delimiter>alias}
+    pos1 = -1;
+    pos2 = -1;
+    for (uint32_t i=0; i<line.Length; i++)
     {
-        entry.Path  = line.substr( 1, pos1 );
+        if (line.Data[i] == '/')
+        {
+            pos1 = i;
+        }
+        else if (delimiter.find( line.Data[i] ) != string::npos)
+        {
+            pos2 = i;
+        }
     }
 
-    if (pos2 == string::npos)
+    if (pos2 < 0)
     {
-        Log( __FILENAME__, __LINE__, "Error: A delimiter was expected in entry: %s", line.c_str() );
+        Log( __FILENAME__, __LINE__, "Error: A delimiter was expected in entry: %s", tokens.Text( line ).c_str() );
         return 1;
     }
 
-    entry.Name  = line.substr( pos1+1, pos2-pos1-1 );
-    entry.Alias = line.substr( pos2+1, line.length()-pos2-2 );
+    if ((pos1 < 0) || (pos1 > pos2))
+    {
+        entry.Path  = "./"; // default path
+        pos1 = 0;
+    }
+    else
+    {
+        entry.Path.assign( line.Data+1, pos1 );
+    }
+
+    entry.Name.assign( line.Data+pos1+1, pos2-pos1-1 );
+    entry.Alias.assign( line.Data+pos2+1, line.Length-pos2-2 );
 
 #if defined(DEBUG)
     Log( __FILENAME__, __LINE__, "DEBUG: Path: '%s' Name: '%s' Alias '%s'", entry.Path.c_str(), entry.Name.c_str(), entry.Alias.c_str() );
 #endif
 
-    // Extension executable
-    getline(fin,line);
-    if (UnprefixString( line, line, PROFILE_ENTRY_CMDS ) == true)
+    // Entry command values
+    tokens.Next( line );
+    if (tokens.Unprefix( line, PROFILE_ENTRY_CMDS, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (   (parts.size() == 0)
-            || (parts.at(0).compare(VALUE_NOVALUE) == 0)
+        if (   (Fields.size() == 0)
+            || (tokens.Equal( Fields.at(0), VALUE_NOVALUE ) == true)
            )
         {
             entry.Custom = false;
         }
         else
         {
-            for (uint8_t i=0; i<parts.size(); i++)
+            for (uint8_t i=0; i<Fields.size(); i++)
             {
-                int32_t value = a_to_i( parts.at(i) );
+                int32_t number = tokens.Integer( Fields.at(i) );
 
-                entry.CmdValues.push_back( value );
-                if (value != DEFAULT_VALUE)
+                entry.CmdValues.push_back( number );
+                if (number != DEFAULT_VALUE)
                 {
                     entry.Custom = true;
                 }
@@ -457,13 +534,14 @@ int8_t CProfile::LoadEntry( ifstream& fin, string& line, const string& delimiter
         return 1;
     }
 
-    getline(fin,line);
-    if (UnprefixString( line, line, PROFILE_ENTRY_ARGS ) == true)
+    // Entry argument values
+    tokens.Next( line );
+    if (tokens.Unprefix( line, PROFILE_ENTRY_ARGS, value ) == true)
     {
-        SplitString( delimiter, line, parts );
+        tokens.Split( value, delimiter, Fields );
 
-        if (   (parts.size() == 0)
-            || (parts.at(0).compare(VALUE_NOVALUE) == 0)
+        if (   (Fields.size() == 0)
+            || (tokens.Equal( Fields.at(0), VALUE_NOVALUE ) == true)
            )
         {
             if (entry.Custom == true)
@@ -479,12 +557,12 @@ int8_t CProfile::LoadEntry( ifstream& fin, string& line, const string& delimiter
             }
             else
             {
-                for (uint8_t i=0; i<parts.size(); i++)
+                for (uint8_t i=0; i<Fields.size(); i++)
                 {
-                    int32_t value = a_to_i( parts.at(i) );
+                    int32_t number = tokens.Integer( Fields.at(i) );
 
-                    entry.ArgValues.push_back( value );
-                    if (value != DEFAULT_VALUE)
+                    entry.ArgValues.push_back( number );
+                    if (number != DEFAULT_VALUE)
                     {
                         entry.Custom = true;
                     }
@@ -498,10 +576,8 @@ int8_t CProfile::LoadEntry( ifstream& fin, string& line, const string& delimiter
         return 1;
     }
 
-    if ((entry.Alias.length() > 0) || (entry.Custom == true))
-    {
-        Entries.push_back( entry );
-    }
+    // The line after the block is left for the caller
+    tokens.Next( line );
 
     return 0;
 }
@@ -541,9 +617,13 @@ int16_t CProfile::AddEntry( listoption_t& argument, const string& name )
 
 int8_t CProfile::Save( const string& location, const string& delimiter )
 {
-    ofstream   fout;
+    ofstream        fout;
+    string          temporary;
+    CProfileCache   cache;
 
-    fout.open( location.c_str(), ios_base::trunc );
+    // Written beside the profile and renamed over it, so a power loss leaves either the old or the new profile
+    temporary = location + ".tmp";
+    fout.open( temporary.c_str(), ios_base::trunc );
 
     if (!fout)
     {
@@ -557,6 +637,15 @@ int8_t CProfile::Save( const string& location, const string& delimiter )
         fout << "# Global Settings" << endl;
         fout << PROFILE_TARGETAPP << TargetApp << endl;
         fout << PROFILE_FILEPATH << FilePath << endl;
+        if (SyncAfter.size() > 0)
+        {
+            fout << PROFILE_SYNCAFTER << SyncAfter.at(0);
+            for (uint16_t i=1; i<SyncAfter.size(); i++)
+            {
+                fout << delimiter << SyncAfter.at(i);
+            }
+            fout << endl;
+        }
         // Commands
         fout << endl << "# Command Settings" << endl;
         for (uint16_t index=0; index<Commands.size(); index++)
@@ -700,6 +789,19 @@ int8_t CProfile::Save( const string& location, const string& delimiter )
         }
 
         fout.close();
+
+        // Only this file is flushed, not everything dirty on the device
+        SyncFile( temporary );
+        if (fout.fail() || rename( temporary.c_str(), location.c_str() ) != 0)
+        {
+            Log( __FILENAME__, __LINE__, "Failed to write profile %s", location.c_str() );
+            unlink( temporary.c_str() );
+            return 1;
+        }
+        SavedFilePath = FilePath;
+
+        // Stamped with the file just written, so the next start maps it instead of parsing
+        cache.Save( location, delimiter, *this );
     }
     else
     {
@@ -709,6 +811,246 @@ int8_t CProfile::Save( const string& location, const string& delimiter )
     return 0;
 }
 
+int8_t CProfile::Commit( const string& location, const string& delimiter, uint32_t limit )
+{
+    string          path;
+    struct stat     info;
+
+    path = location + PROFILE_JOURNAL_EXT;
+
+    // The path browsed to is remembered, but only journaled once instead of at every change of directory
+    if (FilePath != SavedFilePath)
+    {
+        if (AppendJournal( location, PROFILE_FILEPATH + FilePath + "\n" ) == 0)
+        {
+            SavedFilePath = FilePath;
+        }
+    }
+
+    if (stat( path.c_str(), &info ) != 0)
+    {
+        // Nothing changed since the profile was written
+        return 0;
+    }
+
+    if ((uint32_t)info.st_size > limit)
+    {
+        Log( __FILENAME__, __LINE__, "Compacting journal %s of %d bytes into the profile", path.c_str(), (int32_t)info.st_size );
+        if (Save( location, delimiter ))
+        {
+            return 1;
+        }
+        unlink( path.c_str() );
+        Journaled = false;
+    }
+    else if (Journaled == true)
+    {
+        SyncFile( path );
+        Journaled = false;
+    }
+    return 0;
+}
+
+int8_t CProfile::JournalEntry( const string& location, const string& delimiter, uint16_t index )
+{
+    stringstream    text;
+    entry_t*        entry;
+
+    if (!CheckRange( index, Entries.size() ))
+    {
+        Log( __FILENAME__, __LINE__, "Error: JournalEntry index out of range" );
+        return 1;
+    }
+    entry = &Entries.at(index);
+
+    // Same block as in the profile, the values are kept as they are so the journal can also reset them
+    text << "{" << entry->Path << entry->Name << delimiter << entry->Alias << "}" << endl;
+    text << PROFILE_ENTRY_CMDS;
+    if ((entry->CmdValues.size() == 0) && (entry->ArgValues.size() == 0))
+    {
+        text << VALUE_NOVALUE << endl << PROFILE_ENTRY_ARGS << VALUE_NOVALUE << endl;
+    }
+    else
+    {
+        for (uint16_t i=0; i<entry->CmdValues.size(); i++)
+        {
+            text << ((i>0) ? delimiter : "") << entry->CmdValues.at(i);
+        }
+        text << endl << PROFILE_ENTRY_ARGS;
+        for (uint16_t i=0; i<entry->ArgValues.size(); i++)
+        {
+            text << ((i>0) ? delimiter : "") << entry->ArgValues.at(i);
+        }
+        text << endl;
+    }
+
+    return AppendJournal( location, text.str() );
+}
+
+int8_t CProfile::JournalDefault( const string& location, const string& delimiter, const listoption_t& argument )
+{
+    stringstream    text;
+
+    // Commands and extensions are named rather than indexed, the profile file may be edited in between
+    if (   (argument.Command >= 0)
+        && CheckRange( argument.Command, Commands.size() )
+        && CheckRange( argument.Argument, Commands.at(argument.Command).Arguments.size() )
+       )
+    {
+        text << PROFILE_CMDDEFAULT << Commands.at(argument.Command).Name
+             << delimiter << Commands.at(argument.Command).Arguments.at(argument.Argument).Name
+             << delimiter << i_to_a(Commands.at(argument.Command).Arguments.at(argument.Argument).Default) << endl;
+    }
+    else if (   (argument.Command < 0)
+             && CheckRange( argument.Extension, Extensions.size() )
+             && CheckRange( argument.Argument, Extensions.at(argument.Extension).Arguments.size() )
+             && (Extensions.at(argument.Extension).extName.size() > 0)
+            )
+    {
+        text << PROFILE_EXTDEFAULT << Extensions.at(argument.Extension).extName.at(0)
+             << delimiter << Extensions.at(argument.Extension).Arguments.at(argument.Argument).Name
+             << delimiter << i_to_a(Extensions.at(argument.Extension).Arguments.at(argument.Argument).Default) << endl;
+    }
+    else
+    {
+        Log( __FILENAME__, __LINE__, "Error: JournalDefault argument out of range" );
+        return 1;
+    }
+
+    return AppendJournal( location, text.str() );
+}
+
+int8_t CProfile::LoadJournal( const string& location, const string& delimiter )
+{
+    bool            readline;
+    int16_t         found;
+    uint16_t        changes;
+    string          path;
+    textview_t      line;
+    textview_t      value;
+    entry_t         entry;
+    CTokenizer      tokens;
+
+    path = location + PROFILE_JOURNAL_EXT;
+    if (tokens.Open( path ))
+    {
+        // No journal, nothing changed since the profile was written
+        return 0;
+    }
+
+    changes  = 0;
+    readline = true;
+    while ((readline == false) || (tokens.Next( line ) == true))
+    {
+        readline = true;
+        if (line.Length == 0)
+        {
+            continue;
+        }
+
+        if ((line.Data[0] == '{') && (line.Data[line.Length-1] == '}'))
+        {
+            // A block cut short by a power loss ends the replay
+            entry = entry_t();
+            if (ReadEntry( tokens, line, delimiter, entry ))
+            {
+                tokens.Close();
+                return 1;
+            }
+            readline = false;
+
+            // The latest values of an entry replace any before them
+            found = -1;
+            for (uint16_t i=0; i<Entries.size(); i++)
+            {
+                if ((Entries.at(i).Name == entry.Name) && (Entries.at(i).Path == entry.Path))
+                {
+                    found = i;
+                    break;
+                }
+            }
+            if (found >= 0)
+            {
+                Entries.at(found) = entry;
+            }
+            else
+            {
+                Entries.push_back( entry );
+            }
+        }
+        else if (tokens.Unprefix( line, PROFILE_FILEPATH, value ) == true)
+        {
+            FilePath = tokens.Text( value );
+            CheckPath(FilePath);
+        }
+        else if (tokens.Unprefix( line, PROFILE_CMDDEFAULT, value ) == true)
+        {
+            tokens.Split( value, delimiter, Fields );
+            for (uint16_t i=0; i<Commands.size() && Fields.size() == 3; i++)
+            {
+                if (tokens.Equal( Fields.at(0), Commands.at(i).Name.c_str() ) == true)
+                {
+                    for (uint16_t j=0; j<Commands.at(i).Arguments.size(); j++)
+                    {
+                        if (tokens.Equal( Fields.at(1), Commands.at(i).Arguments.at(j).Name.c_str() ) == true)
+                        {
+                            Commands.at(i).Arguments.at(j).Default = tokens.Integer( Fields.at(2) );
+                        }
+                    }
+                }
+            }
+        }
+        else if (tokens.Unprefix( line, PROFILE_EXTDEFAULT, value ) == true)
+        {
+            tokens.Split( value, delimiter, Fields );
+            found = (Fields.size() == 3) ? FindExtension( tokens.Text( Fields.at(0) ) ) : -1;
+            if (found >= 0)
+            {
+                for (uint16_t j=0; j<Extensions.at(found).Arguments.size(); j++)
+                {
+                    if (tokens.Equal( Fields.at(1), Extensions.at(found).Arguments.at(j).Name.c_str() ) == true)
+                    {
+                        Extensions.at(found).Arguments.at(j).Default = tokens.Integer( Fields.at(2) );
+                    }
+                }
+            }
+        }
+        else
+        {
+            continue;
+        }
+        changes++;
+    }
+    tokens.Close();
+
+    Log( __FILENAME__, __LINE__, "  replayed %d changes from journal %s", changes, path.c_str() );
+    return 0;
+}
+
+int8_t CProfile::AppendJournal( const string& location, const string& text )
+{
+    ofstream    fout;
+    string      path;
+
+    path = location + PROFILE_JOURNAL_EXT;
+    fout.open( path.c_str(), ios_base::app );
+    if (!fout)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open journal %s", path.c_str() );
+        return 1;
+    }
+
+    fout << text;
+    fout.close();
+    if (fout.fail())
+    {
+        Log( __FILENAME__, __LINE__, "Failed to write journal %s", path.c_str() );
+        return 1;
+    }
+    Journaled = true;
+    return 0;
+}
+
 int8_t CProfile::ScanEntry( listitem_t& item, vector<listoption_t>& items )
 {
     int16_t ext_index;
@@ -932,6 +1274,8 @@ void CProfile::ScanArgument( listoption_t& item, vector<string>& values )
 
 int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip, vector<listitem_t>& items )
 {
+    TRACE_SPAN( "CProfile::ScanDir" );
+
     DIR *dp = NULL;
     struct dirent *dirp = NULL;
     string filename;
@@ -948,6 +1292,7 @@ int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip,
 
     if (ZipFile.length() == 0)
     {
+        IoCount( IO_OPENDIR );
         if((dp = opendir(location.c_str())) == NULL)
         {
             Log( __FILENAME__, __LINE__, "Failed to open dir path %s", location.c_str() );
@@ -956,6 +1301,7 @@ int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip,
 
         while ((dirp = readdir(dp)) != NULL)
         {
+            IoCount( IO_READDIR );
             filename = string(dirp->d_name);
 
             if (filename.length() > 0)
@@ -1011,7 +1357,7 @@ int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip,
     }
 
     // Filter
-    for (uint16_t file=0; file<files.size(); file++)
+    for (uint32_t file=0; file<files.size(); file++)
     {
         found = false;
         if (   (CheckExtension( files.at(file), ZIP_EXT) < 0)       // Any non-zip ext should be filtered
@@ -1091,12 +1437,15 @@ int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip,
     }
 
     // Sort
-    sort( items.begin(), items.end(), CompareItems );
+    {
+        TRACE_SPAN( "CProfile::CompareItems" );
+        sort( items.begin(), items.end(), CompareItems );
+    }
 
     // Build alphabetic indices
     AlphabeticIndices.clear();
     AlphabeticIndices.resize(TOTAL_LETTERS, 0);
-    for (uint16_t i=0; i<items.size(); i++)
+    for (uint32_t i=0; i<items.size(); i++)
     {
         if (items.at(i).Type != TYPE_DIR)
         {
@@ -1135,6 +1484,125 @@ int8_t CProfile::ScanDir( const string& location, bool showhidden, bool showzip,
     return 0;
 }
 
+static uint8_t ValueType( const string& value )
+{
+    if (value.compare( VALUE_FILENAME ) == 0)
+    {
+        return VALUETYPE_FILENAME;
+    }
+    else if (value.compare( VALUE_NOVALUE ) == 0)
+    {
+        return VALUETYPE_NOVALUE;
+    }
+    else if (value.compare( VALUE_FLAGONLY ) == 0)
+    {
+        return VALUETYPE_FLAGONLY;
+    }
+    return VALUETYPE_TEXT;
+}
+
+int8_t CProfile::Compile( void )
+{
+    int8_t              result;
+    argument_t*         argument;
+    argforce_t*         argforce;
+    argplan_t*          plan;
+    vector<int16_t>*    forces;
+
+    result = 0;
+    CmdPlans.clear();
+    ExtPlans.clear();
+    CmdPlans.resize( Commands.size() );
+    ExtPlans.resize( Extensions.size() );
+
+    for (uint16_t i=0; i<Commands.size(); i++)
+    {
+        CmdPlans.at(i).Program = Commands.at(i).Path + Commands.at(i).Command;
+        CmdPlans.at(i).Arguments.resize( Commands.at(i).Arguments.size() );
+
+        for (uint16_t j=0; j<Commands.at(i).Arguments.size(); j++)
+        {
+            argument = &Commands.at(i).Arguments.at(j);
+            plan     = &CmdPlans.at(i).Arguments.at(j);
+
+            plan->UseFlag  = (argument->Flag.compare( VALUE_NOVALUE ) != 0);
+            plan->UseValue = (argument->Flag.compare( VALUE_FLAGONLY ) != 0);
+            plan->Flag     = argument->Flag;
+            for (uint16_t k=0; k<argument->Values.size(); k++)
+            {
+                plan->Types.push_back( ValueType( argument->Values.at(k) ) );
+            }
+
+            if (!CheckRange( argument->Default, argument->Values.size() ))
+            {
+                Log( __FILENAME__, __LINE__, "Error: command %s argument %s has no value for its default", Commands.at(i).Name.c_str(), argument->Name.c_str() );
+                result = 1;
+            }
+        }
+    }
+
+    for (uint16_t i=0; i<Extensions.size(); i++)
+    {
+        ExtPlans.at(i).Arguments.resize( Extensions.at(i).Arguments.size() );
+
+        for (uint16_t j=0; j<Extensions.at(i).Arguments.size(); j++)
+        {
+            argument = &Extensions.at(i).Arguments.at(j);
+            plan     = &ExtPlans.at(i).Arguments.at(j);
+
+            plan->Flag = " " + argument->Flag + " ";
+            for (uint16_t k=0; k<argument->Values.size(); k++)
+            {
+                plan->Types.push_back( ValueType( argument->Values.at(k) ) );
+            }
+
+            if (!CheckRange( argument->Default, argument->Values.size() ))
+            {
+                Log( __FILENAME__, __LINE__, "Error: extension %s argument %s has no value for its default", Extensions.at(i).exeName.c_str(), argument->Name.c_str() );
+                result = 1;
+            }
+        }
+
+        // The first force listed for a path and argument wins
+        for (uint16_t j=0; j<Extensions.at(i).ArgForces.size(); j++)
+        {
+            argforce = &Extensions.at(i).ArgForces.at(j);
+            ExtPlans.at(i).ForceTypes.push_back( ValueType( argforce->Value ) );
+            if (!CheckRange( argforce->Argument, Extensions.at(i).Arguments.size() ))
+            {
+                Log( __FILENAME__, __LINE__, "Error: extension %s argforce for %s uses argument %d which does not exist", Extensions.at(i).exeName.c_str(), argforce->Path.c_str(), argforce->Argument );
+                result = 1;
+                continue;
+            }
+
+            forces = &ExtPlans.at(i).ArgForces[argforce->Path];
+            if (forces->size() == 0)
+            {
+                forces->resize( Extensions.at(i).Arguments.size(), -1 );
+            }
+            if (forces->at(argforce->Argument) < 0)
+            {
+                forces->at(argforce->Argument) = j;
+            }
+        }
+
+        // The last exe force listing a file wins, as when every force was checked at launch
+        for (uint16_t j=0; j<Extensions.at(i).ExeForces.size(); j++)
+        {
+            if (Extensions.at(i).ExeForces.at(j).Files.size() == 0)
+            {
+                Log( __FILENAME__, __LINE__, "Warning: extension %s exeforce for %s lists no files", Extensions.at(i).exeName.c_str(), Extensions.at(i).ExeForces.at(j).exeName.c_str() );
+            }
+            for (uint16_t k=0; k<Extensions.at(i).ExeForces.at(j).Files.size(); k++)
+            {
+                ExtPlans.at(i).ExeForces[Extensions.at(i).ExeForces.at(j).Files.at(k)] = j;
+            }
+        }
+    }
+
+    return result;
+}
+
 int16_t CProfile::FindExtension( const string& ext )
 {
     for (uint16_t i=0; i<Extensions.size(); i++)
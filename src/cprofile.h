@@ -23,8 +23,11 @@
 #ifndef CPROFILE_H
 #define CPROFILE_H
 
+#include <map>
+
 #include "cbase.h"
 #include "czip.h"
+#include "ctokenizer.h"
 
 using namespace std;
 
@@ -32,6 +35,7 @@ using namespace std;
 
 #define PROFILE_TARGETAPP       "targetapp="        /** Prefix for the profile file to identify the path the target application. */
 #define PROFILE_FILEPATH        "filepath="         /** Prefix for the profile file to identify the initial path for files. */
+#define PROFILE_SYNCAFTER       "syncafter="        /** Prefix for the profile file to identify paths flushed after the application exits, separated by the profile delimiter. */
 #define PROFILE_BLACKLIST       "blacklist="        /** Prefix for the profile file to identify items not to be displayed. */
 #define PROFILE_CMDPATH         "cmdpath="          /** Prefix for the profile file to identify a command path and binary. */
 #define PROFILE_CMDARG          "cmdarg="           /** Prefix for the profile file to identify a command argument. */
@@ -41,6 +45,9 @@ using namespace std;
 #define PROFILE_ARGFORCE        "argforce="         /** Prefix for the profile file to identify the executable argument force. */
 #define PROFILE_ENTRY_ARGS      "entryargs="        /** Prefix for the profile file to identify an entry custom argument values. */
 #define PROFILE_ENTRY_CMDS      "entrycmds="        /** Prefix for the profile file to identify an entry custom command values. */
+#define PROFILE_CMDDEFAULT      "cmddefault="       /** Prefix for the journal to identify a new default value of a command argument. */
+#define PROFILE_EXTDEFAULT      "extdefault="       /** Prefix for the journal to identify a new default value of an extension argument. */
+#define PROFILE_JOURNAL_EXT     ".journal"          /** Appended to the profile path to name the journal of changes made since it was written. */
 
 #define EXT_DIRS                "dirs"              /** Special extension identifier for directories. */
 #define VALUE_FILENAME          "%filename%"        /** Profile keyword that is replaced by the path to selected file. */
@@ -133,6 +140,43 @@ struct extension_t {
     vector<exeforce_t>  ExeForces;  /** @brief Override the exe path based on file names. */
 };
 
+/** @brief Kinds of argument values, resolved when the profile is loaded
+ */
+enum VALUETYPES_T {
+    VALUETYPE_TEXT=0,               /** @brief Text passed as is */
+    VALUETYPE_FILENAME,             /** @brief Replaced by the selected file */
+    VALUETYPE_NOVALUE,              /** @brief The argument is left out */
+    VALUETYPE_FLAGONLY              /** @brief Only the flag is passed */
+};
+
+/** @brief Data structure for an argument prepared for building command lines
+ */
+struct argplan_t {
+    argplan_t() : UseFlag(true), UseValue(true), Flag(""), Types() {};
+    bool                UseFlag;    /** @brief For commands, false if the flag is not passed */
+    bool                UseValue;   /** @brief For commands, false if the value is not passed */
+    string              Flag;       /** @brief Flag text ready to add to the command line */
+    vector<uint8_t>     Types;      /** @brief Kind of each value (index is defined in VALUETYPES_T) */
+};
+
+/** @brief Data structure for a command prepared for building command lines
+ */
+struct cmdplan_t {
+    cmdplan_t() : Program(""), Arguments() {};
+    string              Program;    /** @brief Path and name of the command */
+    vector<argplan_t>   Arguments;  /** @brief Prepared arguments, same order as command_t::Arguments */
+};
+
+/** @brief Data structure for an extension prepared for building command lines
+ */
+struct extplan_t {
+    extplan_t() : Arguments(), ForceTypes(), ExeForces(), ArgForces() {};
+    vector<argplan_t>                   Arguments;  /** @brief Prepared arguments, same order as extension_t::Arguments */
+    vector<uint8_t>                     ForceTypes; /** @brief Kind of the value of each arg force (index is defined in VALUETYPES_T) */
+    map<string, int16_t>                ExeForces;  /** @brief Lookup from file name to the exe force that applies */
+    map<string, vector<int16_t> >       ArgForces;  /** @brief Lookup from path to the arg force of each argument, -1 for none */
+};
+
 /** @brief Data structure for a detected entry that has been set with custom arg/cmd values
  */
 struct entry_t {
@@ -169,29 +213,54 @@ class CProfile : public CBase
          */
         int8_t  Save            ( const string& location, const string&  delimiter );
 
+        /** @brief Keep the changes made since the profile was loaded. They are appended to the journal, the
+         *         profile is only rewritten once the journal grows past the limit.
+         * @param location : path to the profile file.
+         * @param delimiter : the delimiter used between options.
+         * @param limit : size of the journal in bytes above which it is compacted into the profile.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  Commit          ( const string& location, const string& delimiter, uint32_t limit );
+
+        /** @brief Append the current values of an entry to the journal.
+         * @param location : path to the profile file.
+         * @param delimiter : the delimiter used between options.
+         * @param index : index of the entry.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  JournalEntry    ( const string& location, const string& delimiter, uint16_t index );
+
+        /** @brief Append the current default value of an argument to the journal.
+         * @param location : path to the profile file.
+         * @param delimiter : the delimiter used between options.
+         * @param argument : the command or extension argument.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  JournalDefault  ( const string& location, const string& delimiter, const listoption_t& argument );
+
         /** @brief Load a command from a line from the profile.
-         * @param fin : file input.
-         * @param line : current read line.
+         * @param tokens : the mapped profile.
+         * @param line : current read line, set to the first line after the block.
          * @param delimiter : the delimiter used between options.
          * @return 0 if passed 1 if failed.
          */
-        int8_t  LoadCmd         ( ifstream& fin, string& line, const string& delimiter );
+        int8_t  LoadCmd         ( CTokenizer& tokens, textview_t& line, const string& delimiter );
 
         /** @brief Load a extension from a line from the profile.
-         * @param fin : file input.
-         * @param line : current read line.
+         * @param tokens : the mapped profile.
+         * @param line : current read line, set to the first line after the block.
          * @param delimiter : the delimiter used between options.
          * @return 0 if passed 1 if failed.
          */
-        int8_t  LoadExt         ( ifstream& fin, string& line, const string& delimiter );
+        int8_t  LoadExt         ( CTokenizer& tokens, textview_t& line, const string& delimiter );
 
         /** @brief Load a entry from a line from the profile.
-         * @param fin : file input.
-         * @param line : current read line.
+         * @param tokens : the mapped profile.
+         * @param line : current read line, set to the first line after the block.
          * @param delimiter : the delimiter used between options.
          * @return 0 if passed 1 if failed.
          */
-        int8_t  LoadEntry       ( ifstream& fin, string& line, const string& delimiter );
+        int8_t  LoadEntry       ( CTokenizer& tokens, textview_t& line, const string& delimiter );
 
         /** @brief Scan an entry for command and arguments and load them into a list.
          * @param item : the selected item from the list.
@@ -222,6 +291,11 @@ class CProfile : public CBase
          */
         int8_t  ScanDir         ( const string& location, bool showhidden, bool showzip, vector<listitem_t>& items );
 
+        /** @brief Prepare the commands and extensions for building command lines and check them for errors.
+         * @return 0 if passed 1 if errors were found.
+         */
+        int8_t  Compile         ( void );
+
         /** @brief Find the extension a file belongs to.
          * @param ext : extension to search for.
          * @return -1 if failed, else the index of the ext structure.
@@ -235,11 +309,49 @@ class CProfile : public CBase
         string              TargetApp;          /**< Label for the target application the launcher is executing. */
         string              ZipFile;            /**< If not empty then the currently loaded zip file. */
         string              EntryFilter;
+        vector<string>      SyncAfter;          /**< Paths whose file systems are flushed after the application exits, LAUNCH_SYNC_ALL for all. */
         vector<command_t>   Commands;           /**< Commands to be run before executing the target application. */
         vector<extension_t> Extensions;         /**< File extensions launchable by the target application. */
         vector<entry_t>     Entries;            /**< Entries with custom values. */
+        vector<cmdplan_t>   CmdPlans;           /**< Prepared commands, same order as Commands. */
+        vector<extplan_t>   ExtPlans;           /**< Prepared extensions, same order as Extensions. */
         vector<int16_t>     AlphabeticIndices;  /**< Set to cause the current directory to be rescaned. */
         CZip                Minizip;            /**< Handles examining and extracting zip files. */
+
+    private:
+        /** @brief Parse the profile data from the text file.
+         * @param location : path to the profile file.
+         * @param delimiter : the delimiter used between options.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  LoadText        ( const string& location, const string& delimiter );
+
+        /** @brief Replay the journal over the profile data loaded from the profile file.
+         * @param location : path to the profile file.
+         * @param delimiter : the delimiter used between options.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  LoadJournal     ( const string& location, const string& delimiter );
+
+        /** @brief Read the path, name, alias and values of an entry block.
+         * @param tokens : the mapped profile or journal.
+         * @param line : current read line, set to the first line after the block.
+         * @param delimiter : the delimiter used between options.
+         * @param entry : receives the entry.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  ReadEntry       ( CTokenizer& tokens, textview_t& line, const string& delimiter, entry_t& entry );
+
+        /** @brief Append text to the journal.
+         * @param location : path to the profile file.
+         * @param text : the lines to append.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  AppendJournal   ( const string& location, const string& text );
+
+        vector<textview_t>  Fields;             /**< Fields of the line being loaded, kept so their memory is reused. */
+        string              SavedFilePath;      /**< File path as the profile and journal have it, a different FilePath is journaled on commit. */
+        bool                Journaled;          /**< True once the journal was appended to since the profile was loaded. */
 };
 
 bool CompareItems( listitem_t a, listitem_t b );    /**< Compare two listitems, which sort by type and then by name. */
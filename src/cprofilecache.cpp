@@ -0,0 +1,552 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cprofilecache.h"
+
+#include <string.h>
+
+/** Size in bytes of a record of each table, same order as PROFILECACHE_TABLES_T. */
+static const uint32_t CacheRecordSizes[CACHE_TABLE_TOTAL] = {
+    sizeof(cachecommand_t),
+    sizeof(cacheextension_t),
+    sizeof(cacheargument_t),
+    sizeof(cacheargforce_t),
+    sizeof(cacheexeforce_t),
+    sizeof(cacheentry_t),
+    sizeof(cachestring_t),
+    sizeof(int32_t),
+    sizeof(char)
+};
+
+CProfileCache::CProfileCache() : CBase(),
+        Tables              (),
+        Previous            (""),
+        Pooled              (),
+        Mapped              (NULL),
+        Header              (NULL),
+        Valid               (false)
+{
+}
+
+CProfileCache::~CProfileCache()
+{
+}
+
+int8_t CProfileCache::Save( const string& location, const string& delimiter, const CProfile& profile )
+{
+    int32_t             fd;
+    bool                failed;
+    bool                custom;
+    uint32_t            offset;
+    string              path;
+    string              temporary;
+    struct stat         info;
+    cacheheader_t       header;
+    vector<int32_t>     cmdvalues;
+    vector<int32_t>     argvalues;
+
+    if (stat( location.c_str(), &info ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to compile profile %s: %s", location.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    Tables.clear();
+    Tables.resize( CACHE_TABLE_TOTAL );
+    Previous.clear();
+    memset( &Pooled, 0, sizeof(Pooled) );
+
+    memset( &header, 0, sizeof(header) );
+    header.Magic        = PROFILECACHE_MAGIC;
+    header.Version      = PROFILECACHE_VERSION;
+    header.Key          = Key( delimiter );
+    header.SourceTime   = info.st_mtime;
+    header.SourceSize   = info.st_size;
+    header.TargetApp    = Intern( profile.TargetApp );
+    header.FilePath     = Intern( profile.FilePath );
+    header.SyncAfter    = InternList( profile.SyncAfter );
+
+    for (uint16_t index=0; index<profile.Commands.size(); index++)
+    {
+        const command_t&    command = profile.Commands.at(index);
+        cachecommand_t      record;
+
+        memset( &record, 0, sizeof(record) );
+        record.Name         = Intern( command.Name );
+        record.Command      = Intern( command.Command );
+        record.Path         = Intern( command.Path );
+        record.Arguments    = AddArguments( command.Arguments );
+        Tables.at(CACHE_COMMANDS).append( reinterpret_cast<const char*>(&record), sizeof(record) );
+    }
+
+    for (uint16_t index=0; index<profile.Extensions.size(); index++)
+    {
+        const extension_t&  extension = profile.Extensions.at(index);
+        cacheextension_t    record;
+
+        memset( &record, 0, sizeof(record) );
+        record.exeName      = Intern( extension.exeName );
+        record.exePath      = Intern( extension.exePath );
+        record.extName      = InternList( extension.extName );
+        record.Blacklist    = InternList( extension.Blacklist );
+        record.Arguments    = AddArguments( extension.Arguments );
+
+        record.ArgForces.First = Tables.at(CACHE_ARGFORCES).length() / sizeof(cacheargforce_t);
+        record.ArgForces.Count = extension.ArgForces.size();
+        for (uint16_t i=0; i<extension.ArgForces.size(); i++)
+        {
+            cacheargforce_t force;
+
+            memset( &force, 0, sizeof(force) );
+            force.Argument  = extension.ArgForces.at(i).Argument;
+            force.Path      = Intern( extension.ArgForces.at(i).Path );
+            force.Value     = Intern( extension.ArgForces.at(i).Value );
+            Tables.at(CACHE_ARGFORCES).append( reinterpret_cast<const char*>(&force), sizeof(force) );
+        }
+
+        record.ExeForces.First = Tables.at(CACHE_EXEFORCES).length() / sizeof(cacheexeforce_t);
+        record.ExeForces.Count = extension.ExeForces.size();
+        for (uint16_t i=0; i<extension.ExeForces.size(); i++)
+        {
+            cacheexeforce_t force;
+
+            memset( &force, 0, sizeof(force) );
+            force.exeName   = Intern( extension.ExeForces.at(i).exeName );
+            force.exePath   = Intern( extension.ExeForces.at(i).exePath );
+            force.Files     = InternList( extension.ExeForces.at(i).Files );
+            Tables.at(CACHE_EXEFORCES).append( reinterpret_cast<const char*>(&force), sizeof(force) );
+        }
+        Tables.at(CACHE_EXTENSIONS).append( reinterpret_cast<const char*>(&record), sizeof(record) );
+    }
+
+    // Entries are kept as the text would read them back, so both forms of the profile load the same
+    for (uint16_t index=0; index<profile.Entries.size(); index++)
+    {
+        const entry_t&  entry = profile.Entries.at(index);
+        cacheentry_t    record;
+
+        custom = false;
+        cmdvalues.clear();
+        argvalues.clear();
+        if (entry.Custom == true)
+        {
+            // An empty list is written as an empty field, which reads back as 0
+            cmdvalues.assign( entry.CmdValues.begin(), entry.CmdValues.end() );
+            argvalues.assign( entry.ArgValues.begin(), entry.ArgValues.end() );
+            if (cmdvalues.size() == 0)
+            {
+                cmdvalues.push_back( 0 );
+            }
+            if (argvalues.size() == 0)
+            {
+                argvalues.push_back( 0 );
+            }
+            for (uint16_t i=0; i<cmdvalues.size(); i++)
+            {
+                custom |= (cmdvalues.at(i) != DEFAULT_VALUE);
+            }
+            for (uint16_t i=0; i<argvalues.size(); i++)
+            {
+                custom |= (argvalues.at(i) != DEFAULT_VALUE);
+            }
+        }
+
+        if ((entry.Alias.length() == 0) && (custom == false))
+        {
+            continue;
+        }
+
+        memset( &record, 0, sizeof(record) );
+        record.Custom       = (custom == true) ? 1 : 0;
+        record.Name         = Intern( entry.Name );
+        record.Path         = Intern( entry.Path );
+        record.Alias        = Intern( entry.Alias );
+        record.CmdValues    = AddValues( cmdvalues );
+        record.ArgValues    = AddValues( argvalues );
+        Tables.at(CACHE_ENTRIES).append( reinterpret_cast<const char*>(&record), sizeof(record) );
+    }
+
+    // Every record is a multiple of 4 bytes and the pool is last, so each table stays aligned
+    offset = sizeof(header);
+    for (uint8_t table=0; table<CACHE_TABLE_TOTAL; table++)
+    {
+        header.Tables[table].First = offset;
+        header.Tables[table].Count = Tables.at(table).length() / CacheRecordSizes[table];
+        offset += Tables.at(table).length();
+    }
+
+    path      = location + PROFILECACHE_EXT;
+    temporary = path + ".tmp";
+    fd = open( temporary.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+    if (fd < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write compiled profile %s: %s", temporary.c_str(), strerror(errno) );
+        Tables.clear();
+        return 1;
+    }
+
+    failed = (write( fd, &header, sizeof(header) ) != (ssize_t)sizeof(header));
+    for (uint8_t table=0; table<CACHE_TABLE_TOTAL && failed == false; table++)
+    {
+        failed = (write( fd, Tables.at(table).data(), Tables.at(table).length() ) != (ssize_t)Tables.at(table).length());
+    }
+    if (close( fd ) != 0)
+    {
+        failed = true;
+    }
+    Tables.clear();
+
+    if (failed == true || rename( temporary.c_str(), path.c_str() ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write compiled profile %s: %s", path.c_str(), strerror(errno) );
+        unlink( temporary.c_str() );
+        return 1;
+    }
+    return 0;
+}
+
+int8_t CProfileCache::Load( const string& location, const string& delimiter, CProfile& profile )
+{
+    int32_t                 fd;
+    void*                   map;
+    size_t                  length;
+    string                  path;
+    struct stat             info;
+    struct stat             mapped;
+    string                  targetapp;
+    string                  filepath;
+    vector<string>          syncafter;
+    vector<command_t>       commands;
+    vector<extension_t>     extensions;
+    vector<entry_t>         entries;
+
+    IoCount( IO_STAT );
+    if (stat( location.c_str(), &info ) != 0)
+    {
+        return 1;
+    }
+
+    path = location + PROFILECACHE_EXT;
+    IoCount( IO_OPEN );
+    fd = open( path.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    if (fstat( fd, &mapped ) != 0 || mapped.st_size < (off_t)sizeof(cacheheader_t))
+    {
+        close( fd );
+        return 1;
+    }
+    IoCount( IO_STAT, mapped.st_size );
+
+    length = mapped.st_size;
+    map = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (map == MAP_FAILED)
+    {
+        return 1;
+    }
+
+    // The text is the source of truth, any edit to it or to how it is read makes the compiled form stale
+    Mapped = static_cast<const uint8_t*>(map);
+    Header = static_cast<const cacheheader_t*>(map);
+    Valid  = (Header->Magic      == PROFILECACHE_MAGIC   &&
+              Header->Version    == PROFILECACHE_VERSION &&
+              Header->Key        == Key( delimiter )     &&
+              Header->SourceTime == (int64_t)info.st_mtime &&
+              Header->SourceSize == (int64_t)info.st_size);
+
+    for (uint8_t table=0; table<CACHE_TABLE_TOTAL && Valid == true; table++)
+    {
+        const cachelist_t& range = Header->Tables[table];
+
+        Valid = (range.First % sizeof(int32_t) == 0) &&
+                ((uint64_t)range.First + (uint64_t)range.Count * CacheRecordSizes[table] <= length);
+    }
+
+    if (Valid == true)
+    {
+        targetapp = Text( Header->TargetApp );
+        filepath  = Text( Header->FilePath );
+        TextList( Header->SyncAfter, syncafter );
+
+        commands.resize( Header->Tables[CACHE_COMMANDS].Count );
+        for (uint32_t index=0; index<commands.size() && Valid == true; index++)
+        {
+            const cachecommand_t* record = static_cast<const cachecommand_t*>(Record( CACHE_COMMANDS, index ));
+
+            commands.at(index).Name     = Text( record->Name );
+            commands.at(index).Command  = Text( record->Command );
+            commands.at(index).Path     = Text( record->Path );
+            Arguments( record->Arguments, commands.at(index).Arguments );
+        }
+
+        extensions.resize( Header->Tables[CACHE_EXTENSIONS].Count );
+        for (uint32_t index=0; index<extensions.size() && Valid == true; index++)
+        {
+            const cacheextension_t* record = static_cast<const cacheextension_t*>(Record( CACHE_EXTENSIONS, index ));
+            extension_t&            extension = extensions.at(index);
+
+            extension.exeName = Text( record->exeName );
+            extension.exePath = Text( record->exePath );
+            TextList( record->extName, extension.extName );
+            TextList( record->Blacklist, extension.Blacklist );
+            Arguments( record->Arguments, extension.Arguments );
+
+            if (Contains( CACHE_ARGFORCES, record->ArgForces ) == true)
+            {
+                extension.ArgForces.resize( record->ArgForces.Count );
+                for (uint32_t i=0; i<record->ArgForces.Count && Valid == true; i++)
+                {
+                    const cacheargforce_t* force = static_cast<const cacheargforce_t*>(Record( CACHE_ARGFORCES, record->ArgForces.First+i ));
+
+                    extension.ArgForces.at(i).Argument  = force->Argument;
+                    extension.ArgForces.at(i).Path      = Text( force->Path );
+                    extension.ArgForces.at(i).Value     = Text( force->Value );
+                }
+            }
+
+            if (Contains( CACHE_EXEFORCES, record->ExeForces ) == true)
+            {
+                extension.ExeForces.resize( record->ExeForces.Count );
+                for (uint32_t i=0; i<record->ExeForces.Count && Valid == true; i++)
+                {
+                    const cacheexeforce_t* force = static_cast<const cacheexeforce_t*>(Record( CACHE_EXEFORCES, record->ExeForces.First+i ));
+
+                    extension.ExeForces.at(i).exeName   = Text( force->exeName );
+                    extension.ExeForces.at(i).exePath   = Text( force->exePath );
+                    TextList( force->Files, extension.ExeForces.at(i).Files );
+                }
+            }
+        }
+
+        entries.resize( Header->Tables[CACHE_ENTRIES].Count );
+        for (uint32_t index=0; index<entries.size() && Valid == true; index++)
+        {
+            const cacheentry_t* record = static_cast<const cacheentry_t*>(Record( CACHE_ENTRIES, index ));
+
+            entries.at(index).Custom    = (record->Custom != 0);
+            entries.at(index).Name      = Text( record->Name );
+            entries.at(index).Path      = Text( record->Path );
+            entries.at(index).Alias     = Text( record->Alias );
+            Values( record->CmdValues, entries.at(index).CmdValues );
+            Values( record->ArgValues, entries.at(index).ArgValues );
+        }
+    }
+
+    munmap( map, length );
+    Mapped = NULL;
+    Header = NULL;
+
+    if (Valid == false)
+    {
+        Log( __FILENAME__, __LINE__, "Compiled profile %s is out of date and will be rebuilt", path.c_str() );
+        return 1;
+    }
+
+    profile.TargetApp = targetapp;
+    profile.FilePath  = filepath;
+    profile.SyncAfter.swap( syncafter );
+    profile.Commands.swap( commands );
+    profile.Extensions.swap( extensions );
+    profile.Entries.swap( entries );
+
+    // Check for directory exe
+    for (uint16_t index=0; index<profile.Extensions.size(); index++)
+    {
+        if (profile.Extensions.at(index).exeName.length() > 0)
+        {
+            for (uint8_t i=0; i<profile.Extensions.at(index).extName.size(); i++)
+            {
+                if (CheckExtension( profile.Extensions.at(index).extName.at(i), EXT_DIRS) >= 0)
+                {
+                    profile.LaunchableDirs = true;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+uint64_t CProfileCache::Key( const string& delimiter )
+{
+    uint64_t        hash = 14695981039346656037ULL;
+    const char*     home;
+    const char*     pwd;
+    string          key;
+
+    // Paths in the profile are expanded with HOME and PWD when the text is read
+    home = getenv("HOME");
+    pwd  = getenv("PWD");
+    key  = delimiter + "\n" + ((home != NULL) ? home : "") + "\n" + ((pwd != NULL) ? pwd : "");
+
+    for (uint32_t i=0; i<key.length(); i++)
+    {
+        hash ^= (uint8_t)key.at(i);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+cachestring_t CProfileCache::Intern( const string& text )
+{
+    // Entries of one directory follow each other, repeating the last string catches most duplicates for free
+    if (text != Previous)
+    {
+        Previous        = text;
+        Pooled.Offset   = Tables.at(CACHE_POOL).length();
+        Pooled.Length   = text.length();
+        Tables.at(CACHE_POOL).append( text );
+    }
+    return Pooled;
+}
+
+cachelist_t CProfileCache::InternList( const vector<string>& texts )
+{
+    cachelist_t     list;
+    cachestring_t   pooled;
+
+    list.First = Tables.at(CACHE_STRINGS).length() / sizeof(cachestring_t);
+    list.Count = texts.size();
+    for (uint32_t i=0; i<texts.size(); i++)
+    {
+        pooled = Intern( texts.at(i) );
+        Tables.at(CACHE_STRINGS).append( reinterpret_cast<const char*>(&pooled), sizeof(pooled) );
+    }
+    return list;
+}
+
+cachelist_t CProfileCache::AddArguments( const vector<argument_t>& arguments )
+{
+    cachelist_t     list;
+    cacheargument_t record;
+
+    list.First = Tables.at(CACHE_ARGUMENTS).length() / sizeof(cacheargument_t);
+    list.Count = arguments.size();
+    for (uint32_t i=0; i<arguments.size(); i++)
+    {
+        memset( &record, 0, sizeof(record) );
+        record.Default  = arguments.at(i).Default;
+        record.Name     = Intern( arguments.at(i).Name );
+        record.Flag     = Intern( arguments.at(i).Flag );
+        record.Names    = InternList( arguments.at(i).Names );
+        record.Values   = InternList( arguments.at(i).Values );
+        Tables.at(CACHE_ARGUMENTS).append( reinterpret_cast<const char*>(&record), sizeof(record) );
+    }
+    return list;
+}
+
+cachelist_t CProfileCache::AddValues( const vector<int32_t>& values )
+{
+    cachelist_t     list;
+
+    list.First = Tables.at(CACHE_VALUES).length() / sizeof(int32_t);
+    list.Count = values.size();
+    for (uint32_t i=0; i<values.size(); i++)
+    {
+        Tables.at(CACHE_VALUES).append( reinterpret_cast<const char*>(&values.at(i)), sizeof(int32_t) );
+    }
+    return list;
+}
+
+const void* CProfileCache::Record( uint8_t table, uint32_t index )
+{
+    if (Valid == false || index >= Header->Tables[table].Count)
+    {
+        Valid = false;
+        return NULL;
+    }
+    return Mapped + Header->Tables[table].First + index * CacheRecordSizes[table];
+}
+
+bool CProfileCache::Contains( uint8_t table, const cachelist_t& list )
+{
+    if (Valid == false || (uint64_t)list.First + list.Count > Header->Tables[table].Count)
+    {
+        Valid = false;
+    }
+    return Valid;
+}
+
+string CProfileCache::Text( const cachestring_t& text )
+{
+    if (Valid == false || (uint64_t)text.Offset + text.Length > Header->Tables[CACHE_POOL].Count)
+    {
+        Valid = false;
+        return "";
+    }
+    return string( reinterpret_cast<const char*>(Mapped + Header->Tables[CACHE_POOL].First + text.Offset), text.Length );
+}
+
+void CProfileCache::TextList( const cachelist_t& list, vector<string>& texts )
+{
+    const cachestring_t* pooled;
+
+    texts.clear();
+    if (Contains( CACHE_STRINGS, list ) == true && list.Count > 0)
+    {
+        pooled = static_cast<const cachestring_t*>(Record( CACHE_STRINGS, list.First ));
+        texts.resize( list.Count );
+        for (uint32_t i=0; i<list.Count; i++)
+        {
+            texts.at(i) = Text( pooled[i] );
+        }
+    }
+}
+
+void CProfileCache::Arguments( const cachelist_t& list, vector<argument_t>& arguments )
+{
+    const cacheargument_t* record;
+
+    arguments.clear();
+    if (Contains( CACHE_ARGUMENTS, list ) == true)
+    {
+        arguments.resize( list.Count );
+        for (uint32_t i=0; i<list.Count; i++)
+        {
+            record = static_cast<const cacheargument_t*>(Record( CACHE_ARGUMENTS, list.First+i ));
+            if (record == NULL)
+            {
+                return;
+            }
+            arguments.at(i).Default = record->Default;
+            arguments.at(i).Name    = Text( record->Name );
+            arguments.at(i).Flag    = Text( record->Flag );
+            TextList( record->Names, arguments.at(i).Names );
+            TextList( record->Values, arguments.at(i).Values );
+        }
+    }
+}
+
+void CProfileCache::Values( const cachelist_t& list, vector<int16_t>& values )
+{
+    const int32_t* mapped;
+
+    values.clear();
+    if (Contains( CACHE_VALUES, list ) == true && list.Count > 0)
+    {
+        mapped = static_cast<const int32_t*>(Record( CACHE_VALUES, list.First ));
+        values.assign( mapped, mapped + list.Count );
+    }
+}
@@ -0,0 +1,244 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CPROFILECACHE_H
+#define CPROFILECACHE_H
+
+#include "cbase.h"
+#include "cprofile.h"
+
+using namespace std;
+
+#define PROFILECACHE_EXT        ".bin"          /** Appended to the profile path to name its compiled form. */
+#define PROFILECACHE_MAGIC      0x43504C50      /** "PLPC" identifies a compiled profile. */
+#define PROFILECACHE_VERSION    1               /** Incremented when the layout of the compiled profile changes. */
+
+/** @brief Tables of the compiled profile, each is an array of fixed size records
+ */
+enum PROFILECACHE_TABLES_T {
+    CACHE_COMMANDS=0,       /** @brief cachecommand_t records */
+    CACHE_EXTENSIONS,       /** @brief cacheextension_t records */
+    CACHE_ARGUMENTS,        /** @brief cacheargument_t records of every command and extension */
+    CACHE_ARGFORCES,        /** @brief cacheargforce_t records of every extension */
+    CACHE_EXEFORCES,        /** @brief cacheexeforce_t records of every extension */
+    CACHE_ENTRIES,          /** @brief cacheentry_t records */
+    CACHE_STRINGS,          /** @brief cachestring_t records of every list of strings */
+    CACHE_VALUES,           /** @brief int32_t values of every entry */
+    CACHE_POOL,             /** @brief Characters of every string, without terminators */
+    CACHE_TABLE_TOTAL
+};
+
+/** @brief A string in the pool
+ */
+struct cachestring_t {
+    uint32_t        Offset;         /** @brief Position of the first character in the pool */
+    uint32_t        Length;         /** @brief Number of characters */
+};
+
+/** @brief A run of consecutive records in one of the tables
+ */
+struct cachelist_t {
+    uint32_t        First;          /** @brief Index of the first record */
+    uint32_t        Count;          /** @brief Number of records */
+};
+
+/** @brief Header at the start of the compiled profile, the tables follow it
+ */
+struct cacheheader_t {
+    uint32_t        Magic;          /** @brief Always PROFILECACHE_MAGIC */
+    uint16_t        Version;        /** @brief Always PROFILECACHE_VERSION */
+    uint16_t        Reserved;       /** @brief Unused, keeps the fields aligned */
+    uint64_t        Key;            /** @brief Hash of the delimiter and environment the source was parsed with */
+    int64_t         SourceTime;     /** @brief Modification time of the profile it was compiled from */
+    int64_t         SourceSize;     /** @brief Size in bytes of the profile it was compiled from */
+    cachestring_t   TargetApp;      /** @brief Label of the target application */
+    cachestring_t   FilePath;       /** @brief Path searched for launchable files */
+    cachelist_t     SyncAfter;      /** @brief Paths flushed after the application exits, in CACHE_STRINGS */
+    cachelist_t     Tables[CACHE_TABLE_TOTAL];  /** @brief Byte offset from the start of the file and record count of each table */
+};
+
+/** @brief Compiled command_t
+ */
+struct cachecommand_t {
+    cachestring_t   Name;           /** @brief Display name */
+    cachestring_t   Command;        /** @brief Executable name */
+    cachestring_t   Path;           /** @brief Path to the executable */
+    cachelist_t     Arguments;      /** @brief Arguments, in CACHE_ARGUMENTS */
+};
+
+/** @brief Compiled extension_t
+ */
+struct cacheextension_t {
+    cachestring_t   exeName;        /** @brief Executable name */
+    cachestring_t   exePath;        /** @brief Path to the executable */
+    cachelist_t     extName;        /** @brief Extensions, in CACHE_STRINGS */
+    cachelist_t     Blacklist;      /** @brief Filtered file names, in CACHE_STRINGS */
+    cachelist_t     Arguments;      /** @brief Arguments, in CACHE_ARGUMENTS */
+    cachelist_t     ArgForces;      /** @brief Argument overrides, in CACHE_ARGFORCES */
+    cachelist_t     ExeForces;      /** @brief Executable overrides, in CACHE_EXEFORCES */
+};
+
+/** @brief Compiled argument_t
+ */
+struct cacheargument_t {
+    int32_t         Default;        /** @brief Index to the default value */
+    cachestring_t   Name;           /** @brief Display name */
+    cachestring_t   Flag;           /** @brief Flag passed before the value */
+    cachelist_t     Names;          /** @brief Names of the values, in CACHE_STRINGS */
+    cachelist_t     Values;         /** @brief Values, in CACHE_STRINGS */
+};
+
+/** @brief Compiled argforce_t
+ */
+struct cacheargforce_t {
+    int32_t         Argument;       /** @brief Index of the argument to override */
+    cachestring_t   Path;           /** @brief Location of the target files */
+    cachestring_t   Value;          /** @brief Value to override the argument with */
+};
+
+/** @brief Compiled exeforce_t
+ */
+struct cacheexeforce_t {
+    cachestring_t   exeName;        /** @brief Executable name */
+    cachestring_t   exePath;        /** @brief Path to the executable */
+    cachelist_t     Files;          /** @brief Files it applies to, in CACHE_STRINGS */
+};
+
+/** @brief Compiled entry_t
+ */
+struct cacheentry_t {
+    int32_t         Custom;         /** @brief 1 if the entry has values different than the defaults */
+    cachestring_t   Name;           /** @brief Name of the entry */
+    cachestring_t   Path;           /** @brief Path to the file */
+    cachestring_t   Alias;          /** @brief Name displayed instead of the file name */
+    cachelist_t     CmdValues;      /** @brief Command values, in CACHE_VALUES */
+    cachelist_t     ArgValues;      /** @brief Argument values, in CACHE_VALUES */
+};
+
+/** @brief This class writes the profile in a compiled form next to the text, so the next start maps it
+ *         instead of parsing the text again
+ */
+class CProfileCache : public CBase
+{
+    public:
+        /** Constructor. */
+        CProfileCache();
+        /** Destructor. */
+        virtual ~CProfileCache();
+
+        /** @brief Write the compiled form of the profile, stamped with the text file it matches.
+         * @param location : path to the profile file, the compiled form is written beside it.
+         * @param delimiter : the delimiter used between options.
+         * @param profile : the profile data as it would be read back from the text.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t          Save        ( const string& location, const string& delimiter, const CProfile& profile );
+
+        /** @brief Read the compiled form of the profile, it is rejected if the text changed since.
+         * @param location : path to the profile file, the compiled form is read from beside it.
+         * @param delimiter : the delimiter used between options.
+         * @param profile : receives the profile data, left untouched if the compiled form is rejected.
+         * @return 0 if the compiled form was used 1 if not.
+         */
+        int8_t          Load        ( const string& location, const string& delimiter, CProfile& profile );
+
+    private:
+        /** @brief Hash the settings that change how the text is read.
+         * @param delimiter : the delimiter used between options.
+         * @return the hash
+         */
+        uint64_t        Key         ( const string& delimiter );
+
+        /** @brief Add a string to the pool, a repeat of the previous string is stored once.
+         * @param text : the string
+         * @return the pooled string
+         */
+        cachestring_t   Intern      ( const string& text );
+
+        /** @brief Add a list of strings to CACHE_STRINGS.
+         * @param texts : the strings
+         * @return the run of records
+         */
+        cachelist_t     InternList  ( const vector<string>& texts );
+
+        /** @brief Add arguments to CACHE_ARGUMENTS.
+         * @param arguments : the arguments
+         * @return the run of records
+         */
+        cachelist_t     AddArguments( const vector<argument_t>& arguments );
+
+        /** @brief Add entry values to CACHE_VALUES.
+         * @param values : the values
+         * @return the run of records
+         */
+        cachelist_t     AddValues   ( const vector<int32_t>& values );
+
+        /** @brief Get a record of a table in the mapped file, marks the file invalid if it is out of range.
+         * @param table : the table (index is defined in PROFILECACHE_TABLES_T)
+         * @param index : index of the record
+         * @return the record, NULL if out of range
+         */
+        const void*     Record      ( uint8_t table, uint32_t index );
+
+        /** @brief Check a run of records is inside a table, marks the file invalid if not.
+         * @param table : the table (index is defined in PROFILECACHE_TABLES_T)
+         * @param list : the run of records
+         * @return true if the run is inside the table
+         */
+        bool            Contains    ( uint8_t table, const cachelist_t& list );
+
+        /** @brief Get a string from the mapped pool.
+         * @param text : the pooled string
+         * @return the string, empty if out of range
+         */
+        string          Text        ( const cachestring_t& text );
+
+        /** @brief Get a list of strings from the mapped CACHE_STRINGS.
+         * @param list : the run of records
+         * @param texts : receives the strings
+         */
+        void            TextList    ( const cachelist_t& list, vector<string>& texts );
+
+        /** @brief Get arguments from the mapped CACHE_ARGUMENTS.
+         * @param list : the run of records
+         * @param arguments : receives the arguments
+         */
+        void            Arguments   ( const cachelist_t& list, vector<argument_t>& arguments );
+
+        /** @brief Get entry values from the mapped CACHE_VALUES.
+         * @param list : the run of records
+         * @param values : receives the values
+         */
+        void            Values      ( const cachelist_t& list, vector<int16_t>& values );
+
+        CProfileCache(const CProfileCache &);
+        CProfileCache & operator=(const CProfileCache&);
+
+        vector<string>          Tables;             /**< Records of each table being written. */
+        string                  Previous;           /**< Last string added to the pool being written. */
+        cachestring_t           Pooled;             /**< Where the last string was added to the pool. */
+        const uint8_t*          Mapped;             /**< Start of the mapped file being loaded. */
+        const cacheheader_t*    Header;             /**< Header of the mapped file being loaded. */
+        bool                    Valid;              /**< False once anything in the mapped file was out of range. */
+};
+
+#endif // CPROFILECACHE_H
@@ -0,0 +1,277 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "creadahead.h"
+
+#include <string.h>
+
+static int ReadaheadThread( void* data )
+{
+    TRACE_THREAD( "readahead" );
+    return static_cast<CReadahead*>(data)->Worker();
+}
+
+CReadahead::CReadahead() : CBase(),
+        Quit        (false),
+        Thread      (NULL),
+        Lock        (NULL),
+        Wake        (NULL),
+        Queue       (),
+        Done        (),
+        Files       (0),
+        Bytes       (0)
+{
+}
+
+CReadahead::~CReadahead()
+{
+    Close();
+}
+
+int8_t CReadahead::Open( void )
+{
+    Close();
+
+    Quit    = false;
+    Files   = 0;
+    Bytes   = 0;
+
+    Lock = SDL_CreateMutex();
+    Wake = SDL_CreateCond();
+    if (Lock == NULL || Wake == NULL)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to create readahead mutex: %s", SDL_GetError() );
+        return 1;
+    }
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    Thread = SDL_CreateThread( ReadaheadThread, "readahead", this );
+#else /* SDL 1.2 */
+    Thread = SDL_CreateThread( ReadaheadThread, this );
+#endif
+    if (Thread == NULL)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to create readahead thread, files will be warmed synchronously: %s", SDL_GetError() );
+    }
+    return 0;
+}
+
+void CReadahead::Close( void )
+{
+    if (Thread != NULL)
+    {
+        SDL_LockMutex( Lock );
+        Quit = true;
+        SDL_CondSignal( Wake );
+        SDL_UnlockMutex( Lock );
+
+        SDL_WaitThread( Thread, NULL );
+        Thread = NULL;
+    }
+
+    if (Wake != NULL)
+    {
+        SDL_DestroyCond( Wake );
+        Wake = NULL;
+    }
+    if (Lock != NULL)
+    {
+        SDL_DestroyMutex( Lock );
+        Lock = NULL;
+
+        Log( __FILENAME__, __LINE__, "Readahead warmed %d files, %d KB", Files, (int32_t)(Bytes/1024) );
+    }
+
+    Queue.clear();
+    Done.clear();
+}
+
+void CReadahead::Request( const string& path )
+{
+    if (Lock == NULL || path.length() == 0)
+    {
+        return;
+    }
+
+    SDL_LockMutex( Lock );
+    if (Done.insert( path ).second == false)
+    {
+        SDL_UnlockMutex( Lock );
+        return;
+    }
+
+    if (Thread != NULL)
+    {
+        Queue.push_back( path );
+        SDL_CondSignal( Wake );
+        SDL_UnlockMutex( Lock );
+    }
+    else
+    {
+        SDL_UnlockMutex( Lock );
+        Warm( path );
+    }
+}
+
+uint64_t CReadahead::Warmed( void )
+{
+    uint64_t bytes;
+
+    if (Lock == NULL)
+    {
+        return Bytes;
+    }
+
+    SDL_LockMutex( Lock );
+    bytes = Bytes;
+    SDL_UnlockMutex( Lock );
+
+    return bytes;
+}
+
+int32_t CReadahead::Worker( void )
+{
+    string path;
+
+    SDL_LockMutex( Lock );
+    // Everything queued is still warmed on quit, the target is about to need it
+    while (Quit == false || Queue.size() > 0)
+    {
+        if (Queue.size() == 0)
+        {
+            SDL_CondWait( Wake, Lock );
+            continue;
+        }
+
+        path = Queue.front();
+        Queue.erase( Queue.begin() );
+        SDL_UnlockMutex( Lock );
+
+        Warm( path );
+
+        SDL_LockMutex( Lock );
+    }
+    SDL_UnlockMutex( Lock );
+
+    return 0;
+}
+
+void CReadahead::Warm( const string& path )
+{
+    DIR*            dir;
+    struct dirent*  dirp;
+    struct stat     info;
+    string          name;
+    string          prefix;
+    vector<string>  libraries;
+    uint32_t        files;
+    uint64_t        bytes;
+
+    if (stat( path.c_str(), &info ) != 0)
+    {
+        return;
+    }
+
+    files = 0;
+    bytes = 0;
+    if (S_ISDIR(info.st_mode))
+    {
+        // Libraries next to the binary, found through LD_LIBRARY_PATH=./
+        dir = opendir( path.c_str() );
+        if (dir == NULL)
+        {
+            return;
+        }
+        prefix = path;
+        if (prefix.at(prefix.length()-1) != '/')
+        {
+            prefix += '/';
+        }
+        while ((dirp = readdir(dir)) != NULL)
+        {
+            name = dirp->d_name;
+            if (name.find( READAHEAD_LIBRARY ) != string::npos)
+            {
+                libraries.push_back( prefix + name );
+            }
+        }
+        closedir( dir );
+
+        for (uint16_t i=0; i<libraries.size(); i++)
+        {
+            if (stat( libraries.at(i).c_str(), &info ) == 0 && S_ISREG(info.st_mode))
+            {
+                bytes += Advise( libraries.at(i) );
+                files++;
+            }
+        }
+    }
+    else if (S_ISREG(info.st_mode))
+    {
+        bytes = Advise( path );
+        files = 1;
+    }
+
+#if defined(DEBUG)
+    Log( __FILENAME__, __LINE__, "Readahead %s: %d files, %d KB", path.c_str(), files, (int32_t)(bytes/1024) );
+#endif
+
+    if (Lock != NULL)
+    {
+        SDL_LockMutex( Lock );
+        Files += files;
+        Bytes += bytes;
+        SDL_UnlockMutex( Lock );
+    }
+}
+
+uint64_t CReadahead::Advise( const string& path )
+{
+    int32_t     fd;
+    uint64_t    bytes;
+    struct stat info;
+
+    fd = open( path.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return 0;
+    }
+
+    bytes = 0;
+#if defined(POSIX_FADV_WILLNEED)
+    // The kernel starts the reads and returns, the pages arrive while the launcher shuts down
+    if (fstat( fd, &info ) == 0)
+    {
+        if (posix_fadvise( fd, 0, 0, POSIX_FADV_WILLNEED ) == 0)
+        {
+            bytes = info.st_size;
+        }
+        else
+        {
+            Log( __FILENAME__, __LINE__, "Warning readahead failed for %s", path.c_str() );
+        }
+    }
+#endif
+    close( fd );
+
+    return bytes;
+}
@@ -0,0 +1,94 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CREADAHEAD_H
+#define CREADAHEAD_H
+
+#include <set>
+
+#include "cbase.h"
+
+using namespace std;
+
+#define READAHEAD_LIBRARY       ".so"       /** Files in a library directory containing this are shared libraries. */
+
+/** @brief This class asks the kernel to read files into the page cache on a worker thread, so the target
+ *         application finds its image, binary and libraries already in memory
+ */
+class CReadahead : public CBase
+{
+    public:
+        /** Constructor. */
+        CReadahead();
+        /** Destructor. */
+        virtual ~CReadahead();
+
+        /** @brief Start the worker thread, falls back to warming on the calling thread if it cannot be created.
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( void );
+
+        /** @brief Finish the queued files, stop the worker thread and log how much was warmed.
+         */
+        void            Close       ( void );
+
+        /** @brief Queue a file to be read ahead, a file already warmed since Open is skipped.
+         * @param path : the file, or a directory to read ahead every shared library in it
+         */
+        void            Request     ( const string& path );
+
+        /** @brief Get the number of bytes read ahead since Open.
+         * @return the number of bytes
+         */
+        uint64_t        Warmed      ( void );
+
+        /** @brief Loop of the worker thread, only to be called by the thread entry.
+         * @return 0 if passed 1 if failed
+         */
+        int32_t         Worker      ( void );
+
+    private:
+        /** @brief Read ahead a file, or every shared library in a directory.
+         * @param path : the file or directory
+         */
+        void            Warm        ( const string& path );
+
+        /** @brief Ask the kernel to read a whole file into the page cache.
+         * @param path : the file
+         * @return number of bytes requested
+         */
+        uint64_t        Advise      ( const string& path );
+
+        CReadahead(const CReadahead &);
+        CReadahead & operator=(const CReadahead&);
+
+        bool                    Quit;           /**< Set to stop the worker thread once the queue is empty. */
+        SDL_Thread*             Thread;         /**< Worker thread, NULL when warming synchronously. */
+        SDL_mutex*              Lock;           /**< Guards the queue and the counters. */
+        SDL_cond*               Wake;           /**< Signaled when the queue changes or on quit. */
+        vector<string>          Queue;          /**< Paths waiting to be read ahead, in request order. */
+        set<string>             Done;           /**< Paths already requested since Open. */
+        uint32_t                Files;          /**< Number of files read ahead since Open. */
+        uint64_t                Bytes;          /**< Number of bytes read ahead since Open. */
+};
+
+#endif // CREADAHEAD_H
@@ -0,0 +1,409 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "creplay.h"
+
+/* Names used by scripts for the events, index is defined in EVENT_T */
+static const char* ReplayEvents[EVENT_TOTAL] = { "one_up", "one_down", "page_up", "page_down", "dir_up", "dir_down", "zip_mode",
+                                                 "cfg_app", "cfg_item", "set_one", "set_all", "select", "back", "quit", "hud" };
+
+/* Names used in the report, index is defined in REPLAY_SAMPLES_T */
+static const char* ReplaySamples[REPLAY_TOTAL] = { "draw", "present", "frame", "latency" };
+
+CReplay::CReplay() : CBase(),
+        Running     (false),
+        Keys        (),
+        Script      (),
+        Line        (0),
+        Wait        (0),
+        HoldKey     (false),
+        HeldKey     (),
+        HoldAxis    (false),
+        HeldAxis    (0),
+        Typing      (""),
+        Frames      (0),
+        Checking    (0),
+        AllocFrames (0),
+        FrameStart  (0),
+        DrawEnd     (0),
+        Pending     ()
+{
+}
+
+CReplay::~CReplay()
+{
+}
+
+int8_t CReplay::Open( const string& location, const vector<KeyCode>& keys )
+{
+    ifstream        fin;
+    string          line;
+    vector<string>  parts;
+    replaycommand_t command;
+    uint32_t        number;
+    uint16_t        event;
+
+    Script.clear();
+
+    fin.open( location.c_str(), ios_base::in );
+    if (!fin)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open replay script %s", location.c_str() );
+        return 1;
+    }
+
+    number = 0;
+    while (getline( fin, line ))
+    {
+        number++;
+        if (line.find( '#' ) != string::npos)
+        {
+            line.erase( line.find( '#' ) );
+        }
+        SplitString( " ", line, parts );
+        parts.erase( remove( parts.begin(), parts.end(), string("") ), parts.end() );
+        if (parts.size() == 0)
+        {
+            continue;
+        }
+
+        command = replaycommand_t();
+        if (parts.at(0).compare( "wait" ) == 0 && parts.size() == 2)
+        {
+            command.Type    = REPLAY_WAIT;
+            command.Frames  = a_to_i( parts.at(1) );
+        }
+        else if (parts.at(0).compare( "press" ) == 0 && (parts.size() == 2 || parts.size() == 3))
+        {
+            for (event=0; event<EVENT_TOTAL; event++)
+            {
+                if (parts.at(1).compare( ReplayEvents[event] ) == 0)
+                {
+                    break;
+                }
+            }
+            if (event >= EVENT_TOTAL || event >= keys.size())
+            {
+                Log( __FILENAME__, __LINE__, "Error replay script line %d: unknown event %s", number, parts.at(1).c_str() );
+                return 1;
+            }
+            command.Type    = REPLAY_PRESS;
+            command.Key     = keys.at(event);
+            command.Frames  = (parts.size() == 3) ? a_to_i( parts.at(2) ) : 1;
+        }
+        else if (parts.at(0).compare( "type" ) == 0 && parts.size() == 2)
+        {
+            command.Type    = REPLAY_TYPE;
+            command.Text    = lowercase( parts.at(1) );
+        }
+        else if (parts.at(0).compare( "erase" ) == 0 && parts.size() <= 2)
+        {
+            command.Type    = REPLAY_TYPE;
+            command.Text    = string( (parts.size() == 2) ? a_to_i( parts.at(1) ) : 1, '\b' );
+        }
+        else if (parts.at(0).compare( "noalloc" ) == 0 && parts.size() == 2)
+        {
+#if defined(ALLOCS)
+            command.Type    = REPLAY_NOALLOC;
+            command.Frames  = a_to_i( parts.at(1) );
+#else
+            Log( __FILENAME__, __LINE__, "Error replay script line %d: noalloc needs a build with ALLOCS=1", number );
+            return 1;
+#endif
+        }
+        else if (parts.at(0).compare( "axis" ) == 0 && (parts.size() == 3 || parts.size() == 4))
+        {
+            command.Type    = REPLAY_AXIS;
+            command.Axis    = a_to_i( parts.at(1) );
+            command.Value   = a_to_i( parts.at(2) );
+            command.Frames  = (parts.size() == 4) ? a_to_i( parts.at(3) ) : 1;
+        }
+        else
+        {
+            Log( __FILENAME__, __LINE__, "Error replay script line %d: unknown command '%s'", number, line.c_str() );
+            return 1;
+        }
+        command.Frames = MAX( command.Frames, 1 );
+        Script.push_back( command );
+    }
+    fin.close();
+
+    Keys        = keys;
+    Line        = 0;
+    Wait        = 0;
+    HoldKey     = false;
+    HoldAxis    = false;
+    Typing.clear();
+    Frames      = 0;
+    Checking    = 0;
+    AllocFrames = 0;
+    Pending.clear();
+    for (uint8_t index=0; index<REPLAY_TOTAL; index++)
+    {
+        Samples[index].clear();
+    }
+    Running     = true;
+
+    Log( __FILENAME__, __LINE__, "Replaying %d commands from %s", (int32_t)Script.size(), location.c_str() );
+    return 0;
+}
+
+void CReplay::Close( const string& location, const memstats_t& memory )
+{
+    ofstream            fout;
+    vector<uint32_t>    sorted;
+
+    if (Running == false)
+    {
+        return;
+    }
+    Running = false;
+
+    // The percentiles are logged even if the report cannot be written
+    fout.open( location.c_str(), ios_base::trunc );
+    if (!fout)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open replay report %s", location.c_str() );
+    }
+
+    if (AllocFrames > 0)
+    {
+        Log( __FILENAME__, __LINE__, "Replay failed: %d checked frames allocated", AllocFrames );
+    }
+
+    fout << "{" << endl << "  \"frames\": " << Frames << "," << endl
+         << "  \"alloc_frames\": " << AllocFrames << "," << endl << "  \"timings\": [" << endl;
+    for (uint8_t index=0; index<REPLAY_TOTAL; index++)
+    {
+        sorted = Samples[index];
+        sort( sorted.begin(), sorted.end() );
+        if (sorted.size() == 0)
+        {
+            sorted.push_back( 0 );
+        }
+
+        Log( __FILENAME__, __LINE__, "Replay %-8s %6d samples p50 %8d us p90 %8d us p99 %8d us max %8d us", ReplaySamples[index],
+             (int32_t)Samples[index].size(), sorted.at((sorted.size()-1)*50/100), sorted.at((sorted.size()-1)*90/100),
+             sorted.at((sorted.size()-1)*99/100), sorted.back() );
+
+        fout << "    { \"name\": \"" << ReplaySamples[index] << "\""
+             << ", \"count\": " << Samples[index].size()
+             << ", \"p50_us\": " << sorted.at((sorted.size()-1)*50/100)
+             << ", \"p90_us\": " << sorted.at((sorted.size()-1)*90/100)
+             << ", \"p99_us\": " << sorted.at((sorted.size()-1)*99/100)
+             << ", \"max_us\": " << sorted.back()
+             << " }" << (index < REPLAY_TOTAL-1 ? "," : "") << endl;
+    }
+    fout << "  ]," << endl << "  \"io\": [" << endl;
+    for (uint8_t action=0; action<IO_ACTIONS; action++)
+    {
+        fout << "    { \"action\": \"" << IoActionName( action ) << "\"";
+        for (uint8_t call=0; call<IO_CALLS; call++)
+        {
+            fout << ", \"" << IoCallName( call ) << "\": " << IoCalls( action, call );
+        }
+        fout << ", \"bytes\": " << IoBytes( action ) << " }" << (action < IO_ACTIONS-1 ? "," : "") << endl;
+    }
+    fout << "  ]," << endl << "  \"memory\": { \"held\": " << memory.Held << ", \"limit\": " << memory.Limit
+         << ", \"resident_kb\": " << memory.Resident << ", \"evictions\": " << memory.Evictions
+         << ", \"evicted\": " << memory.Evicted << " }" << endl << "}" << endl;
+    fout.close();
+}
+
+bool CReplay::Active( void )
+{
+    return Running;
+}
+
+uint32_t CReplay::Allocated( void )
+{
+    return AllocFrames;
+}
+
+bool CReplay::Step( void )
+{
+    const replaycommand_t* command;
+
+    ALLOCS_SCOPE( ALLOC_TOOLS );
+
+    if (Running == false)
+    {
+        return false;
+    }
+
+    FrameStart = Now();
+    DrawEnd    = 0;
+    Frames++;
+
+#if defined(ALLOCS)
+    // The frame that just ended is checked before the script moves on
+    if (Checking > 0)
+    {
+        if (AllocLastFrame() > 0)
+        {
+            AllocFrames++;
+            Log( __FILENAME__, __LINE__, "Error replay frame %d allocated %d times", Frames-1, AllocLastFrame() );
+        }
+        Checking--;
+    }
+#endif
+
+    // Letters are typed one per frame, the filter rescans the list after each
+    if (Typing.length() > 0)
+    {
+        KeyCode key = (Typing.at(0) == '\b') ? SDLK_BACKSPACE : static_cast<KeyCode>(Typing.at(0));
+
+        PushKey( key, true );
+        PushKey( key, false );
+        Typing.erase( 0, 1 );
+        return false;
+    }
+
+    if (Wait > 0)
+    {
+        Wait--;
+        return false;
+    }
+
+    // A release takes a frame of its own like a real key
+    if (HoldKey == true)
+    {
+        HoldKey = false;
+        PushKey( HeldKey, false );
+        return false;
+    }
+    if (HoldAxis == true)
+    {
+        HoldAxis = false;
+        PushAxis( HeldAxis, 0 );
+        return false;
+    }
+
+    if (Line >= Script.size())
+    {
+        return true;
+    }
+
+    command = &Script.at(Line++);
+    Wait    = command->Frames-1;
+    switch (command->Type)
+    {
+        case REPLAY_PRESS:
+            PushKey( command->Key, true );
+            HoldKey = true;
+            HeldKey = command->Key;
+            break;
+        case REPLAY_TYPE:
+            Typing = command->Text;
+            break;
+        case REPLAY_AXIS:
+            PushAxis( command->Axis, command->Value );
+            HoldAxis = true;
+            HeldAxis = command->Axis;
+            break;
+        case REPLAY_NOALLOC:
+            Checking = command->Frames;
+            break;
+        default:
+            break;
+    }
+    return false;
+}
+
+void CReplay::Drawn( void )
+{
+    ALLOCS_SCOPE( ALLOC_TOOLS );
+
+    if (Running == true)
+    {
+        DrawEnd = Now();
+        Samples[REPLAY_DRAW].push_back( DrawEnd-FrameStart );
+    }
+}
+
+void CReplay::Presented( void )
+{
+    uint64_t now;
+
+    ALLOCS_SCOPE( ALLOC_TOOLS );
+
+    if (Running == false)
+    {
+        return;
+    }
+
+    now = Now();
+    if (DrawEnd > 0)
+    {
+        Samples[REPLAY_PRESENT].push_back( now-DrawEnd );
+    }
+    Samples[REPLAY_FRAME].push_back( now-FrameStart );
+
+    for (uint16_t index=0; index<Pending.size(); index++)
+    {
+        Samples[REPLAY_LATENCY].push_back( now-Pending.at(index) );
+    }
+    Pending.clear();
+}
+
+void CReplay::PushKey( KeyCode key, bool down )
+{
+    SDL_Event event;
+
+    memset( &event, 0, sizeof(event) );
+    event.type              = down ? SDL_KEYDOWN : SDL_KEYUP;
+    event.key.keysym.sym    = key;
+    if (SDL_PushEvent( &event ) < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to push replay event: %s", SDL_GetError() );
+    }
+    else if (down == true)
+    {
+        Pending.push_back( Now() );
+    }
+}
+
+void CReplay::PushAxis( uint8_t axis, int16_t value )
+{
+    SDL_Event event;
+
+    memset( &event, 0, sizeof(event) );
+    event.type          = SDL_JOYAXISMOTION;
+    event.jaxis.axis    = axis;
+    event.jaxis.value   = value;
+    if (SDL_PushEvent( &event ) < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Failed to push replay event: %s", SDL_GetError() );
+    }
+    else if (value != 0)
+    {
+        Pending.push_back( Now() );
+    }
+}
+
+uint64_t CReplay::Now( void )
+{
+    struct timeval now;
+
+    gettimeofday( &now, NULL );
+    return (uint64_t)now.tv_sec*1000000 + now.tv_usec;
+}
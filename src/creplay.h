@@ -0,0 +1,162 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CREPLAY_H
+#define CREPLAY_H
+
+#include <sys/time.h>
+
+#include "cbase.h"
+#include "cconfig.h"
+#include "cmembudget.h"
+
+using namespace std;
+
+#define REPLAY_VIDEODRIVER  "dummy"             /** Video driver used for a replay unless SDL_VIDEODRIVER is already set. */
+#define REPLAY_REPORT       "replay.json"       /** Default location for the replay report. */
+
+/** @brief Samples of one timing of the replay
+ */
+enum REPLAY_SAMPLES_T {
+    REPLAY_DRAW=0,                  /** @brief Time spent in DisplaySelector */
+    REPLAY_PRESENT,                 /** @brief Time from the end of DisplaySelector until the frame was presented */
+    REPLAY_FRAME,                   /** @brief Time from the start of the frame until it was presented */
+    REPLAY_LATENCY,                 /** @brief Time from an injected event until the next presented frame */
+    REPLAY_TOTAL
+};
+
+/** @brief Kinds of commands in a replay script
+ */
+enum REPLAY_COMMANDS_T {
+    REPLAY_WAIT=0,                  /** @brief Let frames pass */
+    REPLAY_PRESS,                   /** @brief Press and hold a key */
+    REPLAY_TYPE,                    /** @brief Press keys one per frame */
+    REPLAY_AXIS,                    /** @brief Move and hold a joystick axis */
+    REPLAY_NOALLOC                  /** @brief Let frames pass, each must not allocate */
+};
+
+/** @brief Data structure for one command of a replay script
+ */
+struct replaycommand_t {
+    replaycommand_t() : Type(REPLAY_WAIT), Key(), Axis(0), Value(0), Frames(1), Text("") {};
+    uint8_t     Type;               /** @brief Kind of command (index is defined in REPLAY_COMMANDS_T) */
+    KeyCode     Key;                /** @brief Key to press */
+    uint8_t     Axis;               /** @brief Axis to move */
+    int16_t     Value;              /** @brief Position of the axis */
+    uint32_t    Frames;             /** @brief Frames the command lasts */
+    string      Text;               /** @brief Characters to type, a backspace erases */
+};
+
+/** @brief This class feeds a script of input events to the selector without a screen and measures how long
+ *         the frames and the response to the events take
+ *
+ *  The script holds one command per line, # starts a comment:
+ *      wait <frames>                   let frames pass without input
+ *      press <event> [frames]          press the key mapped to an event (one_up, dir_down, select, ...) and hold it
+ *      type <text>                     press the keys of letters and digits, one per frame, to filter the list
+ *      erase [count]                   press backspace
+ *      axis <axis> <value> [frames]    move a joystick axis and return it to the center
+ *      noalloc <frames>                let frames pass, the replay fails if any of them allocates (needs ALLOCS)
+ */
+class CReplay : public CBase
+{
+    public:
+        /** Constructor. */
+        CReplay();
+        /** Destructor. */
+        virtual ~CReplay();
+
+        /** @brief Read a script, the replay is active from then on.
+         * @param location : the script file
+         * @param keys : key mapped to each event (index is defined in EVENT_T)
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( const string& location, const vector<KeyCode>& keys );
+
+        /** @brief Write the report of the timings and stop the replay.
+         * @param location : the report file, written as json
+         * @param memory : counters of the memory budget at the end of the replay
+         */
+        void            Close       ( const string& location, const memstats_t& memory );
+
+        /** @brief Get the frames that allocated during a noalloc command.
+         * @return number of frames, the replay failed if not 0
+         */
+        uint32_t        Allocated   ( void );
+
+        /** @brief Check if a script is being replayed.
+         * @return true if active
+         */
+        bool            Active      ( void );
+
+        /** @brief Push the events of the script for the coming frame, to be called before the inputs are polled.
+         * @return true once the script has finished
+         */
+        bool            Step        ( void );
+
+        /** @brief Note that the drawing of the frame is done. */
+        void            Drawn       ( void );
+
+        /** @brief Note that the frame was presented. */
+        void            Presented   ( void );
+
+    private:
+        /** @brief Push a key event.
+         * @param key : the key
+         * @param down : true for a press, false for a release
+         */
+        void            PushKey     ( KeyCode key, bool down );
+
+        /** @brief Push a joystick axis event.
+         * @param axis : the axis
+         * @param value : position of the axis
+         */
+        void            PushAxis    ( uint8_t axis, int16_t value );
+
+        /** @brief Get the current time.
+         * @return time in microseconds
+         */
+        uint64_t        Now         ( void );
+
+        CReplay(const CReplay &);
+        CReplay & operator=(const CReplay&);
+
+        bool                    Running;            /**< True while a script is replayed. */
+        vector<KeyCode>         Keys;               /**< Key mapped to each event. */
+        vector<replaycommand_t> Script;             /**< Commands to replay, in order. */
+        uint32_t                Line;               /**< Index of the next command. */
+        uint32_t                Wait;               /**< Frames left before the next command. */
+        bool                    HoldKey;            /**< True if a key is released when the wait ends. */
+        KeyCode                 HeldKey;            /**< Key held by the last press. */
+        bool                    HoldAxis;           /**< True if an axis is centered when the wait ends. */
+        uint8_t                 HeldAxis;           /**< Axis moved by the last axis command. */
+        string                  Typing;             /**< Characters left to type, one per frame. */
+        uint32_t                Frames;             /**< Frames run since the replay started. */
+        uint32_t                Checking;           /**< Frames left that must not allocate. */
+        uint32_t                AllocFrames;        /**< Frames that allocated while checked. */
+        uint64_t                FrameStart;         /**< Start of the current frame. */
+        uint64_t                DrawEnd;            /**< End of the drawing of the current frame. */
+        vector<uint64_t>        Pending;            /**< Times of the events not yet presented. */
+        vector<uint32_t>        Samples[REPLAY_TOTAL];  /**< Timings in microseconds (index is defined in REPLAY_SAMPLES_T). */
+};
+
+#endif // CREPLAY_H
@@ -0,0 +1,817 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cbase.h"
+#include "cscaler.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define SCALE_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SCALE_NEON
+#endif
+
+using namespace std;
+
+#define FIXED_SHIFT     16                      /**< Fraction bits of the source position when stepping. */
+#define FIXED_HALF      (1<<(FIXED_SHIFT-1))    /**< One half in fixed point. */
+#define WEIGHT_SHIFT    8                       /**< Fraction bits of the filter weights. */
+#define WEIGHT_ONE      (1<<WEIGHT_SHIFT)       /**< A weight of one. */
+#define WEIGHT_ROUND    (1<<(WEIGHT_SHIFT-1))   /**< Added before shifting out the weight fraction. */
+#define RECIP_SHIFT     16                      /**< Fraction bits of the box filter reciprocals. */
+#define MASK_KEY        1                       /**< Some pixels of the image are the color key. */
+#define MASK_ALPHA      2                       /**< Some pixels of the image are not opaque. */
+
+/** @brief Pixel layouts with a filtered path
+ */
+enum SCALE_LAYOUT_T {
+    LAYOUT_BYTES=0,                 /** @brief 24 or 32 bpp, every channel is one byte */
+    LAYOUT_RGB565,                  /** @brief 16 bpp with 5/6/5 bit channels */
+    LAYOUT_OTHER                    /** @brief Palette or uncommon format, can only be point sampled */
+};
+
+/* Intermediate rows hold every channel as a 0-255 value in 16 bits. For LAYOUT_BYTES the
+ * channels stay interleaved, for LAYOUT_RGB565 each channel is stored in its own plane so the
+ * final pack can be done in vector registers. Either way the vertical pass only sees a flat
+ * array of uint16_t. */
+
+static uint8_t ScaleLayout( const SDL_PixelFormat* format )
+{
+    if (format->BytesPerPixel == 2 && format->Rmask == 0xF800 && format->Gmask == 0x07E0 && format->Bmask == 0x001F)
+        return LAYOUT_RGB565;
+    if (format->BytesPerPixel == 3 || format->BytesPerPixel == 4)
+        return LAYOUT_BYTES;
+    return LAYOUT_OTHER;
+}
+
+static inline uint16_t Expand5( uint16_t value )
+{
+    return (value<<3)|(value>>2);
+}
+
+static inline uint16_t Expand6( uint16_t value )
+{
+    return (value<<2)|(value>>4);
+}
+
+static inline uint32_t ReadPixel( const uint8_t* p, uint8_t bpp )
+{
+    switch (bpp)
+    {
+        case 1:
+            return *p;
+        case 2:
+            return *reinterpret_cast<const uint16_t*>(p);
+        case 3:
+            if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+                return p[0] << 16 | p[1] << 8 | p[2];
+            else
+                return p[0] | p[1] << 8 | p[2] << 16;
+        default:
+            return *reinterpret_cast<const uint32_t*>(p);
+    }
+}
+
+static inline void WritePixel( uint8_t* p, uint8_t bpp, uint32_t pixel )
+{
+    switch (bpp)
+    {
+        case 1:
+            *p = pixel;
+            break;
+        case 2:
+            *reinterpret_cast<uint16_t*>(p) = pixel;
+            break;
+        case 3:
+            if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
+            {
+                p[0] = (pixel >> 16) & 0xFF;
+                p[1] = (pixel >> 8) & 0xFF;
+                p[2] = pixel & 0xFF;
+            }
+            else
+            {
+                p[0] = pixel & 0xFF;
+                p[1] = (pixel >> 8) & 0xFF;
+                p[2] = (pixel >> 16) & 0xFF;
+            }
+            break;
+        default:
+            *reinterpret_cast<uint32_t*>(p) = pixel;
+            break;
+    }
+}
+
+/* Same positions as the per pixel scaler this replaced: each source pixel is copied over the destination
+ * pixels from its scaled position on, the last one written is kept. A destination pixel no source pixel
+ * reaches is -1 and stays black. */
+static void NearestTable( int32_t src_size, int32_t dst_size, vector<int32_t>& index )
+{
+    double stretch = static_cast<double>(dst_size) / static_cast<double>(src_size);
+
+    index.assign( dst_size, -1 );
+    for (int32_t i=0; i<src_size; i++)
+    {
+        for (int32_t o=0; o<stretch; o++)
+        {
+            int32_t pos = static_cast<int32_t>(stretch * i) + o;
+            if (pos < dst_size)
+                index.at(pos) = i;
+        }
+    }
+}
+
+/* Source positions sample the pixel centers: src = (dst + 0.5) * scale - 0.5 */
+static void LinearTable( int32_t src_size, int32_t dst_size, vector<int32_t>& index0, vector<int32_t>& index1, vector<uint16_t>& weight )
+{
+    index0.resize(dst_size);
+    index1.resize(dst_size);
+    weight.resize(dst_size);
+    for (int32_t i=0; i<dst_size; i++)
+    {
+        int32_t pos     = static_cast<int32_t>(((2*i+1) * (static_cast<int64_t>(src_size)<<FIXED_SHIFT)) / (2*dst_size)) - FIXED_HALF;
+        int32_t clamped = MAX(pos, 0);
+        index0.at(i) = clamped>>FIXED_SHIFT;
+        if (index0.at(i) >= src_size-1)
+        {
+            index0.at(i) = src_size-1;
+            index1.at(i) = src_size-1;
+            weight.at(i) = 0;
+        }
+        else
+        {
+            index1.at(i) = index0.at(i)+1;
+            weight.at(i) = (clamped>>(FIXED_SHIFT-WEIGHT_SHIFT)) & (WEIGHT_ONE-1);
+        }
+    }
+}
+
+/* Each destination pixel covers the source range [start,end), the ranges never overlap */
+static void BoxTable( int32_t src_size, int32_t dst_size, vector<int32_t>& start, vector<int32_t>& end )
+{
+    start.resize(dst_size);
+    end.resize(dst_size);
+    for (int32_t i=0; i<dst_size; i++)
+    {
+        start.at(i) = (i*src_size) / dst_size;
+        end.at(i)   = MAX(((i+1)*src_size) / dst_size, start.at(i)+1);
+    }
+}
+
+static inline uint16_t Divide( uint32_t sum, uint32_t recip )
+{
+    return MIN((sum*recip + (1<<(RECIP_SHIFT-1))) >> RECIP_SHIFT, 255);
+}
+
+static void HorizontalLinear( const uint8_t* row, uint8_t layout, uint8_t bpp, int32_t width,
+                              const int32_t* index0, const int32_t* index1, const uint16_t* weight, uint16_t* out )
+{
+    if (layout == LAYOUT_RGB565)
+    {
+        const uint16_t* pixels = reinterpret_cast<const uint16_t*>(row);
+        uint16_t* red   = out;
+        uint16_t* green = out+width;
+        uint16_t* blue  = out+width*2;
+
+        for (int32_t x=0; x<width; x++)
+        {
+            uint16_t a  = pixels[index0[x]];
+            uint16_t b  = pixels[index1[x]];
+            uint16_t w  = weight[x];
+            uint16_t iw = WEIGHT_ONE-w;
+
+            red[x]   = (Expand5(a>>11)*iw        + Expand5(b>>11)*w + WEIGHT_ROUND)        >> WEIGHT_SHIFT;
+            green[x] = (Expand6((a>>5)&0x3F)*iw  + Expand6((b>>5)&0x3F)*w + WEIGHT_ROUND)  >> WEIGHT_SHIFT;
+            blue[x]  = (Expand5(a&0x1F)*iw       + Expand5(b&0x1F)*w + WEIGHT_ROUND)       >> WEIGHT_SHIFT;
+        }
+    }
+    else if (bpp == 4)
+    {
+        for (int32_t x=0; x<width; x++, out+=4)
+        {
+            const uint8_t* a = row + index0[x]*4;
+            const uint8_t* b = row + index1[x]*4;
+            uint16_t w  = weight[x];
+            uint16_t iw = WEIGHT_ONE-w;
+
+            out[0] = (a[0]*iw + b[0]*w + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+            out[1] = (a[1]*iw + b[1]*w + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+            out[2] = (a[2]*iw + b[2]*w + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+            out[3] = (a[3]*iw + b[3]*w + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+        }
+    }
+    else
+    {
+        for (int32_t x=0; x<width; x++, out+=bpp)
+        {
+            const uint8_t* a = row + index0[x]*bpp;
+            const uint8_t* b = row + index1[x]*bpp;
+            uint16_t w  = weight[x];
+            uint16_t iw = WEIGHT_ONE-w;
+
+            for (uint8_t c=0; c<bpp; c++)
+                out[c] = (a[c]*iw + b[c]*w + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+        }
+    }
+}
+
+static void ExpandRow565( const uint8_t* row, int32_t width, uint16_t* out )
+{
+    const uint16_t* pixels = reinterpret_cast<const uint16_t*>(row);
+    uint16_t* red   = out;
+    uint16_t* green = out+width;
+    uint16_t* blue  = out+width*2;
+
+    for (int32_t x=0; x<width; x++)
+    {
+        red[x]   = Expand5(pixels[x]>>11);
+        green[x] = Expand6((pixels[x]>>5)&0x3F);
+        blue[x]  = Expand5(pixels[x]&0x1F);
+    }
+}
+
+/* Columns of sum already hold the total of every source row in the box, average them across */
+static void HorizontalBox( const uint32_t* sum, uint8_t layout, uint8_t bpp, int32_t src_width, int32_t width,
+                           int32_t rows, const int32_t* start, const int32_t* end, uint16_t* out )
+{
+    for (int32_t x=0; x<width; x++)
+    {
+        uint32_t area  = (end[x]-start[x]) * rows;
+        uint32_t recip = ((1<<RECIP_SHIFT) + (area>>1)) / area;
+
+        if (layout == LAYOUT_RGB565)
+        {
+            for (uint8_t c=0; c<3; c++)
+            {
+                const uint32_t* plane = sum + c*src_width;
+                uint32_t total = 0;
+
+                for (int32_t i=start[x]; i<end[x]; i++)
+                    total += plane[i];
+                out[c*width+x] = Divide( total, recip );
+            }
+        }
+        else if (bpp == 4)
+        {
+            uint32_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+
+            for (const uint32_t* p=sum+start[x]*4; p<sum+end[x]*4; p+=4)
+            {
+                c0 += p[0];
+                c1 += p[1];
+                c2 += p[2];
+                c3 += p[3];
+            }
+            out[x*4+0] = Divide( c0, recip );
+            out[x*4+1] = Divide( c1, recip );
+            out[x*4+2] = Divide( c2, recip );
+            out[x*4+3] = Divide( c3, recip );
+        }
+        else
+        {
+            for (uint8_t c=0; c<bpp; c++)
+            {
+                uint32_t total = 0;
+
+                for (int32_t i=start[x]; i<end[x]; i++)
+                    total += sum[i*bpp+c];
+                out[x*bpp+c] = Divide( total, recip );
+            }
+        }
+    }
+}
+
+/* out = (a*(1-w) + b*w), products stay below 65536 because channels are 0-255 */
+static void BlendRows( const uint16_t* a, const uint16_t* b, uint16_t weight, uint16_t* out, uint32_t count )
+{
+    uint16_t iweight = WEIGHT_ONE-weight;
+    uint32_t i = 0;
+
+#if defined(SCALE_SSE2)
+    __m128i wa = _mm_set1_epi16( iweight );
+    __m128i wb = _mm_set1_epi16( weight );
+    __m128i wr = _mm_set1_epi16( WEIGHT_ROUND );
+    for (; i+8<=count; i+=8)
+    {
+        __m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>(a+i) );
+        __m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>(b+i) );
+        __m128i v  = _mm_add_epi16( _mm_mullo_epi16(va, wa), _mm_add_epi16(_mm_mullo_epi16(vb, wb), wr) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(out+i), _mm_srli_epi16(v, WEIGHT_SHIFT) );
+    }
+#elif defined(SCALE_NEON)
+    uint16x8_t wa = vdupq_n_u16( iweight );
+    uint16x8_t wb = vdupq_n_u16( weight );
+    uint16x8_t wr = vdupq_n_u16( WEIGHT_ROUND );
+    for (; i+8<=count; i+=8)
+    {
+        uint16x8_t v = vmlaq_u16( wr, vld1q_u16(a+i), wa );
+        v = vmlaq_u16( v, vld1q_u16(b+i), wb );
+        vst1q_u16( out+i, vshrq_n_u16(v, WEIGHT_SHIFT) );
+    }
+#endif
+    for (; i<count; i++)
+        out[i] = (a[i]*iweight + b[i]*weight + WEIGHT_ROUND) >> WEIGHT_SHIFT;
+}
+
+static void AccumulateRow( const uint16_t* in, uint32_t* sum, uint32_t count )
+{
+    uint32_t i = 0;
+
+#if defined(SCALE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    for (; i+8<=count; i+=8)
+    {
+        __m128i v  = _mm_loadu_si128( reinterpret_cast<const __m128i*>(in+i) );
+        __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>(sum+i) );
+        __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>(sum+i+4) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(sum+i),   _mm_add_epi32(lo, _mm_unpacklo_epi16(v, zero)) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(sum+i+4), _mm_add_epi32(hi, _mm_unpackhi_epi16(v, zero)) );
+    }
+#elif defined(SCALE_NEON)
+    for (; i+8<=count; i+=8)
+    {
+        uint16x8_t v = vld1q_u16( in+i );
+        vst1q_u32( sum+i,   vaddw_u16(vld1q_u32(sum+i),   vget_low_u16(v)) );
+        vst1q_u32( sum+i+4, vaddw_u16(vld1q_u32(sum+i+4), vget_high_u16(v)) );
+    }
+#endif
+    for (; i<count; i++)
+        sum[i] += in[i];
+}
+
+static void AccumulateBytes( const uint8_t* in, uint32_t* sum, uint32_t count )
+{
+    uint32_t i = 0;
+
+#if defined(SCALE_SSE2)
+    __m128i zero = _mm_setzero_si128();
+    for (; i+16<=count; i+=16)
+    {
+        __m128i v  = _mm_loadu_si128( reinterpret_cast<const __m128i*>(in+i) );
+        __m128i lo = _mm_unpacklo_epi8( v, zero );
+        __m128i hi = _mm_unpackhi_epi8( v, zero );
+        __m128i* out = reinterpret_cast<__m128i*>(sum+i);
+
+        _mm_storeu_si128( out+0, _mm_add_epi32(_mm_loadu_si128(out+0), _mm_unpacklo_epi16(lo, zero)) );
+        _mm_storeu_si128( out+1, _mm_add_epi32(_mm_loadu_si128(out+1), _mm_unpackhi_epi16(lo, zero)) );
+        _mm_storeu_si128( out+2, _mm_add_epi32(_mm_loadu_si128(out+2), _mm_unpacklo_epi16(hi, zero)) );
+        _mm_storeu_si128( out+3, _mm_add_epi32(_mm_loadu_si128(out+3), _mm_unpackhi_epi16(hi, zero)) );
+    }
+#elif defined(SCALE_NEON)
+    for (; i+8<=count; i+=8)
+    {
+        uint16x8_t v = vmovl_u8( vld1_u8(in+i) );
+        vst1q_u32( sum+i,   vaddw_u16(vld1q_u32(sum+i),   vget_low_u16(v)) );
+        vst1q_u32( sum+i+4, vaddw_u16(vld1q_u32(sum+i+4), vget_high_u16(v)) );
+    }
+#endif
+    for (; i<count; i++)
+        sum[i] += in[i];
+}
+
+static void PackBytes( const uint16_t* in, uint8_t* out, uint32_t count )
+{
+    uint32_t i = 0;
+
+#if defined(SCALE_SSE2)
+    for (; i+16<=count; i+=16)
+    {
+        __m128i lo = _mm_loadu_si128( reinterpret_cast<const __m128i*>(in+i) );
+        __m128i hi = _mm_loadu_si128( reinterpret_cast<const __m128i*>(in+i+8) );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(out+i), _mm_packus_epi16(lo, hi) );
+    }
+#elif defined(SCALE_NEON)
+    for (; i+8<=count; i+=8)
+        vst1_u8( out+i, vmovn_u16(vld1q_u16(in+i)) );
+#endif
+    for (; i<count; i++)
+        out[i] = in[i];
+}
+
+static void Pack565( const uint16_t* in, uint16_t* out, uint32_t width )
+{
+    const uint16_t* red   = in;
+    const uint16_t* green = in+width;
+    const uint16_t* blue  = in+width*2;
+    uint32_t x = 0;
+
+#if defined(SCALE_SSE2)
+    for (; x+8<=width; x+=8)
+    {
+        __m128i r = _mm_slli_epi16( _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(red+x)), 3), 11 );
+        __m128i g = _mm_slli_epi16( _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(green+x)), 2), 5 );
+        __m128i b = _mm_srli_epi16( _mm_loadu_si128(reinterpret_cast<const __m128i*>(blue+x)), 3 );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(out+x), _mm_or_si128(r, _mm_or_si128(g, b)) );
+    }
+#elif defined(SCALE_NEON)
+    for (; x+8<=width; x+=8)
+    {
+        uint16x8_t r = vshlq_n_u16( vshrq_n_u16(vld1q_u16(red+x), 3), 11 );
+        uint16x8_t g = vshlq_n_u16( vshrq_n_u16(vld1q_u16(green+x), 2), 5 );
+        uint16x8_t b = vshrq_n_u16( vld1q_u16(blue+x), 3 );
+        vst1q_u16( out+x, vorrq_u16(r, vorrq_u16(g, b)) );
+    }
+#endif
+    for (; x<width; x++)
+        out[x] = ((red[x]>>3)<<11) | ((green[x]>>2)<<5) | (blue[x]>>3);
+}
+
+static void PackRow( const uint16_t* in, uint8_t layout, uint8_t* out, uint32_t width, uint32_t count )
+{
+    if (layout == LAYOUT_RGB565)
+        Pack565( in, reinterpret_cast<uint16_t*>(out), width );
+    else
+        PackBytes( in, out, count );
+}
+
+static void ScaleNearest( SDL_Surface* src, SDL_Surface* dst )
+{
+    uint8_t         bpp     = src->format->BytesPerPixel;
+    int32_t         last_y  = -1;
+    vector<int32_t> offsets;
+    vector<int32_t> rows;
+    vector<int32_t> holes;
+
+    NearestTable( src->w, dst->w, offsets );
+    NearestTable( src->h, dst->h, rows );
+    for (int32_t x=0; x<dst->w; x++)
+    {
+        if (offsets.at(x) < 0)
+        {
+            holes.push_back( x );
+            offsets.at(x) = 0;
+        }
+        offsets.at(x) *= bpp;
+    }
+
+    for (int32_t y=0; y<dst->h; y++)
+    {
+        int32_t  src_y  = rows.at(y);
+        uint8_t* out    = static_cast<uint8_t*>(dst->pixels) + y*dst->pitch;
+        const uint8_t* in = static_cast<const uint8_t*>(src->pixels) + src_y*src->pitch;
+
+        if (src_y < 0)
+        {
+            memset( out, 0, dst->w*bpp );
+            last_y = -1;
+            continue;
+        }
+        if (src_y == last_y)
+        {
+            memcpy( out, out-dst->pitch, dst->w*bpp );
+            continue;
+        }
+        last_y = src_y;
+
+        switch (bpp)
+        {
+            case 1:
+                for (int32_t x=0; x<dst->w; x++)
+                    out[x] = in[offsets[x]];
+                break;
+            case 2:
+                for (int32_t x=0; x<dst->w; x++)
+                    reinterpret_cast<uint16_t*>(out)[x] = *reinterpret_cast<const uint16_t*>(in+offsets[x]);
+                break;
+            case 3:
+                for (int32_t x=0; x<dst->w; x++)
+                    memcpy( out+x*3, in+offsets[x], 3 );
+                break;
+            case 4:
+                for (int32_t x=0; x<dst->w; x++)
+                    reinterpret_cast<uint32_t*>(out)[x] = *reinterpret_cast<const uint32_t*>(in+offsets[x]);
+                break;
+        }
+        for (uint32_t i=0; i<holes.size(); i++)
+            memset( out+holes[i]*bpp, 0, bpp );
+    }
+}
+
+/* Finds what the filters must leave out of the average. A key no pixel uses or an alpha channel that is
+ * opaque everywhere can take the fast paths. */
+static uint8_t ScaleMask( SDL_Surface* src, uint32_t& key )
+{
+    uint8_t     bpp     = src->format->BytesPerPixel;
+    uint32_t    amask   = src->format->Amask;
+    uint8_t     found   = 0;
+    uint8_t     mask    = 0;
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+    if (SDL_GetColorKey( src, &key ) == 0)
+        found |= MASK_KEY;
+#else /* SDL 1.2 */
+    key = src->format->colorkey;
+    if (src->flags & SDL_SRCCOLORKEY)
+        found |= MASK_KEY;
+#endif
+    if (amask != 0)
+        found |= MASK_ALPHA;
+    // The key is matched on the color only, like the blitter does
+    key &= ~amask;
+
+    for (int32_t y=0; y<src->h && mask != found; y++)
+    {
+        const uint8_t* in = static_cast<const uint8_t*>(src->pixels) + y*src->pitch;
+
+        for (int32_t x=0; x<src->w; x++, in+=bpp)
+        {
+            uint32_t pixel = ReadPixel( in, bpp );
+
+            if ((found & MASK_KEY) && (pixel & ~amask) == key)
+                mask |= MASK_KEY;
+            if ((found & MASK_ALPHA) && (pixel & amask) != amask)
+                mask |= MASK_ALPHA;
+        }
+    }
+    return mask;
+}
+
+/* Keyed and translucent images are filtered one pixel at a time with the same taps as the fast paths.
+ * Whether a pixel is keyed comes from the nearest sample so the outline matches SCALE_NEAREST, key pixels
+ * are left out of the average and colors are weighted by their alpha so neither bleeds into the edges. */
+static void ScaleMasked( SDL_Surface* src, SDL_Surface* dst, uint8_t layout, uint8_t mode, uint8_t mask, uint32_t key )
+{
+    uint8_t             bpp      = src->format->BytesPerPixel;
+    uint32_t            amask    = src->format->Amask;
+    uint8_t             channels = (layout == LAYOUT_RGB565 ? 3 : bpp);
+    int8_t              alpha    = -1;
+    vector<int32_t>     near_x, near_y, x0, x1, y0, y1, taps_x, taps_y;
+    vector<uint16_t>    wx, wy;
+
+    if ((mask & MASK_ALPHA) && layout == LAYOUT_BYTES)
+        alpha = (SDL_BYTEORDER == SDL_BIG_ENDIAN) ? bpp-1-src->format->Ashift/8 : src->format->Ashift/8;
+
+    NearestTable( src->w, dst->w, near_x );
+    NearestTable( src->h, dst->h, near_y );
+    if (mode == SCALE_BOX)
+    {
+        BoxTable( src->w, dst->w, x0, x1 );
+        BoxTable( src->h, dst->h, y0, y1 );
+    }
+    else
+    {
+        LinearTable( src->w, dst->w, x0, x1, wx );
+        LinearTable( src->h, dst->h, y0, y1, wy );
+    }
+    taps_x.resize( dst->w );
+    taps_y.resize( dst->h );
+    for (int32_t x=0; x<dst->w; x++)
+        taps_x.at(x) = (mode == SCALE_BOX) ? x1.at(x)-x0.at(x) : 2;
+    for (int32_t y=0; y<dst->h; y++)
+        taps_y.at(y) = (mode == SCALE_BOX) ? y1.at(y)-y0.at(y) : 2;
+
+    for (int32_t y=0; y<dst->h; y++)
+    {
+        uint8_t* out = static_cast<uint8_t*>(dst->pixels) + y*dst->pitch;
+
+        for (int32_t x=0; x<dst->w; x++, out+=bpp)
+        {
+            uint64_t    sums[4] = { 0, 0, 0, 0 };
+            uint64_t    opacity = 0;
+            uint64_t    total   = 0;
+            uint32_t    nearest = 0;
+            uint32_t    pixel;
+
+            if (near_x.at(x) >= 0 && near_y.at(y) >= 0)
+                nearest = ReadPixel( static_cast<const uint8_t*>(src->pixels) + near_y.at(y)*src->pitch + near_x.at(x)*bpp, bpp );
+            if ((mask & MASK_KEY) && (nearest & ~amask) == key)
+            {
+                WritePixel( out, bpp, nearest );
+                continue;
+            }
+
+            // Box taps cover [start,end) with equal weights, linear taps are the two neighbors on each axis
+            for (int32_t i=0; i<taps_y.at(y); i++)
+            {
+                int32_t  ty       = (mode == SCALE_BOX) ? y0.at(y)+i : (i == 0 ? y0.at(y) : y1.at(y));
+                uint32_t weight_y = (mode == SCALE_BOX) ? 1 : (i == 0 ? WEIGHT_ONE-wy.at(y) : wy.at(y));
+                const uint8_t* row = static_cast<const uint8_t*>(src->pixels) + ty*src->pitch;
+
+                for (int32_t j=0; j<taps_x.at(x); j++)
+                {
+                    int32_t  tx     = (mode == SCALE_BOX) ? x0.at(x)+j : (j == 0 ? x0.at(x) : x1.at(x));
+                    uint32_t weight = weight_y * ((mode == SCALE_BOX) ? 1 : (j == 0 ? WEIGHT_ONE-wx.at(x) : wx.at(x)));
+                    const uint8_t* in = row + tx*bpp;
+                    uint16_t value[4] = { 0, 0, 0, 0 };
+                    uint16_t cover;
+
+                    pixel = ReadPixel( in, bpp );
+                    if ((mask & MASK_KEY) && (pixel & ~amask) == key)
+                        continue;
+
+                    if (layout == LAYOUT_RGB565)
+                    {
+                        value[0] = Expand5(pixel>>11);
+                        value[1] = Expand6((pixel>>5)&0x3F);
+                        value[2] = Expand5(pixel&0x1F);
+                    }
+                    else
+                    {
+                        for (uint8_t c=0; c<channels; c++)
+                            value[c] = in[c];
+                    }
+                    cover = (alpha >= 0) ? value[alpha] : 255;
+
+                    total   += weight;
+                    opacity += weight * cover;
+                    for (uint8_t c=0; c<channels; c++)
+                        sums[c] += static_cast<uint64_t>(weight) * cover * value[c];
+                }
+            }
+
+            // Only keyed or clear pixels around, nothing to average
+            if (opacity == 0)
+            {
+                WritePixel( out, bpp, nearest );
+                continue;
+            }
+
+            if (layout == LAYOUT_RGB565)
+            {
+                pixel = ((sums[0]/opacity)>>3)<<11 | ((sums[1]/opacity)>>2)<<5 | ((sums[2]/opacity)>>3);
+                WritePixel( out, bpp, pixel );
+            }
+            else
+            {
+                for (uint8_t c=0; c<channels; c++)
+                    out[c] = (c == alpha) ? opacity/total : sums[c]/opacity;
+                pixel = ReadPixel( out, bpp );
+            }
+
+            // An average may land on the key, the lowest color bit off keeps it visible
+            if ((mask & MASK_KEY) && (pixel & ~amask) == key)
+                WritePixel( out, bpp, pixel ^ (~amask & (amask+1)) );
+        }
+    }
+}
+
+static void ScaleBilinear( SDL_Surface* src, SDL_Surface* dst, uint8_t layout )
+{
+    uint8_t             bpp      = src->format->BytesPerPixel;
+    uint32_t            count    = dst->w * (layout == LAYOUT_RGB565 ? 3 : bpp);
+    vector<int32_t>     x0, x1, y0, y1;
+    vector<uint16_t>    wx, wy;
+    vector<uint16_t>    buffer(count*3);
+    uint16_t*           row_a    = &buffer.at(0);
+    uint16_t*           row_b    = row_a+count;
+    uint16_t*           blend    = row_b+count;
+    int32_t             row_a_y  = -1;
+    int32_t             row_b_y  = -1;
+
+    LinearTable( src->w, dst->w, x0, x1, wx );
+    LinearTable( src->h, dst->h, y0, y1, wy );
+
+    for (int32_t y=0; y<dst->h; y++)
+    {
+        const uint16_t* line;
+
+        // Consecutive output rows mostly share source rows, only filter the ones not already held
+        if (row_a_y != y0.at(y))
+        {
+            if (row_b_y == y0.at(y))
+            {
+                swap( row_a, row_b );
+                swap( row_a_y, row_b_y );
+            }
+            else
+            {
+                HorizontalLinear( static_cast<const uint8_t*>(src->pixels) + y0.at(y)*src->pitch,
+                                  layout, bpp, dst->w, &x0.at(0), &x1.at(0), &wx.at(0), row_a );
+                row_a_y = y0.at(y);
+            }
+        }
+
+        line = row_a;
+        if (wy.at(y) > 0)
+        {
+            if (row_b_y != y1.at(y))
+            {
+                HorizontalLinear( static_cast<const uint8_t*>(src->pixels) + y1.at(y)*src->pitch,
+                                  layout, bpp, dst->w, &x0.at(0), &x1.at(0), &wx.at(0), row_b );
+                row_b_y = y1.at(y);
+            }
+            BlendRows( row_a, row_b, wy.at(y), blend, count );
+            line = blend;
+        }
+
+        PackRow( line, layout, static_cast<uint8_t*>(dst->pixels) + y*dst->pitch, dst->w, count );
+    }
+}
+
+static void ScaleBox( SDL_Surface* src, SDL_Surface* dst, uint8_t layout )
+{
+    uint8_t             bpp      = src->format->BytesPerPixel;
+    uint8_t             channels = (layout == LAYOUT_RGB565 ? 3 : bpp);
+    uint32_t            count    = dst->w * channels;
+    uint32_t            src_count = src->w * channels;
+    vector<int32_t>     x_start, x_end, y_start, y_end;
+    vector<uint16_t>    expanded;
+    vector<uint16_t>    row(count);
+    vector<uint32_t>    sum(src_count);
+
+    BoxTable( src->w, dst->w, x_start, x_end );
+    BoxTable( src->h, dst->h, y_start, y_end );
+    if (layout == LAYOUT_RGB565)
+        expanded.resize(src_count);
+
+    // Total the source rows of the box first so the horizontal pass runs once per output row
+    for (int32_t y=0; y<dst->h; y++)
+    {
+        fill( sum.begin(), sum.end(), 0 );
+        for (int32_t src_y=y_start.at(y); src_y<y_end.at(y); src_y++)
+        {
+            const uint8_t* in = static_cast<const uint8_t*>(src->pixels) + src_y*src->pitch;
+
+            if (layout == LAYOUT_RGB565)
+            {
+                ExpandRow565( in, src->w, &expanded.at(0) );
+                AccumulateRow( &expanded.at(0), &sum.at(0), src_count );
+            }
+            else
+            {
+                AccumulateBytes( in, &sum.at(0), src_count );
+            }
+        }
+        HorizontalBox( &sum.at(0), layout, bpp, src->w, dst->w, y_end.at(y)-y_start.at(y),
+                       &x_start.at(0), &x_end.at(0), &row.at(0) );
+
+        PackRow( &row.at(0), layout, static_cast<uint8_t*>(dst->pixels) + y*dst->pitch, dst->w, count );
+    }
+}
+
+int8_t ScalePixels( SDL_Surface* src, SDL_Surface* dst, uint8_t mode )
+{
+    uint8_t  layout;
+    uint8_t  mask;
+    uint32_t key;
+
+    if (src == NULL || dst == NULL || src->w <= 0 || src->h <= 0 || dst->w <= 0 || dst->h <= 0)
+        return 1;
+
+    if (src->format->BytesPerPixel != dst->format->BytesPerPixel)
+        return 1;
+
+    if (SDL_MUSTLOCK(src))
+        SDL_LockSurface(src);
+    if (SDL_MUSTLOCK(dst))
+        SDL_LockSurface(dst);
+
+    layout = ScaleLayout( src->format );
+    if (mode >= SCALE_TOTAL)
+        mode = SCALE_BOX;
+    if (layout == LAYOUT_OTHER)
+        mode = SCALE_NEAREST;
+    // The box filter only averages, enlarging an axis needs interpolation
+    if (mode == SCALE_BOX && (dst->w > src->w || dst->h > src->h))
+        mode = SCALE_BILINEAR;
+    mask = (mode == SCALE_NEAREST) ? 0 : ScaleMask( src, key );
+
+    if (mask != 0)
+    {
+        ScaleMasked( src, dst, layout, mode, mask, key );
+    }
+    else
+    {
+        switch (mode)
+        {
+            case SCALE_NEAREST:
+                ScaleNearest( src, dst );
+                break;
+            case SCALE_BILINEAR:
+                ScaleBilinear( src, dst, layout );
+                break;
+            case SCALE_BOX:
+                ScaleBox( src, dst, layout );
+                break;
+        }
+    }
+
+    if (SDL_MUSTLOCK(dst))
+        SDL_UnlockSurface(dst);
+    if (SDL_MUSTLOCK(src))
+        SDL_UnlockSurface(src);
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CSCALER_H
+#define CSCALER_H
+
+#include <stdint.h>
+
+#include "SDL.h"
+
+/** @brief Filters that can be used to scale an image
+ */
+enum SCALE_MODE_T {
+    SCALE_NEAREST=0,                /** @brief Point sampling, fastest but aliases when shrinking */
+    SCALE_BILINEAR,                 /** @brief Weighted average of the four closest pixels */
+    SCALE_BOX,                      /** @brief Area average when shrinking, bilinear when enlarging */
+    SCALE_TOTAL
+};
+
+/** @brief Scales the pixels of one surface into another surface with the same pixel format.
+ *         32/24 bpp and RGB565 surfaces are filtered, any other format is point sampled. Pixels of the color
+ *         key are kept where the nearest sample is keyed and left out of the average elsewhere, colors are
+ *         weighted by their alpha. Nearest sampling gives the same pixels as the per pixel scaler it replaced.
+ * @param src : input image
+ * @param dst : output image, its dimensions are the scaled size
+ * @param mode : filter to use (index is defined in SCALE_MODE_T)
+ * @return 0 if passed 1 if failed
+ */
+int8_t ScalePixels( SDL_Surface* src, SDL_Surface* dst, uint8_t mode );
+
+#endif // CSCALER_H
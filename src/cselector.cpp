@@ -31,6 +31,8 @@ CSelector::CSelector() : CBase(),
         SetAllEntryValue    (false),
         TextScrollDir       (true),
         ExtractAllFiles     (false),
+        DwellPending        (false),
+        DrawAll             (false),
         DrawState_Title     (true),
         DrawState_About     (true),
         DrawState_Filter    (true),
@@ -59,6 +61,7 @@ CSelector::CSelector() : CBase(),
         FrameEndTime        (0),
         FrameStartTime      (0),
         FrameDelay          (0),
+        DwellTime           (0),
 #if SDL_VERSION_ATLEAST(2,0,0)
         Window              (NULL),
         Renderer            (NULL),
@@ -80,15 +83,30 @@ CSelector::CSelector() : CBase(),
         ImageZipMode        (NULL),
 #if defined(DEBUG)
         ImageDebug          (NULL),
+        DebugText           (""),
 #endif
         ImageButtons        (),
+        ImageLabels         (),
         Fonts               (),
         Config              (),
         Profile             (),
         System              (),
+        Preview             (),
+        Bundle              (),
+        Launch              (),
+        Readahead           (),
+        Snapshot            (),
+        Replay              (),
+        Hud                 (),
+        Startup             (),
+        Memory              (),
         ConfigPath          (DEF_CONFIG),
         ProfilePath         (DEF_PROFILE),
         ZipListPath         (DEF_ZIPLIST),
+        ReplayPath          (),
+        ReplayReportPath    (REPLAY_REPORT),
+        StartupReportPath   (),
+        StartupBudget       (0),
         EventReleased       (),
         EventPressCount     (),
         ButtonModesLeft     (),
@@ -111,6 +129,8 @@ CSelector::CSelector() : CBase(),
     RectButtonsLeft.resize( BUTTONS_MAX_LEFT );
     RectButtonsRight.resize( BUTTONS_MAX_RIGHT );
     ImageButtons.resize( EVENT_TOTAL, NULL );
+    ImageLabels.resize( EVENT_TOTAL, NULL );
+    ScreenRectsDirty.reserve( DIRTY_RECTS );
     LabelButtons.resize( EVENT_TOTAL, "" );
 
     LabelButtons.at(EVENT_ONE_UP)       = BUTTON_LABEL_ONE_UP;
@@ -145,41 +165,72 @@ int8_t CSelector::Run( int32_t argc, char** argv )
     result = 0;
 
     ProcessArguments( argc, argv );
+    Startup.Open( StartupBudget );
 
     System.SetCPUClock( Config.CPUClock );
 
+    // A replay needs no screen, an already set driver is kept
+    if (ReplayPath.length() > 0)
+    {
+        setenv( "SDL_VIDEODRIVER", REPLAY_VIDEODRIVER, 0 );
+    }
+
     // Load video,input,profile resources
     if (OpenResources())
     {
         result = 1;
     }
 
+    if ((result == 0) && (ReplayPath.length() > 0) && (Replay.Open( ReplayPath, Config.KeyMaps )))
+    {
+        result = 1;
+    }
+
     // Display and poll the user for a selection
     if (result == 0)
     {
-        int16_t selection = DisplayScreen();
+        int16_t selection;
 
-        // Setup a exec script for execution following termination of this application
-        if (selection >= 0)
+        // As supervisor the launcher comes back here once the application exits
+        do
         {
-            if (RunExec( selection ))
+            selection = DisplayScreen();
+
+            // A replay ends at the selection, nothing is launched
+            if ((selection >= 0) && (Replay.Active() == true))
+            {
+                Log( __FILENAME__, __LINE__, "Replay selected '%s'", ItemsEntry.at(selection).Name.c_str() );
+                selection = -1;
+            }
+
+            // Setup a exec script for execution following termination of this application
+            if (selection >= 0)
+            {
+                if (RunExec( selection ))
+                {
+                    result = 1;
+                }
+            }
+            else if (selection < -1)
             {
                 result = 1;
             }
-        }
-        else if (selection < -1)
-        {
-            result = 1;
-        }
-        else
-        {
-            result = 0;
-        }
+            else
+            {
+                result = 0;
+            }
+        } while ((Config.Supervisor == true) && (selection >= 0) && (result == 0));
     }
 
     // Release resources
     CloseResources( result );
 
+    // A replay that checked for allocations fails the run if a frame made any, as does a slow start
+    if ((Replay.Allocated() > 0) || (Startup.OverBudget() == true))
+    {
+        result = 1;
+    }
+
     return result;
 }
 
@@ -226,36 +277,121 @@ void CSelector::ProcessArguments( int argc, char** argv )
         {
             ZipListPath = string(argv[++arg_index]);
         }
+        else
+        if (argument.compare( ARG_REPLAY ) == 0)
+        {
+            ReplayPath = string(argv[++arg_index]);
+        }
+        else
+        if (argument.compare( ARG_REPLAY_REPORT ) == 0)
+        {
+            ReplayReportPath = string(argv[++arg_index]);
+        }
+        else
+        if (argument.compare( ARG_STARTUP_REPORT ) == 0)
+        {
+            StartupReportPath = string(argv[++arg_index]);
+        }
+        else
+        if (argument.compare( ARG_STARTUP_BUDGET ) == 0)
+        {
+            StartupBudget = a_to_i( string(argv[++arg_index]) );
+        }
     }
 }
 
 int8_t CSelector::OpenResources( void )
 {
-    uint32_t flags;
-    string text;
-    SDL_Surface* background = NULL;
+    TRACE_SPAN( "CSelector::OpenResources" );
+
+    bool resumed;
 
     Log( __FILENAME__, __LINE__, "Loading config." );
+    Startup.Begin( STARTUP_CONFIG );
     if (Config.Load( ConfigPath ))
     {
         Log( __FILENAME__, __LINE__, "Failed to load config" );
         return 1;
     }
+    Startup.End( STARTUP_CONFIG );
+    LogThreshold = Config.LogLevel;
 
     Log( __FILENAME__, __LINE__, "Loading ziplist." );
+    Startup.Begin( STARTUP_ZIPLIST );
     if ((Config.UseZipSupport == true) && (Profile.Minizip.LoadUnzipList( ZipListPath )))
     {
         Log( __FILENAME__, __LINE__, "Failed to load ziplist" );
         return 1;
     }
+    Startup.End( STARTUP_ZIPLIST );
+
+    // The list from the last run is drawn while the profile loads
+    resumed = false;
+    if (ResumeSnapshot() == 0)
+    {
+        if (OpenDisplay())
+        {
+            return 1;
+        }
+
+        if (ConfigureButtons() || DisplaySelector())
+        {
+            return 1;
+        }
+        Startup.Begin( STARTUP_PRESENT );
+        UpdateScreen();
+        Startup.End( STARTUP_PRESENT );
+        Startup.Ready( "snapshot" );
+        resumed = true;
+    }
+
+    Log( __FILENAME__, __LINE__, "Loading profile: %s", ProfilePath.c_str() );
+    Startup.Begin( STARTUP_PROFILE );
+    if (Profile.Load( ProfilePath, Config.Delimiter ))
+    {
+        Log( __FILENAME__, __LINE__, "Failed to load profile" );
+        return 1;
+    }
+    Startup.End( STARTUP_PROFILE );
+
+    if (resumed == true)
+    {
+        // Entries saved without values are dropped from the profile, which moves the ones after them
+        for (uint16_t i=0; i<ItemsEntry.size(); i++)
+        {
+            if (   (ItemsEntry.at(i).Entry >= 0)
+                && (   (!CheckRange( ItemsEntry.at(i).Entry, Profile.Entries.size() ))
+                    || (Profile.Entries.at(ItemsEntry.at(i).Entry).Name.compare(ItemsEntry.at(i).Name) != 0)
+                   )
+               )
+            {
+                Log( __FILENAME__, __LINE__, "Snapshot entries do not match the profile, rescanning" );
+                Rescan = true;
+                break;
+            }
+        }
+        Snapshot.Clear();
+        return 0;
+    }
+
+    return OpenDisplay();
+}
+
+int8_t CSelector::OpenDisplay( void )
+{
+    uint32_t flags;
+    string text;
+    SDL_Surface* background = NULL;
 
     // Initialize defaults, Video and Audio subsystems
     Log( __FILENAME__, __LINE__, "Initializing SDL." );
+    Startup.Begin( STARTUP_SDL );
     if (SDL_Init( SDL_INIT_VIDEO|SDL_INIT_AUDIO|SDL_INIT_TIMER|SDL_INIT_JOYSTICK )==-1)
     {
         Log( __FILENAME__, __LINE__, "Failed to initialize SDL: %s.", SDL_GetError() );
         return 1;
     }
+    Startup.End( STARTUP_SDL );
     Log( __FILENAME__, __LINE__, "SDL initialized." );
 
     // Setup SDL Screen
@@ -265,6 +401,7 @@ int8_t CSelector::OpenResources( void )
         flags |= FULLSCREEN;
     }
 
+    Startup.Begin( STARTUP_VIDEO );
 #if SDL_VERSION_ATLEAST(2,0,0)
     SDL_GetDisplayUsableBounds( 0, &WindowBounds );
 
@@ -313,6 +450,7 @@ int8_t CSelector::OpenResources( void )
     // Refresh entire screen for the first frame
     UpdateRect( 0, 0, Config.ScreenWidth, Config.ScreenHeight );
 #endif
+    Startup.End( STARTUP_VIDEO );
 
     // Load joystick
 #if !defined(PANDORA) && !defined(X86)
@@ -331,50 +469,65 @@ int8_t CSelector::OpenResources( void )
         return 1;
     }
 
+    // Graphics and font converted on a previous start
+    Bundle.Open( Config.BundlePath, PixelFormat, Config.ScreenWidth, Config.ScreenHeight, Config.ScaleMode );
+
     // Load ttf font
-    Fonts.at(FONT_SIZE_SMALL) = TTF_OpenFont( Config.PathFont.c_str(), Config.FontSizes.at(FONT_SIZE_SMALL) );
+    Startup.Begin( STARTUP_FONT_SMALL );
+    Fonts.at(FONT_SIZE_SMALL) = Bundle.Font( Config.PathFont, Config.FontSizes.at(FONT_SIZE_SMALL) );
     if (!Fonts.at(FONT_SIZE_SMALL))
     {
         Log( __FILENAME__, __LINE__, "Failed to open small TTF_OpenFont: %s", TTF_GetError() );
         return 1;
     }
-    Fonts.at(FONT_SIZE_MEDIUM) = TTF_OpenFont( Config.PathFont.c_str(), Config.FontSizes.at(FONT_SIZE_MEDIUM) );
+    Startup.End( STARTUP_FONT_SMALL );
+    Startup.Begin( STARTUP_FONT_MEDIUM );
+    Fonts.at(FONT_SIZE_MEDIUM) = Bundle.Font( Config.PathFont, Config.FontSizes.at(FONT_SIZE_MEDIUM) );
     if (!Fonts.at(FONT_SIZE_MEDIUM))
     {
         Log( __FILENAME__, __LINE__, "Failed to open medium TTF_OpenFont: %s", TTF_GetError() );
         return 1;
     }
-    Fonts.at(FONT_SIZE_LARGE) = TTF_OpenFont( Config.PathFont.c_str(), Config.FontSizes.at(FONT_SIZE_LARGE) );
+    Startup.End( STARTUP_FONT_MEDIUM );
+    Startup.Begin( STARTUP_FONT_LARGE );
+    Fonts.at(FONT_SIZE_LARGE) = Bundle.Font( Config.PathFont, Config.FontSizes.at(FONT_SIZE_LARGE) );
     if (!Fonts.at(FONT_SIZE_LARGE))
     {
         Log( __FILENAME__, __LINE__, "Failed to open large TTF_OpenFont: %s", TTF_GetError() );
         return 1;
     }
-
-    Log( __FILENAME__, __LINE__, "Loading profile: %s", ProfilePath.c_str() );
-    if (Profile.Load( ProfilePath, Config.Delimiter ))
-    {
-        Log( __FILENAME__, __LINE__, "Failed to load profile" );
-        return 1;
-    }
+    Startup.End( STARTUP_FONT_LARGE );
 
     // Load images
-    background = LOAD_IMAGE( Config.PathBackground );
-    if (background != NULL)
+    Startup.Begin( STARTUP_BACKGROUND );
+    ImageBackground = Bundle.Image( Config.PathBackground, Config.ScreenWidth, Config.ScreenHeight );
+    if (ImageBackground == NULL)
     {
-        ImageBackground = ScaleSurface( background, Config.ScreenWidth, Config.ScreenHeight );
-        FREE_IMAGE(background);
+        background = LOAD_IMAGE( Config.PathBackground );
+        if (background != NULL)
+        {
+            ImageBackground = ScaleSurface( background, Config.ScreenWidth, Config.ScreenHeight, Config.ScaleMode );
+            FREE_IMAGE(background);
+            Bundle.AddImage( Config.PathBackground, Config.ScreenWidth, Config.ScreenHeight, ImageBackground );
+        }
     }
+    Startup.End( STARTUP_BACKGROUND );
 
+    Startup.Begin( STARTUP_BUTTONS );
     for (uint8_t button_index=0; button_index<Config.PathButtons.size(); button_index++)
     {
-        ImageButtons.at(button_index) = LOAD_IMAGE( Config.PathButtons.at(button_index) );
+        // Events that are never shown as a button have no graphic
+        if (Config.PathButtons.at(button_index).length() > 0)
+        {
+            ImageButtons.at(button_index) = LoadAsset( Config.PathButtons.at(button_index) );
+        }
     }
+    Startup.End( STARTUP_BUTTONS );
 
     //      Mouse pointer
     if (Config.ShowPointer==true)
     {
-        ImagePointer = LOAD_IMAGE( Config.PathPointer );
+        ImagePointer = LoadAsset( Config.PathPointer );
         if (ImagePointer == NULL)
         {
             SDL_ShowCursor( SDL_ENABLE );
@@ -389,8 +542,26 @@ int8_t CSelector::OpenResources( void )
         SDL_ShowCursor( SDL_DISABLE );
     }
 
+    //      Preview decoder
+    if (Preview.Open( Config.PreviewsPath, Config.PreviewWidth, Config.PreviewHeight, Config.ScaleMode,
+                      PixelFormat, Config.PreviewCache, Config.ThumbnailsPath ))
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open preview decoder" );
+        return 1;
+    }
+
+    //      Memory budget of the caches
+    Memory.Open( Config.MemoryLimit*1024 );
+
+    //      Readahead of the files needed by the target
+    if (Readahead.Open())
+    {
+        Log( __FILENAME__, __LINE__, "Failed to open readahead" );
+        return 1;
+    }
+
     //      List selector pointer
-    ImageSelectPointer = LOAD_IMAGE( Config.PathSelectPointer );
+    ImageSelectPointer = LoadAsset( Config.PathSelectPointer );
     if (ImageSelectPointer == NULL)
     {
         ImageSelectPointer = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_MEDIUM), ENTRY_ARROW, Config.Colors.at(COLOR_BLACK) );
@@ -418,22 +589,46 @@ int8_t CSelector::OpenResources( void )
         return 1;
     }
 
+    // Anything loaded from its source is converted for the next start
+    Bundle.Save();
+
     return 0;
 }
 
 void CSelector::CloseResources( int8_t result )
 {
-    if (result == 0)
+    bool       replay;
+    memstats_t memory;
+
+    // The start up is reported once, also when an entry is launched
+    Startup.Close( StartupReportPath );
+    IoReport();
+    Memory.Report();
+
+    // A replay leaves the config, profile, snapshot and unzip list as they were
+    replay = Replay.Active();
+    if (replay == true)
+    {
+        Memory.Stats( memory );
+        Replay.Close( ReplayReportPath, memory );
+    }
+    else if (result == 0)
     {
         Config.Save( ConfigPath );
-        Profile.Save( ProfilePath, Config.Delimiter );
+        Profile.Commit( ProfilePath, Config.Delimiter, Config.JournalLimit*1024 );
+        SaveSnapshot();
     }
 
-    if (Config.UseZipSupport == true)
+    if ((Config.UseZipSupport == true) && (replay == false))
     {
         Profile.Minizip.SaveUnzipList( ZipListPath );
     }
 
+    CloseDisplay();
+}
+
+void CSelector::CloseDisplay( void )
+{
     // Close joystick
     if (Joystick != NULL)
     {
@@ -464,7 +659,8 @@ void CSelector::CloseResources( int8_t result )
     FREE_IMAGE( ImageBackground );
     FREE_IMAGE( ImagePointer );
     FREE_IMAGE( ImageSelectPointer );
-    FREE_IMAGE( ImagePreview );
+    ImagePreview = NULL;
+    Preview.Close();
     FREE_IMAGE( ImageTitle );
     FREE_IMAGE( ImageAbout );
     FREE_IMAGE( ImageFilePath );
@@ -474,10 +670,14 @@ void CSelector::CloseResources( int8_t result )
 #if defined(DEBUG)
     FREE_IMAGE( ImageDebug );
 #endif
+    Hud.Close();
     for (uint8_t button_index=0; button_index<ImageButtons.size(); button_index++)
     {
         FREE_IMAGE( ImageButtons.at(button_index) );
+        FREE_IMAGE( ImageLabels.at(button_index) );
     }
+    FreeListNames();
+    Bundle.Close();
 
 #if SDL_VERSION_ATLEAST(2,0,0)
     if (PixelFormat != NULL)
@@ -488,13 +688,21 @@ void CSelector::CloseResources( int8_t result )
     if (Renderer != NULL)
     {
         SDL_DestroyRenderer( Renderer );
+        Renderer = NULL;
     }
 
     if (Window != NULL)
     {
         SDL_DestroyWindow( Window );
+        Window = NULL;
     }
 #endif
+    // The display may be opened again by the supervisor
+    PixelFormat = NULL;
+    Screen      = NULL;
+
+    // Files queued at launch are still warmed while the rest shuts down
+    Readahead.Close();
 
     Log( __FILENAME__, __LINE__, "Quitting TTF." );
     TTF_Quit();
@@ -503,10 +711,24 @@ void CSelector::CloseResources( int8_t result )
     SDL_Quit();
 
     // Flush all std buffers before exit
+    LogFlush();
     fflush( stdout );
     fflush( stderr );
 }
 
+SDL_Surface* CSelector::LoadAsset( const string& path )
+{
+    SDL_Surface* image;
+
+    image = Bundle.Image( path, 0, 0 );
+    if (image == NULL)
+    {
+        image = LOAD_IMAGE( path );
+        Bundle.AddImage( path, 0, 0, image );
+    }
+    return image;
+}
+
 int16_t CSelector::DisplayScreen( void )
 {
     while (   (IsEventOff(EVENT_QUIT) == true)
@@ -515,6 +737,12 @@ int16_t CSelector::DisplayScreen( void )
               )
           )
     {
+        // Feed the next scripted input, the end of the script quits
+        if (Replay.Step())
+        {
+            return -1;
+        }
+
         // Get user input
         if (PollInputs())
         {
@@ -523,6 +751,17 @@ int16_t CSelector::DisplayScreen( void )
 
         // Select the mode
         SelectMode();
+        ToggleHud();
+
+        // An entry whose arguments are being edited is likely to be launched next
+        if (   (DwellPending == true)
+            && (Config.ReadaheadDwell > 0)
+            && (SDL_GetTicks() - DwellTime >= Config.ReadaheadDwell)
+           )
+        {
+            DwellPending = false;
+            WarmEntry( DisplayList.at(MODE_SELECT_ENTRY).absolute );
+        }
 
         // Configure the buttons according to the mode
         if (ConfigureButtons())
@@ -530,20 +769,42 @@ int16_t CSelector::DisplayScreen( void )
             return -2;
         }
 
+        // A flipped screen is drawn in full under each update of the performance display
+        if ((Config.ScreenFlip == true) && (Hud.Due( false ) == true))
+        {
+            Redraw = true;
+        }
+
         // Draw the selector
         if (DisplaySelector())
         {
             return -2;
         }
+        Replay.Drawn();
+
+        // Draw the performance display on top
+        if (DrawHud())
+        {
+            return -2;
+        }
 
         // Update the screen
+        Startup.Begin( STARTUP_PRESENT );
         UpdateScreen();
+        Startup.End( STARTUP_PRESENT );
+        Startup.Ready( "scan" );
+
+        // Caches are trimmed after the frame, anything freed is only rendered again when it is drawn
+        TrimMemory();
     }
 
     if (IsEventOn( EVENT_QUIT ) == true)
     {
-        // Detete any files exracted from zip
-        Profile.Minizip.DelUnzipFiles();
+        // Detete any files exracted from zip, a replay extracts none and leaves those of earlier runs
+        if (Replay.Active() == false)
+        {
+            Profile.Minizip.DelUnzipFiles();
+        }
 
         return -1;
     }
@@ -619,10 +880,17 @@ void CSelector::UpdateRect( int16_t x, int16_t y, int16_t w, int16_t h )
 
 void CSelector::UpdateScreen( void )
 {
+    TRACE_SPAN( "CSelector::UpdateScreen" );
+    ALLOCS_SCOPE( ALLOC_PRESENT );
+
+    uint8_t kind;
+
 #if SDL_VERSION_ATLEAST(2,0,0)
     SDL_UpdateWindowSurface( Window );
 
     FramesDrawn++;
+    Replay.Presented();
+    kind = HUD_DRAWN;
 #else /* SDL 1.2 */
 #if defined(DEBUG_FORCE_REDRAW)
     Redraw = true;
@@ -645,21 +913,29 @@ void CSelector::UpdateScreen( void )
 
         Redraw = false;
         FramesDrawn++;
+        Replay.Presented();
+        kind = HUD_DRAWN;
     }
     else
     {
         if (SkipFrame == true)
         {
             FramesSkipped++;
+            kind = HUD_SKIPPED;
         }
         else
         {
             FramesSleep++;
+            kind = HUD_SLEEP;
         }
     }
     ScreenRectsDirty.clear();
 #endif
 
+    TRACE_FRAME();
+    ALLOCS_FRAME();
+    Hud.Frame( kind );
+
     FrameEndTime = SDL_GetTicks();
     FrameDelay   = (MS_PER_SEC/FRAMES_PER_SEC) - (FrameEndTime - FrameStartTime);
 
@@ -680,10 +956,13 @@ void CSelector::UpdateScreen( void )
     }
     else
     {
+        TRACE_SPAN( "CSelector::FrameDelay" );
+
         SkipFrame = false;
         SDL_Delay( MIN(FrameDelay, MS_PER_SEC) );
     }
     FrameStartTime = SDL_GetTicks();
+    Hud.Start();
 
 #if defined(DEBUG_FPS)
     if (FrameStartTime - FrameCountTime >= MS_PER_SEC)
@@ -765,14 +1044,28 @@ void CSelector::SelectMode( void )
 
     if (Mode != old_mode)
     {
+        IoAction( IO_NAVIGATE );
         DrawState_ButtonL  = true;
         DrawState_ButtonR  = true;
         Rescan = true;
+
+        if ((Mode == MODE_SELECT_ARGUMENT) && (old_mode == MODE_SELECT_ENTRY))
+        {
+            DwellPending = true;
+            DwellTime    = SDL_GetTicks();
+        }
+        else if (Mode == MODE_SELECT_ENTRY)
+        {
+            DwellPending = false;
+        }
     }
 }
 
 int8_t CSelector::DisplaySelector( void )
 {
+    TRACE_SPAN( "CSelector::DisplaySelector" );
+    ALLOCS_SCOPE( ALLOC_DRAW );
+
     SDL_Rect rect_pos = { Config.EntryXOffset, Config.EntryYOffset, 0 ,0 };
 
     if (Rescan)
@@ -790,19 +1083,22 @@ int8_t CSelector::DisplaySelector( void )
         RefreshList     = false;
     }
 
+    if (Mode == MODE_SELECT_ENTRY)
+    {
+        CheckPreview();
+    }
+
     if ((Redraw == true) || (CurScrollPause != 0) || (CurScrollSpeed != 0) || (TextScrollOffset != 0))
     {
+        // Everything is drawn on a flipped screen, text that did not change is not rendered again
         if (Config.ScreenFlip == true)
         {
             DrawState_Title     = true;
             DrawState_About     = true;
-            DrawState_Filter    = true;
-            DrawState_FilePath  = true;
-            DrawState_Index     = true;
-            DrawState_ZipMode   = true;
             DrawState_Preview   = true;
             DrawState_ButtonL   = true;
             DrawState_ButtonR   = true;
+            DrawAll             = true;
         }
 #if defined(DEBUG_DRAW_STATES)
         else
@@ -846,11 +1142,132 @@ int8_t CSelector::DisplaySelector( void )
         {
             ApplyImage( Mouse.x, Mouse.y, ImagePointer, Screen, NULL );
         }
+        DrawAll = false;
+    }
+
+    return 0;
+}
+
+void CSelector::ToggleHud( void )
+{
+    if (IsEventOn( EVENT_HUD ) == true)
+    {
+        EventPressCount.at(EVENT_HUD) = EVENT_LOOPS_OFF;
+        Hud.Toggle();
+
+        // Anything the display covered is drawn again
+        Redraw = true;
+        UpdateRect( 0, 0, Config.ScreenWidth, Config.ScreenHeight );
+    }
+}
+
+int8_t CSelector::DrawHud( void )
+{
+    ALLOCS_SCOPE( ALLOC_TOOLS );
+
+    SDL_Rect        area;
+    previewstats_t  previews;
+    memstats_t      memory;
+
+    if (Hud.Due( Redraw ) == false)
+    {
+        return 0;
+    }
+
+    Preview.Stats( previews );
+    Memory.Stats( memory );
+    if (Hud.Draw( Screen, Fonts.at(FONT_SIZE_SMALL), Config.Colors.at(Config.ColorFontFiles), previews, memory, area ))
+    {
+        return 1;
     }
+    UpdateRect( area.x, area.y, area.w, area.h );
+    Redraw = true;
 
     return 0;
 }
 
+void CSelector::TrimMemory( void )
+{
+    ALLOCS_SCOPE( ALLOC_TOOLS );
+
+    uint32_t    bytes;
+    uint32_t    excess;
+    uint32_t    freed;
+
+    if (Memory.Due() == false)
+    {
+        return;
+    }
+
+    Memory.Set( MEM_BACKGROUND, SurfaceBytes( ImageBackground ) );
+
+    bytes = SurfaceBytes( ImagePointer ) + SurfaceBytes( ImageSelectPointer );
+    for (uint16_t index=0; index<ImageButtons.size(); index++)
+    {
+        bytes += SurfaceBytes( ImageButtons.at(index) );
+    }
+    Memory.Set( MEM_BUTTONS, bytes );
+
+    // Archives are listed into the entries, their contents are counted with the directory
+    bytes = ItemsEntry.capacity()*sizeof(listitem_t) + ItemsArgument.capacity()*sizeof(listoption_t)
+          + ItemsValue.capacity()*sizeof(string);
+    for (uint16_t index=0; index<ItemsEntry.size(); index++)
+    {
+        bytes += ItemsEntry.at(index).Name.capacity();
+    }
+    for (uint16_t index=0; index<ItemsArgument.size(); index++)
+    {
+        bytes += ItemsArgument.at(index).Name.capacity();
+    }
+    for (uint16_t index=0; index<ItemsValue.size(); index++)
+    {
+        bytes += ItemsValue.at(index).capacity();
+    }
+    Memory.Set( MEM_LISTING, bytes );
+
+    bytes = SurfaceBytes( ImageTitle ) + SurfaceBytes( ImageAbout ) + SurfaceBytes( ImageFilePath )
+          + SurfaceBytes( ImageFilter ) + SurfaceBytes( ImageIndex ) + SurfaceBytes( ImageZipMode );
+    for (uint16_t index=0; index<ImageLabels.size(); index++)
+    {
+        bytes += SurfaceBytes( ImageLabels.at(index) );
+    }
+    for (uint16_t index=0; index<ListNames.size(); index++)
+    {
+        bytes += SurfaceBytes( ListNames.at(index).image );
+    }
+    Memory.Set( MEM_TEXT, bytes );
+
+    Memory.Set( MEM_PREVIEWS, Preview.Held() );
+
+    excess = Memory.Excess();
+    if (excess == 0)
+    {
+        return;
+    }
+
+    // Previews go first, they are mapped again from the thumbnails when selected
+    freed = Preview.Trim( excess );
+    Memory.Evicted( MEM_PREVIEWS, freed );
+    if (freed >= excess)
+    {
+        return;
+    }
+
+    // Then the text of the buttons and the list, it is rendered again when drawn
+    freed = 0;
+    for (uint16_t index=0; index<ImageLabels.size(); index++)
+    {
+        freed += SurfaceBytes( ImageLabels.at(index) );
+        FREE_IMAGE( ImageLabels.at(index) );
+    }
+    for (uint16_t index=0; index<ListNames.size(); index++)
+    {
+        freed += SurfaceBytes( ListNames.at(index).image );
+        FREE_IMAGE( ListNames.at(index).image );
+    }
+    Memory.Evicted( MEM_TEXT, freed );
+}
+
 void CSelector::DirectoryUp( void )
 {
     if (Profile.FilePath.length() > 0)
@@ -910,11 +1327,17 @@ void CSelector::ZipDown( void )
 void CSelector::RescanItems( void )
 {
     uint16_t total;
+    uint32_t start;
 
     switch (Mode)
     {
         case MODE_SELECT_ENTRY:
+            start = SDL_GetTicks();
+            Startup.Begin( STARTUP_SCAN );
             Profile.ScanDir( Profile.FilePath, Config.ShowHidden, Config.UseZipSupport, ItemsEntry );
+            Startup.End( STARTUP_SCAN );
+            Hud.Scanned( SDL_GetTicks() - start );
+            Preview.Refresh();
             total = ItemsEntry.size();
             break;
         case MODE_SELECT_ARGUMENT:
@@ -943,6 +1366,7 @@ void CSelector::RescanItems( void )
     {
         RectEntries.resize( total );
     }
+    FreeListNames();
     ListNames.resize( RectEntries.size() );
 
     if (Mode == MODE_SELECT_ENTRY)
@@ -980,6 +1404,8 @@ void CSelector::RescanItems( void )
 
 void CSelector::PopulateList( void )
 {
+    FreeListNames();
+
     // Set limits
     SelectionLimits( DisplayList.at( Mode ) );
 
@@ -1003,6 +1429,14 @@ void CSelector::PopulateList( void )
     }
 }
 
+void CSelector::FreeListNames( void )
+{
+    for (uint16_t i=0; i<ListNames.size(); i++)
+    {
+        FREE_IMAGE( ListNames.at(i).image );
+    }
+}
+
 void CSelector::PopModeEntry( void )
 {
     for (uint16_t i=0; i<ListNames.size(); i++)
@@ -1011,26 +1445,12 @@ void CSelector::PopModeEntry( void )
 
         if (CheckRange( index, ItemsEntry.size() ))
         {
-            ListNames.at(i).text.clear();
-            if (ItemsEntry.at(index).Entry >= 0)
-            {
-                ListNames.at(i).text = Profile.Entries.at(ItemsEntry.at(index).Entry).Alias;
-            }
-            if (ListNames.at(i).text.length() == 0)
-            {
-                ListNames.at(i).text = ItemsEntry.at(index).Name;
-            }
-
-            if (Config.ShowExts == false)
-            {
-                ListNames.at(i).text = ListNames.at(i).text.substr( 0, ListNames.at(i).text.find_last_of(".") );
-            }
-            ListNames.at(i).text = ListNames.at(i).text;
+            ListNames.at(i).text = EntryText( index );
 
             if (index == DisplayList.at(Mode).absolute)
             {
                 ListNames.at(i).font = FONT_SIZE_LARGE;
-                LoadPreview( ListNames.at(i).text );        // Load preview
+                LoadPreview( index );                       // Load preview
             }
             else
             {
@@ -1215,6 +1635,20 @@ void CSelector::PopModeValue( void )
                 Log( __FILENAME__, __LINE__, "Error: PopModeValue index is out of range" );
             }
         }
+
+        // Only the change is written now, the profile is rewritten when the journal is compacted
+        // A replay changes the entries in memory only, the journal stays as it was like the profile
+        if ((SetAllEntryValue == true) && (Replay.Active() == false))
+        {
+            Profile.JournalDefault( ProfilePath, Config.Delimiter, argument );
+        }
+        if (   ((SetOneEntryValue == true) || (SetAllEntryValue == true))
+            && (Replay.Active() == false)
+            && (CheckRange( ItemsEntry.at(DisplayList.at(MODE_SELECT_ENTRY).absolute).Entry, Profile.Entries.size() ))
+           )
+        {
+            Profile.JournalEntry( ProfilePath, Config.Delimiter, ItemsEntry.at(DisplayList.at(MODE_SELECT_ENTRY).absolute).Entry );
+        }
     }
     else
     {
@@ -1227,35 +1661,74 @@ void CSelector::PopModeOption( void )
     // TODO
 }
 
-void CSelector::LoadPreview( const string& name )
+string CSelector::EntryText( uint16_t index )
 {
-    string filename;
-    SDL_Surface* preview = NULL;
+    string text;
 
-    if (ImagePreview != NULL)
+    if (CheckRange( ItemsEntry.at(index).Entry, Profile.Entries.size() ))
     {
-        DrawState_Preview = true;
+        text = Profile.Entries.at(ItemsEntry.at(index).Entry).Alias;
+    }
+    else if ((ItemsEntry.at(index).Entry >= 0) && (CheckRange( index, Snapshot.Aliases.size() )))
+    {
+        // The profile is still loading
+        text = Snapshot.Aliases.at(index);
+    }
+    if (text.length() == 0)
+    {
+        text = ItemsEntry.at(index).Name;
     }
 
-    FREE_IMAGE( ImagePreview );
+    if (Config.ShowExts == false)
+    {
+        text = text.substr( 0, text.find_last_of(".") );
+    }
+    return text;
+}
 
-    filename = Config.PreviewsPath + "/" + name.substr( 0, name.find_last_of(".")) + ".png";
+void CSelector::LoadPreview( uint16_t index )
+{
+    TRACE_SPAN( "CSelector::LoadPreview" );
 
-#if defined(DEBUG)
-    Log( __FILENAME__, __LINE__, "Loading preview picture: %s", filename.c_str() );
-#endif
+    vector<string> neighbors;
 
-    preview = LOAD_IMAGE( filename );
-    if (preview != NULL)
+    for (uint16_t offset=1; offset<=PREVIEW_PREFETCH; offset++)
+    {
+        if (index >= offset)
+        {
+            neighbors.push_back( EntryText( index-offset ) );
+        }
+        if (index+offset < ItemsEntry.size())
+        {
+            neighbors.push_back( EntryText( index+offset ) );
+        }
+    }
+
+    // Clear the old preview, the new one is drawn whenever the decoder has it
+    if (ImagePreview != NULL)
     {
-        ImagePreview = ScaleSurface( preview, Config.PreviewWidth, Config.PreviewHeight );
-        FREE_IMAGE( preview );
         DrawState_Preview = true;
     }
+    ImagePreview = NULL;
+
+    Preview.Request( EntryText( index ), neighbors );
+    CheckPreview();
+}
+
+void CSelector::CheckPreview( void )
+{
+    if (Preview.Fetch( ImagePreview ) == true)
+    {
+        DrawState_Preview   = true;
+        Redraw              = true;
+    }
 }
 
 int8_t CSelector::DrawNames( SDL_Rect& location )
 {
+    TRACE_SPAN( "CSelector::DrawNames" );
+    ALLOCS_SCOPE( ALLOC_NAMES );
+
     uint16_t startx, starty;
     uint16_t entry_height = 0;
     SDL_Rect rect_clip;
@@ -1311,7 +1784,12 @@ int8_t CSelector::DrawNames( SDL_Rect& location )
         {
             if (ListNames.at(entry_index).text.length() > 0)
             {
-                text_surface = TTF_RenderText_Solid( Fonts.at(ListNames.at(entry_index).font), ListNames.at(entry_index).text.c_str(), Config.Colors.at(ListNames.at(entry_index).color) );
+                // Rendered once each time the list is populated, scrolling only moves the clip
+                if (ListNames.at(entry_index).image == NULL)
+                {
+                    ListNames.at(entry_index).image = TTF_RenderText_Solid( Fonts.at(ListNames.at(entry_index).font), ListNames.at(entry_index).text.c_str(), Config.Colors.at(ListNames.at(entry_index).color) );
+                }
+                text_surface = ListNames.at(entry_index).image;
 
                 if (text_surface != NULL)
                 {
@@ -1381,8 +1859,6 @@ int8_t CSelector::DrawNames( SDL_Rect& location )
                     location.x -= (ImageSelectPointer->w + POINTER_OFFSET);
 
                     entry_height = text_surface->h;
-
-                    FREE_IMAGE( text_surface );
                 }
                 else
                 {
@@ -1658,7 +2134,12 @@ int8_t CSelector::DrawButton( uint8_t button, TTF_Font* font, SDL_Rect& location
 
     if (Config.ShowLabels == true)
     {
-        text_surface = TTF_RenderText_Solid( font, LabelButtons.at(button).c_str(), Config.Colors.at(Config.ColorFontButton) );
+        // The labels never change, each is rendered once
+        if (ImageLabels.at(button) == NULL)
+        {
+            ImageLabels.at(button) = TTF_RenderText_Solid( font, LabelButtons.at(button).c_str(), Config.Colors.at(Config.ColorFontButton) );
+        }
+        text_surface = ImageLabels.at(button);
 
         if (text_surface != NULL)
         {
@@ -1666,8 +2147,6 @@ int8_t CSelector::DrawButton( uint8_t button, TTF_Font* font, SDL_Rect& location
             rect_text.y = location.y + ((location.h-text_surface->h)/2);
 
             ApplyImage( rect_text.x, rect_text.y, text_surface, Screen, NULL );
-
-            FREE_IMAGE( text_surface );
         }
         else
         {
@@ -1685,6 +2164,9 @@ int8_t CSelector::DrawText( SDL_Rect& location )
     int16_t         prev_height;
     string          text;
     SDL_Rect        box, clip;
+#if defined(DEBUG)
+    char            debug[DEBUG_TEXT];
+#endif
 
     prev_width  = 0;
     prev_height = 0;
@@ -1710,9 +2192,13 @@ int8_t CSelector::DrawText( SDL_Rect& location )
     // Entry Filter and Filepath (they can overlap so both are drawn when either change)
     if (Mode == MODE_SELECT_ENTRY)
     {
-        if ((DrawState_FilePath == true) || (DrawState_Filter == true))
+        if ((DrawState_FilePath == true) || (DrawState_Filter == true) || (DrawAll == true))
         {
             int16_t max_height;
+            bool    render;
+
+            // The text is only rendered again when it changed
+            render = (DrawState_FilePath == true) || (DrawState_Filter == true);
 
             // Entry Filter
             if (ImageFilter != NULL)
@@ -1727,33 +2213,37 @@ int8_t CSelector::DrawText( SDL_Rect& location )
             }
             max_height = prev_height;
 
-            FREE_IMAGE( ImageFilter );
-
-            if (Profile.EntryFilter.length() > 0)
+            if ((render == true) && (DrawState_Filter == true))
             {
-                ImageFilter = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_MEDIUM), Profile.EntryFilter.c_str(), Config.Colors.at(Config.ColorFontFiles) );
-                if (ImageFilter != NULL)
+                FREE_IMAGE( ImageFilter );
+
+                if (Profile.EntryFilter.length() > 0)
                 {
-                    clip.x = 0;
-                    clip.y = 0;
-                    clip.w = Config.FilePathMaxWidth;
-                    clip.h = ImageFilter->h;
-                    if (ImageFilter->w > Config.FilePathMaxWidth)
+                    ImageFilter = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_MEDIUM), Profile.EntryFilter.c_str(), Config.Colors.at(Config.ColorFontFiles) );
+                    if (ImageFilter == NULL)
                     {
-                        clip.x = ImageFilter->w-Config.FilePathMaxWidth;
+                        Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
+                        return 1;
                     }
-
-                    location.x = Config.ScreenWidth - ImageFilter->w - Config.EntryXOffset;
-
-                    ApplyImage( location.x, location.y, ImageFilter, Screen, &clip );
-
-                    max_height = MAX( max_height, ImageFilePath->h );
                 }
-                else
+            }
+
+            if (ImageFilter != NULL)
+            {
+                clip.x = 0;
+                clip.y = 0;
+                clip.w = Config.FilePathMaxWidth;
+                clip.h = ImageFilter->h;
+                if (ImageFilter->w > Config.FilePathMaxWidth)
                 {
-                    Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
-                    return 1;
+                    clip.x = ImageFilter->w-Config.FilePathMaxWidth;
                 }
+
+                location.x = Config.ScreenWidth - ImageFilter->w - Config.EntryXOffset;
+
+                ApplyImage( location.x, location.y, ImageFilter, Screen, &clip );
+
+                max_height = MAX( max_height, ImageFilter->h );
             }
             location.x = Config.EntryXOffset;
 
@@ -1770,15 +2260,24 @@ int8_t CSelector::DrawText( SDL_Rect& location )
             }
             max_height = MAX( max_height, prev_height );
 
-            FREE_IMAGE(ImageFilePath);
-
-            text = Profile.FilePath;
-            if (Profile.ZipFile.length())
+            if ((render == true) && (DrawState_FilePath == true))
             {
-                text += "->" + Profile.ZipFile;
+                FREE_IMAGE(ImageFilePath);
+
+                text = Profile.FilePath;
+                if (Profile.ZipFile.length())
+                {
+                    text += "->" + Profile.ZipFile;
+                }
+
+                ImageFilePath = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_MEDIUM), text.c_str(), Config.Colors.at(Config.ColorFontFiles) );
+                if (ImageFilePath == NULL)
+                {
+                    Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
+                    return 1;
+                }
             }
 
-            ImageFilePath = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_MEDIUM), text.c_str(), Config.Colors.at(Config.ColorFontFiles) );
             if (ImageFilePath != NULL)
             {
                 clip.x = 0;
@@ -1795,11 +2294,6 @@ int8_t CSelector::DrawText( SDL_Rect& location )
 
                 max_height = MAX( max_height, ImageFilePath->h );
             }
-            else
-            {
-                Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
-                return 1;
-            }
 
             UpdateRect( 0, location.y, Config.ScreenWidth, max_height );
 
@@ -1846,7 +2340,7 @@ int8_t CSelector::DrawText( SDL_Rect& location )
     }
 
     // Draw index
-    if (DrawState_Index == true)
+    if ((DrawState_Index == true) || (DrawAll == true))
     {
         if (ImageIndex != NULL)
         {
@@ -1859,14 +2353,22 @@ int8_t CSelector::DrawText( SDL_Rect& location )
             prev_height = 0;
         }
 
-        FREE_IMAGE( ImageIndex );
-
-        text = "0 of 0";
-        if (total > 0)
+        if (DrawState_Index == true)
         {
-            text = i_to_a(DisplayList.at(Mode).absolute+1) + " of " + i_to_a(total);
+            FREE_IMAGE( ImageIndex );
+
+            text = "0 of 0";
+            if (total > 0)
+            {
+                text = i_to_a(DisplayList.at(Mode).absolute+1) + " of " + i_to_a(total);
+            }
+            ImageIndex = TTF_RenderText_Solid(Fonts.at(FONT_SIZE_SMALL), text.c_str(), Config.Colors.at(Config.ColorFontFiles));
+            if (ImageIndex == NULL)
+            {
+                Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
+                return 1;
+            }
         }
-        ImageIndex = TTF_RenderText_Solid(Fonts.at(FONT_SIZE_SMALL), text.c_str(), Config.Colors.at(Config.ColorFontFiles));
 
         if (ImageIndex != NULL)
         {
@@ -1876,18 +2378,13 @@ int8_t CSelector::DrawText( SDL_Rect& location )
             ApplyImage( box.x, box.y, ImageIndex, Screen, NULL );
             UpdateRect( box.x, box.y, MAX(ImageIndex->w, prev_width), MAX(ImageIndex->h, prev_height) );
         }
-        else
-        {
-            Log( __FILENAME__, __LINE__, "Failed to create TTF surface with TTF_RenderText_Solid: %s", TTF_GetError() );
-            return 1;
-        }
         DrawState_Index = false;
     }
 
     // Zip extract option
-    if (DrawState_ZipMode == true)
+    if ((DrawState_ZipMode == true) || (DrawAll == true))
     {
-        if ((Config.UseZipSupport == true) && (Profile.ZipFile.length() > 0))
+        if ((DrawState_ZipMode == true) && (Config.UseZipSupport == true) && (Profile.ZipFile.length() > 0))
         {
             if (ImageZipMode != NULL)
             {
@@ -1945,15 +2442,17 @@ int8_t CSelector::DrawText( SDL_Rect& location )
         prev_height = 0;
     }
 
-    FREE_IMAGE( ImageDebug );
-
-    text = "DEBUG abs " + i_to_a(DisplayList.at(Mode).absolute)  + " rel " + i_to_a(DisplayList.at(Mode).relative)
-         + " F " + i_to_a(DisplayList.at(Mode).first) + " L " + i_to_a(DisplayList.at(Mode).last)
-         + " T " + i_to_a(DisplayList.at(Mode).total)
-         + " fps " + i_to_a(FPSDrawn) + " skp " + i_to_a(FPSSkip) + " slp " + i_to_a(FPSSleep)
-         + " lp " + i_to_a(LoopTimeAverage);
+    // Formatted without allocating, the text is only rendered again when a value changed
+    snprintf( debug, sizeof(debug), "DEBUG abs %d rel %d F %d L %d T %d fps %d skp %d slp %d lp %d",
+              DisplayList.at(Mode).absolute, DisplayList.at(Mode).relative, DisplayList.at(Mode).first,
+              DisplayList.at(Mode).last, DisplayList.at(Mode).total, FPSDrawn, FPSSkip, FPSSleep, LoopTimeAverage );
 
-    ImageDebug = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_SMALL), text.c_str(), Config.Colors.at(Config.ColorFontFiles) );
+    if ((ImageDebug == NULL) || (DebugText.compare( debug ) != 0))
+    {
+        FREE_IMAGE( ImageDebug );
+        DebugText  = debug;
+        ImageDebug = TTF_RenderText_Solid( Fonts.at(FONT_SIZE_SMALL), debug, Config.Colors.at(Config.ColorFontFiles) );
+    }
 
     if (ImageDebug != NULL)
     {
@@ -1981,13 +2480,30 @@ int8_t CSelector::RunExec( uint16_t selection )
     string filepath;
     string command;
     string extension;
-    string value;
     string cmdpath, cmdname;
     vector<string> commands;
+    stringstream selecttime;
+    struct timeval selected;
+    uint8_t type;
+    const string* value = NULL;
     entry_t* entry = NULL;
     argforce_t* argforce = NULL;
     exeforce_t* exeforce = NULL;
     argument_t* argument = NULL;
+    cmdplan_t* cmdplan = NULL;
+    extplan_t* extplan = NULL;
+    argplan_t* argplan = NULL;
+    vector<int16_t>* forces = NULL;
+    map<string, int16_t>::iterator exeforce_found;
+    map<string, vector<int16_t> >::iterator argforce_found;
+
+    IoAction( IO_LAUNCH );
+
+    // Handed to the application so it can measure how long the launch took
+    gettimeofday( &selected, NULL );
+    Launch.Clear();
+    selecttime << selected.tv_sec << "." << setw(6) << setfill('0') << selected.tv_usec;
+    Launch.SelectTime = selecttime.str();
 
     // Find a entry for argument values
     entry_found = false;
@@ -1998,6 +2514,9 @@ int8_t CSelector::RunExec( uint16_t selection )
         return 1;
     }
 
+    // The reads overlap with building the command and closing the display
+    WarmEntry( selection );
+
     if (ItemsEntry.at(selection).Entry >= 0)
     {
         entry = &Profile.Entries.at(ItemsEntry.at(selection).Entry);
@@ -2022,11 +2541,10 @@ int8_t CSelector::RunExec( uint16_t selection )
 
     if (CheckRange( ext_index, Profile.Extensions.size() ))
     {
-        command.clear();
-
         // Unzip if needed
         if ((Config.UseZipSupport == true) && (Profile.ZipFile.length() > 0))
         {
+            IoCount( IO_MKDIR );
             mkdir( Config.ZipPath.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH );
             if (ExtractAllFiles == true)    // Extract all
             {
@@ -2046,145 +2564,138 @@ int8_t CSelector::RunExec( uint16_t selection )
 
 
         // Setup commands
-        for (uint16_t i=0; i<Profile.Commands.size(); i++)
+        for (uint16_t i=0; i<Profile.CmdPlans.size(); i++)
         {
-            //command += "cd " + Profile.Commands.at(i).Path + "; ";
-            command += Profile.Commands.at(i).Path + Profile.Commands.at(i).Command;
+            cmdplan = &Profile.CmdPlans.at(i);
 
-            for (uint16_t j=0; j<Profile.Commands.at(i).Arguments.size(); j++)
+            Launch.Begin( "", false );
+            Launch.AddText( cmdplan->Program );
+
+            for (uint16_t j=0; j<cmdplan->Arguments.size(); j++)
             {
-                if (Profile.Commands.at(i).Arguments.at(j).Flag.compare(VALUE_NOVALUE) != 0)
+                argument = &Profile.Commands.at(i).Arguments.at(j);
+
+                if (cmdplan->Arguments.at(j).UseFlag == true)
                 {
-                    command += Profile.Commands.at(i).Arguments.at(j).Flag;
+                    Launch.AddText( cmdplan->Arguments.at(j).Flag );
                 }
 
-                if (Profile.Commands.at(i).Arguments.at(j).Flag.compare(VALUE_FLAGONLY) !=0 )
+                if (cmdplan->Arguments.at(j).UseValue == true)
                 {
                     if (   (entry_found == true)
                         && (entry->CmdValues.at(i) > DEFAULT_VALUE)
                        )
                     {
-                        command += Profile.Commands.at(i).Arguments.at(j).Values.at(entry->CmdValues.at(i));
+                        Launch.AddText( argument->Values.at(entry->CmdValues.at(i)) );
                     }
                     else
                     {
-                        command += Profile.Commands.at(i).Arguments.at(j).Values.at(Profile.Commands.at(i).Arguments.at(j).Default);
+                        Launch.AddText( argument->Values.at(argument->Default) );
                     }
                 }
             }
-            command += "; ";
         }
 
+        extplan = &Profile.ExtPlans.at(ext_index);
+
         // Check exe forces
         cmdpath = Profile.Extensions.at(ext_index).exePath;
         cmdname = Profile.Extensions.at(ext_index).exeName;
 
-        for (uint16_t j=0; j<Profile.Extensions.at(ext_index).ExeForces.size(); j++)
+        exeforce_found = extplan->ExeForces.find( filename );
+        if (exeforce_found != extplan->ExeForces.end())
         {
-            exeforce = &Profile.Extensions.at(ext_index).ExeForces.at(j);
-            for (uint16_t k=0; k<exeforce->Files.size(); k++)
-            {
-                if (exeforce->Files.at(k).compare( filename ) == 0)
-                {
-                    cmdpath = exeforce->exePath;
-                    cmdname = exeforce->exeName;
-                    break;
-                }
-            }
+            exeforce = &Profile.Extensions.at(ext_index).ExeForces.at(exeforce_found->second);
+            cmdpath  = exeforce->exePath;
+            cmdname  = exeforce->exeName;
         }
 
-        // Add Executable to command
-        command += "cd " + cmdpath + "; ";
-        command += "LD_LIBRARY_PATH=./; export LD_LIBRARY_PATH; ";
-        command += "./" + cmdname;
+        // Arg forces for the current path
+        argforce_found = extplan->ArgForces.find( Profile.FilePath );
+        forces = (argforce_found != extplan->ArgForces.end()) ? &argforce_found->second : NULL;
+
+        // Add Executable to command, it runs from its own directory with its own libraries
+        Launch.Begin( cmdpath, true );
+        Launch.AddText( "./" + cmdname );
 
         // Setup arguments
         for (uint16_t i=0; i<Profile.Extensions.at(ext_index).Arguments.size(); i++)
         {
-            value.clear();
             argument = &Profile.Extensions.at(ext_index).Arguments.at(i);
+            argplan  = &extplan->Arguments.at(i);
+            argforce = (forces != NULL && forces->at(i) >= 0) ? &Profile.Extensions.at(ext_index).ArgForces.at(forces->at(i)) : NULL;
 
-            // Check arg forces
-            for (uint16_t j=0; j<Profile.Extensions.at(ext_index).ArgForces.size(); j++)
+            // Check arg forces, then the custom entry value, then the default value
+            if (argforce != NULL && argforce->Value.length() > 0)
             {
-                argforce = &Profile.Extensions.at(ext_index).ArgForces.at(j);
-                if (argforce->Path.compare( Profile.FilePath ) == 0)
-                {
-                    if (i == argforce->Argument)
-                    {
-                        Log( __FILENAME__, __LINE__, "Setting argforce on arg %d", i );
-                        value = argforce->Value;
-                        break;
-                    }
-                }
+                Log( __FILENAME__, __LINE__, "Setting argforce on arg %d", i );
+                value = &argforce->Value;
+                type  = extplan->ForceTypes.at(forces->at(i));
             }
-            // Check arguments for default value or custom entry value
-            if (value.length() == 0 )
+            else if (   (entry_found == true)
+                     && (CheckRange( i, entry->ArgValues.size() ))
+                     && (entry->ArgValues.at(i) > DEFAULT_VALUE)
+                    )
             {
-                if (   (entry_found == true)
-                    && (CheckRange( i, entry->ArgValues.size() ))
-                    && (entry->ArgValues.at(i) > DEFAULT_VALUE)
-                   )
+                value = &argument->Values.at( entry->ArgValues.at(i) );
+                type  = argplan->Types.at( entry->ArgValues.at(i) );
+            }
+            else if (CheckRange( argument->Default, argument->Values.size() ))
+            {
+                value = &argument->Values.at( argument->Default );
+                type  = argplan->Types.at( argument->Default );
+            }
+            else
+            {
+                Log( __FILENAME__, __LINE__, "Error: RunExec argument->Default is out of range" );
+                return 1;
+            }
+
+            // Add the argument if used
+            if ((value->length() == 0) || (type == VALUETYPE_NOVALUE))
+            {
+                continue;
+            }
+
+            Launch.AddText( argplan->Flag );
+
+            if (type == VALUETYPE_FILENAME)
+            {
+                if (Config.FilenameArgNoExt == true)
                 {
-                    value = argument->Values.at( entry->ArgValues.at(i) );
+                    string::size_type pos = filename.find_last_of(".");
+                    if (pos != string::npos)
+                        filename.resize( pos );
                 }
-                else
+
+                // Passed as one argument whatever characters the name has
+                if (entry_found==true)
                 {
-                    if (CheckRange( argument->Default, argument->Values.size() ))
+                    if (Config.FilenameAbsPath == true)
                     {
-                        value = argument->Values.at( argument->Default );
+                        Launch.AddLiteral( entry->Path + entry->Name );
                     }
                     else
                     {
-                        Log( __FILENAME__, __LINE__, "Error: RunExec argument->Default is out of range" );
-                        return 1;
+                        Launch.AddLiteral( entry->Name );
                     }
                 }
-            }
-            // Add the argument if used
-            if (value.length() > 0)
-            {
-                if (value.compare( VALUE_NOVALUE ) != 0 )
+                else
                 {
-                    command += " " + argument->Flag + " ";
-
-                    if (value.compare( VALUE_FLAGONLY ) !=0 )
+                    if (Config.FilenameAbsPath == true)
                     {
-                        if (value.compare( VALUE_FILENAME ) == 0)
-                        {
-                            if (Config.FilenameArgNoExt == true)
-                            {
-                                string::size_type pos = filename.find_last_of(".");
-                                if (pos != string::npos)
-                                    filename.resize( pos );
-                            }
-
-                            if (entry_found==true)
-                            {
-                                command += '\"';
-                                if (Config.FilenameAbsPath == true)
-                                {
-                                    command += entry->Path;
-                                }
-                                command += entry->Name + '\"';
-                            }
-                            else
-                            {
-                                command += '\"';
-                                if (Config.FilenameAbsPath == true)
-                                {
-                                    command += filepath;
-                                }
-                                command += filename + '\"';
-                            }
-                        }
-                        else
-                        {
-                            command += value;
-                        }
+                        Launch.AddLiteral( filepath + filename );
+                    }
+                    else
+                    {
+                        Launch.AddLiteral( filename );
                     }
                 }
             }
+            else if (type == VALUETYPE_TEXT)
+            {
+                Launch.AddText( *value );
+            }
         }
     }
     else
@@ -2193,19 +2704,11 @@ int8_t CSelector::RunExec( uint16_t selection )
         return 1;
     }
 
-    command += "; sync;";
-    if (Config.ReloadLauncher == true)
-    {
-        command += " cd " + Profile.LauncherPath + ";";
-        command += " exec ./" + Profile.LauncherName ;
-        // Arguments
-        command += " " + string(ARG_PROFILE) + " " + ProfilePath;
-        command += " " + string(ARG_CONFIG)  + " " + ConfigPath;
-        command += " " + string(ARG_ZIPLIST) + " " + ZipListPath;
-    }
+    // Launcher files are flushed when written, the target's own writes only if the profile asks
+    Launch.SyncPaths = Profile.SyncAfter;
 
     /* Print out all the commands in a list form  */
-    SplitString( ";", command, commands );
+    SplitString( ";", Launch.Script(), commands );
 
     Log( __FILENAME__, __LINE__, "Running command start:" );
     for(uint16_t i=0; i<commands.size(); i++)
@@ -2214,21 +2717,251 @@ int8_t CSelector::RunExec( uint16_t selection )
     }
     Log( __FILENAME__, __LINE__, "Running command end:" );
 
+    if (Config.Supervisor == true)
+    {
+        return Supervise();
+    }
+
     CloseResources(0);
 
-    execlp( "/bin/sh", "/bin/sh", "-c", command.c_str(), NULL );
+    // Nothing after the exec returns to main, the trace is written while every other thread is stopped
+    TRACE_CLOSE();
+
+    // The plan takes the place of the launcher, the shell execs it again once the plan exits
+    if (Config.ReloadLauncher == true)
+    {
+        Launch.ReloadPath = Profile.LauncherPath;
+        Launch.Reload.push_back( "./" + Profile.LauncherName );
+        Launch.Reload.push_back( ARG_PROFILE );
+        Launch.Reload.push_back( ProfilePath );
+        Launch.Reload.push_back( ARG_CONFIG );
+        Launch.Reload.push_back( ConfigPath );
+        Launch.Reload.push_back( ARG_ZIPLIST );
+        Launch.Reload.push_back( ZipListPath );
+    }
+
+    Launch.Replace( Config.LaunchShell );
 
     //if execution continues then something went wrong and as we already called SDL_Quit we cannot continue, try reloading
     Log( __FILENAME__, __LINE__, "Error executing selected application, re-launching %s", APPNAME );
 
-    chdir( Profile.LauncherPath.c_str() );
-    execlp( Profile.LauncherName.c_str(), Profile.LauncherName.c_str(), NULL );
+    if (Config.ReloadLauncher == true)
+    {
+        command = "./" + Profile.LauncherName;
+
+        chdir( Profile.LauncherPath.c_str() );
+        LogFlush();
+        execl( command.c_str(), Profile.LauncherName.c_str(),
+               ARG_PROFILE, ProfilePath.c_str(), ARG_CONFIG, ConfigPath.c_str(), ARG_ZIPLIST, ZipListPath.c_str(), NULL );
+
+        Log( __FILENAME__, __LINE__, "Error re-launching %s: %s", APPNAME, strerror(errno) );
+    }
+
+    return 1;
+}
+
+void CSelector::SaveSnapshot( void )
+{
+    time_t time;
+
+    if (Config.SnapshotPath.length() == 0)
+    {
+        return;
+    }
+
+    Snapshot.Clear();
+    Snapshot.Mode           = Mode;
+    Snapshot.TargetApp      = Profile.TargetApp;
+    Snapshot.FilePath       = Profile.FilePath;
+    Snapshot.ZipFile        = Profile.ZipFile;
+    Snapshot.EntryFilter    = Profile.EntryFilter;
+    for (uint8_t i=0; i<DisplayList.size(); i++)
+    {
+        Snapshot.Positions.push_back( DisplayList.at(i).first );
+        Snapshot.Positions.push_back( DisplayList.at(i).last );
+        Snapshot.Positions.push_back( DisplayList.at(i).absolute );
+        Snapshot.Positions.push_back( DisplayList.at(i).relative );
+        Snapshot.Positions.push_back( DisplayList.at(i).total );
+    }
+    Snapshot.Items = ItemsEntry;
+    for (uint16_t i=0; i<ItemsEntry.size(); i++)
+    {
+        if (CheckRange( ItemsEntry.at(i).Entry, Profile.Entries.size() ))
+        {
+            Snapshot.Aliases.push_back( Profile.Entries.at(ItemsEntry.at(i).Entry).Alias );
+        }
+        else
+        {
+            Snapshot.Aliases.push_back( "" );
+        }
+    }
+    Snapshot.AlphabeticIndices = Profile.AlphabeticIndices;
+    Preview.CopyIndex( Snapshot.PreviewPath, time, Snapshot.PreviewIndex );
+    Snapshot.PreviewTime = time;
+
+    Snapshot.Save( Config.SnapshotPath, ConfigPath, ProfilePath );
+    Snapshot.Clear();
+}
+
+int8_t CSelector::ResumeSnapshot( void )
+{
+    uint16_t total;
+
+    if (Snapshot.Load( Config.SnapshotPath, ConfigPath, ProfilePath ))
+    {
+        return 1;
+    }
+
+    // Only the listing of entries is kept, the other modes need the profile
+    total = Snapshot.Items.size();
+    if (   (Snapshot.Mode != MODE_SELECT_ENTRY)
+        || (Snapshot.Positions.size() != DisplayList.size()*5)
+        || ((total > 0) && (!CheckRange( Snapshot.Positions.at(MODE_SELECT_ENTRY*5+2), total )))
+       )
+    {
+        Log( __FILENAME__, __LINE__, "Snapshot does not match the selector, rescanning" );
+        Snapshot.Clear();
+        return 1;
+    }
+
+    Mode                        = Snapshot.Mode;
+    Profile.TargetApp           = Snapshot.TargetApp;
+    Profile.FilePath            = Snapshot.FilePath;
+    Profile.ZipFile             = Snapshot.ZipFile;
+    Profile.EntryFilter         = Snapshot.EntryFilter;
+    Profile.AlphabeticIndices   = Snapshot.AlphabeticIndices;
+    ItemsEntry.swap( Snapshot.Items );
+    for (uint8_t i=0; i<DisplayList.size(); i++)
+    {
+        DisplayList.at(i).first     = Snapshot.Positions.at(i*5);
+        DisplayList.at(i).last      = Snapshot.Positions.at(i*5+1);
+        DisplayList.at(i).absolute  = Snapshot.Positions.at(i*5+2);
+        DisplayList.at(i).relative  = Snapshot.Positions.at(i*5+3);
+        DisplayList.at(i).total     = Snapshot.Positions.at(i*5+4);
+    }
+    Preview.RestoreIndex( Snapshot.PreviewPath, Snapshot.PreviewTime, Snapshot.PreviewIndex );
+
+    // The same sizes RescanItems would have set
+    RectEntries.resize( MIN(total, Config.MaxEntries) );
+    FreeListNames();
+    ListNames.resize( RectEntries.size() );
+
+    Log( __FILENAME__, __LINE__, "Resuming %d entries in %s%s from the snapshot", total, Profile.FilePath.c_str(), Profile.ZipFile.c_str() );
+    Rescan      = false;
+    RefreshList = true;
+    return 0;
+}
+
+void CSelector::WarmEntry( uint16_t selection )
+{
+    int16_t ext_index;
+    string filename;
+    string extension;
+    string cmdpath, cmdname;
+    entry_t* entry = NULL;
+    extplan_t* extplan = NULL;
+    map<string, int16_t>::iterator exeforce_found;
+
+    if ((Config.Readahead == false) || (!CheckRange( selection, ItemsEntry.size() )))
+    {
+        return;
+    }
+
+    filename = ItemsEntry.at(selection).Name;
+    if (ItemsEntry.at(selection).Type == TYPE_DIR)
+    {
+        extension = EXT_DIRS;
+    }
+    else
+    {
+        extension = filename.substr( filename.find_last_of(".")+1 );
+
+        if (ItemsEntry.at(selection).Entry >= 0)
+        {
+            entry = &Profile.Entries.at(ItemsEntry.at(selection).Entry);
+        }
+        if ((entry != NULL) && (entry->Custom == true))
+        {
+            Readahead.Request( entry->Path + entry->Name );
+        }
+        else if ((Config.UseZipSupport == true) && (Profile.ZipFile.length() > 0))
+        {
+            // The zip is warmed whole, the entry is extracted from it on launch
+            Readahead.Request( Profile.FilePath + Profile.ZipFile );
+        }
+        else
+        {
+            Readahead.Request( Profile.FilePath + filename );
+        }
+    }
+
+    ext_index = Profile.FindExtension( extension );
+    if (!CheckRange( ext_index, Profile.Extensions.size() ))
+    {
+        return;
+    }
+
+    extplan = &Profile.ExtPlans.at(ext_index);
+    cmdpath = Profile.Extensions.at(ext_index).exePath;
+    cmdname = Profile.Extensions.at(ext_index).exeName;
+
+    exeforce_found = extplan->ExeForces.find( filename );
+    if (exeforce_found != extplan->ExeForces.end())
+    {
+        cmdpath = Profile.Extensions.at(ext_index).ExeForces.at(exeforce_found->second).exePath;
+        cmdname = Profile.Extensions.at(ext_index).ExeForces.at(exeforce_found->second).exeName;
+    }
+
+    // The binary and the libraries it finds through LD_LIBRARY_PATH=./
+    Readahead.Request( cmdpath + cmdname );
+    Readahead.Request( cmdpath );
+}
+
+int8_t CSelector::Supervise( void )
+{
+    // Everything is saved and the display released, the application gets the device as if the launcher had exited
+    CloseResources(0);
+
+    if (Launch.Execute( Config.LaunchShell ))
+    {
+        Log( __FILENAME__, __LINE__, "Error the selected application could not be started, returning to the list" );
+    }
+
+    // The application may have changed the clock
+    System.SetCPUClock( Config.CPUClock );
+
+    if (OpenDisplay())
+    {
+        Log( __FILENAME__, __LINE__, "Failed to reopen the display" );
+        return 1;
+    }
+
+    // The listing is kept, only the surfaces have to be rendered again
+    for (uint16_t index=0; index<EventPressCount.size(); index++)
+    {
+        EventPressCount.at(index) = EVENT_LOOPS_OFF;
+        EventReleased.at(index)   = false;
+    }
+    RefreshList         = true;
+    Redraw              = true;
+    DrawState_Title     = true;
+    DrawState_About     = true;
+    DrawState_Filter    = true;
+    DrawState_FilePath  = true;
+    DrawState_Index     = true;
+    DrawState_ZipMode   = true;
+    DrawState_Preview   = true;
+    DrawState_ButtonL   = true;
+    DrawState_ButtonR   = true;
 
     return 0;
 }
 
 int8_t CSelector::PollInputs( void )
 {
+    TRACE_SPAN( "CSelector::PollInputs" );
+    ALLOCS_SCOPE( ALLOC_INPUT );
+
     int16_t     newsel;
     string      keyname;
     SDL_Event   event;
@@ -2288,6 +3021,7 @@ int8_t CSelector::PollInputs( void )
                         }
                         DrawState_Filter    = true;
                         Rescan              = true;
+                        IoAction( IO_FILTER );
                     }
                 }
                 else
@@ -2560,6 +3294,13 @@ int8_t CSelector::PollInputs( void )
     }
 
     // List navigation
+    if (   (IsEventOn(EVENT_ONE_UP) == true) || (IsEventOn(EVENT_ONE_DOWN) == true)
+        || (IsEventOn(EVENT_PAGE_UP) == true) || (IsEventOn(EVENT_PAGE_DOWN) == true)
+        || (IsEventOn(EVENT_DIR_UP) == true) || (IsEventOn(EVENT_DIR_DOWN) == true)
+       )
+    {
+        IoAction( IO_NAVIGATE );
+    }
     if (IsEventOn(EVENT_ONE_UP)==true)
     {
         DisplayList.at(Mode).absolute--;
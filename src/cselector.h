@@ -23,11 +23,22 @@
 #ifndef CSELECTOR_H
 #define CSELECTOR_H
 
+#include <sys/time.h>
+
 #include "version.h"
 #include "cbase.h"
 #include "cconfig.h"
 #include "cprofile.h"
 #include "csystem.h"
+#include "cpreview.h"
+#include "cbundle.h"
+#include "claunch.h"
+#include "creadahead.h"
+#include "csnapshot.h"
+#include "creplay.h"
+#include "chud.h"
+#include "cstartup.h"
+#include "cmembudget.h"
 
 using namespace std;
 
@@ -38,6 +49,10 @@ using namespace std;
 #define DEF_PROFILE             "profile.txt"                   /** Default profile filename. */
 #define ARG_ZIPLIST             "--ziplist"                     /** Flag to override the ziplist file. */
 #define DEF_ZIPLIST             "ziplist.txt"                   /** Default ziplist filename. */
+#define ARG_REPLAY              "--replay"                      /** Flag to run a input script on the dummy video driver. */
+#define ARG_REPLAY_REPORT       "--replay-report"               /** Flag to override the replay report file. */
+#define ARG_STARTUP_REPORT      "--startup-report"              /** Flag to write the timings of the start up to a file. */
+#define ARG_STARTUP_BUDGET      "--startup-budget"              /** Flag to fail the run if the first frame takes longer, in milliseconds. */
 
 #define ENTRY_ARROW             "-> "                           /** Ascii fallback for the entry arrow selector. */
 #define BUTTON_LABEL_ONE_UP     "<"                             /** Ascii text fallback for the one up button label. */
@@ -69,8 +84,11 @@ using namespace std;
 #define FRAMES_PER_SEC          60                              /** Frames in 1 Second. */
 #define FRAME_SKIP_RATIO        4                               /** Maximum frames skip ratio, draw 1 frame for every X number of skipped frames. */
 #define POINTER_OFFSET          5                               /** Space between pointer and entry text. */
+#define DIRTY_RECTS             32                              /** Screen areas reserved for updates so a frame does not allocate them. */
+#if defined(DEBUG)
+#define DEBUG_TEXT              128                             /** Size of the debug text. */
+#endif
 
-#define FREE_IMAGE(X)   if (X != NULL) { SDL_FreeSurface(X); X = NULL; } /** Macro for checking and releasing pointers to pixel data. */
 
 /** @brief Modes of the launcher.
  */
@@ -96,10 +114,11 @@ struct item_pos_t {
 /** @brief The font, color, text for a item in the display list
  */
 struct listtext_t {
-    listtext_t() : font(0), color(0), text("") {};
+    listtext_t() : font(0), color(0), text(""), image(NULL) {};
     int8_t font;            /** Index of the selected font size for the text. */
     int8_t color;           /** Index of the color for the text. */
     string text;            /** Text for an item for the display list. */
+    SDL_Surface* image;     /** Rendered text, NULL until drawn, freed when the list is populated again. */
 };
 
 /** @brief This class controls resources, logic for gui, interaction with the user.
@@ -137,6 +156,21 @@ class CSelector : public CBase
          */
         void    CloseResources      ( int8_t result );
 
+        /** @brief Open the display, fonts and images.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  OpenDisplay         ( void );
+
+        /** @brief Close the display, fonts and images and quit SDL.
+         */
+        void    CloseDisplay        ( void );
+
+        /** @brief Get an unscaled image from the bundle, loading it and adding it to the bundle if needed.
+         * @param path : path to the image
+         * @return the image or NULL if it could not be loaded
+         */
+        SDL_Surface* LoadAsset      ( const string& path );
+
         /** @brief Main loop of the application, polls input, runs current mode, and refreshes the screen.
          * @return -1  for no selection otherwise the entry selection number.
          */
@@ -159,9 +193,33 @@ class CSelector : public CBase
          */
         int8_t  DisplaySelector     ( void );
 
-        /** @brief Loads the preview image if any exists.
+        /** @brief Shows or hides the performance display when its event is on.
+         */
+        void    ToggleHud           ( void );
+
+        /** @brief Draws the performance display over the screen when it is shown.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  DrawHud             ( void );
+
+        /** @brief Measures the memory held and frees previews then rendered text when over the budget or under pressure.
+         */
+        void    TrimMemory          ( void );
+
+        /** @brief Selects the preview for an entry and queues its neighbors to be decoded ahead.
+         * @param index : index of the selected entry
+         */
+        void    LoadPreview         ( uint16_t index );
+
+        /** @brief Picks up the selected preview once it has been decoded and schedules it to be drawn.
+         */
+        void    CheckPreview        ( void );
+
+        /** @brief Builds the text displayed for an entry, from its alias or its name.
+         * @param index : index of the entry
+         * @return the display text
          */
-        void    LoadPreview         ( const string& name );
+        string  EntryText           ( uint16_t index );
 
         /** @brief Moves the current path one directory level up.
          */
@@ -183,6 +241,10 @@ class CSelector : public CBase
          */
         void    PopulateList        ( void );
 
+        /** @brief Free the rendered text of the display list, done before its text or size changes.
+         */
+        void    FreeListNames       ( void );
+
         /** @brief Load the display with items with entries.
          */
         void    PopModeEntry        ( void );
@@ -247,6 +309,25 @@ class CSelector : public CBase
          */
         int8_t  RunExec             ( uint16_t selection );
 
+        /** @brief Write the mode, display positions and the listing of entries for the next start.
+         */
+        void    SaveSnapshot        ( void );
+
+        /** @brief Restore the mode, display positions and the listing of entries written by the last run.
+         * @return 0 if the state was restored 1 if the listing has to be scanned
+         */
+        int8_t  ResumeSnapshot      ( void );
+
+        /** @brief Queues the file of an entry, the binary that runs it and its libraries to be read into memory.
+         * @param selection : index of the entry
+         */
+        void    WarmEntry           ( uint16_t selection );
+
+        /** @brief Run the launch plan as child processes and reopen the display once it exits.
+         * @return 0 if passed 1 if failed.
+         */
+        int8_t  Supervise           ( void );
+
         /** @brief Collect all input events from the user
          * @return 0 if passed 1 if failed
          */
@@ -263,6 +344,8 @@ class CSelector : public CBase
         bool                    SetAllEntryValue;   /**< Set default for all entries to the selected value. */
         bool                    TextScrollDir;      /**< Determines the direction of the horizontal scroll, left or right. */
         bool                    ExtractAllFiles;    /**< True if all files should be extracted from a zip, if false only the selected file is. */
+        bool                    DwellPending;       /**< True while the arguments of an entry are open and it has not been read ahead. */
+        bool                    DrawAll;            /**< Set to draw every part of the screen again, text is only rendered again if its state is set. */
 
         bool                    DrawState_Title;
         bool                    DrawState_About;
@@ -293,6 +376,7 @@ class CSelector : public CBase
         int32_t                 FrameEndTime;       /**< Tick count at the end of the frame. */
         int32_t                 FrameStartTime;     /**< Tick count at the start of the frame. */
         int16_t                 FrameDelay;         /**< Tick duration of the frame. */
+        uint32_t                DwellTime;          /**< Tick count when the arguments of the entry were opened. */
 
 #if SDL_VERSION_ATLEAST(2,0,0)
         SDL_Window*             Window;             /**< SDL Window reference to the screen. */
@@ -307,7 +391,7 @@ class CSelector : public CBase
         SDL_Surface*            ImageBackground;    /**< SDL surface reference to the background pixel data (optional). */
         SDL_Surface*            ImagePointer;       /**< SDL surface reference to the pointer pixel data (optional). */
         SDL_Surface*            ImageSelectPointer; /**< SDL surface reference to the list select pointer pixel data (optional). */
-        SDL_Surface*            ImagePreview;       /**< SDL surface reference to the preview pixel data. */
+        SDL_Surface*            ImagePreview;       /**< SDL surface reference to the preview pixel data, owned by Preview. */
         SDL_Surface*            ImageTitle;         /**< SDL surface reference to the title text pixel data. */
         SDL_Surface*            ImageAbout;         /**< SDL surface reference to the about text pixel data. */
         SDL_Surface*            ImageFilePath;      /**< SDL surface reference to the about text pixel data. */
@@ -316,15 +400,30 @@ class CSelector : public CBase
         SDL_Surface*            ImageZipMode;       /**< SDL surface reference to the about text pixel data. */
 #if defined(DEBUG)
         SDL_Surface*            ImageDebug;         /**< SDL surface reference to the about text pixel data. */
+        string                  DebugText;          /**< Text of the debug surface. */
 #endif
         vector<SDL_Surface*>    ImageButtons;       /**< SDL surface references to the button's pixel data (optional). */
+        vector<SDL_Surface*>    ImageLabels;        /**< SDL surface references to the rendered button labels, NULL until drawn. */
         vector<TTF_Font*>       Fonts;              /**< SDL-TTF references to the rendered font in different size. */
         CConfig                 Config;             /**< The configuration data. */
         CProfile                Profile;            /**< The extension and entries data. */
         CSystem                 System;             /**< System specific controls and methods. */
+        CPreview                Preview;            /**< Decodes and caches the preview images. */
+        CBundle                 Bundle;             /**< Holds the images and font ready to use, must outlive them. */
+        CLaunch                 Launch;             /**< Programs to run for the selected entry. */
+        CReadahead              Readahead;          /**< Reads the files of the selected entry into memory ahead of launch. */
+        CSnapshot               Snapshot;           /**< State of the list kept between runs, only holds data while starting. */
+        CReplay                 Replay;             /**< Feeds a scripted input sequence and times the frames it causes. */
+        CHud                    Hud;                /**< Performance display drawn over the screen. */
+        CStartup                Startup;            /**< Times the phases of the start up and the first frame. */
+        CMemBudget              Memory;             /**< Keeps the images, text and lists within the memory limit. */
         string                  ConfigPath;         /**< Contains the file path to the config.txt. */
         string                  ProfilePath;        /**< Contains the file path to the profile.txt. */
         string                  ZipListPath;        /**< Contains the path and name of the files that have been unzipped. */
+        string                  ReplayPath;         /**< Contains the file path to the replay script, empty for normal use. */
+        string                  ReplayReportPath;   /**< Contains the file path the replay timings are written to. */
+        string                  StartupReportPath;  /**< Contains the file path the start up timings are written to, empty for none. */
+        uint32_t                StartupBudget;      /**< Milliseconds the first frame may take, 0 for no limit. */
         vector<bool>            EventReleased;      /**< Collection of the states if a release event was detected. */
         vector<int8_t>          EventPressCount;    /**< Collection of the loop counts for when an event can act again. */
         vector<uint8_t>         ButtonModesLeft;    /**< Collection of the state of the buttons on the left side. */
@@ -0,0 +1,342 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "csnapshot.h"
+
+#include <string.h>
+
+CSnapshot::CSnapshot() : CBase(),
+        Mode                (0),
+        TargetApp           (""),
+        FilePath            (""),
+        ZipFile             (""),
+        EntryFilter         (""),
+        Positions           (),
+        Items               (),
+        Aliases             (),
+        AlphabeticIndices   (),
+        PreviewPath         (""),
+        PreviewTime         (0),
+        PreviewIndex        (),
+        Buffer              (""),
+        Cursor              (NULL),
+        End                 (NULL)
+{
+}
+
+CSnapshot::~CSnapshot()
+{
+}
+
+int8_t CSnapshot::Save( const string& location, const string& config, const string& profile )
+{
+    int32_t             fd;
+    bool                failed;
+    uint16_t            count16;
+    uint32_t            count32;
+    string              temporary;
+    snapshotheader_t    header;
+    map<string, string>::iterator it;
+
+    if (location.length() == 0)
+    {
+        return 0;
+    }
+
+    Buffer.clear();
+    PutString( TargetApp );
+    PutString( FilePath );
+    PutString( ZipFile );
+    PutString( EntryFilter );
+
+    count16 = Positions.size();
+    Put( &count16, sizeof(count16) );
+    for (uint16_t i=0; i<Positions.size(); i++)
+    {
+        Put( &Positions.at(i), sizeof(int16_t) );
+    }
+
+    count32 = Items.size();
+    Put( &count32, sizeof(count32) );
+    for (uint32_t i=0; i<Items.size(); i++)
+    {
+        Put( &Items.at(i).Type, sizeof(Items.at(i).Type) );
+        Put( &Items.at(i).Entry, sizeof(Items.at(i).Entry) );
+        PutString( Items.at(i).Name );
+        PutString( (i < Aliases.size()) ? Aliases.at(i) : "" );
+    }
+
+    count16 = AlphabeticIndices.size();
+    Put( &count16, sizeof(count16) );
+    for (uint16_t i=0; i<AlphabeticIndices.size(); i++)
+    {
+        Put( &AlphabeticIndices.at(i), sizeof(int16_t) );
+    }
+
+    PutString( PreviewPath );
+    Put( &PreviewTime, sizeof(PreviewTime) );
+    count32 = PreviewIndex.size();
+    Put( &count32, sizeof(count32) );
+    for (it=PreviewIndex.begin(); it!=PreviewIndex.end(); it++)
+    {
+        PutString( it->first );
+        PutString( it->second );
+    }
+
+    memset( &header, 0, sizeof(header) );
+    header.Magic    = SNAPSHOT_MAGIC;
+    header.Version  = SNAPSHOT_VERSION;
+    header.Mode     = Mode;
+    header.ListTime = ListTime();
+    header.Length   = Buffer.length();
+    Stamp( config, header.ConfigTime, header.ConfigSize );
+    Stamp( profile, header.ProfileTime, header.ProfileSize );
+
+    temporary = location + ".tmp";
+    fd = open( temporary.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+    if (fd < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write snapshot %s: %s", temporary.c_str(), strerror(errno) );
+        Buffer.clear();
+        return 1;
+    }
+
+    failed = (write( fd, &header, sizeof(header) ) != (ssize_t)sizeof(header));
+    if (failed == false)
+    {
+        failed = (write( fd, Buffer.data(), Buffer.length() ) != (ssize_t)Buffer.length());
+    }
+    if (close( fd ) != 0)
+    {
+        failed = true;
+    }
+    Buffer.clear();
+
+    if (failed == true || rename( temporary.c_str(), location.c_str() ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write snapshot %s: %s", location.c_str(), strerror(errno) );
+        unlink( temporary.c_str() );
+        return 1;
+    }
+    return 0;
+}
+
+int8_t CSnapshot::Load( const string& location, const string& config, const string& profile )
+{
+    int32_t                 fd;
+    bool                    valid;
+    void*                   map;
+    size_t                  length;
+    int64_t                 time;
+    int64_t                 size;
+    uint16_t                count16;
+    uint32_t                count32;
+    struct stat             info;
+    string                  key;
+    string                  value;
+    const snapshotheader_t* header;
+
+    Clear();
+    count16 = 0;
+    count32 = 0;
+
+    if (location.length() == 0)
+    {
+        return 1;
+    }
+
+    fd = open( location.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    if (fstat( fd, &info ) != 0 || info.st_size < (off_t)sizeof(snapshotheader_t))
+    {
+        close( fd );
+        return 1;
+    }
+
+    length = info.st_size;
+    map = mmap( NULL, length, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (map == MAP_FAILED)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to map snapshot %s: %s", location.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    // A different config or profile could change what is listed and how, the snapshot is only a shortcut
+    header = static_cast<const snapshotheader_t*>(map);
+    valid  = (header->Magic   == SNAPSHOT_MAGIC   &&
+              header->Version == SNAPSHOT_VERSION &&
+              length == sizeof(snapshotheader_t) + header->Length);
+    if (valid == true)
+    {
+        Stamp( config, time, size );
+        valid = (time == header->ConfigTime && size == header->ConfigSize);
+    }
+    if (valid == true)
+    {
+        Stamp( profile, time, size );
+        valid = (time == header->ProfileTime && size == header->ProfileSize);
+    }
+
+    if (valid == true)
+    {
+        Mode   = header->Mode;
+        Cursor = reinterpret_cast<const uint8_t*>(header+1);
+        End    = Cursor + header->Length;
+
+        valid = GetString( TargetApp ) && GetString( FilePath ) && GetString( ZipFile ) && GetString( EntryFilter );
+
+        valid = valid && Get( &count16, sizeof(count16) ) && Fits( count16, sizeof(int16_t) );
+        Positions.resize( valid ? count16 : 0 );
+        for (uint16_t i=0; i<Positions.size() && valid; i++)
+        {
+            valid = Get( &Positions.at(i), sizeof(int16_t) );
+        }
+
+        // Each item is at least its type, its entry and two empty strings
+        valid = valid && Get( &count32, sizeof(count32) ) && Fits( count32, sizeof(uint8_t) + sizeof(int16_t) + 2*sizeof(uint16_t) );
+        Items.resize( valid ? count32 : 0 );
+        Aliases.resize( Items.size() );
+        for (uint32_t i=0; i<Items.size() && valid; i++)
+        {
+            valid = Get( &Items.at(i).Type, sizeof(Items.at(i).Type) ) &&
+                    Get( &Items.at(i).Entry, sizeof(Items.at(i).Entry) ) &&
+                    GetString( Items.at(i).Name ) &&
+                    GetString( Aliases.at(i) );
+        }
+
+        valid = valid && Get( &count16, sizeof(count16) ) && Fits( count16, sizeof(int16_t) );
+        AlphabeticIndices.resize( valid ? count16 : 0 );
+        for (uint16_t i=0; i<AlphabeticIndices.size() && valid; i++)
+        {
+            valid = Get( &AlphabeticIndices.at(i), sizeof(int16_t) );
+        }
+
+        valid = valid && GetString( PreviewPath ) && Get( &PreviewTime, sizeof(PreviewTime) ) && Get( &count32, sizeof(count32) );
+        valid = valid && Fits( count32, 2*sizeof(uint16_t) );
+        for (uint32_t i=0; i<count32 && valid; i++)
+        {
+            valid = GetString( key ) && GetString( value );
+            PreviewIndex[key] = value;
+        }
+
+        // Files added or removed since would be missing from the listing
+        valid = valid && (Cursor == End) && (ListTime() == header->ListTime) && (header->ListTime != 0);
+    }
+
+    Cursor = NULL;
+    End    = NULL;
+    munmap( map, length );
+
+    if (valid == false)
+    {
+        Log( __FILENAME__, __LINE__, "Snapshot %s is out of date and will be ignored", location.c_str() );
+        Clear();
+        return 1;
+    }
+    return 0;
+}
+
+void CSnapshot::Clear( void )
+{
+    Mode = 0;
+    TargetApp.clear();
+    FilePath.clear();
+    ZipFile.clear();
+    EntryFilter.clear();
+    Positions.clear();
+    Items.clear();
+    Aliases.clear();
+    AlphabeticIndices.clear();
+    PreviewPath.clear();
+    PreviewTime = 0;
+    PreviewIndex.clear();
+}
+
+void CSnapshot::Stamp( const string& path, int64_t& time, int64_t& size )
+{
+    struct stat info;
+
+    time = 0;
+    size = 0;
+    if (stat( path.c_str(), &info ) == 0)
+    {
+        time = info.st_mtime;
+        size = info.st_size;
+    }
+}
+
+int64_t CSnapshot::ListTime( void )
+{
+    int64_t time;
+    int64_t size;
+
+    Stamp( FilePath + ZipFile, time, size );
+    return time;
+}
+
+void CSnapshot::Put( const void* data, uint32_t length )
+{
+    Buffer.append( static_cast<const char*>(data), length );
+}
+
+void CSnapshot::PutString( const string& text )
+{
+    uint16_t length;
+
+    length = MIN(text.length(), (size_t)0xFFFF);
+    Put( &length, sizeof(length) );
+    Put( text.data(), length );
+}
+
+bool CSnapshot::Get( void* data, uint32_t length )
+{
+    if (Cursor == NULL || (uint32_t)(End - Cursor) < length)
+    {
+        return false;
+    }
+    memcpy( data, Cursor, length );
+    Cursor += length;
+    return true;
+}
+
+bool CSnapshot::Fits( uint32_t count, uint32_t record )
+{
+    return (Cursor != NULL && count <= (uint32_t)(End - Cursor) / record);
+}
+
+bool CSnapshot::GetString( string& text )
+{
+    uint16_t length;
+
+    if (Get( &length, sizeof(length) ) == false || (uint32_t)(End - Cursor) < length)
+    {
+        return false;
+    }
+    text.assign( reinterpret_cast<const char*>(Cursor), length );
+    Cursor += length;
+    return true;
+}
@@ -0,0 +1,146 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CSNAPSHOT_H
+#define CSNAPSHOT_H
+
+#include <map>
+
+#include "cbase.h"
+#include "cprofile.h"
+
+using namespace std;
+
+#define SNAPSHOT_MAGIC      0x4E534C50      /** "PLSN" identifies a snapshot file. */
+#define SNAPSHOT_VERSION    1               /** Incremented when the layout of the snapshot file changes. */
+
+/** @brief Header at the start of the snapshot file, the variable length state follows it
+ */
+struct snapshotheader_t {
+    uint32_t    Magic;              /** @brief Always SNAPSHOT_MAGIC */
+    uint16_t    Version;            /** @brief Always SNAPSHOT_VERSION */
+    uint8_t     Mode;               /** @brief Mode of the selector when it was taken */
+    uint8_t     Reserved;           /** @brief Unused, keeps the fields aligned */
+    int64_t     ConfigTime;         /** @brief Modification time of the config file */
+    int64_t     ConfigSize;         /** @brief Size in bytes of the config file */
+    int64_t     ProfileTime;        /** @brief Modification time of the profile file */
+    int64_t     ProfileSize;        /** @brief Size in bytes of the profile file */
+    int64_t     ListTime;           /** @brief Modification time of the directory or zip that was listed */
+    uint32_t    Length;             /** @brief Size in bytes of the state following the header */
+};
+
+/** @brief This class holds the state of the selector when the launcher closes, so the next start can draw
+ *         the list before the profile is loaded and the directory is scanned
+ */
+class CSnapshot : public CBase
+{
+    public:
+        /** Constructor. */
+        CSnapshot();
+        /** Destructor. */
+        virtual ~CSnapshot();
+
+        /** @brief Write the state to a file, stamped with the config and profile it goes with.
+         * @param location : the snapshot file, empty does nothing
+         * @param config : the config file
+         * @param profile : the profile file
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Save        ( const string& location, const string& config, const string& profile );
+
+        /** @brief Read the state from a file, it is rejected if the config, profile or listing changed since.
+         * @param location : the snapshot file, empty does nothing
+         * @param config : the config file
+         * @param profile : the profile file
+         * @return 0 if the state is valid 1 if not
+         */
+        int8_t          Load        ( const string& location, const string& config, const string& profile );
+
+        /** @brief Remove all state. */
+        void            Clear       ( void );
+
+        uint8_t                 Mode;               /**< Mode of the selector. */
+        string                  TargetApp;          /**< Label of the target application from the profile. */
+        string                  FilePath;           /**< Directory that was listed. */
+        string                  ZipFile;            /**< Zip file that was listed, empty if none. */
+        string                  EntryFilter;        /**< Filter applied to the listing. */
+        vector<int16_t>         Positions;          /**< First, last, absolute, relative and total of each mode's display list. */
+        vector<listitem_t>      Items;              /**< The listing of entries. */
+        vector<string>          Aliases;            /**< Alias of each item of the listing, empty if it has none. */
+        vector<int16_t>         AlphabeticIndices;  /**< Index of the first item for each letter. */
+        string                  PreviewPath;        /**< Directory the preview index was built from. */
+        int64_t                 PreviewTime;        /**< Modification time of the preview directory for the index. */
+        map<string, string>     PreviewIndex;       /**< Lookup from key to file name of every preview. */
+
+    private:
+        /** @brief Get the modification time and size of a file.
+         * @param path : the file
+         * @param time : set to the modification time, 0 if the file does not exist
+         * @param size : set to the size, 0 if the file does not exist
+         */
+        void            Stamp       ( const string& path, int64_t& time, int64_t& size );
+
+        /** @brief Get the modification time of what the listing was made from.
+         * @return the modification time of the zip file or the directory
+         */
+        int64_t         ListTime    ( void );
+
+        /** @brief Append raw bytes to the state being written.
+         * @param data : the bytes
+         * @param length : number of bytes
+         */
+        void            Put         ( const void* data, uint32_t length );
+
+        /** @brief Append a string to the state being written.
+         * @param text : the string
+         */
+        void            PutString   ( const string& text );
+
+        /** @brief Read raw bytes from the state being loaded.
+         * @param data : destination of the bytes
+         * @param length : number of bytes
+         * @return true if the bytes were in the file
+         */
+        bool            Get         ( void* data, uint32_t length );
+
+        /** @brief Check that a count read from the file can be right before anything is sized by it.
+         * @param count : number of records
+         * @param record : smallest size of one record in bytes
+         * @return true if that many records fit in what is left to load
+         */
+        bool            Fits        ( uint32_t count, uint32_t record );
+
+        /** @brief Read a string from the state being loaded.
+         * @param text : the string
+         * @return true if the string was in the file
+         */
+        bool            GetString   ( string& text );
+
+        CSnapshot(const CSnapshot &);
+        CSnapshot & operator=(const CSnapshot&);
+
+        string                  Buffer;             /**< State being written. */
+        const uint8_t*          Cursor;             /**< Position in the mapped state being loaded. */
+        const uint8_t*          End;                /**< End of the mapped state being loaded. */
+};
+
+#endif // CSNAPSHOT_H
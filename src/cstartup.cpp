@@ -0,0 +1,142 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cstartup.h"
+
+/* Names used in the log and the report, index is defined in STARTUP_PHASES_T */
+static const char* StartupPhases[STARTUP_TOTAL] = { "config", "ziplist", "sdl_init", "video", "font_small", "font_medium",
+                                                    "font_large", "profile", "background", "buttons", "first_scan", "first_present" };
+
+CStartup::CStartup() : CBase(),
+        Start       (0),
+        Budget      (0),
+        Over        (false),
+        FirstFrame  (0),
+        Source      ("")
+{
+    for (uint8_t phase=0; phase<STARTUP_TOTAL; phase++)
+    {
+        Begun[phase] = 0;
+        Spent[phase] = -1;
+    }
+}
+
+CStartup::~CStartup()
+{
+}
+
+void CStartup::Open( uint32_t budget )
+{
+    Start   = Now();
+    Budget  = budget;
+}
+
+void CStartup::Close( const string& location )
+{
+    ofstream fout;
+
+    if (Start == 0)
+    {
+        return;
+    }
+    Start = 0;
+
+    for (uint8_t phase=0; phase<STARTUP_TOTAL; phase++)
+    {
+        if (Spent[phase] >= 0)
+        {
+            Log( __FILENAME__, __LINE__, "Startup %-13s %8d us", StartupPhases[phase], (int32_t)Spent[phase] );
+        }
+    }
+
+    // A run that never presented a frame cannot meet the budget
+    if ((Budget > 0) && ((FirstFrame == 0) || (FirstFrame > (uint64_t)Budget*1000)))
+    {
+        Log( __FILENAME__, __LINE__, "Error startup took %d ms, the budget is %d ms", (int32_t)(FirstFrame/1000), Budget );
+        Over = true;
+    }
+
+    if (location.length() > 0)
+    {
+        fout.open( location.c_str(), ios_base::trunc );
+        if (!fout)
+        {
+            Log( __FILENAME__, __LINE__, "Failed to open startup report %s", location.c_str() );
+            return;
+        }
+
+        fout << "{" << endl
+             << "  \"first_frame_us\": " << FirstFrame << "," << endl
+             << "  \"source\": \"" << Source << "\"," << endl
+             << "  \"budget_ms\": " << Budget << "," << endl
+             << "  \"passed\": " << (Over ? "false" : "true") << "," << endl
+             << "  \"phases\": [" << endl;
+        for (uint8_t phase=0; phase<STARTUP_TOTAL; phase++)
+        {
+            fout << "    { \"name\": \"" << StartupPhases[phase] << "\", \"us\": " << Spent[phase]
+                 << " }" << (phase < STARTUP_TOTAL-1 ? "," : "") << endl;
+        }
+        fout << "  ]" << endl << "}" << endl;
+        fout.close();
+    }
+}
+
+bool CStartup::OverBudget( void )
+{
+    return Over;
+}
+
+void CStartup::Begin( uint8_t phase )
+{
+    if ((phase < STARTUP_TOTAL) && (Spent[phase] < 0))
+    {
+        Begun[phase] = Now();
+    }
+}
+
+void CStartup::End( uint8_t phase )
+{
+    if ((phase < STARTUP_TOTAL) && (Spent[phase] < 0) && (Begun[phase] > 0))
+    {
+        Spent[phase] = Now() - Begun[phase];
+    }
+}
+
+void CStartup::Ready( const char* source )
+{
+    if ((Start == 0) || (FirstFrame > 0))
+    {
+        return;
+    }
+
+    FirstFrame  = Now() - Start;
+    Source      = source;
+    Log( __FILENAME__, __LINE__, "First frame drawn from the %s after %d ms", source, (int32_t)(FirstFrame/1000) );
+}
+
+uint64_t CStartup::Now( void )
+{
+    struct timeval now;
+
+    gettimeofday( &now, NULL );
+    return (uint64_t)now.tv_sec*1000000 + now.tv_usec;
+}
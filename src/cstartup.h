@@ -0,0 +1,109 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CSTARTUP_H
+#define CSTARTUP_H
+
+#include <sys/time.h>
+
+#include "cbase.h"
+
+using namespace std;
+
+/** @brief Phases of the start up, each is timed the first time it runs
+ */
+enum STARTUP_PHASES_T {
+    STARTUP_CONFIG=0,               /** @brief Loading the config */
+    STARTUP_ZIPLIST,                /** @brief Loading the list of zip extensions */
+    STARTUP_SDL,                    /** @brief SDL_Init */
+    STARTUP_VIDEO,                  /** @brief Creating the window or setting the video mode */
+    STARTUP_FONT_SMALL,             /** @brief Opening the small font */
+    STARTUP_FONT_MEDIUM,            /** @brief Opening the medium font */
+    STARTUP_FONT_LARGE,             /** @brief Opening the large font */
+    STARTUP_PROFILE,                /** @brief Loading the profile */
+    STARTUP_BACKGROUND,             /** @brief Loading and scaling the background */
+    STARTUP_BUTTONS,                /** @brief Loading the button images */
+    STARTUP_SCAN,                   /** @brief The first scan of the directory */
+    STARTUP_PRESENT,                /** @brief Presenting the first frame */
+    STARTUP_TOTAL
+};
+
+/** @brief This class times the phases of the start up and the time until the first frame is on screen,
+ *         the report is written as json and checked against a budget
+ */
+class CStartup : public CBase
+{
+    public:
+        /** Constructor. */
+        CStartup();
+        /** Destructor. */
+        virtual ~CStartup();
+
+        /** @brief Note the start, the phases and the first frame are timed from here.
+         * @param budget : milliseconds the first frame may take, 0 for no limit
+         */
+        void            Open        ( uint32_t budget );
+
+        /** @brief Log the phases, check the budget and write the report if one was asked for.
+         * @param location : the report file, written as json, empty for none
+         */
+        void            Close       ( const string& location );
+
+        /** @brief Check if the first frame took longer than the budget.
+         * @return true if over the budget
+         */
+        bool            OverBudget  ( void );
+
+        /** @brief Start timing a phase, only the first run of a phase is kept.
+         * @param phase : the phase (index is defined in STARTUP_PHASES_T)
+         */
+        void            Begin       ( uint8_t phase );
+
+        /** @brief Stop timing a phase.
+         * @param phase : the phase (index is defined in STARTUP_PHASES_T)
+         */
+        void            End         ( uint8_t phase );
+
+        /** @brief Note that the first frame was presented, later calls are ignored.
+         * @param source : what the list of the frame was drawn from
+         */
+        void            Ready       ( const char* source );
+
+    private:
+        /** @brief Get the current time.
+         * @return time in microseconds
+         */
+        uint64_t        Now         ( void );
+
+        CStartup(const CStartup &);
+        CStartup & operator=(const CStartup&);
+
+        uint64_t                Start;                      /**< Time the start up began, 0 before Open. */
+        uint32_t                Budget;                     /**< Milliseconds the first frame may take, 0 for no limit. */
+        bool                    Over;                       /**< True if the first frame took longer than the budget. */
+        uint64_t                FirstFrame;                 /**< Microseconds until the first frame, 0 until it is presented. */
+        string                  Source;                     /**< What the first frame was drawn from. */
+        uint64_t                Begun[STARTUP_TOTAL];       /**< Start of each phase while it runs (index is defined in STARTUP_PHASES_T). */
+        int64_t                 Spent[STARTUP_TOTAL];       /**< Microseconds of each phase, -1 if it did not run (index is defined in STARTUP_PHASES_T). */
+};
+
+#endif // CSTARTUP_H
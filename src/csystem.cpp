@@ -65,6 +65,7 @@ void CSystem::SetCPUClock( uint16_t& mhz )
 
 #if defined(PANDORA)
     string command = "/usr/bin/sudo cpuset " + i_to_a(mhz);
+    LogFlush();
     execlp( command.c_str(), command.c_str(), NULL, NULL, NULL );
 
 #elif defined(WIZ) || defined(CAANOO)
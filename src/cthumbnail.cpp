@@ -0,0 +1,281 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "cthumbnail.h"
+
+#include <string.h>
+
+// The header must fit in front of the pixel data
+typedef char thumbheader_size_check[(sizeof(thumbheader_t) <= THUMB_HEADER_SIZE) ? 1 : -1];
+
+CThumbnail::CThumbnail() : CBase(),
+        Path        (""),
+        Format      (NULL),
+        Mappings    ()
+{
+}
+
+CThumbnail::~CThumbnail()
+{
+    while (Mappings.size() > 0)
+    {
+        Free( Mappings.begin()->first );
+    }
+}
+
+int8_t CThumbnail::Open( const string& path, SDL_PixelFormat* format )
+{
+    struct stat info;
+
+    Path   = path;
+    Format = format;
+
+    if (Path.length() == 0)
+    {
+        return 0;
+    }
+
+    if (stat( Path.c_str(), &info ) != 0)
+    {
+        if (mkdir( Path.c_str(), 0755 ) != 0)
+        {
+            Log( __FILENAME__, __LINE__, "Warning failed to create thumbnail path %s: %s", Path.c_str(), strerror(errno) );
+            Path.clear();
+            return 1;
+        }
+    }
+    else if (!S_ISDIR(info.st_mode))
+    {
+        Log( __FILENAME__, __LINE__, "Warning thumbnail path is not a directory: %s", Path.c_str() );
+        Path.clear();
+        return 1;
+    }
+    return 0;
+}
+
+SDL_Surface* CThumbnail::Load( const string& source, const struct stat& info, uint16_t width, uint16_t height )
+{
+    int32_t             fd;
+    struct stat         status;
+    thumbmap_t          mapping;
+    const thumbheader_t* header;
+    SDL_Surface*        image;
+
+    if (Path.length() == 0)
+    {
+        return NULL;
+    }
+
+    IoCount( IO_OPEN );
+    fd = open( Location( Hash(source, width, height) ).c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    if (fstat( fd, &status ) != 0 || status.st_size < THUMB_HEADER_SIZE)
+    {
+        close( fd );
+        return NULL;
+    }
+    IoCount( IO_STAT, status.st_size );
+
+    // Private and writable so SDL may touch the pixels without changing the file
+    mapping.Length  = status.st_size;
+    mapping.Address = mmap( NULL, mapping.Length, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if (mapping.Address == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    header = static_cast<const thumbheader_t*>(mapping.Address);
+    if (header->Magic        != THUMB_MAGIC                                         ||
+        header->Version      != THUMB_VERSION                                       ||
+        header->KeyHash      != Hash(source, width, height)                         ||
+        header->SourceTime   != (int64_t)info.st_mtime                              ||
+        header->SourceSize   != (int64_t)info.st_size                               ||
+        header->Width        != width                                               ||
+        header->Height       != height                                              ||
+        header->Pitch        <  (uint32_t)header->Width*((header->BitsPerPixel+7)/8)||
+        mapping.Length       <  THUMB_HEADER_SIZE + (size_t)header->Pitch*header->Height)
+    {
+        // Out of date, the caller will decode the source and replace it
+        munmap( mapping.Address, mapping.Length );
+        return NULL;
+    }
+
+    image = SDL_CreateRGBSurfaceFrom( static_cast<uint8_t*>(mapping.Address) + THUMB_HEADER_SIZE,
+                                      header->Width, header->Height, header->BitsPerPixel, header->Pitch,
+                                      header->Rmask, header->Gmask, header->Bmask, header->Amask );
+    if (image == NULL)
+    {
+        munmap( mapping.Address, mapping.Length );
+        return NULL;
+    }
+
+    if (header->ColorKey != 0)
+    {
+#if SDL_VERSION_ATLEAST(2,0,0)
+        SDL_SetColorKey( image, SDL_TRUE, SDL_MapRGB( image->format, 0xFF, 0, 0xFF ) );
+#else /* SDL 1.2 */
+        SDL_SetColorKey( image, SDL_SRCCOLORKEY, SDL_MapRGB( image->format, 0xFF, 0, 0xFF ) );
+#endif
+    }
+
+    Mappings[image] = mapping;
+    return image;
+}
+
+int8_t CThumbnail::Save( const string& source, const struct stat& info, SDL_Surface* image )
+{
+    int32_t         fd;
+    bool            failed;
+    uint8_t         block[THUMB_HEADER_SIZE];
+    thumbheader_t   header;
+    string          location;
+    string          temporary;
+    uint8_t*        row;
+    uint32_t        length;
+
+    if (Path.length() == 0 || image == NULL)
+    {
+        return 0;
+    }
+
+    memset( &header, 0, sizeof(header) );
+    header.Magic        = THUMB_MAGIC;
+    header.Version      = THUMB_VERSION;
+    header.BitsPerPixel = image->format->BitsPerPixel;
+#if SDL_VERSION_ATLEAST(2,0,0)
+    header.ColorKey     = (SDL_GetColorKey( image, NULL ) == 0) ? 1 : 0;
+#else /* SDL 1.2 */
+    header.ColorKey     = (image->flags & SDL_SRCCOLORKEY) ? 1 : 0;
+#endif
+    header.KeyHash      = Hash( source, image->w, image->h );
+    header.SourceTime   = info.st_mtime;
+    header.SourceSize   = info.st_size;
+    header.Width        = image->w;
+    header.Height       = image->h;
+    header.Rmask        = image->format->Rmask;
+    header.Gmask        = image->format->Gmask;
+    header.Bmask        = image->format->Bmask;
+    header.Amask        = image->format->Amask;
+
+    // Rows are stored without the surface padding, rounded up to keep them 4 byte aligned
+    length       = image->w*image->format->BytesPerPixel;
+    header.Pitch = (length+3) & ~3;
+
+    memset( block, 0, sizeof(block) );
+    memcpy( block, &header, sizeof(header) );
+
+    location  = Location( header.KeyHash );
+    temporary = location + ".tmp";
+
+    fd = open( temporary.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+    if (fd < 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write thumbnail %s: %s", temporary.c_str(), strerror(errno) );
+        return 1;
+    }
+
+    failed = (write( fd, block, sizeof(block) ) != (ssize_t)sizeof(block));
+
+    if (SDL_MUSTLOCK(image))
+    {
+        SDL_LockSurface( image );
+    }
+    memset( block, 0, sizeof(block) );
+    for (int32_t y=0; y<image->h && failed == false; y++)
+    {
+        row = static_cast<uint8_t*>(image->pixels) + y*image->pitch;
+        failed = (write( fd, row, length ) != (ssize_t)length);
+        if (failed == false && header.Pitch > length)
+        {
+            failed = (write( fd, block, header.Pitch-length ) != (ssize_t)(header.Pitch-length));
+        }
+    }
+    if (SDL_MUSTLOCK(image))
+    {
+        SDL_UnlockSurface( image );
+    }
+
+    if (close( fd ) != 0)
+    {
+        failed = true;
+    }
+
+    // Readers only ever see a complete file
+    if (failed == true || rename( temporary.c_str(), location.c_str() ) != 0)
+    {
+        Log( __FILENAME__, __LINE__, "Warning failed to write thumbnail %s: %s", location.c_str(), strerror(errno) );
+        unlink( temporary.c_str() );
+        return 1;
+    }
+    return 0;
+}
+
+void CThumbnail::Free( SDL_Surface* image )
+{
+    map<SDL_Surface*, thumbmap_t>::iterator found;
+
+    if (image == NULL)
+    {
+        return;
+    }
+
+    found = Mappings.find( image );
+    SDL_FreeSurface( image );
+    if (found != Mappings.end())
+    {
+        munmap( found->second.Address, found->second.Length );
+        Mappings.erase( found );
+    }
+}
+
+uint64_t CThumbnail::Hash( const string& source, uint16_t width, uint16_t height )
+{
+    uint64_t        hash = 14695981039346656037ULL;
+    stringstream    key;
+
+    key << source << ":" << width << "x" << height;
+    if (Format != NULL)
+    {
+        key << ":" << (int32_t)Format->BitsPerPixel << ":" << hex << Format->Rmask << Format->Gmask << Format->Bmask;
+    }
+
+    string text = key.str();
+    for (uint32_t i=0; i<text.length(); i++)
+    {
+        hash ^= (uint8_t)text.at(i);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+string CThumbnail::Location( uint64_t hash )
+{
+    stringstream name;
+
+    name << Path << "/" << hex << setw(16) << setfill('0') << hash << THUMB_EXT;
+    return name.str();
+}
@@ -0,0 +1,127 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CTHUMBNAIL_H
+#define CTHUMBNAIL_H
+
+#include <map>
+
+#include "cbase.h"
+
+using namespace std;
+
+#define THUMB_EXT           ".thm"          /** Extension of the thumbnail files. */
+#define THUMB_MAGIC         0x48544C50      /** "PLTH" identifies a thumbnail file. */
+#define THUMB_VERSION       2               /** Incremented when the layout of the thumbnail file or the scaled pixels change. */
+#define THUMB_HEADER_SIZE   64              /** Pixel data starts at this offset, keeps rows aligned in the mapping. */
+
+/** @brief Header at the start of every thumbnail file
+ */
+struct thumbheader_t {
+    uint32_t    Magic;              /** @brief Always THUMB_MAGIC */
+    uint16_t    Version;            /** @brief Always THUMB_VERSION */
+    uint8_t     BitsPerPixel;       /** @brief Depth of the pixel data */
+    uint8_t     ColorKey;           /** @brief 1 if the magenta color key is applied to the image */
+    uint64_t    KeyHash;            /** @brief Hash of the source path, target size and pixel format */
+    int64_t     SourceTime;         /** @brief Modification time of the source image */
+    int64_t     SourceSize;         /** @brief Size in bytes of the source image */
+    uint16_t    Width;              /** @brief Width of the pixel data */
+    uint16_t    Height;             /** @brief Height of the pixel data */
+    uint32_t    Pitch;              /** @brief Bytes per row of the pixel data */
+    uint32_t    Rmask;              /** @brief Red mask of the pixel data */
+    uint32_t    Gmask;              /** @brief Green mask of the pixel data */
+    uint32_t    Bmask;              /** @brief Blue mask of the pixel data */
+    uint32_t    Amask;              /** @brief Alpha mask of the pixel data */
+};
+
+/** @brief Data structure for a thumbnail mapped into memory
+ */
+struct thumbmap_t {
+    thumbmap_t() : Address(NULL), Length(0) {};
+    void*       Address;            /** @brief Start of the mapping */
+    size_t      Length;             /** @brief Length of the mapping */
+};
+
+/** @brief This class stores scaled images on disk in a raw format so they can be mapped back without decoding.
+ *         Surfaces are tracked by the instance, it must only be used by one thread at a time.
+ */
+class CThumbnail : public CBase
+{
+    public:
+        /** Constructor. */
+        CThumbnail();
+        /** Destructor. */
+        virtual ~CThumbnail();
+
+        /** @brief Set the location of the cache, the directory is created if needed.
+         * @param path : directory for the thumbnail files, empty disables the cache
+         * @param format : pixel format of the screen
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( const string& path, SDL_PixelFormat* format );
+
+        /** @brief Map a thumbnail for an image if an up to date one exists.
+         * @param source : path to the full size image
+         * @param info : status of the full size image
+         * @param width : expected width of the thumbnail
+         * @param height : expected height of the thumbnail
+         * @return surface with the pixels in the mapping, NULL if no valid thumbnail exists
+         */
+        SDL_Surface*    Load        ( const string& source, const struct stat& info, uint16_t width, uint16_t height );
+
+        /** @brief Write a scaled image as the thumbnail of a full size image.
+         * @param source : path to the full size image
+         * @param info : status of the full size image
+         * @param image : the scaled image
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Save        ( const string& source, const struct stat& info, SDL_Surface* image );
+
+        /** @brief Release a surface, unmapping it if it was returned by Load.
+         * @param image : surface to free
+         */
+        void            Free        ( SDL_Surface* image );
+
+    private:
+        /** @brief Compute the identifying hash of a thumbnail.
+         * @param source : path to the full size image
+         * @param width : width of the thumbnail
+         * @param height : height of the thumbnail
+         * @return FNV-1a hash of the values
+         */
+        uint64_t        Hash        ( const string& source, uint16_t width, uint16_t height );
+
+        /** @brief Build the path of a thumbnail file.
+         * @param hash : identifying hash from Hash
+         * @return the path of the thumbnail file
+         */
+        string          Location    ( uint64_t hash );
+
+        CThumbnail(const CThumbnail &);
+        CThumbnail & operator=(const CThumbnail&);
+
+        string                          Path;       /**< Directory for the thumbnail files, empty if disabled. */
+        SDL_PixelFormat*                Format;     /**< Pixel format of the screen. */
+        map<SDL_Surface*, thumbmap_t>   Mappings;   /**< Mappings backing the surfaces returned by Load. */
+};
+
+#endif // CTHUMBNAIL_H
@@ -0,0 +1,240 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "ctokenizer.h"
+
+#include <string.h>
+
+CTokenizer::CTokenizer() : CBase(),
+        Map         (NULL),
+        MapLength   (0),
+        Cursor      (NULL),
+        End         (NULL)
+{
+}
+
+CTokenizer::~CTokenizer()
+{
+    Close();
+}
+
+int8_t CTokenizer::Open( const string& location )
+{
+    int32_t     fd;
+    struct stat info;
+
+    Close();
+
+    IoCount( IO_OPEN );
+    fd = open( location.c_str(), O_RDONLY );
+    if (fd < 0)
+    {
+        return 1;
+    }
+
+    if (fstat( fd, &info ) != 0)
+    {
+        close( fd );
+        return 1;
+    }
+    IoCount( IO_STAT, info.st_size );
+
+    // An empty file has no lines, there is nothing to map
+    if (info.st_size > 0)
+    {
+        MapLength = info.st_size;
+        Map = mmap( NULL, MapLength, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if (Map == MAP_FAILED)
+        {
+            Log( __FILENAME__, __LINE__, "Failed to map %s: %s", location.c_str(), strerror(errno) );
+            close( fd );
+            Map = NULL;
+            MapLength = 0;
+            return 1;
+        }
+        Cursor = static_cast<const char*>(Map);
+        End    = Cursor + MapLength;
+    }
+    close( fd );
+
+    return 0;
+}
+
+void CTokenizer::Close( void )
+{
+    if (Map != NULL)
+    {
+        munmap( Map, MapLength );
+        Map = NULL;
+    }
+    MapLength   = 0;
+    Cursor      = NULL;
+    End         = NULL;
+}
+
+bool CTokenizer::Next( textview_t& line )
+{
+    const char* feed;
+
+    if (Cursor == NULL || Cursor >= End)
+    {
+        line = textview_t();
+        return false;
+    }
+
+    feed = static_cast<const char*>(memchr( Cursor, '\n', End - Cursor ));
+    if (feed == NULL)
+    {
+        feed = End;
+    }
+
+    line    = textview_t( Cursor, feed - Cursor );
+    Cursor  = (feed < End) ? feed + 1 : End;
+    return true;
+}
+
+bool CTokenizer::Unprefix( const textview_t& line, const char* prefix, textview_t& value )
+{
+    uint32_t    length;
+    const char* start;
+    const char* stop;
+
+    length = strlen( prefix );
+    if (line.Length < length || memcmp( line.Data, prefix, length ) != 0)
+    {
+        return false;
+    }
+
+    stop  = line.Data + line.Length;
+    start = static_cast<const char*>(memchr( line.Data, '=', line.Length ));
+    start = (start != NULL) ? start + 1 : line.Data;
+
+    // Remove any comments
+    for (const char* c=start; c<stop; c++)
+    {
+        if (*c == '#')
+        {
+            stop = c;
+            break;
+        }
+    }
+
+    // Trim left and right white spaces
+    while (start < stop && isspace( static_cast<uint8_t>(*start) ))
+    {
+        start++;
+    }
+    while (stop > start && isspace( static_cast<uint8_t>(*(stop-1)) ))
+    {
+        stop--;
+    }
+
+    value = textview_t( start, stop - start );
+    return true;
+}
+
+void CTokenizer::Split( const textview_t& text, const string& delimiter, vector<textview_t>& fields )
+{
+    const char* start;
+    const char* stop;
+    const char* c;
+
+    fields.clear();
+
+    start = text.Data;
+    stop  = text.Data + text.Length;
+    if (delimiter.length() == 0)
+    {
+        fields.push_back( text );
+        return;
+    }
+
+    for (c=start; c+delimiter.length()<=stop; )
+    {
+        if (memcmp( c, delimiter.data(), delimiter.length() ) == 0)
+        {
+            fields.push_back( textview_t( start, c - start ) );
+            c    += delimiter.length();
+            start = c;
+        }
+        else
+        {
+            c++;
+        }
+    }
+    fields.push_back( textview_t( start, stop - start ) );
+}
+
+string CTokenizer::Text( const textview_t& view )
+{
+    return string( view.Data, view.Length );
+}
+
+bool CTokenizer::Equal( const textview_t& view, const char* text )
+{
+    return (strlen(text) == view.Length) && (memcmp( view.Data, text, view.Length ) == 0);
+}
+
+int32_t CTokenizer::Integer( const textview_t& view )
+{
+    bool        negative;
+    int64_t     number;
+    const char* c;
+    const char* stop;
+
+    c    = view.Data;
+    stop = view.Data + view.Length;
+    while (c < stop && isspace( static_cast<uint8_t>(*c) ))
+    {
+        c++;
+    }
+
+    negative = false;
+    if (c < stop && (*c == '-' || *c == '+'))
+    {
+        negative = (*c == '-');
+        c++;
+    }
+
+    number = 0;
+    // Clamped so a long run of digits cannot overflow
+    while (c < stop && *c >= '0' && *c <= '9')
+    {
+        if (number > 0x7FFFFFFF)
+        {
+            number = 0x80000000LL;
+            break;
+        }
+        number = number*10 + (*c - '0');
+        c++;
+    }
+
+    if (negative == true)
+    {
+        number = -MIN(number, 0x80000000LL);
+    }
+    else
+    {
+        number = MIN(number, 0x7FFFFFFFLL);
+    }
+    return (int32_t)number;
+}
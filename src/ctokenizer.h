@@ -0,0 +1,109 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CTOKENIZER_H
+#define CTOKENIZER_H
+
+#include "cbase.h"
+
+using namespace std;
+
+/** @brief Piece of the text held by a tokenizer, only valid while the tokenizer is open
+ */
+struct textview_t {
+    textview_t() : Data(NULL), Length(0) {};
+    textview_t( const char* data, uint32_t length ) : Data(data), Length(length) {};
+    const char* Data;               /** @brief First character, not terminated */
+    uint32_t    Length;             /** @brief Number of characters */
+};
+
+/** @brief This class maps a text file and splits it into lines and fields without copying it
+ */
+class CTokenizer : public CBase
+{
+    public:
+        /** Constructor. */
+        CTokenizer();
+        /** Destructor. */
+        virtual ~CTokenizer();
+
+        /** @brief Map a file, the previous one is unmapped.
+         * @param location : the file
+         * @return 0 if passed 1 if failed
+         */
+        int8_t          Open        ( const string& location );
+
+        /** @brief Unmap the file, every view into it becomes invalid. */
+        void            Close       ( void );
+
+        /** @brief Get the next line without its line feed.
+         * @param line : set to the line, empty at the end of the file
+         * @return true if a line was read, false at the end of the file
+         */
+        bool            Next        ( textview_t& line );
+
+        /** @brief Check for a prefix and get the value after it the way CBase::UnprefixString does:
+         *         the value follows the first '=', ends at a '#' and has white space trimmed.
+         * @param line : the line
+         * @param prefix : text the line must start with
+         * @param value : set to the value
+         * @return true if the line starts with the prefix
+         */
+        bool            Unprefix    ( const textview_t& line, const char* prefix, textview_t& value );
+
+        /** @brief Split text into the fields between delimiters, there is always at least one field.
+         * @param text : the text
+         * @param delimiter : text between fields
+         * @param fields : set to the fields, the capacity is reused between calls
+         */
+        void            Split       ( const textview_t& text, const string& delimiter, vector<textview_t>& fields );
+
+        /** @brief Copy a view into a string.
+         * @param view : the view
+         * @return the text
+         */
+        string          Text        ( const textview_t& view );
+
+        /** @brief Compare a view with text.
+         * @param view : the view
+         * @param text : terminated text
+         * @return true if they are the same
+         */
+        bool            Equal       ( const textview_t& view, const char* text );
+
+        /** @brief Read a decimal number at the start of a view, leading white space is skipped.
+         * @param view : the view
+         * @return the number, 0 if there is none
+         */
+        int32_t         Integer     ( const textview_t& view );
+
+    private:
+        CTokenizer(const CTokenizer &);
+        CTokenizer & operator=(const CTokenizer&);
+
+        void*                   Map;            /**< Mapping of the file, NULL if none. */
+        size_t                  MapLength;      /**< Length of the mapping. */
+        const char*             Cursor;         /**< Start of the next line. */
+        const char*             End;            /**< End of the text. */
+};
+
+#endif // CTOKENIZER_H
@@ -0,0 +1,214 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#include "ctrace.h"
+
+#if defined(TRACE)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "SDL.h"
+
+using namespace std;
+
+#define TRACE_INSTANT       0xFFFFFFFF      // Duration marking an event without a length
+
+/** @brief A span or frame boundary
+ */
+struct traceevent_t {
+    const char*     Name;                   /** @brief Name of the event */
+    uint64_t        Start;                  /** @brief Start in microseconds */
+    uint32_t        Duration;               /** @brief Length in microseconds, TRACE_INSTANT for a frame boundary */
+};
+
+/** @brief The events recorded by one thread
+ */
+struct tracebuffer_t {
+    tracebuffer_t() : Thread(0), Name(NULL), Count(0), Dropped(0), Events(NULL) {}
+    uint32_t        Thread;                 /** @brief Thread id written to the trace */
+    const char*     Name;                   /** @brief Name of the thread, NULL if not named */
+    uint32_t        Count;                  /** @brief Number of events recorded */
+    uint32_t        Dropped;                /** @brief Number of events not recorded because the buffer was full */
+    traceevent_t*   Events;                 /** @brief TRACE_EVENTS events */
+};
+
+static bool                     TraceEnabled    = false;
+static uint64_t                 TraceOrigin     = 0;
+static SDL_mutex*               TraceLock       = NULL;     // Guards the list of buffers
+static vector<tracebuffer_t*>   TraceBuffers;
+static __thread tracebuffer_t*  TraceLocal      = NULL;     // Buffer of the calling thread, only it writes to it
+
+static uint64_t TraceNow( void )
+{
+    struct timeval now;
+
+    gettimeofday( &now, NULL );
+    return (uint64_t)now.tv_sec*1000000 + now.tv_usec;
+}
+
+static tracebuffer_t* TraceBuffer( void )
+{
+    if (TraceLocal == NULL)
+    {
+        TraceLocal          = new tracebuffer_t;
+        TraceLocal->Events  = new traceevent_t[TRACE_EVENTS];
+
+        SDL_LockMutex( TraceLock );
+        TraceBuffers.push_back( TraceLocal );
+        TraceLocal->Thread = TraceBuffers.size();
+        SDL_UnlockMutex( TraceLock );
+    }
+    return TraceLocal;
+}
+
+static void TraceRecord( const char* name, uint64_t start, uint32_t duration )
+{
+    tracebuffer_t*  buffer;
+    traceevent_t*   event;
+
+    buffer = TraceBuffer();
+    if (buffer->Count >= TRACE_EVENTS)
+    {
+        buffer->Dropped++;
+        return;
+    }
+
+    event = &buffer->Events[buffer->Count++];
+    event->Name     = name;
+    event->Start    = start;
+    event->Duration = duration;
+}
+
+void TraceOpen( void )
+{
+    if (TraceEnabled == true || getenv( TRACE_ENV ) == NULL)
+    {
+        return;
+    }
+
+    TraceLock = SDL_CreateMutex();
+    if (TraceLock == NULL)
+    {
+        return;
+    }
+    TraceOrigin  = TraceNow();
+    TraceEnabled = true;
+    TraceThread( "main" );
+}
+
+void TraceClose( void )
+{
+    const char*     location;
+    FILE*           fout;
+    tracebuffer_t*  buffer;
+    traceevent_t*   event;
+    bool            first;
+
+    if (TraceEnabled == false)
+    {
+        return;
+    }
+    TraceEnabled = false;
+
+    location = getenv( TRACE_ENV );
+    fout = fopen( location, "w" );
+    if (fout != NULL)
+    {
+        first = true;
+        fprintf( fout, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+        for (uint32_t index=0; index<TraceBuffers.size(); index++)
+        {
+            buffer = TraceBuffers.at(index);
+
+            fprintf( fout, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\",\"dropped\":%u}}",
+                     first ? "" : ",", buffer->Thread, (buffer->Name != NULL) ? buffer->Name : "thread", buffer->Dropped );
+            first = false;
+
+            for (uint32_t count=0; count<buffer->Count; count++)
+            {
+                event = &buffer->Events[count];
+                if (event->Duration == TRACE_INSTANT)
+                {
+                    fprintf( fout, ",\n{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%llu}",
+                             event->Name, buffer->Thread, (unsigned long long)(event->Start-TraceOrigin) );
+                }
+                else
+                {
+                    fprintf( fout, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%u}",
+                             event->Name, buffer->Thread, (unsigned long long)(event->Start-TraceOrigin), event->Duration );
+                }
+            }
+        }
+        fprintf( fout, "\n]}\n" );
+        fclose( fout );
+    }
+
+    for (uint32_t index=0; index<TraceBuffers.size(); index++)
+    {
+        delete [] TraceBuffers.at(index)->Events;
+        delete TraceBuffers.at(index);
+    }
+    TraceBuffers.clear();
+    TraceLocal = NULL;
+
+    SDL_DestroyMutex( TraceLock );
+    TraceLock = NULL;
+}
+
+void TraceThread( const char* name )
+{
+    if (TraceEnabled == true)
+    {
+        TraceBuffer()->Name = name;
+    }
+}
+
+void TraceFrame( void )
+{
+    if (TraceEnabled == true)
+    {
+        TraceRecord( "frame", TraceNow(), TRACE_INSTANT );
+    }
+}
+
+uint64_t TraceBegin( void )
+{
+    return (TraceEnabled == true) ? TraceNow() : 0;
+}
+
+void TraceEnd( const char* name, uint64_t start )
+{
+    uint64_t duration;
+
+    if (start == 0 || TraceEnabled == false)
+    {
+        return;
+    }
+
+    duration = TraceNow() - start;
+    TraceRecord( name, start, (duration < TRACE_INSTANT) ? (uint32_t)duration : TRACE_INSTANT-1 );
+}
+
+#endif // TRACE
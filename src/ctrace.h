@@ -0,0 +1,100 @@
+/**
+ *  @section LICENSE
+ *
+ *  PickleLauncher
+ *  Copyright (C) 2010-2019 Scott Smith
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *  @section LOCATION
+ */
+
+#ifndef CTRACE_H
+#define CTRACE_H
+
+#include <stdint.h>
+
+/** Spans are only compiled in with -DTRACE (make TRACE=1) and only recorded when the environment
+ *  variable TRACE_ENV names the file the chrome trace is written to on exit. */
+#if defined(TRACE)
+#define TRACE_JOIN(X,Y)     X##Y
+#define TRACE_NAME(X,Y)     TRACE_JOIN(X,Y)
+#define TRACE_SPAN(X)       CTraceSpan TRACE_NAME(trace_span_,__LINE__)( X )    /**< Record the time until the end of the scope. */
+#define TRACE_FRAME()       TraceFrame()                                        /**< Mark the end of a frame. */
+#define TRACE_THREAD(X)     TraceThread( X )                                    /**< Name the calling thread in the trace. */
+#define TRACE_OPEN()        TraceOpen()                                         /**< Start recording if asked by the environment. */
+#define TRACE_CLOSE()       TraceClose()                                        /**< Write the trace and stop recording. */
+#else
+#define TRACE_SPAN(X)
+#define TRACE_FRAME()
+#define TRACE_THREAD(X)
+#define TRACE_OPEN()
+#define TRACE_CLOSE()
+#endif
+
+#define TRACE_ENV           "PL_TRACE"      /**< Environment variable holding the path of the trace file. */
+#define TRACE_EVENTS        32768           /**< Events kept for each thread, later events are dropped. */
+
+#if defined(TRACE)
+
+/** @brief Start recording when TRACE_ENV is set, the calling thread is named main.
+ */
+void        TraceOpen       ( void );
+
+/** @brief Write every recorded event as chrome trace json to the file named by TRACE_ENV and stop recording,
+ *         all other threads must have finished.
+ */
+void        TraceClose      ( void );
+
+/** @brief Name the calling thread in the trace.
+ * @param name : name of the thread, must not be freed
+ */
+void        TraceThread     ( const char* name );
+
+/** @brief Record a frame boundary on the calling thread.
+ */
+void        TraceFrame      ( void );
+
+/** @brief Get the start time of a span.
+ * @return time in microseconds, 0 if nothing is recorded
+ */
+uint64_t    TraceBegin      ( void );
+
+/** @brief Record a span on the calling thread.
+ * @param name : name of the span, must not be freed
+ * @param start : time returned by TraceBegin
+ */
+void        TraceEnd        ( const char* name, uint64_t start );
+
+/** @brief Records the time spent in a scope, use TRACE_SPAN to create one
+ */
+class CTraceSpan
+{
+    public:
+        /** Constructor. */
+        CTraceSpan( const char* name ) : Name(name), Start(TraceBegin()) {}
+        /** Destructor. */
+        ~CTraceSpan() { TraceEnd( Name, Start ); }
+
+    private:
+        CTraceSpan(const CTraceSpan &);
+        CTraceSpan & operator=(const CTraceSpan&);
+
+        const char*     Name;           /**< Name of the span. */
+        uint64_t        Start;          /**< Start of the span in microseconds, 0 when not recorded. */
+};
+
+#endif // TRACE
+
+#endif // CTRACE_H
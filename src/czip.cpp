@@ -49,12 +49,15 @@ CZip::~CZip()
 
 void CZip::ListFiles( const string& zipfile, vector<string>& list )
 {
+    TRACE_SPAN( "CZip::ListFiles" );
+
     uint32_t i;
     int32_t err;
     unzFile uf=NULL;
     unz_global_info64 gi;
 
     // Open the zip file
+    IoCount( IO_OPEN );
     uf = unzOpen64( zipfile.c_str() );
 
     if (uf != NULL)
@@ -75,59 +78,68 @@ void CZip::ListFiles( const string& zipfile, vector<string>& list )
     Log( __FILENAME__, __LINE__, "Reading zip file %s", zipfile.c_str() );
 
     // Spit out some information about the files in the zip for debug
-    Log( __FILENAME__, __LINE__, "  Length  Method     Size Ratio   Date    Time   CRC-32     Name" );
-    Log( __FILENAME__, __LINE__, "  ------  ------     ---- -----   ----    ----   ------     ----" );
+    if (LogEnabled( LOG_DEBUG ))
+    {
+        LogAt( LOG_DEBUG, __FILENAME__, __LINE__, "  Length  Method     Size Ratio   Date    Time   CRC-32     Name" );
+        LogAt( LOG_DEBUG, __FILENAME__, __LINE__, "  ------  ------     ---- -----   ----    ----   ------     ----" );
+    }
     for (i=0; i<gi.number_entry; i++)
     {
         char filename_inzip[256];
         unz_file_info64 file_info;
-        uLong ratio=0;
-        const char *string_method = NULL;
-        char charCrypt=' ';
         err = unzGetCurrentFileInfo64( uf, &file_info, filename_inzip, sizeof(filename_inzip), NULL, 0, NULL, 0 );
         if (err != UNZ_OK)
         {
             Log( __FILENAME__, __LINE__, "error %d with zipfile in unzGetCurrentFileInfo", err );
             break;
         }
-        if (file_info.uncompressed_size > 0)
-            ratio = (uLong)((file_info.compressed_size*100)/file_info.uncompressed_size);
-
-        /* display a '*' if the file is crypted */
-        if ((file_info.flag & 1) != 0)
-            charCrypt='*';
 
-        if (file_info.compression_method == 0)
-            string_method="Stored";
-        else
-        if (file_info.compression_method == Z_DEFLATED)
+        // Large archives list thousands of entries, only describe them when they are logged
+        if (LogEnabled( LOG_DEBUG ))
         {
-            uInt iLevel=(uInt)((file_info.flag & 0x6)/2);
-            if (iLevel==0)
-              string_method="Defl:N";
-            else if (iLevel==1)
-              string_method="Defl:X";
-            else if ((iLevel==2) || (iLevel==3))
-              string_method="Defl:F"; /* 2:fast , 3 : extra fast*/
-        }
-        else
-        if (file_info.compression_method == Z_BZIP2ED)
-        {
-              string_method="BZip2 ";
+            uLong ratio=0;
+            const char *string_method = NULL;
+            char charCrypt=' ';
+
+            if (file_info.uncompressed_size > 0)
+                ratio = (uLong)((file_info.compressed_size*100)/file_info.uncompressed_size);
+
+            /* display a '*' if the file is crypted */
+            if ((file_info.flag & 1) != 0)
+                charCrypt='*';
+
+            if (file_info.compression_method == 0)
+                string_method="Stored";
+            else
+            if (file_info.compression_method == Z_DEFLATED)
+            {
+                uInt iLevel=(uInt)((file_info.flag & 0x6)/2);
+                if (iLevel==0)
+                  string_method="Defl:N";
+                else if (iLevel==1)
+                  string_method="Defl:X";
+                else if ((iLevel==2) || (iLevel==3))
+                  string_method="Defl:F"; /* 2:fast , 3 : extra fast*/
+            }
+            else
+            if (file_info.compression_method == Z_BZIP2ED)
+            {
+                  string_method="BZip2 ";
+            }
+            else
+                string_method="Unkn. ";
+
+            Display64BitsSize( file_info.uncompressed_size,7 );
+            LogAt( LOG_DEBUG, __FILENAME__, __LINE__, "  %6s%c", string_method, charCrypt );
+            Display64BitsSize( file_info.compressed_size,7 );
+            LogAt( LOG_DEBUG, __FILENAME__, __LINE__, " %3lu%%  %2.2lu-%2.2lu-%2.2lu  %2.2lu:%2.2lu  %8.8lx   %s",
+                    ratio,
+                    (uLong)file_info.tmu_date.tm_mon + 1,
+                    (uLong)file_info.tmu_date.tm_mday,
+                    (uLong)file_info.tmu_date.tm_year % 100,
+                    (uLong)file_info.tmu_date.tm_hour,(uLong)file_info.tmu_date.tm_min,
+                    (uLong)file_info.crc,filename_inzip);
         }
-        else
-            string_method="Unkn. ";
-
-        Display64BitsSize( file_info.uncompressed_size,7 );
-        Log( __FILENAME__, __LINE__, "  %6s%c", string_method, charCrypt );
-        Display64BitsSize( file_info.compressed_size,7 );
-        Log( __FILENAME__, __LINE__, " %3lu%%  %2.2lu-%2.2lu-%2.2lu  %2.2lu:%2.2lu  %8.8lx   %s",
-                ratio,
-                (uLong)file_info.tmu_date.tm_mon + 1,
-                (uLong)file_info.tmu_date.tm_mday,
-                (uLong)file_info.tmu_date.tm_year % 100,
-                (uLong)file_info.tmu_date.tm_hour,(uLong)file_info.tmu_date.tm_min,
-                (uLong)file_info.crc,filename_inzip);
         if ((i+1) < gi.number_entry)
         {
             err = unzGoToNextFile( uf );
@@ -148,12 +160,15 @@ void CZip::ListFiles( const string& zipfile, vector<string>& list )
 
 void CZip::ExtractFile( const string& zipfile, const string& location, const string& filename )
 {
+    TRACE_SPAN( "CZip::ExtractFile" );
+
     uint32_t i;
     int32_t err;
     unzFile uf = NULL;
     unz_global_info64 gi;
 
     // Open the zip file
+    IoCount( IO_OPEN );
     uf = unzOpen64( zipfile.c_str() );
 
     if (uf != NULL)
@@ -212,6 +227,7 @@ void CZip::ExtractFiles( const string& zipfile, const string& location )
     unzFile uf=NULL;
     unz_global_info64 gi;
 
+    IoCount( IO_OPEN );
     uf = unzOpen64( zipfile.c_str() );
 
     if (uf != NULL)
@@ -287,6 +303,7 @@ int32_t CZip::Extract( unzFile uf, const string& location )
 
     write_filename = location + '/' + string(filename_inzip);
 
+    IoCount( IO_OPEN );
     fout = fopen64( write_filename.c_str(), "wb" );
 
     if (fout != NULL)
@@ -302,6 +319,7 @@ int32_t CZip::Extract( unzFile uf, const string& location )
             }
             if (err > 0)
             {
+                IoCount( IO_WRITE, err );
                 if (fwrite( buf, err, 1, fout ) != 1)
                 {
                     Log( __FILENAME__, __LINE__, "error in writing extracted file" );
@@ -355,11 +373,11 @@ void CZip::Display64BitsSize(ZPOS64_T n, int size_char)
       while (size_char > size_display_string)
       {
           size_char--;
-          Log( __FILENAME__, __LINE__, " " );
+          LogAt( LOG_DEBUG, __FILENAME__, __LINE__, " " );
       }
   }
 
-  Log( __FILENAME__, __LINE__, "%s", &number[pos_string] );
+  LogAt( LOG_DEBUG, __FILENAME__, __LINE__, "%s", &number[pos_string] );
 }
 
 void CZip::AddUnzipFile( const string& filename )
@@ -383,6 +401,7 @@ void CZip::DelUnzipFiles( void )
 #if defined(DEBUG)
         Log( __FILENAME__, __LINE__, "Removing file %s", UnzipFiles.at(i).c_str() );
 #endif
+        IoCount( IO_REMOVE );
         remove( UnzipFiles.at(i).c_str() );
     }
     UnzipFiles.clear();
@@ -392,6 +411,7 @@ int8_t CZip::SaveUnzipList( const string& location )
 {
     ofstream   fout;
 
+    IoCount( IO_OPEN );
     fout.open(location.c_str(), ios_base::trunc);
 
     if (!fout)
@@ -413,6 +433,9 @@ int8_t CZip::SaveUnzipList( const string& location )
                 fout << UnzipFiles.at(i) << endl;
             }
         }
+        fout.close();
+
+        SyncFile( location );
     }
 
     return 0;
@@ -423,6 +446,7 @@ int8_t CZip::LoadUnzipList( const string& location )
     string          line;
     ifstream        fin;
 
+    IoCount( IO_OPEN );
     fin.open(location.c_str(), ios_base::in);
 
     if (!fin)
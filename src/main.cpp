@@ -27,9 +27,14 @@ int32_t main( int32_t argc, char** argv )
     int32_t result;
     CSelector selector;
 
+    LogOpen();
+    TRACE_OPEN();
     selector.Log( __FILENAME__, __LINE__, "Starting %s Version %s.", APPNAME, APPVERSION );
     result = selector.Run( argc, argv );
     selector.Log( __FILENAME__, __LINE__, "Quitting %s Version %s.", APPNAME, APPVERSION );
+    TRACE_CLOSE();
+    ALLOCS_REPORT();
+    LogClose();
 
     return result;
 }